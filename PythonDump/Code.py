@@ -2,7 +2,7 @@ from __future__ import annotations
 import io
 import re
 import struct
-from typing import List, Dict, Optional, Union, TYPE_CHECKING
+from typing import List, Dict, Optional, Tuple, Union, TYPE_CHECKING
 from dataclasses import dataclass, field
 
 from Enums import packet_header_t, mem_types_t
@@ -98,8 +98,9 @@ class Code:
     # Variables
     # ====================================================================
 
-    def var(self,var_type: mem_types_t, alias: str, data=None, dims: Optional[List[int]] = None):
-        self.user_ctx.add(type=var_type, alias=alias, data=data, dims=dims)
+    def var(self,var_type: mem_types_t, alias: str, data=None, dims: Optional[List[int]] = None, retain: bool = False):
+        """User variable, *retain* keeps its value over power loss (counters, odometers...)."""
+        self.user_ctx.add(type=var_type, alias=alias, data=data, dims=dims, retain=int(retain))
 
     def ref(self, alias: str) -> Ref:
         """Get a Ref to a user variable by alias."""
@@ -579,12 +580,15 @@ class Code:
                  raw: bool = False,
                  sort: bool = True,
                  verbose: bool = True,
-                 subscriptions=None):
+                 subscriptions=None,
+                 image: bool = False):
         """
         Sort blocks → reindex → write hex dump to *filename*.
 
         :param filename:       Output file path.
         :param raw:            If True, write without comments (for BLE send).
+        :param image:          If True, write program image upload chunks (for BLE send),
+                               one packet per MTU instead of one per instance / block item.
         :param sort:           If True (default), run topological sort + reindex.
         :param verbose:        Print summary to stdout.
         :param subscriptions:  SubscriptionBuilder instance – if given, subscription
@@ -598,7 +602,9 @@ class Code:
         dump = FullDump(self, subscriptions=subscriptions)
 
         with open(filename, "w") as f:
-            if raw:
+            if image:
+                dump.write_image(f)
+            elif raw:
                 dump.write_raw(f)
             else:
                 dump.write(f)
@@ -623,6 +629,18 @@ class Code:
                            packet_header_t.PACKET_H_CODE_CFG,
                            self.block_count)
 
+    @staticmethod
+    def generate_loop_cfg_packet(classes: List[Tuple[int, int, int, int]]) -> bytes:
+        """
+        Task classes packet, classes = [(period_us, first_block, blocks_cnt, wtd_max_skipped), ...].
+        Class 0 is main class, ranges have to follow (sorted) block order and cover whole code.
+        Empty list returns device to single class.
+        """
+        pkt = struct.pack('<BB', packet_header_t.PACKET_H_LOOP_CFG, len(classes))
+        for period_us, first_block, blocks_cnt, wtd_max_skipped in classes:
+            pkt += struct.pack('<IHHB', period_us, first_block, blocks_cnt, wtd_max_skipped)
+        return pkt
+
     def generate_packets(self, manager: Optional[AccessManager] = None) -> List[bytes]:
         """
         Generate all packets in correct order:
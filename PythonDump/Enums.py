@@ -16,6 +16,9 @@ class mem_types_t(IntEnum):
     MEM_I32                          = 4
     MEM_B                            = 5
     MEM_F                            = 6
+    MEM_Q                            = 7   # Q16.16 fixed point, int32 raw value / MEM_Q_ONE
+
+MEM_Q_ONE = 1 << 16
 
 
 
@@ -27,6 +30,7 @@ mem_types_map: dict[mem_types_t, Any] = {
     mem_types_t.MEM_I32: ct.c_int32,
     mem_types_t.MEM_B:   ct.c_bool,
     mem_types_t.MEM_F:   ct.c_float,
+    mem_types_t.MEM_Q:   ct.c_int32,
 }
 
 mem_types_size: dict[mem_types_t, int] = {
@@ -37,6 +41,7 @@ mem_types_size: dict[mem_types_t, int] = {
     mem_types_t.MEM_I32: ct.sizeof(ct.c_int32),
     mem_types_t.MEM_B:   ct.sizeof(ct.c_bool),
     mem_types_t.MEM_F:   ct.sizeof(ct.c_float),
+    mem_types_t.MEM_Q:   ct.sizeof(ct.c_int32),
 }
 
 mem_types_pack_map: dict[mem_types_t, str] = {
@@ -47,6 +52,7 @@ mem_types_pack_map: dict[mem_types_t, str] = {
     mem_types_t.MEM_I32: '<i',
     mem_types_t.MEM_B:   '<?',
     mem_types_t.MEM_F:   '<f',
+    mem_types_t.MEM_Q:   '<i',
 }
 
 mem_types_to_str_map: dict[mem_types_t, str] = {
@@ -57,6 +63,7 @@ mem_types_to_str_map: dict[mem_types_t, str] = {
     mem_types_t.MEM_I32: 'MEM_I32',
     mem_types_t.MEM_B:   'MEM_B',
     mem_types_t.MEM_F:   'MEM_F',
+    mem_types_t.MEM_Q:   'MEM_Q',
 }
 
 
@@ -75,8 +82,12 @@ class packet_header_t(IntEnum):
     PACKET_H_SUBSCRIPTION_INIT       = 0xC0
     PACKET_H_SUBSCRIPTION_ADD        = 0xC1
     PACKET_H_PUBLISH                 = 0xD0
+    PACKET_H_PROFILE                 = 0xD1
+    PACKET_H_LOOP_STATS              = 0xD2
     PACKET_H_ERROR_LOG               = 0xE1
     PACKET_H_STATUS_LOG              = 0xE0
+    PACKET_H_SEQ                     = 0xFD  # transport wrapper: [FD][seq:u16][write], sequenced upload window (emu_rx.h)
+    PACKET_H_FRAMES                  = 0xFE  # transport wrapper: [FE] + n * ([len:u16][packet]), one ACK per write
 
 
 
@@ -107,6 +118,15 @@ class emu_order_t(IntEnum):
     ORD_EMU_RUN_ONCE                 = 0x5000,  # Run one cycle and wait for next order
     ORD_EMU_RUN_WITH_DEBUG           = 0x6000,  # Run with debug (Dump after each cycle)
     ORD_EMU_RUN_ONE_STEP             = 0x7000,  # Run one block / one step (With debug)
+    ORD_EMU_PROFILER_START           = 0x8000,  # Clear and start per block profiler, optional [uint16_t send_every] cycles after order
+    ORD_EMU_PROFILER_STOP            = 0x8001,  # Stop recording, stats are kept
+    ORD_EMU_PROFILER_SEND            = 0x8002,  # Send PACKET_H_PROFILE report now
+    ORD_EMU_LOOP_STATS_GET           = 0x8010,  # Send PACKET_H_LOOP_STATS now, optional [uint16_t send_every] cycles for periodic report (0 = off)
+    ORD_EMU_LOOP_STATS_RESET         = 0x8011,  # Clear loop statistics
+    ORD_EMU_SET_EXEC_MODE            = 0x8020,  # [uint8_t mode] 0 - full pass, 1 - dirty (only blocks with written inputs), applied at loop start
+    ORD_EMU_IMAGE_SAVE               = 0x9000,  # Save verified program (upload since ORD_RESET_ALL) to flash, replayed at boot
+    ORD_EMU_IMAGE_ERASE              = 0x9001,  # Erase saved program, next boot waits for upload
+    ORD_EMU_IMAGE_UPLOAD             = 0x9002,  # [uint32_t offset][image bytes] chunk of program image (FullDump.get_image), complete image replaces program
 
 
 
@@ -262,6 +282,30 @@ OWNER_NAMES = [
     "subscribe_process",
     "subscribe_reset",
     "subscribe_send",
+    "profiler_start",
+    "profiler_send",
+    "loop_stats_send",
+    "sched_set_mode",
+    "sched_build",
+    "code_compile",
+    "partition_worker_init",
+    "partition_build",
+    "loop_parse_cfg",
+    "loop_classes_apply",
+    "logger",
+    "arena_init",
+    "operands_build",
+    "packed_op",
+    "mem_get_span",
+    "emu_image_save",
+    "emu_image_erase",
+    "emu_image_boot",
+    "emu_image_upload",
+    "emu_image_upload_run",
+    "emu_retain_init",
+    "emu_retain_start",
+    "emu_retain_flush",
+    "emu_interface_frames",
 ]
 
 LOG_NAMES = [
@@ -335,4 +379,6 @@ LOG_NAMES = [
     "clock_out_active",
     "clock_out_inactive",
     "to_large_to_sub",
+    "error_logs_dropped",
+    "status_logs_dropped",
 ]
\ No newline at end of file
@@ -9,14 +9,22 @@ Outputs hex packets in correct order for C parser:
 7. Block outputs  
 8. Block data
 9. Loop control orders
+
+or as single program image (emu_image.h) uploaded in ORD_EMU_IMAGE_UPLOAD chunks.
 """
 
 import struct
+import zlib
 from typing import TextIO, List
 
-from Enums import emu_order_t, packet_header_t
+from Enums import emu_order_t, packet_header_t, mem_types_t
 from Code import Code
 
+# Program image, must match emu_image.h
+EMU_IMAGE_MAGIC   = 0x494D5545
+EMU_IMAGE_VERSION = 1
+EMU_IMAGE_HEADER  = struct.Struct('<IHHIII')   # magic, version, types_cnt, records, size, crc
+
 # =============================================================================
 # FULL DUMP CLASS
 # =============================================================================
@@ -187,3 +195,39 @@ class FullDump:
                     include_loop_init=False, include_loop_start=False)
                 for pkt, _ in pkts]
 
+    def get_image(self,
+                  include_loop_init: bool = True,
+                  include_loop_start: bool = True) -> bytes:
+        """
+        Build program image: header + ``[len:u16][packet]`` records of all
+        packets and loop orders, same bytes device keeps in flash.
+        ORD_PARSE_* section markers are left out, device has no handler for them.
+        """
+        records = []
+        for _, pkts, orders in self._collect_sections(include_loop_init,
+                                                      include_loop_start):
+            records += [pkt for pkt, _ in pkts]
+            records += [struct.pack("<H", order.value) for order in orders
+                        if not order.name.startswith("ORD_PARSE_")]
+        body = b"".join(struct.pack("<H", len(rec)) + rec for rec in records)
+        header = EMU_IMAGE_HEADER.pack(EMU_IMAGE_MAGIC, EMU_IMAGE_VERSION,
+                                       len(mem_types_t), len(records),
+                                       len(body), zlib.crc32(body))
+        return header + body
+
+    def write_image(self, writer: TextIO,
+                    max_packet: int = 512,
+                    include_loop_init: bool = True,
+                    include_loop_start: bool = True):
+        """
+        Generate hex dump of ORD_EMU_IMAGE_UPLOAD chunks (``[order:u16][offset:u32][bytes]``,
+        at most *max_packet* bytes each). Sent like any other raw dump.
+        """
+        image = self.get_image(include_loop_init, include_loop_start)
+        order = struct.pack("<H", emu_order_t.ORD_EMU_IMAGE_UPLOAD.value)
+        step = max_packet - len(order) - 4
+        if step < EMU_IMAGE_HEADER.size:
+            raise ValueError(f"max_packet {max_packet} too small for image header")
+        for offset in range(0, len(image), step):
+            chunk = order + struct.pack("<I", offset) + image[offset:offset + step]
+            writer.write(chunk.hex().upper() + "\n")
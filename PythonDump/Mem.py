@@ -9,7 +9,7 @@ import struct
     mem_types_pack_map maps mem_types_t to struct pack format strings
     packet_header_t defines packet header enums
 """
-from Enums import mem_types_t, mem_types_map, mem_types_pack_map, mem_types_size, packet_header_t
+from Enums import mem_types_t, mem_types_map, mem_types_pack_map, mem_types_size, packet_header_t, MEM_Q_ONE
 
 # ============================================================================
 # 1. Enums & Structures
@@ -25,7 +25,9 @@ class instance_head_t(ct.Structure):
     uint16_t type      : 4;  /*mem_types_t type*/
     uint16_t updated   : 1;  /*Updated flag can be used for block output variables*/
     uint16_t can_clear : 1;  /*Can updated flag be cleared*/
-    uint16_t reserved  : 3;  /*padding*/
+    uint16_t packed    : 1;  /*MEM_B array stored 1 bit per element*/
+    uint16_t retain    : 1;  /*value survives power loss (NVS), restored at loop start*/
+    uint16_t reserved  : 1;  /*padding*/
     """
     _pack_ = 1
     _fields_ = [
@@ -34,7 +36,9 @@ class instance_head_t(ct.Structure):
         ("type",          ct.c_uint16, 4),
         ("updated",       ct.c_uint16, 1),
         ("can_clear",     ct.c_uint16, 1),
-        ("reserved",      ct.c_uint16, 3),
+        ("packed",        ct.c_uint16, 1),
+        ("retain",        ct.c_uint16, 1),
+        ("reserved",      ct.c_uint16, 1),
     ]
 
 
@@ -55,7 +59,7 @@ class mem_instance_t:
     #index of this instance in context storage list for its type (must be equal to emulator side)
     my_index: int = 0 
 
-    def __init__(self, ctx: int, type: mem_types_t, dims: Optional[List[int]], data: Any, can_clear: int = 1, alias: str = None, idx: int = 0):
+    def __init__(self, ctx: int, type: mem_types_t, dims: Optional[List[int]], data: Any, can_clear: int = 1, alias: str = None, idx: int = 0, packed: int = 0, retain: int = 0):
         self.head = instance_head_t()
         self.head.context = ctx
         self.head.type = type.value
@@ -63,6 +67,10 @@ class mem_instance_t:
         self.head.updated = 1
         
         safe_dims = dims if dims is not None else []
+        if packed and (type != mem_types_t.MEM_B or not safe_dims):
+            raise ValueError("Only MEM_B arrays can be packed")
+        self.head.packed = packed
+        self.head.retain = retain
         self.head.dims_cnt = len(safe_dims)
         self.dims = [ct.c_uint16(d) for d in safe_dims]
         self.data = data
@@ -94,6 +102,9 @@ class mem_instance_t:
         if not c_type: raise ValueError(f"Unknown Type: {self.head.type}")
 
         values = self.data if isinstance(self.data, list) else [self.data]
+        if m_type == mem_types_t.MEM_Q:
+            # Q16.16 raw value, saturated like emulator does
+            values = [max(-2**31, min(2**31 - 1, round(v * MEM_Q_ONE))) for v in values]
         ArrayType = c_type * len(values)
         return bytes(ArrayType(*values))
 
@@ -121,10 +132,12 @@ class mem_context_t:
         self.storage = {t: [] for t in mem_types_t}
         self.alias_map = {}
 
-    def add(self, type: mem_types_t, alias: str, data: Any = None, dims: Optional[List[int]] = None, can_clear: int = 1):
+    def add(self, type: mem_types_t, alias: str, data: Any = None, dims: Optional[List[int]] = None, can_clear: int = 1, packed: int = 0, retain: int = 0):
         """
         Adds an instance to the context.
         :param alias: Unique string name to refer to this variable later.
+        :param packed: MEM_B array stored 1 bit per element on emulator side (data packets stay 1 byte per element)
+        :param retain: value survives power loss, *data* is used only until first save
         """
         #Calculate the next index for this type
         current_list = self.storage[type]
@@ -142,7 +155,9 @@ class mem_context_t:
             data=data,
             can_clear=can_clear,
             alias=alias,
-            idx=next_idx
+            idx=next_idx,
+            packed=packed,
+            retain=retain
         )
         
         current_list.append(new_inst)
@@ -261,6 +276,10 @@ class mem_context_t:
                     for d in inst.dims:
                         val = d.value if hasattr(d, 'value') else int(d)
                         product *= val
+                    if inst.head.packed:
+                        # same as context_create_instance: word aligned start, whole uint32_t words (MEM_B heap is in bytes)
+                        heap_elements = (heap_elements + 3) & ~3
+                        product = ((product + 31) // 32) * 4
                     heap_elements += product
 
             packet += struct.pack('<IHH', heap_elements, instance_count, total_dims_rank)
@@ -18,11 +18,12 @@ class access_packet_t(ct.LittleEndianStructure):
         uint8_t  is_index_resolved:1;
         uint8_t  dims_cnt   :3;
         uint8_t  idx_type   :3;
-        uint8_t  reserved   :2; 
+        uint8_t  whole_array:1;
+        uint8_t  reserved   :1; 
         uint16_t instance_idx;
     }access_packet;
     
-    Total: 4 bytes
+    Total: 4 bytes (+ [slice_dim:u8][count:u16] after indices when whole_array)
     """
     _pack_ = 1
     _fields_ = [
@@ -33,7 +34,8 @@ class access_packet_t(ct.LittleEndianStructure):
         # Byte 1
         ("dims_cnt",          ct.c_uint8, 3),
         ("idx_type",          ct.c_uint8, 3),
-        ("reserved",          ct.c_uint8, 2),
+        ("whole_array",       ct.c_uint8, 1),
+        ("reserved",          ct.c_uint8, 1),
         # Bytes 2-3
         ("instance_idx",      ct.c_uint16),
     ]
@@ -97,18 +99,36 @@ class Ref:
         Ref("matrix")[10, 5]         # Static array access  
         Ref("matrix")[10][Ref("i")]  # Mixed: static + dynamic index
         Ref("matrix")[Ref("x"), Ref("y")]  # Fully dynamic
+        Ref("buffer")[2:10]          # Span (slice), elements 2..9
+        Ref("matrix")[3, :]          # Span, whole row 3
+        Ref("matrix")[Ref("r"), :]   # Span, row selected at runtime
     """
     
     def __init__(self, alias: str):
         self.alias = alias
         self.indices: List[Tuple[bool, Union[int, 'Ref']]] = []  # (is_static, value)
+        self.slice: Optional[Tuple[int, int]] = None  # (dim, count), count 0 = to end of dim
     
     def __getitem__(self, item) -> 'Ref':
         """Handle [] operator for array indexing."""
         items = item if isinstance(item, tuple) else (item,)
         
         for it in items:
-            if isinstance(it, int):
+            if isinstance(it, slice):
+                # Span along this dim, start is index value of dim
+                if self.slice is not None:
+                    raise ValueError("Only one slice per access")
+                if it.step not in (None, 1):
+                    raise ValueError("Slice step is not supported")
+                start = 0 if it.start is None else it.start
+                if not isinstance(start, int) or not (it.stop is None or isinstance(it.stop, int)):
+                    raise TypeError("Slice bounds have to be int")
+                count = 0 if it.stop is None else it.stop - start
+                if it.stop is not None and count <= 0:
+                    raise ValueError(f"Empty slice {start}:{it.stop}")
+                self.slice = (len(self.indices), count)
+                self.indices.append((True, start))
+            elif isinstance(it, int):
                 # Static index (e.g., [10])
                 self.indices.append((True, it))
             elif isinstance(it, Ref):
@@ -146,6 +166,8 @@ class Ref:
             _, idx_val = self.indices[i]
             if idx_val >= dims[i]:
                 raise IndexError(f"Index {idx_val} out of bounds for dimension {i} (size {dims[i]})")
+            if self.slice is not None and self.slice[0] == i and self.slice[1] and idx_val + self.slice[1] > dims[i]:
+                raise IndexError(f"Slice {idx_val}+{self.slice[1]} out of bounds for dimension {i} (size {dims[i]})")
             flat_index += idx_val * stride
             stride *= dims[i]
         
@@ -185,6 +207,7 @@ class Ref:
             if is_static:
                 idx_type_mask |= (1 << i)
         header.idx_type = idx_type_mask & 0x7
+        header.whole_array = 1 if self.slice is not None else 0
         
         # 5. Convert header to bytes
         blob = bytearray(bytes(header))
@@ -198,12 +221,19 @@ class Ref:
                 # Dynamic: recursive access_packet
                 blob.extend(val.to_bytes(manager))
         
+        # 7. Span: [slice_dim:u8][count:u16]
+        if self.slice is not None:
+            blob.extend(struct.pack('<BH', self.slice[0], self.slice[1]))
+        
         return bytes(blob)
     
     def __repr__(self) -> str:
         idx_str = ""
-        for is_static, val in self.indices:
-            if is_static:
+        for i, (is_static, val) in enumerate(self.indices):
+            if self.slice is not None and self.slice[0] == i:
+                end = "" if self.slice[1] == 0 else str(val + self.slice[1])
+                idx_str += f"[{val}:{end}]"
+            elif is_static:
                 idx_str += f"[{val}]"
             else:
                 idx_str += f"[{val!r}]"
@@ -301,5 +331,6 @@ if __name__ == "__main__":
     print("  Byte 1: [dims_cnt:3][idx_type:3][reserved:2]")
     print("  Bytes 2-3: instance_idx (uint16)")
     print("  Then for each dim: uint16 if static, or recursive packet if dynamic")
+    print("  Span (whole_array bit, byte 1 bit 6): [slice_dim:u8][count:u16] after indices")
     print("=" * 60)
 
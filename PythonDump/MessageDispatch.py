@@ -3,7 +3,7 @@ from enum import IntEnum
 from typing import List, Optional, Callable
 from dataclasses import dataclass
 
-from Enums import mem_types_t, packet_header_t, mem_types_size, mem_types_pack_map, mem_types_map,  mem_types_to_str_map, emu_err_t, OWNER_NAMES, LOG_NAMES
+from Enums import mem_types_t, packet_header_t, block_types_t, mem_types_size, mem_types_pack_map, mem_types_map,  mem_types_to_str_map, MEM_Q_ONE, emu_err_t, OWNER_NAMES, LOG_NAMES
 
 class DisplayMode(IntEnum):
     PRETTY = 0   # nicely formatted, coloured output (default)
@@ -113,6 +113,8 @@ def _parse_publish(payload: bytes) -> list[PublishEntry]:
 
         for i in range(el_cnt):
             val = struct.unpack_from(fmt, payload, pos)[0]
+            if t == mem_types_t.MEM_Q:
+                val /= MEM_Q_ONE
             pos += type_size
             values.append(val)
 
@@ -175,8 +177,8 @@ def _format_publish(entries: list[PublishEntry]) -> str:
 # ═══════════════════════════════════════════════════════════════════
 
 # Packet layout (after 0xE0 header byte):
-#   [time:  u64 LE  8B]  — snapshot time for the whole batch
-#   [cycle: u64 LE  8B]  — snapshot cycle for the whole batch
+#   [time:  u64 LE  8B]  — loop time when entries were logged
+#   [cycle: u64 LE  8B]  — loop cycle when entries were logged (logger starts new packet when cycle changes)
 #   [entry...]           — repeated emu_result_t (no time/cycle field)
 #
 # ESP32-C6 is RISC-V 32-bit (ILP32), struct alignment = 4
@@ -345,6 +347,166 @@ def _format_status_log(entries: List[StatusLogEntry]) -> str:
     return "\n".join(lines)
 
 
+# ═══════════════════════════════════════════════════════════════════
+# PROFILE parser (0xD1)
+# ═══════════════════════════════════════════════════════════════════
+
+# Packet layout (after 0xD1 header byte):
+#   [total_blocks:  u16 LE]  — blocks in whole report (may span many packets)
+#   [first_idx:     u16 LE]  — idx of first entry in this packet
+#   [cnt:           u8    ]  — entries in this packet
+#   [cycles_per_us: u16 LE]  — to convert cycles to µs
+#   [entry...]               — repeated emu_profile_entry_t (__packed)
+#
+# emu_profile_entry_t layout (__packed):
+#   block_idx:  u16, block_type: u8, calls: u32, active: u32,
+#   min_cycles: u32, avg_cycles: u32, max_cycles: u32
+# Total: 23 bytes
+
+PROFILE_PREFIX_FMT  = '<HHBH'
+PROFILE_PREFIX_SIZE = 7
+
+PROFILE_ENTRY_FMT  = '<HBIIIII'
+PROFILE_ENTRY_SIZE = 23
+
+
+@dataclass
+class ProfileEntry:
+    block_idx: int
+    block_type: int
+    calls: int
+    active: int
+    min_us: float
+    avg_us: float
+    max_us: float
+
+
+_profile_pending: dict[int, ProfileEntry] = {}
+
+
+def _parse_profile(payload: bytes) -> Optional[List[ProfileEntry]]:
+    """Parse PROFILE payload (after 0xD1 header byte).
+    Returns full report once all blocks were received, None while waiting for next packets."""
+    if len(payload) < PROFILE_PREFIX_SIZE:
+        return None
+
+    total, first, cnt, cycles_per_us = struct.unpack_from(PROFILE_PREFIX_FMT, payload, 0)
+    cycles_per_us = max(cycles_per_us, 1)
+    pos = PROFILE_PREFIX_SIZE
+
+    if first == 0:
+        _profile_pending.clear()
+
+    for _ in range(cnt):
+        if pos + PROFILE_ENTRY_SIZE > len(payload):
+            break
+        idx, b_type, calls, active, mn, avg, mx = struct.unpack_from(PROFILE_ENTRY_FMT, payload, pos)
+        pos += PROFILE_ENTRY_SIZE
+        _profile_pending[idx] = ProfileEntry(idx, b_type, calls, active,
+                                             mn / cycles_per_us, avg / cycles_per_us, mx / cycles_per_us)
+
+    if first + cnt < total:
+        return None
+
+    entries = [_profile_pending[i] for i in sorted(_profile_pending)]
+    _profile_pending.clear()
+    return entries
+
+
+def _format_profile(entries: List[ProfileEntry], top: int = 20) -> str:
+    """Format PROFILE report as table of hottest blocks (by total time)."""
+    total_us = sum(e.avg_us * e.calls for e in entries) or 1.0
+    ranked = sorted(entries, key=lambda e: e.avg_us * e.calls, reverse=True)
+
+    lines = []
+    lines.append(f"{_C.MAGENTA}{_C.BOLD}╔══ PROFILE ═══════════════════════════════════════╗{_C.RESET}")
+    lines.append(f"  {_C.DIM}{'#':>3} {'idx':>5} {'type':<12} {'calls':>9} {'act%':>6} "
+                 f"{'min µs':>9} {'avg µs':>9} {'max µs':>9} {'share':>6}{_C.RESET}")
+
+    for rank, e in enumerate(ranked[:top], 1):
+        try:
+            type_name = block_types_t(e.block_type).name.replace("BLOCK_", "")
+        except ValueError:
+            type_name = f"type({e.block_type})"
+        act = (100.0 * e.active / e.calls) if e.calls else 0.0
+        share = 100.0 * e.avg_us * e.calls / total_us
+        color = _C.RED if share >= 25 else (_C.YELLOW if share >= 10 else _C.WHITE)
+        lines.append(
+            f"  {rank:>3} {e.block_idx:>5} {_C.BLUE}{type_name:<12}{_C.RESET} {e.calls:>9} {act:>5.1f}% "
+            f"{e.min_us:>9.2f} {e.avg_us:>9.2f} {e.max_us:>9.2f} {color}{share:>5.1f}%{_C.RESET}"
+        )
+
+    if len(ranked) > top:
+        lines.append(f"  {_C.DIM}... {len(ranked) - top} more blocks{_C.RESET}")
+    lines.append(f"{_C.MAGENTA}╚══════════════════════════════════════════════════╝{_C.RESET}")
+    return "\n".join(lines)
+
+
+# ═══════════════════════════════════════════════════════════════════
+# LOOP_STATS parser (0xD2)
+# ═══════════════════════════════════════════════════════════════════
+
+# Packet layout (after 0xD2 header byte):
+#   [cycles:  u32 LE]  — cycles measured since loop init / reset
+#   [skipped: u32 LE]  — cycles skipped by watchdog
+#   [period:  u32 LE]  — loop period in us
+#   3 × [avg:u32][p50:u32][p99:u32][max:u32]  — wake, exec, tail (us)
+
+LOOP_STATS_PREFIX_FMT  = '<III'
+LOOP_STATS_PREFIX_SIZE = 12
+LOOP_METRIC_FMT  = '<IIII'
+LOOP_METRIC_SIZE = 16
+
+
+@dataclass
+class LoopMetric:
+    avg_us: int
+    p50_us: int
+    p99_us: int
+    max_us: int
+
+
+@dataclass
+class LoopStats:
+    cycles: int
+    skipped: int
+    period_us: int
+    wake: LoopMetric     # timer tick → loop task running
+    exec: LoopMetric     # emu_execute_code
+    tail: LoopMetric     # subscribe / logger / profiler after execution
+
+
+def _parse_loop_stats(payload: bytes) -> Optional[LoopStats]:
+    """Parse LOOP_STATS payload (after 0xD2 header byte)."""
+    if len(payload) < LOOP_STATS_PREFIX_SIZE + 3 * LOOP_METRIC_SIZE:
+        return None
+    cycles, skipped, period = struct.unpack_from(LOOP_STATS_PREFIX_FMT, payload, 0)
+    pos = LOOP_STATS_PREFIX_SIZE
+    metrics = []
+    for _ in range(3):
+        metrics.append(LoopMetric(*struct.unpack_from(LOOP_METRIC_FMT, payload, pos)))
+        pos += LOOP_METRIC_SIZE
+    return LoopStats(cycles, skipped, period, *metrics)
+
+
+def _format_loop_stats(s: LoopStats) -> str:
+    """Format LOOP_STATS for display, budget use = (exec+tail) / period."""
+    lines = []
+    lines.append(f"{_C.CYAN}{_C.BOLD}╔══ LOOP STATS ════════════════════════════════════╗{_C.RESET}")
+    skip_col = _C.RED if s.skipped else _C.DIM
+    lines.append(f"  cycles={_C.WHITE}{s.cycles}{_C.RESET}  period={s.period_us}us  "
+                 f"{skip_col}skipped={s.skipped}{_C.RESET}")
+    lines.append(f"  {_C.DIM}{'':<6} {'avg':>8} {'p50':>8} {'p99':>8} {'max':>8}  (us){_C.RESET}")
+    for name, m in (("wake", s.wake), ("exec", s.exec), ("tail", s.tail)):
+        lines.append(f"  {_C.BLUE}{name:<6}{_C.RESET} {m.avg_us:>8} {m.p50_us:>8} {m.p99_us:>8} {m.max_us:>8}")
+    if s.period_us:
+        worst = 100.0 * (s.exec.max_us + s.tail.max_us) / s.period_us
+        color = _C.RED if worst >= 100 else (_C.YELLOW if worst >= 70 else _C.GREEN)
+        lines.append(f"  worst cycle uses {color}{worst:.1f}%{_C.RESET} of period")
+    lines.append(f"{_C.CYAN}╚══════════════════════════════════════════════════╝{_C.RESET}")
+    return "\n".join(lines)
+
+
 _subscription_registry: Optional[List[int]] = None    # el_cnt per subscription entry
 _alias_registry: Optional[List[str]] = None           # alias per subscription entry
 
@@ -427,6 +589,8 @@ _user_callbacks: dict[int, List[Callable]] = {
     packet_header_t.PACKET_H_PUBLISH:    [],
     packet_header_t.PACKET_H_ERROR_LOG:  [],
     packet_header_t.PACKET_H_STATUS_LOG: [],
+    packet_header_t.PACKET_H_PROFILE:    [],
+    packet_header_t.PACKET_H_LOOP_STATS: [],
 }
 
 
@@ -445,6 +609,16 @@ def on_status(callback: Callable[[List[StatusLogEntry]], None]) -> None:
     _user_callbacks[packet_header_t.PACKET_H_STATUS_LOG].append(callback)
 
 
+def on_profile(callback: Callable[[List[ProfileEntry]], None]) -> None:
+    """Register a callback for PROFILE (0xD1) reports. Receives list of ProfileEntry (all blocks, by idx)."""
+    _user_callbacks[packet_header_t.PACKET_H_PROFILE].append(callback)
+
+
+def on_loop_stats(callback: Callable[[LoopStats], None]) -> None:
+    """Register a callback for LOOP_STATS (0xD2) packets. Receives LoopStats."""
+    _user_callbacks[packet_header_t.PACKET_H_LOOP_STATS].append(callback)
+
+
 def dispatch_message(data: bytearray, quiet: bool = False) -> None:
     if not data:
         return
@@ -459,6 +633,8 @@ def dispatch_message(data: bytearray, quiet: bool = False) -> None:
             packet_header_t.PACKET_H_PUBLISH:    "PUB",
             packet_header_t.PACKET_H_ERROR_LOG:  "ERR",
             packet_header_t.PACKET_H_STATUS_LOG: "STS",
+            packet_header_t.PACKET_H_PROFILE:    "PRF",
+            packet_header_t.PACKET_H_LOOP_STATS: "LPS",
         }
         tag = _HEADER_TAG.get(header, f"0x{header:02X}")
         if not quiet:
@@ -476,6 +652,16 @@ def dispatch_message(data: bytearray, quiet: bool = False) -> None:
             entries = _parse_status_log(payload)
             for cb in _user_callbacks[packet_header_t.PACKET_H_STATUS_LOG]:
                 cb(entries)
+        elif header == packet_header_t.PACKET_H_PROFILE:
+            entries = _parse_profile(payload)
+            if entries is not None:
+                for cb in _user_callbacks[packet_header_t.PACKET_H_PROFILE]:
+                    cb(entries)
+        elif header == packet_header_t.PACKET_H_LOOP_STATS:
+            stats = _parse_loop_stats(payload)
+            if stats is not None:
+                for cb in _user_callbacks[packet_header_t.PACKET_H_LOOP_STATS]:
+                    cb(stats)
         return
 
     # ── PRETTY mode (default) ───────────────────────────────────
@@ -500,6 +686,24 @@ def dispatch_message(data: bytearray, quiet: bool = False) -> None:
         for cb in _user_callbacks[packet_header_t.PACKET_H_STATUS_LOG]:
             cb(entries)
 
+    elif header == packet_header_t.PACKET_H_PROFILE:
+        entries = _parse_profile(payload)
+        if entries is None:
+            return
+        if not quiet:
+            print(_format_profile(entries))
+        for cb in _user_callbacks[packet_header_t.PACKET_H_PROFILE]:
+            cb(entries)
+
+    elif header == packet_header_t.PACKET_H_LOOP_STATS:
+        stats = _parse_loop_stats(payload)
+        if stats is None:
+            return
+        if not quiet:
+            print(_format_loop_stats(stats))
+        for cb in _user_callbacks[packet_header_t.PACKET_H_LOOP_STATS]:
+            cb(stats)
+
 def notification_handler(sender, data: bytearray) -> None:
 
     dispatch_message(data)
@@ -2,8 +2,10 @@ import asyncio
 import sys
 import os
 import re  # Dodano do obsługi regex
+import struct
 from bleak import BleakScanner, BleakClient, BleakError
 from MessageDispatch import notification_handler, set_display_mode, DisplayMode
+from Enums import packet_header_t
 
 set_display_mode(DisplayMode.PRETTY)
 
@@ -16,11 +18,63 @@ UUID_READ  = "00000000-0000-0000-0000-000000000002"
 
 CMD_FILE = "test_dump.txt"
 
+# Pack many packets into one write: [FE] + n * ([len:u16][packet]), device ACKs whole write once
+SEND_FRAMED = True
+
+# Keep this many sequenced writes [FD][seq:u16][write] in flight (device receive ring), 0 = stop-and-wait
+SEND_WINDOW = 8
+ACK_TIMEOUT = 5.0
+
+# Device replies on emu_in (emu_rx.h)
+RX_READY = 0x00  # plain write processed
+RX_ACK   = 0x01  # [next:u16] all sequenced writes before next processed
+RX_NACK  = 0x02  # [seq:u16] sequenced write missing, later ones buffered
+RX_BUSY  = 0x03  # [next:u16] plain write dropped, sequenced writes still wait for processing
+BUSY_RETRY = 0.05
+
+
+class SendWindow:
+    """Sender side of sequenced upload, write n goes with seq n % 0x10000."""
+
+    def __init__(self, size):
+        self.size = size
+        self.base = 0       # first write not acknowledged
+        self.sent = 0       # next write to send
+        self.resend = []    # writes device reported missing
+        self.event = asyncio.Event()
+
+    def _index(self, seq, first, last):
+        for n in range(first, last + 1):
+            if n & 0xFFFF == seq:
+                return n
+        return None
+
+    def on_reply(self, data):
+        kind, seq = data[0], int.from_bytes(data[1:3], "little")
+        if kind == RX_ACK:
+            n = self._index(seq, self.base, self.sent)
+            if n is not None:
+                self.base = n
+        elif kind == RX_NACK:
+            n = self._index(seq, self.base, self.sent - 1)
+            if n is not None and n not in self.resend:
+                self.resend.append(n)
+        self.event.set()
+
+
 # Created inside main() so it's bound to the running event loop
 _ready_event: asyncio.Event = None  # type: ignore
+_window: SendWindow = None  # type: ignore
+_busy = False  # last plain write dropped by device, it has to be sent again
 
 async def _ready_ack_handler(sender, data: bytearray):
-    """Called when device sends the 0x00 ACK on emu_in characteristic."""
+    """Called when device replies on emu_in characteristic: 0x00 ready, 0x03 busy, ACK / NACK of sequenced writes."""
+    global _busy
+    if len(data) >= 3 and data[0] in (RX_ACK, RX_NACK):
+        if _window:
+            _window.on_reply(data)
+        return
+    _busy = len(data) >= 1 and data[0] == RX_BUSY
     _ready_event.set()
     
 async def get_characteristic_or_fail(client, uuid):
@@ -49,20 +103,32 @@ async def get_characteristic_or_fail(client, uuid):
     raise BleakError(f"Characteristic {uuid} not found")
 
 
-async def send_file(client, write_char):
-    global _ready_event
-    if not os.path.exists(CMD_FILE):
-        print(f"File {CMD_FILE} not found.")
-        return
-
-    print(f"Sending commands from {CMD_FILE}...")
-
-    with open(CMD_FILE, "r") as f:
+def pack_frames(packets, max_len):
+    """Group packets into PACKET_H_FRAMES writes of at most max_len bytes, packet that does not fit alone goes unwrapped."""
+    writes = []
+    frame = b""
+    for data in packets:
+        rec = struct.pack("<H", len(data)) + data
+        if frame and len(frame) + len(rec) > max_len:
+            writes.append(frame)
+            frame = b""
+        if 1 + len(rec) > max_len:
+            writes.append(data)
+            continue
+        if not frame:
+            frame = bytes([packet_header_t.PACKET_H_FRAMES.value])
+        frame += rec
+    if frame:
+        writes.append(frame)
+    return writes
+
+
+def read_packets(path):
+    """Hex packets from command file, #...# comments and whitespace removed."""
+    packets = []
+    with open(path, "r") as f:
         lines = f.readlines()
 
-    # Prime the event so the first packet is sent immediately
-    _ready_event.set()
-
     for i, line in enumerate(lines, start=1):
         # Strip whitespace first
         stripped = line.strip()
@@ -81,23 +147,95 @@ async def send_file(client, write_char):
             continue
 
         try:
-            data = bytes.fromhex(clean_line)
+            packets.append(bytes.fromhex(clean_line))
         except ValueError:
             print(f"Invalid hex string on line {i}: {clean_line}")
-            continue
+    return packets
+
+
+async def send_file(client, write_char):
+    global _ready_event
+    if not os.path.exists(CMD_FILE):
+        print(f"File {CMD_FILE} not found.")
+        return
+
+    print(f"Sending commands from {CMD_FILE}...")
+
+    packets = read_packets(CMD_FILE)
+    # ATT write payload is MTU - 3, sequenced write needs 3 more bytes
+    max_len = client.mtu_size - 3 - (3 if SEND_WINDOW else 0)
+    writes = pack_frames(packets, max_len) if SEND_FRAMED else packets
+    print(f"{len(packets)} packets in {len(writes)} writes")
+    if not writes:
+        return
+
+    if SEND_WINDOW:
+        await send_windowed(client, write_char, writes, SEND_WINDOW)
+    else:
+        await send_stop_and_wait(client, write_char, writes)
 
+
+async def send_stop_and_wait(client, write_char, writes):
+    global _busy
+    for i, data in enumerate(writes, start=1):
         try:
-            try:
-                await asyncio.wait_for(_ready_event.wait(), timeout=5.0)
-            except asyncio.TimeoutError:
-                print(f"Warning: ACK timeout for message {i}, sending anyway")
-            _ready_event.clear()
-            await client.write_gatt_char(write_char, data, response=False)
-            print(f"Message {i} sent: {data.hex().upper()}")
+            while True:
+                _ready_event.clear()
+                _busy = False
+                await client.write_gatt_char(write_char, data, response=False)
+                print(f"Message {i} sent: {data.hex().upper()}")
+                try:
+                    await asyncio.wait_for(_ready_event.wait(), timeout=ACK_TIMEOUT)
+                except asyncio.TimeoutError:
+                    print(f"Warning: ACK timeout for message {i}, sending next anyway")
+                    _ready_event.set()
+                    break
+                if not _busy:
+                    break
+                # device dropped write, sequenced writes in flight finish first
+                print(f"Device busy, message {i} sent again")
+                await asyncio.sleep(BUSY_RETRY)
         except Exception as e:
             print(f"Failed to send message {i}: {e}")
 
 
+async def send_windowed(client, write_char, writes, size):
+    """First write goes plain (device starts sequenced stream at 0), rest with up to size writes in flight."""
+    global _window
+    # returns after ready byte of first write
+    await send_stop_and_wait(client, write_char, writes[:1])
+
+    seq_writes = [struct.pack("<BH", packet_header_t.PACKET_H_SEQ.value, n & 0xFFFF) + data
+                  for n, data in enumerate(writes[1:])]
+    win = _window = SendWindow(size)
+    resent = 0
+    try:
+        while win.base < len(seq_writes):
+            win.event.clear()
+            if win.resend:
+                n = win.resend.pop(0)
+                if n >= win.base:
+                    await client.write_gatt_char(write_char, seq_writes[n], response=False)
+                    resent += 1
+                continue
+            if win.sent < len(seq_writes) and win.sent - win.base < size:
+                await client.write_gatt_char(write_char, seq_writes[win.sent], response=False)
+                win.sent += 1
+                continue
+            try:
+                await asyncio.wait_for(win.event.wait(), timeout=ACK_TIMEOUT)
+            except asyncio.TimeoutError:
+                # oldest write or its ACK lost, device ACKs again when it has it already
+                print(f"Warning: ACK timeout for write {win.base}, resending")
+                await client.write_gatt_char(write_char, seq_writes[win.base], response=False)
+                resent += 1
+    except Exception as e:
+        print(f"Failed to send write {win.base}: {e}")
+    finally:
+        _window = None
+    print(f"{len(seq_writes) + 1} writes sent, window {size}, {resent} resent")
+
+
 async def main():
     global _ready_event
     _ready_event = asyncio.Event()
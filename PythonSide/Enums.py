@@ -16,6 +16,9 @@ class mem_types_t(IntEnum):
     MEM_I32                          = 4
     MEM_B                            = 5
     MEM_F                            = 6
+    MEM_Q                            = 7   # Q16.16 fixed point, int32 raw value / MEM_Q_ONE
+
+MEM_Q_ONE = 1 << 16
 
 
 
@@ -27,6 +30,7 @@ mem_types_map: dict[mem_types_t, Any] = {
     mem_types_t.MEM_I32: ct.c_int32,
     mem_types_t.MEM_B:   ct.c_bool,
     mem_types_t.MEM_F:   ct.c_float,
+    mem_types_t.MEM_Q:   ct.c_int32,
 }
 
 mem_types_size: dict[mem_types_t, int] = {
@@ -37,6 +41,7 @@ mem_types_size: dict[mem_types_t, int] = {
     mem_types_t.MEM_I32: ct.sizeof(ct.c_int32),
     mem_types_t.MEM_B:   ct.sizeof(ct.c_bool),
     mem_types_t.MEM_F:   ct.sizeof(ct.c_float),
+    mem_types_t.MEM_Q:   ct.sizeof(ct.c_int32),
 }
 
 mem_types_pack_map: dict[mem_types_t, str] = {
@@ -47,6 +52,7 @@ mem_types_pack_map: dict[mem_types_t, str] = {
     mem_types_t.MEM_I32: '<i',
     mem_types_t.MEM_B:   '<?',
     mem_types_t.MEM_F:   '<f',
+    mem_types_t.MEM_Q:   '<i',
 }
 
 
@@ -0,0 +1,1012 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+#include <math.h>
+#include "esp_log.h"
+#include "emu_body.h"
+#include "emu_parse.h"
+#include "emu_blocks.h"
+#include "emu_variables.h"
+#include "emu_variables_acces.h"
+#include "emu_packed.h"
+#include "emu_partition.h"
+#include "emu_sched.h"
+#include "emu_interface.h"
+#include "emu_buffs.h"
+#include "emu_rx.h"
+#include "emu_loop.h"
+#include "emu_retain.h"
+#include "emu_image.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "order_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char* TAG = __FILE_NAME__;
+
+/******************************************************************************************************************************
+ * Host benchmark for emu_execute_code
+ *
+ * Each program is generated as real parse packets and goes through emu_parse_manager, so it is built exactly
+ * as one uploaded via BLE. Memory layout:
+ *   ctx 0 (user):   MEM_B EN=true, MEM_F X, MEM_F Y, MEM_F target for every SET block  (can_clear = 0)
+ *   ctx 1 (blocks): outputs of every block, one scalar per output                        (can_clear = 1)
+ * Every block is enabled by EN from ctx 0, shape only decides where value inputs come from:
+ *   chain: in A = block i-1, in B = Y
+ *   dag:   in A = block i-1, in B = block i/2 (fan-in 2, fan-out up to 3)
+ * FOR programs are groups of [FOR + 3 MATH children], FOR runs children 4 times per cycle.
+ * IDLE is MATH chain where EN of block i is ENO of block i-1 and block 0 gets ENO of last one, nothing ever starts
+ * (worst case for full pass, every block is visited and returns RET_OK_INACTIVE).
+ * Every case runs in full and dirty execution mode (emu_sched.h).
+ *
+ * Loopback upload: same packets go through emu_interface_task like BLE writes (claimed in receive ring, task notified,
+ * replies through emu_rx notify callback). Program is sent one packet per write, framed (PACKET_H_FRAMES, many packets
+ * per MTU sized write) and framed with sequence numbers (EMU_IN_MSG_SLOTS writes in flight), all of them have to build
+ * same program as direct emu_parse_manager calls.
+ *****************************************************************************************************************************/
+
+#ifndef BENCH_MIN_TIME_NS
+#define BENCH_MIN_TIME_NS   200000000ULL /*run each case at least this long*/
+#endif
+#ifndef BENCH_WARMUP_CYCLES
+#define BENCH_WARMUP_CYCLES 5
+#endif
+#ifndef BENCH_ARENA_SIZE
+#define BENCH_ARENA_SIZE    (16 * 1024 * 1024) /*program arena, 10000 blocks case needs few MB on host*/
+#endif
+
+#define BENCH_CTX_USER   0
+#define BENCH_CTX_BLOCKS 1
+#define BENCH_INST_PER_PKT 100
+
+#define BENCH_LOOP_MTU     517  /*preferred MTU of gap.c*/
+#define BENCH_LOOP_WRITE   (BENCH_LOOP_MTU - 3)
+#define BENCH_LOOP_BLOCKS  1000
+#define BENCH_LOOP_CYCLES  10   /*cycles run before state is compared*/
+#ifndef BENCH_LOOP_RTT_US
+#define BENCH_IMAGE_CHUNK  251  /*odd, every upload chunk after first starts at odd offset*/
+#define BENCH_LOOP_RTT_US  7500 /*write to ACK over BLE, one connection interval of gap.c params*/
+#endif
+
+/*-------------------------------HEAP COUNTING (-Wl,--wrap)---------------------------------------- */
+
+static volatile uint32_t bench_alloc_cnt;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size){bench_alloc_cnt++; return __real_malloc(size);}
+void *__wrap_calloc(size_t n, size_t size){bench_alloc_cnt++; return __real_calloc(n, size);}
+void *__wrap_realloc(void *ptr, size_t size){bench_alloc_cnt++; return __real_realloc(ptr, size);}
+
+/*-------------------------------PROGRAM PLAN------------------------------------------------------ */
+
+typedef enum{
+    BENCH_PROG_MATH,
+    BENCH_PROG_LOGIC,
+    BENCH_PROG_SET,
+    BENCH_PROG_FOR,
+    BENCH_PROG_TIMER,
+    BENCH_PROG_MIXED,
+    BENCH_PROG_IDLE,
+    BENCH_PROG_CNT,
+}bench_prog_t;
+
+typedef enum{
+    BENCH_SHAPE_CHAIN,
+    BENCH_SHAPE_DAG,
+    BENCH_SHAPE_CNT,
+}bench_shape_t;
+
+static const char* BENCH_PROG_NAMES[BENCH_PROG_CNT] = {"MATH", "LOGIC", "SET", "FOR", "TIMER", "MIXED", "IDLE"};
+static const char* BENCH_SHAPE_NAMES[BENCH_SHAPE_CNT] = {"chain", "dag"};
+static const uint16_t BENCH_SIZES[] = {10, 100, 1000, 10000};
+static const char* BENCH_MODE_NAMES[] = {"full", "dirty"};
+
+/*Reference to scalar instance*/
+typedef struct{
+    uint8_t ctx;
+    uint8_t type;
+    uint16_t inst;
+}bench_ref_t;
+
+typedef struct{
+    uint8_t type;
+    uint8_t in_cnt;
+    uint8_t q_cnt;
+    uint16_t mask;
+    uint16_t chain_len;     /*FOR only*/
+    bench_ref_t in[4];
+    bench_ref_t q[2];
+    bench_ref_t value;      /*what next blocks read from this one*/
+}bench_block_t;
+
+typedef struct{
+    bench_block_t *blocks;
+    uint16_t cnt;
+    uint16_t inst_cnt[2][MEM_TYPES_COUNT];
+    uint16_t refs;
+    bench_ref_t en, x, y;
+    bench_ref_t retained;   /*instance sent with retain bit (emu_retain.h)*/
+    bool has_retained;
+}bench_plan_t;
+
+static bench_ref_t _plan_var(bench_plan_t *plan, uint8_t ctx, uint8_t type){
+    bench_ref_t ref = {.ctx = ctx, .type = type, .inst = plan->inst_cnt[ctx][type]++};
+    return ref;
+}
+
+static uint8_t _pick_type(bench_prog_t prog, uint16_t i){
+    switch(prog){
+        case BENCH_PROG_MATH:
+        case BENCH_PROG_IDLE:  return BLOCK_MATH;
+        case BENCH_PROG_LOGIC: return BLOCK_LOGIC;
+        case BENCH_PROG_SET:   return BLOCK_SET;
+        case BENCH_PROG_TIMER: return BLOCK_TIMER;
+        case BENCH_PROG_FOR:   return (i % 4 == 0) ? BLOCK_FOR : BLOCK_MATH;
+        default: {
+            static const uint8_t mix[] = {BLOCK_MATH, BLOCK_LOGIC, BLOCK_SET, BLOCK_TIMER};
+            return mix[i % 4];
+        }
+    }
+}
+
+static void _plan_build(bench_plan_t *plan, bench_prog_t prog, bench_shape_t shape, uint16_t cnt){
+    memset(plan, 0, sizeof(*plan));
+    plan->cnt = cnt;
+    plan->blocks = calloc(cnt, sizeof(bench_block_t));
+    plan->en = _plan_var(plan, BENCH_CTX_USER, MEM_B);
+    plan->x  = _plan_var(plan, BENCH_CTX_USER, MEM_F);
+    plan->y  = _plan_var(plan, BENCH_CTX_USER, MEM_F);
+    //IDLE: ENO of last block, allocated first so block 0 can use it
+    bench_ref_t gate = (prog == BENCH_PROG_IDLE) ? _plan_var(plan, BENCH_CTX_BLOCKS, MEM_B) : plan->en;
+
+    for(uint16_t i = 0; i < cnt; i++){
+        bench_block_t *b = &plan->blocks[i];
+        bench_ref_t a = (i > 0) ? plan->blocks[i-1].value : plan->x;
+        bench_ref_t c = (shape == BENCH_SHAPE_DAG && i > 0) ? plan->blocks[i/2].value : plan->y;
+        b->type = _pick_type(prog, i);
+        b->in[0] = plan->en;
+
+        switch(b->type){
+            case BLOCK_MATH:
+            case BLOCK_LOGIC:
+                b->in_cnt = 3; b->mask = 0x7;
+                b->in[1] = a; b->in[2] = c;
+                b->q_cnt = 2;
+                b->q[0] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_B);
+                b->q[1] = _plan_var(plan, BENCH_CTX_BLOCKS, (b->type == BLOCK_MATH) ? MEM_F : MEM_B);
+                b->value = b->q[1];
+                if(prog == BENCH_PROG_IDLE){
+                    b->in[0] = (i > 0) ? plan->blocks[i-1].q[0] : gate;
+                    if(i == cnt - 1){plan->inst_cnt[BENCH_CTX_BLOCKS][MEM_B]--; b->q[0] = gate;}
+                }
+                break;
+            case BLOCK_SET:
+                b->in_cnt = 3; b->mask = 0x7;
+                b->in[1] = (shape == BENCH_SHAPE_DAG) ? c : a;
+                b->in[2] = _plan_var(plan, BENCH_CTX_USER, MEM_F);
+                b->q_cnt = 0;
+                b->value = b->in[2];
+                break;
+            case BLOCK_TIMER:
+                b->in_cnt = 2; b->mask = 0x3;
+                b->in[1] = (shape == BENCH_SHAPE_DAG) ? c : a;
+                b->q_cnt = 2;
+                b->q[0] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_B);
+                b->q[1] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_F);
+                b->value = b->q[1];
+                break;
+            case BLOCK_FOR:
+                b->in_cnt = 4; b->mask = 0x1;
+                b->chain_len = (cnt - 1 - i < 3) ? (cnt - 1 - i) : 3;
+                b->q_cnt = 2;
+                b->q[0] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_B);
+                b->q[1] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_F);
+                b->value = b->q[1];
+                break;
+        }
+        plan->refs += __builtin_popcount(b->mask) + b->q_cnt;
+    }
+}
+
+/*-------------------------------PACKET BUILDER---------------------------------------------------- */
+
+typedef struct{
+    uint8_t data[512];
+    uint16_t len;
+}bench_pkt_t;
+
+static void _put_u8(bench_pkt_t *p, uint8_t v){p->data[p->len++] = v;}
+static void _put_u16(bench_pkt_t *p, uint16_t v){memcpy(&p->data[p->len], &v, 2); p->len += 2;}
+static void _put_u32(bench_pkt_t *p, uint32_t v){memcpy(&p->data[p->len], &v, 4); p->len += 4;}
+static void _put_f(bench_pkt_t *p, float v){memcpy(&p->data[p->len], &v, 4); p->len += 4;}
+
+static void _put_access(bench_pkt_t *p, bench_ref_t ref){
+    _put_u8(p, (ref.type & 0x0F) | ((ref.ctx & 0x07) << 4));
+    _put_u8(p, 0); /*scalar: dims_cnt = 0*/
+    _put_u16(p, ref.inst);
+}
+
+static void _pkt_start(bench_pkt_t *p, packet_header_t header){
+    p->len = 0;
+    _put_u8(p, header);
+}
+
+/*Packets go to interface task instead of parser (loopback upload), NULL = direct emu_parse_manager*/
+typedef struct{
+    bool (*send)(const uint8_t *data, uint16_t len);
+    bool (*flush)(void); /*everything sent is processed when it returns*/
+}bench_sink_t;
+
+static const bench_sink_t *pkt_sink = NULL;
+static uint32_t pkt_cnt = 0;
+
+static bool _pkt_flush(void){
+    return pkt_sink ? pkt_sink->flush() : true;
+}
+
+static bool _pkt_send(bench_pkt_t *p, emu_code_handle_t code){
+    pkt_cnt++;
+    if(pkt_sink){return pkt_sink->send(p->data, p->len);}
+    msg_packet_t msg = {.data = p->data, .len = p->len};
+    emu_result_t res = emu_parse_manager(&msg, 0, code, NULL);
+    if(res.code != EMU_OK){
+        ESP_LOGE(TAG, "Packet 0x%02X rejected: %s", p->data[0], EMU_ERR_TO_STR(res.code));
+        return false;
+    }
+    return true;
+}
+
+static bool _emit_context(bench_plan_t *plan, uint8_t ctx, emu_code_handle_t code){
+    bench_pkt_t p;
+    _pkt_start(&p, PACKET_H_CONTEXT_CFG);
+    _put_u8(&p, ctx);
+    for(uint8_t t = 0; t < MEM_TYPES_COUNT; t++){
+        _put_u32(&p, plan->inst_cnt[ctx][t]);
+        _put_u16(&p, plan->inst_cnt[ctx][t]);
+        _put_u16(&p, 0);
+    }
+    if(!_pkt_send(&p, code)){return false;}
+
+    //instances packets, order of packets gives instance index (per type)
+    for(uint8_t t = 0; t < MEM_TYPES_COUNT; t++){
+        uint16_t left = plan->inst_cnt[ctx][t];
+        while(left){
+            uint16_t n = (left > BENCH_INST_PER_PKT) ? BENCH_INST_PER_PKT : left;
+            _pkt_start(&p, PACKET_H_INSTANCE);
+            for(uint16_t k = 0; k < n; k++){
+                uint16_t inst = plan->inst_cnt[ctx][t] - left + k;
+                bool retain = plan->has_retained && plan->retained.ctx == ctx && plan->retained.type == t && plan->retained.inst == inst;
+                _put_u16(&p, (ctx & 0x07) | ((uint16_t)t << 7) | ((ctx == BENCH_CTX_BLOCKS) << 12) | ((uint16_t)retain << 14));
+            }
+            if(!_pkt_send(&p, code)){return false;}
+            left -= n;
+        }
+    }
+    return true;
+}
+
+static bool _emit_block(bench_block_t *b, uint16_t idx, emu_code_handle_t code){
+    bench_pkt_t p;
+    _pkt_start(&p, PACKET_H_BLOCK_HEADER);
+    _put_u16(&p, idx);
+    _put_u16(&p, b->mask);
+    _put_u8(&p, b->type);
+    _put_u8(&p, b->in_cnt);
+    _put_u8(&p, b->q_cnt);
+    if(!_pkt_send(&p, code)){return false;}
+
+    for(uint8_t i = 0; i < b->in_cnt; i++){
+        if(!((b->mask >> i) & 1)){continue;}
+        _pkt_start(&p, PACKET_H_BLOCK_INPUTS);
+        _put_u16(&p, idx); _put_u8(&p, i); _put_access(&p, b->in[i]);
+        if(!_pkt_send(&p, code)){return false;}
+    }
+    for(uint8_t q = 0; q < b->q_cnt; q++){
+        _pkt_start(&p, PACKET_H_BLOCK_OUTPUTS);
+        _put_u16(&p, idx); _put_u8(&p, q); _put_access(&p, b->q[q]);
+        if(!_pkt_send(&p, code)){return false;}
+    }
+
+    switch(b->type){
+        case BLOCK_MATH:
+            //(A + B) * 0.5, stays bounded along chains
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_CONSTANTS);
+            _put_u8(&p, 1); _put_f(&p, 0.5f);
+            if(!_pkt_send(&p, code)){return false;}
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_INSTRUCTIONS);
+            _put_u8(&p, 5);
+            _put_u8(&p, 0x00); _put_u8(&p, 1);  /*VAR A*/
+            _put_u8(&p, 0x00); _put_u8(&p, 2);  /*VAR B*/
+            _put_u8(&p, 0x02); _put_u8(&p, 0);  /*ADD*/
+            _put_u8(&p, 0x01); _put_u8(&p, 0);  /*CONST 0.5*/
+            _put_u8(&p, 0x03); _put_u8(&p, 0);  /*MUL*/
+            return _pkt_send(&p, code);
+        case BLOCK_LOGIC:
+            //A > B
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_INSTRUCTIONS);
+            _put_u8(&p, 3);
+            _put_u8(&p, 0x00); _put_u8(&p, 1);
+            _put_u8(&p, 0x00); _put_u8(&p, 2);
+            _put_u8(&p, 0x10); _put_u8(&p, 0);
+            return _pkt_send(&p, code);
+        case BLOCK_TIMER:
+            //TON, pt from input
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_CFG);
+            _put_u8(&p, 0x01); _put_u32(&p, 0);
+            return _pkt_send(&p, code);
+        case BLOCK_FOR:
+            //for(i = 0; i < 4; i += 1)
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_CONSTANTS);
+            _put_f(&p, 0.0f); _put_f(&p, 4.0f); _put_f(&p, 1.0f);
+            if(!_pkt_send(&p, code)){return false;}
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_CFG);
+            _put_u16(&p, b->chain_len); _put_u8(&p, 0x02); _put_u8(&p, 0x01);
+            return _pkt_send(&p, code);
+        case BLOCK_COUNTER:
+            //count every cycle while CTU (EN) is true, from 0 without limits
+            _pkt_start(&p, PACKET_H_BLOCK_DATA);
+            _put_u16(&p, idx); _put_u8(&p, b->type); _put_u8(&p, BLOCK_PKT_CFG);
+            _put_u8(&p, 0x01); _put_f(&p, 0.0f); _put_f(&p, 1.0f); _put_f(&p, INFINITY); _put_f(&p, -INFINITY);
+            return _pkt_send(&p, code);
+        default:
+            return true;
+    }
+}
+
+static bool _emit_program(bench_plan_t *plan, emu_code_handle_t code){
+    if(!_emit_context(plan, BENCH_CTX_USER, code)){return false;}
+    if(!_emit_context(plan, BENCH_CTX_BLOCKS, code)){return false;}
+
+    bench_pkt_t p;
+    //EN = true, X = 1.5, Y = 2.0
+    _pkt_start(&p, PACKET_H_INSTANCE_SCALAR_DATA);
+    _put_u8(&p, BENCH_CTX_USER); _put_u8(&p, MEM_B); _put_u8(&p, 1);
+    _put_u16(&p, plan->en.inst); _put_u8(&p, 1);
+    if(!_pkt_send(&p, code)){return false;}
+    _pkt_start(&p, PACKET_H_INSTANCE_SCALAR_DATA);
+    _put_u8(&p, BENCH_CTX_USER); _put_u8(&p, MEM_F); _put_u8(&p, 2);
+    _put_u16(&p, plan->x.inst); _put_f(&p, 1.5f);
+    _put_u16(&p, plan->y.inst); _put_f(&p, 2.0f);
+    if(!_pkt_send(&p, code)){return false;}
+
+    //contexts have to exist before access space is sized
+    if(!_pkt_flush()){return false;}
+    if(mem_access_allocate_space(plan->refs, 0).code != EMU_OK){return false;}
+
+    _pkt_start(&p, PACKET_H_CODE_CFG);
+    _put_u16(&p, plan->cnt);
+    if(!_pkt_send(&p, code)){return false;}
+
+    for(uint16_t i = 0; i < plan->cnt; i++){
+        if(!_emit_block(&plan->blocks[i], i, code)){return false;}
+    }
+    if(!_pkt_flush()){return false;}
+    return emu_parse_verify_code(code).code == EMU_OK;
+}
+
+static void _program_free(bench_plan_t *plan){
+    emu_reset_code_ctx();
+    mem_contexts_reset_all();
+    free(plan->blocks);
+    plan->blocks = NULL;
+}
+
+/*-------------------------------MEASUREMENT------------------------------------------------------- */
+
+static inline uint64_t _now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef struct{
+    uint64_t cycles;
+    uint64_t elapsed_ns;
+    uint32_t allocs;
+    emu_err_t err;
+}bench_result_t;
+
+static bench_result_t _run_case(bench_prog_t prog, bench_shape_t shape, uint16_t cnt, emu_exec_mode_t mode){
+    bench_result_t r = {.err = EMU_OK};
+    bench_plan_t plan;
+    _plan_build(&plan, prog, shape, cnt);
+
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    emu_sched_set_mode(code, mode);
+    if(!_emit_program(&plan, code)){
+        r.err = EMU_ERR_INVALID_DATA;
+        _program_free(&plan);
+        return r;
+    }
+
+    for(uint8_t i = 0; i < BENCH_WARMUP_CYCLES; i++){emu_execute_code(code);}
+
+    uint32_t allocs_start = bench_alloc_cnt;
+    uint64_t start = _now_ns();
+    do{
+        emu_result_t res = emu_execute_code(code);
+        if(res.code != EMU_OK){r.err = res.code; break;}
+        r.cycles++;
+        r.elapsed_ns = _now_ns() - start;
+    }while(r.elapsed_ns < BENCH_MIN_TIME_NS);
+    r.allocs = bench_alloc_cnt - allocs_start;
+
+    _program_free(&plan);
+    return r;
+}
+
+/*-------------------------------LOOPBACK UPLOAD--------------------------------------------------- */
+
+static struct{
+    SemaphoreHandle_t replies;      /*ready byte or ACK, one per processed write*/
+    uint8_t buf[BENCH_LOOP_WRITE];  /*write being packed: [seq header][PACKET_H_FRAMES + frames]*/
+    uint16_t len;
+    uint16_t seq;
+    uint8_t in_flight;
+    bool windowed;
+    uint32_t writes;
+    uint32_t nacks;
+}loop;
+
+static void _loop_notify(const uint8_t *data, size_t len){
+    if(len && (data[0] == EMU_RX_NACK || data[0] == EMU_RX_BUSY)){loop.nacks++; return;}
+    xSemaphoreGive(loop.replies);
+}
+
+static bool _loop_reply(void){
+    if(xSemaphoreTake(loop.replies, pdMS_TO_TICKS(5000)) != pdTRUE){return false;}
+    loop.in_flight--;
+    return loop.nacks == 0;
+}
+
+static bool _loop_drain(void){
+    while(loop.in_flight){
+        if(!_loop_reply()){return false;}
+    }
+    return true;
+}
+
+/*one BLE write, copied into receive ring as gatt_svc does, stop-and-wait waits for its reply and window only when full*/
+static bool _loop_write(const uint8_t *data, uint16_t len){
+    if(loop.in_flight >= (loop.windowed ? EMU_IN_MSG_SLOTS : 1) && !_loop_reply()){return false;}
+    uint8_t head[EMU_RX_SEQ_HEAD] = {0};
+    memcpy(head, data, (len < sizeof(head)) ? len : sizeof(head));
+    msg_packet_t *slot = emu_rx_claim(head, len);
+    if(!slot){return false;}
+    memcpy(slot->data, data, len);
+    emu_rx_commit(slot);
+    loop.writes++;
+    loop.in_flight++;
+    if(emu_interface_process_packet() != pdPASS){return false;}
+    return loop.windowed || _loop_reply();
+}
+
+static bool _loop_send_single(const uint8_t *data, uint16_t len){
+    return _loop_write(data, len);
+}
+
+static bool _loop_write_frames(void){
+    if(!loop.len){return true;}
+    if(loop.windowed){
+        loop.buf[0] = PACKET_H_SEQ;
+        memcpy(&loop.buf[1], &loop.seq, sizeof(loop.seq));
+        loop.seq++;
+    }
+    bool ok = _loop_write(loop.buf, loop.len);
+    loop.len = 0;
+    return ok;
+}
+
+static bool _loop_send_framed(const uint8_t *data, uint16_t len){
+    if(loop.len + sizeof(len) + len > BENCH_LOOP_WRITE && !_loop_write_frames()){return false;}
+    if(!loop.len){
+        loop.len = loop.windowed ? EMU_RX_SEQ_HEAD : 0;
+        loop.buf[loop.len++] = PACKET_H_FRAMES;
+    }
+    memcpy(&loop.buf[loop.len], &len, sizeof(len));
+    memcpy(&loop.buf[loop.len + sizeof(len)], data, len);
+    loop.len += sizeof(len) + len;
+    return true;
+}
+
+static bool _loop_flush_framed(void){
+    return _loop_write_frames() && _loop_drain();
+}
+
+typedef struct{
+    const char *name;
+    bench_sink_t sink;
+    bool windowed;  /*sequenced writes, EMU_IN_MSG_SLOTS in flight*/
+}bench_loop_mode_t;
+
+/*first mode builds program with direct parser calls (reference)*/
+static const bench_loop_mode_t LOOP_MODES[] = {
+    {.name = "direct"},
+    {.name = "single", .sink = {.send = _loop_send_single, .flush = _loop_drain}},
+    {.name = "framed", .sink = {.send = _loop_send_framed, .flush = _loop_flush_framed}},
+    {.name = "window", .sink = {.send = _loop_send_framed, .flush = _loop_flush_framed}, .windowed = true},
+};
+
+/*FNV-1a of all data heaps, program state after few cycles*/
+static uint32_t _state_hash(void){
+    uint32_t h = 2166136261u;
+    for(uint8_t c = 0; c < MAX_CONTEXTS; c++){
+        for(uint8_t t = 0; t < MEM_TYPES_COUNT; t++){
+            const type_manager_t *mgr = &mem_contexts[c].types[t];
+            uint32_t bytes = mgr->data_heap_cursor * MEM_TYPE_SIZES[t];
+            for(uint32_t i = 0; i < bytes; i++){h = (h ^ mgr->data_heap.u8[i]) * 16777619u;}
+        }
+    }
+    return h;
+}
+
+typedef struct{
+    uint32_t packets;
+    uint32_t writes;
+    uint32_t round_trips;   /*writes sender waited for, each costs connection interval over BLE*/
+    uint64_t elapsed_ns;
+    uint32_t hash;
+    bool ok;
+}bench_loop_result_t;
+
+static bench_loop_result_t _run_loopback(const bench_loop_mode_t *mode){
+    bench_loop_result_t r = {0};
+    bench_plan_t plan;
+    //no TIMER, elapsed time would make state differ between builds
+    _plan_build(&plan, BENCH_PROG_FOR, BENCH_SHAPE_DAG, BENCH_LOOP_BLOCKS);
+    loop.writes = loop.nacks = loop.len = loop.seq = loop.in_flight = 0;
+    loop.windowed = false;
+    pkt_cnt = 0;
+    pkt_sink = mode->sink.send ? &mode->sink : NULL;
+
+    uint64_t start = _now_ns();
+    r.ok = true;
+    if(pkt_sink){
+        //upload starts like from host, old program goes away, plain write also starts sequenced stream at 0
+        bench_pkt_t p = {.len = 0};
+        _put_u16(&p, ORD_RESET_ALL);
+        pkt_cnt++;
+        r.ok = _loop_write(p.data, p.len);
+    }
+    loop.windowed = mode->windowed;
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    r.ok = r.ok && _emit_program(&plan, code);
+    r.elapsed_ns = _now_ns() - start;
+    pkt_sink = NULL;
+
+    if(r.ok){
+        for(uint8_t i = 0; i < BENCH_LOOP_CYCLES; i++){r.ok &= (emu_execute_code(code).code == EMU_OK);}
+        r.hash = _state_hash();
+    }
+    r.packets = pkt_cnt;
+    r.writes = loop.writes;
+    //first write (reset) is always plain
+    r.round_trips = mode->windowed ? 1 + (loop.writes - 1 + EMU_IN_MSG_SLOTS - 1) / EMU_IN_MSG_SLOTS : loop.writes;
+    _program_free(&plan);
+    return r;
+}
+
+/*order as one plain write*/
+static bool _loop_order(uint16_t order){
+    bench_pkt_t p = {.len = 0};
+    _put_u16(&p, order);
+    loop.windowed = false;
+    return _loop_write(p.data, p.len);
+}
+
+/*START while loop runs must be rejected before verify, verify would free plan and block programs loop task executes*/
+static bool _loop_start_twice(void){
+    bench_plan_t plan;
+    _plan_build(&plan, BENCH_PROG_FOR, BENCH_SHAPE_DAG, BENCH_LOOP_BLOCKS);
+    loop.writes = loop.nacks = loop.len = loop.seq = loop.in_flight = 0;
+    pkt_sink = &LOOP_MODES[2].sink;
+    bool ok = _loop_order(ORD_RESET_ALL) && _emit_program(&plan, emu_get_current_code_ctx());
+    pkt_sink = NULL;
+    ok = ok && _loop_order(ORD_EMU_LOOP_INIT) && _loop_order(ORD_EMU_LOOP_START) && emu_loop_is_running();
+    vTaskDelay(pdMS_TO_TICKS(50));
+    //verify allocates plan again, rejected START must not allocate anything
+    uint32_t allocs = bench_alloc_cnt;
+    ok = ok && _loop_order(ORD_EMU_LOOP_START);
+    ok = ok && (bench_alloc_cnt == allocs) && emu_loop_is_running();
+    vTaskDelay(pdMS_TO_TICKS(50));
+    ok = ok && _loop_order(ORD_EMU_LOOP_STOP) && !emu_loop_is_running();
+    ok &= _loop_order(ORD_RESET_ALL);
+    _program_free(&plan);
+    return ok;
+}
+
+/*image saved by _image_boot, sent back in ORD_EMU_IMAGE_UPLOAD chunks like host tool does*/
+static struct{
+    uint8_t *data;
+    uint32_t len;
+}image;
+
+static bool _image_read(void){
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, EMU_IMAGE_PARTITION_LABEL);
+    emu_image_header_t head;
+    if(!part || esp_partition_read(part, 0, &head, sizeof(head)) != ESP_OK){return false;}
+    image.len = sizeof(head) + head.size;
+    image.data = malloc(image.len);
+    return image.data && esp_partition_read(part, 0, image.data, image.len) == ESP_OK;
+}
+
+/*upload (journal), ORD_EMU_IMAGE_SAVE, power cycle, program is built from flash image like at boot and runs to same state*/
+static bool _image_boot(uint32_t ref_hash, uint64_t *boot_ns, uint32_t *hash){
+    bench_plan_t plan;
+    _plan_build(&plan, BENCH_PROG_FOR, BENCH_SHAPE_DAG, BENCH_LOOP_BLOCKS);
+    loop.writes = loop.nacks = loop.len = loop.seq = loop.in_flight = 0;
+    pkt_sink = &LOOP_MODES[2].sink;
+    bool ok = _loop_order(ORD_RESET_ALL) && _emit_program(&plan, emu_get_current_code_ctx());
+    pkt_sink = NULL;
+    ok = ok && _loop_order(ORD_EMU_IMAGE_SAVE);
+
+    //power cycle, RAM program and journal are gone, flash keeps image
+    ok = ok && _loop_order(ORD_RESET_ALL);
+    uint64_t start = _now_ns();
+    ok = ok && (emu_interface_boot_image().code == EMU_OK);
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    ok = ok && (emu_parse_verify_code(code).code == EMU_OK);
+    *boot_ns = _now_ns() - start;
+
+    for(uint8_t i = 0; ok && i < BENCH_LOOP_CYCLES; i++){ok = (emu_execute_code(code).code == EMU_OK);}
+    *hash = _state_hash();
+    ok = ok && _image_read();
+    //next bench run must not boot this image
+    ok &= _loop_order(ORD_EMU_IMAGE_ERASE);
+    ok &= _loop_order(ORD_RESET_ALL);
+    _program_free(&plan);
+    return ok && *hash == ref_hash;
+}
+
+static bool _image_chunk(uint32_t idx){
+    uint32_t offset = idx * BENCH_IMAGE_CHUNK;
+    uint32_t len = (image.len - offset < BENCH_IMAGE_CHUNK) ? image.len - offset : BENCH_IMAGE_CHUNK;
+    bench_pkt_t p = {.len = 0};
+    _put_u16(&p, ORD_EMU_IMAGE_UPLOAD);
+    _put_u32(&p, offset);
+    memcpy(&p.data[p.len], &image.data[offset], len);
+    p.len += len;
+    return _loop_write(p.data, p.len);
+}
+
+/*saved image uploaded in chunks, swap sends chunk 2 before chunk 1: it has to be rejected and upload continues when chunk 1 and 2 come in order*/
+static bool _image_upload(bool swap, uint32_t ref_hash, uint32_t *writes, uint64_t *replay_ns, uint32_t *hash){
+    uint32_t chunks = (image.len + BENCH_IMAGE_CHUNK - 1) / BENCH_IMAGE_CHUNK;
+    loop.writes = loop.nacks = loop.len = loop.seq = loop.in_flight = 0;
+    bool ok = image.data && chunks > 3 && _loop_order(ORD_RESET_ALL);
+    if(swap){ok = ok && _image_chunk(0) && _image_chunk(2);}
+    for(uint32_t i = swap ? 1 : 0; ok && i + 1 < chunks; i++){ok = _image_chunk(i);}
+    //last chunk completes image, its write includes crc check and replay of all records
+    uint64_t start = _now_ns();
+    ok = ok && _image_chunk(chunks - 1);
+    *replay_ns = _now_ns() - start;
+
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    ok = ok && (emu_parse_verify_code(code).code == EMU_OK);
+    for(uint8_t i = 0; ok && i < BENCH_LOOP_CYCLES; i++){ok = (emu_execute_code(code).code == EMU_OK);}
+    *hash = _state_hash();
+    *writes = loop.writes;
+    ok &= _loop_order(ORD_RESET_ALL);
+    return ok && *hash == ref_hash;
+}
+
+static void _loopback_report(void){
+    loop.replies = xSemaphoreCreateCounting(EMU_IN_MSG_SLOTS, 0);
+    if(!loop.replies || emu_msg_buffs_init(BENCH_LOOP_MTU) != ESP_OK){
+        printf("No memory for loopback\n");
+        return;
+    }
+    emu_rx_init(_loop_notify);
+    if(xTaskCreate(emu_interface_task, "emu_interface", 8192, NULL, 5, NULL) != pdPASS){
+        printf("Interface task not created\n");
+        return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(100)); /*task stores its handle before first write*/
+
+    //link estimate: processing on host + one connection interval per round trip sender waits for
+    printf("\n%-7s %7s %8s %7s %10s %10s %10s\n", "upload", "blocks", "packets", "writes", "ms", "link ms", "state");
+    uint32_t ref_hash = 0;
+    for(uint8_t m = 0; m < sizeof(LOOP_MODES)/sizeof(LOOP_MODES[0]); m++){
+        bench_loop_result_t r = _run_loopback(&LOOP_MODES[m]);
+        if(!r.ok){
+            printf("%-7s %7u  failed, %"PRIu32" NACKs\n", LOOP_MODES[m].name, BENCH_LOOP_BLOCKS, loop.nacks);
+            continue;
+        }
+        if(!m){ref_hash = r.hash;}
+        double ms = r.elapsed_ns / 1e6;
+        printf("%-7s %7u %8"PRIu32" %7"PRIu32" %10.2f %10.0f   %08"PRIX32"  %s\n", LOOP_MODES[m].name, BENCH_LOOP_BLOCKS, r.packets, r.writes,
+               ms, ms + r.round_trips * (BENCH_LOOP_RTT_US / 1000.0), r.hash, (r.hash == ref_hash) ? "same" : "DIFFERS");
+    }
+    printf("\nSTART while running: %s\n", _loop_start_twice() ? "rejected, loop kept running" : "FAILED");
+
+    uint64_t boot_ns = 0;
+    uint32_t boot_hash = 0;
+    bool booted = _image_boot(ref_hash, &boot_ns, &boot_hash);
+    printf("image: saved, booted from flash in %.2f ms (replay + verify), state %08"PRIX32"  %s\n",
+           boot_ns / 1e6, boot_hash, booted ? "same" : "FAILED");
+
+    for(uint8_t swap = 0; swap < 2; swap++){
+        uint32_t writes = 0, hash = 0;
+        uint64_t replay_ns = 0;
+        bool ok = _image_upload(swap, ref_hash, &writes, &replay_ns, &hash);
+        printf("image upload: %"PRIu32" bytes in %u byte chunks%s, %"PRIu32" writes, last chunk (crc + replay) %.2f ms, state %08"PRIX32"  %s\n",
+               image.len, BENCH_IMAGE_CHUNK, swap ? ", chunk 2 before 1" : "", writes, replay_ns / 1e6, hash, ok ? "same" : "FAILED");
+    }
+    free(image.data);
+    image.data = NULL;
+}
+
+/*-------------------------------PACKED MASKS------------------------------------------------------ */
+
+#define BENCH_MASK_FLAGS 1024
+#define BENCH_MASK_A     2      /*MEM_B instances of user context: EN, ENO, A, B, RESULT*/
+
+/*whole array access of packed 1D array (index 0, slice to end of dim)*/
+static void _put_access_whole(bench_pkt_t *p, uint16_t inst){
+    _put_u8(p, MEM_B | (BENCH_CTX_USER << 4));
+    _put_u8(p, 1 | (1 << 3) | (1 << 6)); /*dims_cnt 1, static index, whole_array*/
+    _put_u16(p, inst);
+    _put_u16(p, 0);
+    _put_u8(p, 0); _put_u16(p, 0);
+}
+
+/*RESULT = A AND B of packed fault masks, one LOGIC block runs word kernel (emu_packed.h)*/
+static bool _emit_mask_program(emu_code_handle_t code){
+    bench_pkt_t p;
+    _pkt_start(&p, PACKET_H_CONTEXT_CFG);
+    _put_u8(&p, BENCH_CTX_USER);
+    for(uint8_t t = 0; t < MEM_TYPES_COUNT; t++){
+        bool b = (t == MEM_B);
+        _put_u32(&p, b ? 4 + 3 * MEM_PACKED_WORDS(BENCH_MASK_FLAGS) * sizeof(uint32_t) : 0);
+        _put_u16(&p, b ? BENCH_MASK_A + 3 : 0);
+        _put_u16(&p, b ? 3 : 0);
+    }
+    if(!_pkt_send(&p, code)){return false;}
+    _pkt_start(&p, PACKET_H_INSTANCE);
+    for(uint8_t i = 0; i < BENCH_MASK_A + 3; i++){
+        bool arr = (i >= BENCH_MASK_A);
+        _put_u16(&p, (BENCH_CTX_USER & 0x07) | ((uint16_t)arr << 3) | ((uint16_t)MEM_B << 7) | ((uint16_t)arr << 13));
+        if(arr){_put_u16(&p, BENCH_MASK_FLAGS);}
+    }
+    if(!_pkt_send(&p, code)){return false;}
+    _pkt_start(&p, PACKET_H_INSTANCE_SCALAR_DATA);
+    _put_u8(&p, BENCH_CTX_USER); _put_u8(&p, MEM_B); _put_u8(&p, 1);
+    _put_u16(&p, 0); _put_u8(&p, 1);
+    if(!_pkt_send(&p, code)){return false;}
+    if(!_pkt_flush()){return false;}
+    if(mem_access_allocate_space(5, 3).code != EMU_OK){return false;}
+
+    _pkt_start(&p, PACKET_H_CODE_CFG);
+    _put_u16(&p, 1);
+    if(!_pkt_send(&p, code)){return false;}
+    _pkt_start(&p, PACKET_H_BLOCK_HEADER);
+    _put_u16(&p, 0); _put_u16(&p, 0x7); _put_u8(&p, BLOCK_LOGIC); _put_u8(&p, 3); _put_u8(&p, 2);
+    if(!_pkt_send(&p, code)){return false;}
+    for(uint8_t i = 0; i < 5; i++){
+        _pkt_start(&p, (i < 3) ? PACKET_H_BLOCK_INPUTS : PACKET_H_BLOCK_OUTPUTS);
+        _put_u16(&p, 0); _put_u8(&p, (i < 3) ? i : i - 3);
+        if(i == 0 || i == 3){_put_access(&p, (bench_ref_t){.ctx = BENCH_CTX_USER, .type = MEM_B, .inst = (i == 3)});}
+        else{_put_access_whole(&p, BENCH_MASK_A + ((i < 3) ? i - 1 : 2));}
+        if(!_pkt_send(&p, code)){return false;}
+    }
+    _pkt_start(&p, PACKET_H_BLOCK_DATA);
+    _put_u16(&p, 0); _put_u8(&p, BLOCK_LOGIC); _put_u8(&p, BLOCK_PKT_INSTRUCTIONS);
+    _put_u8(&p, 3);
+    _put_u8(&p, 0x00); _put_u8(&p, 1);  /*VAR A*/
+    _put_u8(&p, 0x00); _put_u8(&p, 2);  /*VAR B*/
+    _put_u8(&p, 0x20); _put_u8(&p, 0);  /*AND*/
+    if(!_pkt_send(&p, code)){return false;}
+    if(!_pkt_flush()){return false;}
+    return emu_parse_verify_code(code).code == EMU_OK;
+}
+
+static void _mask_report(void){
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    emu_sched_set_mode(code, EMU_EXEC_FULL);
+    if(!_emit_mask_program(code)){
+        printf("\nmasks: program rejected\n");
+        emu_reset_code_ctx();
+        mem_contexts_reset_all();
+        return;
+    }
+    mem_instance_t *inst = mem_contexts[BENCH_CTX_USER].types[MEM_B].instances;
+    uint8_t *bytes = malloc(BENCH_MASK_FLAGS);
+    for(uint16_t i = 0; i < BENCH_MASK_FLAGS; i++){bytes[i] = (i % 3 == 0);}
+    mem_packed_from_bytes(&inst[BENCH_MASK_A], 0, bytes, BENCH_MASK_FLAGS);
+    for(uint16_t i = 0; i < BENCH_MASK_FLAGS; i++){bytes[i] = (i % 2 == 0);}
+    mem_packed_from_bytes(&inst[BENCH_MASK_A + 1], 0, bytes, BENCH_MASK_FLAGS);
+    free(bytes);
+
+    uint64_t cycles = 0, elapsed = 0, start = _now_ns();
+    bool ok = true;
+    do{
+        ok = (emu_execute_code(code).code == EMU_OK);
+        cycles++;
+        elapsed = _now_ns() - start;
+    }while(ok && elapsed < BENCH_MIN_TIME_NS);
+
+    uint32_t set = 0;
+    for(uint16_t i = 0; i < BENCH_MASK_FLAGS; i++){
+        bool exp = (i % 6 == 0);
+        if(mem_packed_get(&inst[BENCH_MASK_A + 2], i) != exp){ok = false;}
+        set += exp;
+    }
+    emu_reset_code_ctx();
+    mem_contexts_reset_all();
+    printf("\nmasks: LOGIC AND of %u packed flags (%"PRIu32" set), %.1f ns/cycle, %.2f ns/flag  %s\n",
+           BENCH_MASK_FLAGS, set, (double)elapsed / cycles, (double)elapsed / cycles / BENCH_MASK_FLAGS, ok ? "ok" : "FAILED");
+}
+
+/*-------------------------------DUAL CORE SPLIT--------------------------------------------------- */
+
+#define BENCH_SPLIT_BLOCKS 1000
+#define BENCH_SPLIT_CYCLES 200
+
+/*two interleaved MATH chains (block i reads block i - 2), two independent subgraphs of same size*/
+static void _plan_build_pair(bench_plan_t *plan){
+    _plan_build(plan, BENCH_PROG_MATH, BENCH_SHAPE_CHAIN, BENCH_SPLIT_BLOCKS);
+    for(uint16_t i = 0; i < plan->cnt; i++){
+        plan->blocks[i].in[1] = (i >= 2) ? plan->blocks[i - 2].value : ((i & 1) ? plan->y : plan->x);
+    }
+}
+
+/*same program with split (worker task + barrier, emu_partition.h) and on loop task only, state has to be same*/
+static bool _split_run(bool split, uint64_t *ns_cycle, uint32_t *hash, uint16_t shares[2]){
+    bench_plan_t plan;
+    _plan_build_pair(&plan);
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    emu_sched_set_mode(code, EMU_EXEC_FULL);
+    bool ok = _emit_program(&plan, code);
+    if(ok && !split){emu_partition_free(code);}
+    if(ok && split && !emu_partition_active(code)){ok = false;}
+    if(ok && code->parts){shares[0] = code->parts->cnt[0]; shares[1] = code->parts->cnt[1];}
+
+    uint64_t start = _now_ns();
+    for(uint16_t i = 0; ok && i < BENCH_SPLIT_CYCLES; i++){ok = (emu_execute_code(code).code == EMU_OK);}
+    *ns_cycle = (_now_ns() - start) / BENCH_SPLIT_CYCLES;
+    *hash = _state_hash();
+    _program_free(&plan);
+    return ok;
+}
+
+static void _split_report(void){
+    if(!EMU_PARALLEL_ENABLED){
+        printf("\nsplit: single core target, code always runs on loop task\n");
+        return;
+    }
+    if(emu_partition_worker_init().code != EMU_OK){
+        printf("\nsplit: no worker task\n");
+        return;
+    }
+    uint64_t ns_single = 0, ns_split = 0;
+    uint32_t h_single = 0, h_split = 0;
+    uint16_t shares[2] = {0};
+    bool ok = _split_run(false, &ns_single, &h_single, shares);
+    ok = _split_run(true, &ns_split, &h_split, shares) && ok;
+    printf("\nsplit: %u blocks, core shares %"PRIu16" / %"PRIu16", single %.1f us/cycle, split %.1f us/cycle, state %08"PRIX32" %s\n",
+           BENCH_SPLIT_BLOCKS, shares[0], shares[1], ns_single / 1e3, ns_split / 1e3, h_split, (ok && h_single == h_split) ? "same" : "FAILED");
+}
+
+/*-------------------------------RETAIN ROUND TRIP------------------------------------------------- */
+
+#define BENCH_RETAIN_CYCLES 25
+
+/*COUNTER with retained U32 VAL, counts once per cycle*/
+static void _plan_build_counter(bench_plan_t *plan){
+    memset(plan, 0, sizeof(*plan));
+    plan->cnt = 1;
+    plan->blocks = calloc(1, sizeof(bench_block_t));
+    plan->en = _plan_var(plan, BENCH_CTX_USER, MEM_B);
+    plan->x  = _plan_var(plan, BENCH_CTX_USER, MEM_F);
+    plan->y  = _plan_var(plan, BENCH_CTX_USER, MEM_F);
+    bench_block_t *b = &plan->blocks[0];
+    b->type = BLOCK_COUNTER;
+    b->in_cnt = 6; b->mask = 0x1;
+    b->in[0] = plan->en;
+    b->q_cnt = 2;
+    b->q[0] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_B);
+    b->q[1] = _plan_var(plan, BENCH_CTX_BLOCKS, MEM_U32);
+    b->value = b->q[1];
+    plan->retained = b->q[1];
+    plan->has_retained = true;
+    plan->refs = 1 + b->q_cnt;
+}
+
+/*program start as ORD_EMU_LOOP_START does it: verify, restore retained values, blocks take back their state*/
+static bool _retain_boot(bench_plan_t *plan, uint64_t *restore_ns){
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    if(!_emit_program(plan, code)){return false;}
+    uint64_t start = _now_ns();
+    bool ok = (emu_retain_start().code == EMU_OK);
+    emu_blocks_restore_all(code);
+    *restore_ns = _now_ns() - start;
+    return ok;
+}
+
+static uint32_t _retain_val(const bench_plan_t *plan){
+    return mem_contexts[plan->retained.ctx].types[MEM_U32].data_heap.u32[plan->retained.inst];
+}
+
+/*counter counts, values go to NVS, power cycle drops RAM, same program restores count and continues*/
+static void _retain_report(void){
+    nvs_handle_t nvs;
+    if(nvs_flash_init() != ESP_OK || emu_retain_init().code != EMU_OK || nvs_open(EMU_RETAIN_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK){
+        printf("\nretain: NVS not available\n");
+        return;
+    }
+    //values of previous bench run would be restored
+    nvs_erase_all(nvs);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+
+    bench_plan_t plan;
+    uint64_t restore_ns;
+    _plan_build_counter(&plan);
+    bool ok = _retain_boot(&plan, &restore_ns);
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    for(uint8_t i = 0; ok && i < BENCH_RETAIN_CYCLES; i++){ok = (emu_execute_code(code).code == EMU_OK);}
+    ok = ok && (emu_retain_flush().code == EMU_OK);
+    uint32_t saved = _retain_val(&plan);
+
+    //power cycle
+    emu_retain_reset();
+    _program_free(&plan);
+    _plan_build_counter(&plan);
+    ok = ok && _retain_boot(&plan, &restore_ns);
+    uint32_t restored = _retain_val(&plan);
+    ok = ok && (emu_execute_code(emu_get_current_code_ctx()).code == EMU_OK);
+    uint32_t next = _retain_val(&plan);
+    emu_retain_reset();
+    _program_free(&plan);
+
+    bool match = ok && saved == BENCH_RETAIN_CYCLES && restored == saved && next == saved + 1;
+    printf("\nretain: counter %"PRIu32" saved, %"PRIu32" restored, %"PRIu32" after next cycle, restore %.1f us  %s\n",
+           saved, restored, next, restore_ns / 1e3, match ? "ok" : "FAILED");
+}
+
+void app_main(void){
+    //parse/verify/block logs would dominate the timing
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    if(emu_arena_init(BENCH_ARENA_SIZE).code != EMU_OK){
+        printf("No memory for program arena\n");
+        exit(1);
+    }
+
+    printf("%-6s %-6s %-5s %7s %12s %12s %13s\n", "shape", "type", "mode", "blocks", "ns/block", "cycles/s", "allocs/cycle");
+    for(uint8_t s = 0; s < BENCH_SHAPE_CNT; s++){
+        for(uint8_t p = 0; p < BENCH_PROG_CNT; p++){
+            for(uint8_t n = 0; n < sizeof(BENCH_SIZES)/sizeof(BENCH_SIZES[0]); n++){
+                for(uint8_t m = EMU_EXEC_FULL; m <= EMU_EXEC_DIRTY; m++){
+                    bench_result_t r = _run_case(p, s, BENCH_SIZES[n], m);
+                    if(r.err != EMU_OK || r.cycles == 0){
+                        printf("%-6s %-6s %-5s %7u  failed: %s\n", BENCH_SHAPE_NAMES[s], BENCH_PROG_NAMES[p], BENCH_MODE_NAMES[m], BENCH_SIZES[n], EMU_ERR_TO_STR(r.err));
+                        continue;
+                    }
+                    double ns_cycle = (double)r.elapsed_ns / r.cycles;
+                    printf("%-6s %-6s %-5s %7u %12.1f %12.0f %13.2f\n", BENCH_SHAPE_NAMES[s], BENCH_PROG_NAMES[p], BENCH_MODE_NAMES[m], BENCH_SIZES[n],
+                           ns_cycle / BENCH_SIZES[n], 1e9 / ns_cycle, (double)r.allocs / r.cycles);
+                }
+            }
+        }
+    }
+    _mask_report();
+    _split_report();
+    _retain_report();
+    _loopback_report();
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "stdint.h"
+#include "stddef.h"
+#include "esp_err.h"
+
+/*Host stand-in for main/ble/include/gatt_buff.h, only types used by emulator*/
+
+typedef struct ble_msg_node {
+    uint8_t *data;
+    uint16_t len;
+    struct ble_msg_node *next;
+} ble_msg_node_t;
+
+typedef struct{
+    ble_msg_node_t *head;
+    size_t count;
+}chr_msg_buffer_t;
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "gatt_buff.h"
+
+/*Host stand-in for main/ble/include/gatt_svc.h, there is no NimBLE on linux target*/
+
+int gatt_send_notify(const uint8_t *data, size_t len);
+void gatt_notify_in(const uint8_t *data, size_t len);
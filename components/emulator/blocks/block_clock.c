@@ -48,10 +48,10 @@ emu_result_t block_clock(block_handle_t block) {
 
     //check is there provided other value by user via inputs
     uint32_t period = cfg->default_period;
-    if(block_in_updated(block, CLK_IN_PERIOD)){MEM_GET(&period, block->inputs[CLK_IN_PERIOD]);}
+    if(block_in_updated(block, CLK_IN_PERIOD)){BLOCK_IN_GET(&period, block, CLK_IN_PERIOD);}
 
     uint32_t width = cfg->default_width;
-    if(block_in_updated(block, CLK_IN_WIDTH)){MEM_GET(&width, block->inputs[CLK_IN_WIDTH]);}
+    if(block_in_updated(block, CLK_IN_WIDTH)){BLOCK_IN_GET(&width, block, CLK_IN_WIDTH);}
 
     if (period == 0) { period = 1; } 
 
@@ -101,8 +101,10 @@ emu_result_t block_clock_parse(const uint8_t *packet_data, const uint16_t packet
     const uint8_t *payload = &packet_data[1];
     
     // Allocate custom cfg if not exists
-    block->custom_data = calloc(1, sizeof(block_clock_cfg_t));
-    if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "Alloc failed");
+    if (!block->custom_data) {
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(block_clock_cfg_t));
+        if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "Alloc failed");
+    }
     
     block_clock_cfg_t *config = (block_clock_cfg_t*)block->custom_data;
     
@@ -134,13 +136,3 @@ emu_result_t block_clock_verify(block_handle_t block) {
     RET_OKD(block->cfg.block_idx, "[%"PRIu16"] verified", block->cfg.block_idx);
 }
 
-
-/*-------------------------------BLOCK FREE FUNCTION---------------------------------------------- */
-
-
-void block_clock_free(block_handle_t block) {
-    if (block && block->custom_data) {
-        free(block->custom_data);
-        block->custom_data = NULL;
-    }
-}
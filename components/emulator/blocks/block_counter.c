@@ -2,7 +2,10 @@
 #include "emu_blocks.h"
 #include "emu_logging.h"
 #include "emu_variables_acces.h"
+#include "emu_helpers.h"
+#include "emu_retain.h"
 #include <string.h>
+#include <math.h>
 
 static const char* TAG = __FILE_NAME__;
 
@@ -12,6 +15,12 @@ typedef enum{
     CFG_WHEN_ACTIVE,
 }counter_cfg_t;
 
+typedef enum{
+    COUNTER_NUM_F = 0,  /*float fields*/
+    COUNTER_NUM_INT,    /*whole numbers in "i"*/
+    COUNTER_NUM_Q,      /*Q16.16 raw values in "i" (VAL is MEM_Q)*/
+}counter_num_t;
+
 typedef struct{
     float current_val;
     float step;
@@ -21,6 +30,14 @@ typedef struct{
     counter_cfg_t cfg;
     bool prev_ctu; 
     bool prev_ctd;
+    uint8_t num;        /*counter_num_t set at verify: integer / Q16.16 VAL counts on "i" without float rounding*/
+    struct {
+        int64_t val;
+        int64_t step;
+        int64_t max;
+        int64_t min;
+        int64_t start;
+    } i;
 }counter_handle_t;
 
 // Input indices
@@ -36,6 +53,34 @@ typedef struct{
 #define OUT_1_VAL       1
 
 
+static __always_inline void _count_up(counter_handle_t *data) {
+    if (data->num != COUNTER_NUM_F) {
+        data->i.val = emu_sat_add_i64(data->i.val, data->i.step);
+        if (data->i.val > data->i.max) data->i.val = data->i.max;
+        return;
+    }
+    data->current_val += data->step;
+    if (data->current_val > data->max) data->current_val = data->max;
+}
+
+static __always_inline void _count_down(counter_handle_t *data) {
+    if (data->num != COUNTER_NUM_F) {
+        data->i.val = emu_sat_sub_i64(data->i.val, data->i.step);
+        if (data->i.val < data->i.min) data->i.val = data->i.min;
+        return;
+    }
+    data->current_val -= data->step;
+    if (data->current_val < data->min) data->current_val = data->min;
+}
+
+/*float input read into float field, or whole number / Q16.16 raw value into int field*/
+#define COUNTER_IN_GET(field, in) do { \
+    if (data->num == COUNTER_NUM_Q)        {int32_t _q = 0; res = block_in_get_q(block, in, &_q); data->i.field = _q;} \
+    else if (data->num == COUNTER_NUM_INT) {res = block_in_get_int(block, in, &data->i.field);} \
+    else                                   {res = BLOCK_IN_GET(&data->field, block, in);} \
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Input %d %s", block->cfg.block_idx, in, EMU_ERR_TO_STR(res.code));} \
+} while (0)
+
 #undef OWNER
 #define OWNER EMU_OWNER_block_counter
 emu_result_t block_counter(block_handle_t block) {
@@ -43,17 +88,18 @@ emu_result_t block_counter(block_handle_t block) {
     counter_handle_t* data = (counter_handle_t*)block->custom_data;
     emu_result_t res;
 
-    if (block_in_updated(block, IN_3_STEP)) {MEM_GET(&data->step, block->inputs[IN_3_STEP]);}
+    if (block_in_updated(block, IN_3_STEP)) {COUNTER_IN_GET(step, IN_3_STEP);}
 
 
-    if (block_in_updated(block, IN_4_LIMIT_MAX)) {MEM_GET(&data->max, block->inputs[IN_4_LIMIT_MAX]);}
+    if (block_in_updated(block, IN_4_LIMIT_MAX)) {COUNTER_IN_GET(max, IN_4_LIMIT_MAX);}
     
-    if (block_in_updated(block, IN_5_LIMIT_MIN)) {MEM_GET(&data->min, block->inputs[IN_5_LIMIT_MIN]);}
+    if (block_in_updated(block, IN_5_LIMIT_MIN)) {COUNTER_IN_GET(min, IN_5_LIMIT_MIN);}
 
 
     // RESET (Priority 1)
     if (block_check_in_true(block, IN_2_RESET)) {
             data->current_val = data->start;
+            data->i.val = data->i.start;
             data->prev_ctu = false; // Clear edge detection state
             data->prev_ctd = false;
             goto finish; // Exit immediately after reset
@@ -65,14 +111,12 @@ emu_result_t block_counter(block_handle_t block) {
         
         if (data->cfg == CFG_ON_RISING) {
             if (!data->prev_ctu){
-                data->current_val += data->step;
+                _count_up(data);
                 data->prev_ctu = true;
-                if (data->current_val > data->max) data->current_val = data->max;
                 goto finish; // CTU handled, skip CTD
             }  
         }else{
-            data->current_val += data->step;
-            if (data->current_val > data->max) data->current_val = data->max;
+            _count_up(data);
             data->prev_ctu = true;
             goto finish;
         }
@@ -83,14 +127,12 @@ emu_result_t block_counter(block_handle_t block) {
         if (block_check_in_true(block, IN_1_CTD)) {
         if (data->cfg == CFG_ON_RISING) {
             if (!data->prev_ctd){
-                data->current_val -= data->step;
+                _count_down(data);
                 data->prev_ctd = true;
-                if (data->current_val < data->min) data->current_val = data->min;
                 goto finish; // CTU handled, skip CTD
             }    
         }else{
-            data->current_val -= data->step;
-            if (data->current_val < data->min) data->current_val = data->min;
+            _count_down(data);
             data->prev_ctd = true;
             goto finish;
         }
@@ -109,6 +151,8 @@ finish:
 
     // OUT_1: VAL (Current Value)
     mem_var_t v_val = { .type = MEM_F, .data.val.f = data->current_val };
+    if (data->num == COUNTER_NUM_INT) {v_val = block_int_var(data->i.val, block->ops[block->cfg.in_cnt + OUT_1_VAL].type);}
+    if (data->num == COUNTER_NUM_Q)   {v_val = (mem_var_t){.type = MEM_Q, .data.val.q = emu_q_sat(data->i.val)};}
     res = block_set_output(block, v_val, OUT_1_VAL);
     if (unlikely(res.code != EMU_OK)) RET_ED(res.code, block->cfg.block_idx, 0, "Set VAL Error");
 
@@ -130,7 +174,7 @@ emu_result_t block_counter_parse(const uint8_t *packet_data, const uint16_t pack
     
     // Allocate custom data if not exists
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(counter_handle_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(counter_handle_t));
         if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "[%d]Null handle ptr", block->cfg.block_idx);
     }
     
@@ -149,6 +193,8 @@ emu_result_t block_counter_parse(const uint8_t *packet_data, const uint16_t pack
         memcpy(&handle->min,   &payload[offset], 4); offset += 4;
         
         handle->current_val = handle->start;
+        handle->i.val = (int64_t)handle->start;
+        handle->num = COUNTER_NUM_F; /*verify moves start into integer fields when VAL is whole number*/
         handle->prev_ctu = false;
         handle->prev_ctd = false;
         
@@ -159,21 +205,62 @@ emu_result_t block_counter_parse(const uint8_t *packet_data, const uint16_t pack
     return EMU_RESULT_OK();
 }
 
+static int64_t _float_to_q(float v) {return emu_float_to_q(v);}
+
+/*integer mode when VAL is whole number variable, config values are whole and connected STEP / MAX / MIN are integer variables,
+Q16.16 mode when VAL is MEM_Q and connected inputs are Q16.16 / integers*/
+static counter_num_t _counter_num(block_handle_t block, const counter_handle_t *data) {
+    if (block->cfg.q_cnt <= OUT_1_VAL) {return COUNTER_NUM_F;}
+    uint8_t val_type = block->ops[block->cfg.in_cnt + OUT_1_VAL].type;
+    bool q = (val_type == MEM_Q);
+    if (!q && !MEM_TYPE_IS_INT(val_type)) {return COUNTER_NUM_F;}
+    const float cfg_vals[] = {data->start, data->step, data->max, data->min};
+    for (uint8_t k = 0; k < sizeof(cfg_vals) / sizeof(cfg_vals[0]); k++) {
+        //limits are often sent as +-FLT_MAX / inf, emu_float_to_i64 / emu_float_to_q clamp them
+        if (isnan(cfg_vals[k]) || (!q && isfinite(cfg_vals[k]) && cfg_vals[k] != truncf(cfg_vals[k]))) {return COUNTER_NUM_F;}
+    }
+    for (uint8_t in = IN_3_STEP; in <= IN_5_LIMIT_MIN && in < block->cfg.in_cnt; in++) {
+        if (!((block->cfg.in_connceted_mask >> in) & 1)) {continue;}
+        uint8_t type = block->ops[in].type;
+        if (!MEM_TYPE_IS_INT(type) && !(q && type == MEM_Q)) {return COUNTER_NUM_F;}
+    }
+    return q ? COUNTER_NUM_Q : COUNTER_NUM_INT;
+}
+
 #undef OWNER
 #define OWNER EMU_OWNER_block_counter_verify
 emu_result_t block_counter_verify(block_handle_t block) {
     if (!block->custom_data) {RET_ED(EMU_ERR_NULL_PTR, block->cfg.block_idx, 0, "Custom Data is NULL %d", block->cfg.block_idx);}
-    return EMU_RESULT_OK();
-}
+    counter_handle_t *data = (counter_handle_t*)block->custom_data;
 
-void block_counter_free(block_handle_t block){
-    if(block && block->custom_data){
-        free(block->custom_data);
-        block->custom_data = NULL;
-        LOG_D(TAG, "[%d]Cleared counter block data", block->cfg.block_idx);
-    }
-    return;
-}
+    counter_num_t num = _counter_num(block, data);
+    //count is kept over STOP / START (verify runs at every START), it is only moved between fields when mode changes
+    if (num == data->num) {return EMU_RESULT_OK();}
+    if (data->num == COUNTER_NUM_INT) {data->current_val = (float)data->i.val;}
+    if (data->num == COUNTER_NUM_Q)   {data->current_val = (float)data->i.val / (float)MEM_Q_ONE;}
+    data->num = num;
+    if (num == COUNTER_NUM_F) {return EMU_RESULT_OK();}
 
+    int64_t (*conv)(float) = (num == COUNTER_NUM_Q) ? _float_to_q : emu_float_to_i64;
+    data->i.start = conv(data->start);
+    data->i.step  = conv(data->step);
+    data->i.max   = conv(data->max);
+    data->i.min   = conv(data->min);
+    data->i.val   = conv(data->current_val);
+    LOG_I(TAG, "[%"PRIu16"] Counter runs on %s", block->cfg.block_idx, (num == COUNTER_NUM_Q) ? "Q16.16" : "integers");
+    return EMU_RESULT_OK();
+}
 
+/*retained VAL restored from NVS is count of last run, start value is not used then*/
+void block_counter_restore(block_handle_t block) {
+    counter_handle_t *data = (counter_handle_t*)block->custom_data;
+    if (!data || block->cfg.q_cnt <= OUT_1_VAL) {return;}
+    const emu_operand_t *op = &block->ops[block->cfg.in_cnt + OUT_1_VAL];
+    if (!op->inst || !op->inst->retain || !emu_retain_restored(op->inst)) {return;}
 
+    mem_var_t v = {.type = op->type, .by_reference = 1, .data.ptr.u8 = op->inst->data.u8};
+    if (data->num == COUNTER_NUM_Q)        {data->i.val = emu_var_to_q(v);}
+    else if (data->num == COUNTER_NUM_INT) {data->i.val = (op->type == MEM_U32) ? (int64_t)GET_VAL(v, u32) : (int64_t)emu_var_to_i32(v);}
+    else                                   {data->current_val = emu_var_to_f(v);}
+    LOG_I(TAG, "[%"PRIu16"] Counter restored from retained VAL", block->cfg.block_idx);
+}
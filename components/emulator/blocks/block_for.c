@@ -4,6 +4,7 @@
 #include "blocks_functions_list.h"
 #include "emu_loop.h" 
 #include "emu_body.h"
+#include "emu_helpers.h"
 #include "esp_log.h"
 #include <math.h>
 #include <float.h>
@@ -41,6 +42,12 @@ typedef struct{
     float cached_limit_adjusted; // limit ± epsilon pre-calculated
     bool has_dynamic_inputs;
     bool first_run; // flag to ensure initialization
+    bool int_mode;  // set at verify: iterator is integer variable, loop runs on "i" with exact compare
+    struct {
+        int64_t start;
+        int64_t end;
+        int64_t step;
+    } i;
 }block_for_handle_t;   
 
 
@@ -53,9 +60,6 @@ typedef struct{
 
 
 static emu_code_handle_t code;
-static bool binded_to_code = false;
-
-extern uint64_t emu_loop_iterator;
 
 // Helper: safe float equality
 static inline bool flt_eq(float a, float b) {
@@ -66,6 +70,71 @@ static inline bool flt_eq(float a, float b) {
 
 #undef OWNER
 #define OWNER EMU_OWNER_block_for
+/**
+ * @brief One pass of chain (body of loop), same for float and integer iterator
+ */
+static __always_inline emu_result_t _run_chain(block_handle_t block, const emu_plan_entry_t *chain, const emu_plan_entry_t *chain_end, uint32_t iteration) {
+    emu_result_t res;
+    if (unlikely(emu_loop_wtd_status())) {
+        RET_ED(EMU_ERR_BLOCK_FOR_TIMEOUT, block->cfg.block_idx, 0, "WTD triggered, elapsed time %"PRIu64", iteration %"PRIu32", wtd set to %"PRIu64" ms", emu_loop_get_time(), iteration, emu_loop_get_wtd_max_skipped()*emu_loop_get_period()/1000);
+    }
+
+    //chain entries are checked by emu_code_compile, nested FOR runs its own chain (skip)
+    for (const emu_plan_entry_t *child = chain; child < chain_end; child += child->skip) {
+        emu_block_reset_outputs_status(child->block);
+        res = child->func(child->block);
+        if (unlikely(res.code != EMU_OK && res.code != EMU_ERR_BLOCK_INACTIVE)) {
+            return res; 
+        }
+    }
+    return EMU_RESULT_OK();
+}
+
+/**
+ * @brief Integer iterator: exact compare and saturating step, loop also ends when step can't move iterator (0, saturated)
+ */
+static emu_result_t _block_for_int(block_handle_t block, block_for_handle_t *config, const emu_plan_entry_t *chain, const emu_plan_entry_t *chain_end) {
+    emu_result_t res;
+    if (block_in_updated(block, BLOCK_FOR_IN_START)) {res = block_in_get_int(block, BLOCK_FOR_IN_START, &config->i.start); if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "Start input %s", EMU_ERR_TO_STR(res.code));}}
+    if (block_in_updated(block, BLOCK_FOR_IN_STOP))  {res = block_in_get_int(block, BLOCK_FOR_IN_STOP,  &config->i.end);   if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "Stop input %s", EMU_ERR_TO_STR(res.code));}}
+    if (block_in_updated(block, BLOCK_FOR_IN_STEP))  {res = block_in_get_int(block, BLOCK_FOR_IN_STEP,  &config->i.step);  if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "Step input %s", EMU_ERR_TO_STR(res.code));}}
+
+    const int64_t end = config->i.end;
+    const int64_t step = config->i.step;
+    const uint8_t iter_type = block->ops[block->cfg.in_cnt + 1].type;
+    int64_t current_val = config->i.start;
+    uint32_t iteration = 0;
+
+    while(1) {
+        bool condition_met;
+        switch (config->condition) {
+            case FOR_COND_GT:  condition_met = (current_val > end); break;
+            case FOR_COND_LT:  condition_met = (current_val < end); break;
+            case FOR_COND_GTE: condition_met = (current_val >= end); break;
+            case FOR_COND_LTE: condition_met = (current_val <= end); break;
+            default: condition_met = false; break;
+        }
+        if (unlikely(!condition_met)) break;
+
+        res = block_set_output(block, block_int_var(current_val, iter_type), 1);
+        if (unlikely(res.code != EMU_OK)) RET_ED(res.code, block->cfg.block_idx, 0, "[%"PRIu16"] Set Out 1 fail", block->cfg.block_idx);
+
+        res = _run_chain(block, chain, chain_end, iteration);
+        if (unlikely(res.code != EMU_OK)) {return res;}
+
+        int64_t next;
+        switch (config->op) {
+            case FOR_OP_SUB: next = emu_sat_sub_i64(current_val, step); break;
+            case FOR_OP_MUL: next = emu_sat_mul_i64(current_val, step); break;
+            default:         next = emu_sat_add_i64(current_val, step); break;
+        }
+        if (unlikely(next == current_val)) break;
+        current_val = next;
+        iteration++;
+    }
+    return EMU_RESULT_OK();
+}
+
 emu_result_t block_for(block_handle_t block) {
     emu_result_t res = EMU_RESULT_OK();
     
@@ -74,20 +143,29 @@ emu_result_t block_for(block_handle_t block) {
     if (!EN) {RET_OK_INACTIVE(block->cfg.block_idx);}
 
     block_for_handle_t* config = (block_for_handle_t*)block->custom_data;
+    const emu_plan_entry_t *chain = &code->plan[block->cfg.block_idx + 1];
+    const emu_plan_entry_t *chain_end = chain + config->chain_len;
+
+    // Write EN output once (always true during loop)
+    mem_var_t v_en = { .type = MEM_B, .data.val.b = true };
+    res = block_set_output(block, v_en, 0);
+    if (unlikely(res.code != EMU_OK)) RET_ED(res.code, block->cfg.block_idx, 0, "Set Out 0 fail");
+
+    if (config->int_mode) {return _block_for_int(block, config, chain, chain_end);}
     
 
     // 3. Update cached parameters only if inputs changed
-    if (block_in_updated(block, BLOCK_FOR_IN_START)) {MEM_GET(&config->cached_start, block->inputs[BLOCK_FOR_IN_START]);}
+    if (block_in_updated(block, BLOCK_FOR_IN_START)) {BLOCK_IN_GET(&config->cached_start, block, BLOCK_FOR_IN_START);}
     
     bool limit_changed = false;
 
     if (block_in_updated(block, BLOCK_FOR_IN_STOP)) {
-        MEM_GET(&config->cached_end, block->inputs[BLOCK_FOR_IN_STOP]);
+        BLOCK_IN_GET(&config->cached_end, block, BLOCK_FOR_IN_STOP);
         limit_changed = true;
     }
 
     if (block_in_updated(block, BLOCK_FOR_IN_STEP)) {
-        MEM_GET(&config->cached_step, block->inputs[BLOCK_FOR_IN_STEP]);
+        BLOCK_IN_GET(&config->cached_step, block, BLOCK_FOR_IN_STEP);
     }
 
     // Calculate limit adjustment on first run or when limit changes
@@ -107,11 +185,6 @@ emu_result_t block_for(block_handle_t block) {
     float step = config->cached_step;
     uint32_t iteration = 0;
 
-    // Write EN output once (always true during loop)
-    mem_var_t v_en = { .type = MEM_B, .data.val.b = true };
-    res = block_set_output(block, v_en, 0);
-    if (unlikely(res.code != EMU_OK)) RET_ED(res.code, block->cfg.block_idx, 0, "Set Out 0 fail");
-
     while(1) {
         
         bool condition_met;
@@ -130,27 +203,8 @@ emu_result_t block_for(block_handle_t block) {
         res = block_set_output(block, v_iter, 1);
         if (unlikely(res.code != EMU_OK)) RET_ED(res.code, block->cfg.block_idx, 0, "[%"PRIu16"] Set Out 1 fail", block->cfg.block_idx);
 
-        if (unlikely(emu_loop_wtd_status())) {
-            RET_ED(EMU_ERR_BLOCK_FOR_TIMEOUT, block->cfg.block_idx, 0, "WTD triggered, elapsed time %"PRIu64", iteration %"PRIu32", wtd set to %"PRIu64" ms", emu_loop_get_time(), iteration, emu_loop_get_wtd_max_skipped()*emu_loop_get_period()/1000);
-        }
-
-        for (uint16_t b = 1; b <= config->chain_len; b++) {
-            block_handle_t child = code->blocks_list[block->cfg.block_idx + b];
-            if (likely(child)) {
-                emu_block_reset_outputs_status(child);
-                
-                uint8_t child_type = child->cfg.block_type;
-                if (likely(child_type < 255)) {
-                    emu_block_func child_func = blocks_main_functions_table[child_type];
-                    if (likely(child_func)) {
-                        res = child_func(child);
-                        if (unlikely(res.code != EMU_OK && res.code != EMU_ERR_BLOCK_INACTIVE)) {
-                            return res; 
-                        }
-                    }
-                }
-            }
-        }
+        res = _run_chain(block, chain, chain_end, iteration);
+        if (unlikely(res.code != EMU_OK)) {return res;}
 
         if (likely(config->op == FOR_OP_ADD)) {
             current_val += step;
@@ -166,8 +220,6 @@ emu_result_t block_for(block_handle_t block) {
         }
         iteration++;
     }
-
-    emu_loop_iterator += config->chain_len;
     
     return EMU_RESULT_OK();
 }
@@ -180,10 +232,8 @@ emu_result_t block_for_parse(const uint8_t *packet_data, const uint16_t packet_l
     block_handle_t block = (block_handle_t)block_ptr;
     if (!block) RET_E(EMU_ERR_NULL_PTR, "NULL block");
     
-    if (!binded_to_code) {
-        code = emu_get_current_code_ctx();
-        binded_to_code = true;
-    }
+    //rebind every parse, code ctx is recreated after reset
+    code = emu_get_current_code_ctx();
     
     // Packet: [packet_id:u8][data...]
     if (packet_len < 1) RET_E(EMU_ERR_PACKET_INCOMPLETE, "Packet too short");
@@ -194,7 +244,7 @@ emu_result_t block_for_parse(const uint8_t *packet_data, const uint16_t packet_l
     
     // Allocate custom data if not exists
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(block_for_handle_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(block_for_handle_t));
         if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "Alloc failed");
     }
     
@@ -244,15 +294,11 @@ emu_result_t block_for_parse(const uint8_t *packet_data, const uint16_t packet_l
     
     return EMU_RESULT_OK();
 }
-
-void block_for_free(block_handle_t block){
-    if(block && block->custom_data){
-        free(block->custom_data);
-        block->custom_data = NULL;
-        LOG_D(TAG, "Cleared for block data");
-    }
-    return;
+uint16_t block_for_chain_len(block_handle_t block){
+    if (!block || !block->custom_data) {return 0;}
+    return ((block_for_handle_t*)block->custom_data)->chain_len;
 }
+
 #undef OWNER
 #define OWNER EMU_OWNER_block_for_verify
 emu_result_t block_for_verify(block_handle_t block) {
@@ -262,5 +308,21 @@ emu_result_t block_for_verify(block_handle_t block) {
     if (data->condition > FOR_COND_LTE) {RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "Invalid Condition Enum: %d", data->condition);}
     if (data->op > FOR_OP_DIV) {RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "Invalid Op Enum: %d", data->op);}
     if (fabsf(data->op_step) < 0.000001f) {RET_WD(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "Step is 0 (Infinite Loop risk)");}
+
+    //integer iterator when output is whole number variable, op is not DIV, constants are whole and connected START / STOP / STEP are integers
+    data->int_mode = false;
+    if (block->cfg.q_cnt < 2 || !MEM_TYPE_IS_INT(block->ops[block->cfg.in_cnt + 1].type) || data->op == FOR_OP_DIV) {return EMU_RESULT_OK();}
+    const float consts[] = {data->start_val, data->end_val, data->op_step};
+    for (uint8_t k = 0; k < sizeof(consts) / sizeof(consts[0]); k++) {
+        if (isnan(consts[k]) || (isfinite(consts[k]) && consts[k] != truncf(consts[k]))) {return EMU_RESULT_OK();}
+    }
+    for (uint8_t in = BLOCK_FOR_IN_START; in <= BLOCK_FOR_IN_STEP && in < block->cfg.in_cnt; in++) {
+        if (((block->cfg.in_connceted_mask >> in) & 1) && !MEM_TYPE_IS_INT(block->ops[in].type)) {return EMU_RESULT_OK();}
+    }
+    data->i.start = emu_float_to_i64(data->start_val);
+    data->i.end   = emu_float_to_i64(data->end_val);
+    data->i.step  = emu_float_to_i64(data->op_step);
+    data->int_mode = true;
+    LOG_I(TAG, "[%"PRIu16"] For iterator runs on integers", block->cfg.block_idx);
     return EMU_RESULT_OK();
 }
@@ -22,7 +22,7 @@ emu_result_t block_in_selector(block_handle_t block){
     if (block_in_updated(block, BLOCK_IN_SEL_SEL)){
         // Fetch selector value
         uint8_t selector = 0; 
-        MEM_GET(&selector, block->inputs[BLOCK_IN_SEL_SEL]);
+        BLOCK_IN_GET(&selector, block, BLOCK_IN_SEL_SEL);
         
         // Options count = total inputs - 2 (EN + SEL)
         uint8_t opt_count = block->cfg.in_cnt - BLOCK_IN_SEL_OPT_BASE;
@@ -32,7 +32,7 @@ emu_result_t block_in_selector(block_handle_t block){
         *block->outputs[0]->instance = *block->inputs[BLOCK_IN_SEL_OPT_BASE + selector]->instance;
     }
     
-    block->outputs[0]->instance->updated = 1; // Mark output as updated so it can trigger next blocks
+    block_mark_output(block, 0, true); // Mark output as updated so it can trigger next blocks
     return EMU_RESULT_OK();
 }
 
@@ -40,9 +40,8 @@ emu_result_t block_latch(block_handle_t block) {
                 break;
             }
         }
-    *block->outputs[0]->instance->data.b = latch->state;
-    block->outputs[0]->instance->updated = 1;
-    return EMU_RESULT_OK();
+    mem_var_t v_out = { .type = MEM_B, .data.val.b = latch->state };
+    return block_set_output(block, v_out, 0);
 }
 
 /*-------------------------------BLOCK PARSER------------------------------------------------------- */
@@ -60,7 +59,7 @@ emu_result_t block_latch_parse(const uint8_t *packet_data, const uint16_t packet
     uint16_t payload_len = packet_len - 1;
 
       if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(block_latch_handle_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(block_latch_handle_t));
         if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "[%d]Null handle ptr", block->cfg.block_idx);
     }
 
@@ -87,12 +86,4 @@ emu_result_t block_latch_verify(block_handle_t block) {
 
 /*-------------------------------BLOCK FREE FUNCTION------------------------------------------------ */
 //handled by generic 
-void block_latch_free(block_handle_t block){
-    if(block && block->custom_data){
-        free(block->custom_data);
-        block->custom_data = NULL;
-        LOG_D(TAG, "[%d]Cleared latch block data", block->cfg.block_idx);
-    }
-    return;
-}
 
@@ -2,6 +2,7 @@
 #include "emu_logging.h"
 #include "emu_variables_acces.h"
 #include "emu_blocks.h" 
+#include "emu_packed.h"
 #include "esp_log.h"
 #include <math.h>
 #include <float.h>
@@ -9,8 +10,8 @@
 
 static const char* TAG = __FILE_NAME__;
 
-#define LOG_INPUTS
-#define LOG_RESULTS
+//#define LOG_INPUTS
+//#define LOG_RESULTS
 
 #define STACK_MAX_DEPTH 16
 
@@ -35,138 +36,175 @@ typedef struct {
     uint8_t input_index; 
 } logic_instruction_t;
 
+/*
+Bit program compiled from RPN at verify (_compile_logic).
+Every condition (comparison or truth of input) writes one bit of condition vector (32 conditions per word).
+AND / OR / NOT trees are flattened (De Morgan for NOT of group) into groups of literals (bit, inverted), group is evaluated
+per word: ALL ((word ^ inv) & mask) == mask, ANY ((word ^ inv) & mask) != 0 and its result is next bit.
+Comparisons are specialized at compile: integer / bool inputs compared as integers (constants turned into integer thresholds),
+float compare only when float input takes part. Compare with Q16.16 input is integer compare in Q16.16 units (integer inputs and
+thresholds scaled at load / compile), so it needs no float either. Constant only parts are folded.
+*/
+typedef enum {
+    LG_GT_F, LG_LT_F, LG_EQ_F, LG_GE_F, LG_LE_F,
+    LG_GT_I, LG_LT_I, LG_EQ_I, LG_GE_I, LG_LE_I,
+    LG_TRUE_F,      /*a > 0.5*/
+    LG_TRUE_I,      /*a > 0*/
+    LG_LOAD_BIT_F,  /*value a = bit b ^ dst as float (condition used as number)*/
+    LG_LOAD_BIT_I,  /*value a = bit b ^ dst as integer*/
+    LG_ALL,         /*all literals of terms a..a+b-1 true*/
+    LG_ANY,         /*any literal of terms a..a+b-1 true*/
+    LG_LOAD_BIT_Q,  /*value a = bit b ^ dst as Q16.16 raw (0 / MEM_Q_ONE)*/
+} logic_bit_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t dst;    /*bit written (not used by loads)*/
+    uint8_t a;
+    uint8_t b;
+} logic_bit_ins_t;
+
+/*Literals of group in one word*/
+typedef struct {
+    uint32_t mask;
+    uint32_t inv;
+    uint8_t word;
+} logic_term_t;
+
+/*Operand value, kind is fixed at compile*/
+typedef union {
+    float f;
+    int64_t i;
+} logic_val_t;
+
+/*Input read before run, type MEM_F reads as float, MEM_Q reads Q16.16 raw value (integers scaled) to .i, other reads input in its own type to .i*/
+typedef struct {
+    uint8_t val;
+    uint8_t in;
+    uint8_t type;
+} logic_load_t;
+
+typedef struct {
+    logic_bit_ins_t *code;
+    uint8_t count;
+    logic_term_t *terms;
+    logic_val_t *vals;      /*inputs, constants (set at compile), conditions used as numbers*/
+    logic_load_t *load;
+    uint8_t load_cnt;
+    uint32_t *bits;         /*condition vector*/
+    uint8_t words;
+    uint8_t result;         /*result bit*/
+    bool result_inv;
+    bool result_const;      /*result known at compile (result_inv is value)*/
+    uint8_t packed_op;      /*RESULT = IN_a op IN_b over whole packed arrays, mem_packed_op_t + 1, 0 = bit program*/
+    uint8_t packed_in[2];
+} logic_program_t;
+
 /*Whole comparision struct*/
 typedef struct {
     logic_instruction_t *code;
     uint8_t count;
     float *constant_table;
+    uint8_t const_count;
+    logic_program_t prog;
 } logic_expression_t;
 
 // Internal Helpers
 static __always_inline bool is_true(float a) {return a > 0.5f;}
-static __always_inline float bool_to_float(bool val) {return val ? 1.0f : 0.0f;}
 
 /*-------------------------------BLOCK IMPLEMENTATION---------------------------------------------- */
 
 #undef OWNER
 #define OWNER EMU_OWNER_block_logic
+/*fault / GPIO mirror masks, 32 elements per word instead of one bit program run per element*/
+static emu_result_t _block_logic_packed(block_handle_t block, const logic_program_t *prog) {
+    uint16_t idx = block->cfg.block_idx;
+    emu_result_t res = mem_packed_op(block->outputs[1]->instance, block->inputs[prog->packed_in[0]]->instance,
+                                     block->inputs[prog->packed_in[1]]->instance, (mem_packed_op_t)(prog->packed_op - 1));
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, ++res.depth, "[%"PRIu16"] Packed arrays op: %s", idx, EMU_ERR_TO_STR(res.code));}
+    mem_flag_set(block->ops[block->cfg.in_cnt + 1].updated);
+    return block_set_output(block, (mem_var_t){.type = MEM_B, .data.val.b = true}, 0);
+}
+
 emu_result_t block_logic(block_handle_t block) {
     if (!emu_block_check_inputs_updated(block)||!block_check_in_true(block, 0)) {RET_OK_INACTIVE(block->cfg.block_idx);}
 
-    //stack opertatin variables
-    logic_expression_t* eval = (logic_expression_t*)block->custom_data;
-    float stack[STACK_MAX_DEPTH]; 
-    int8_t over_top = 0;
-    
+    const logic_program_t *prog = &((logic_expression_t*)block->custom_data)->prog;
+    if (prog->packed_op) {return _block_logic_packed(block, prog);}
+    logic_val_t *v = prog->vals;
+    uint32_t *bits = prog->bits;
     emu_result_t res;
 
-    //this part gets all inputs first so we don't have to access memory multiple times during eval
-    float inputs[block->cfg.in_cnt];
-    memset(inputs, 0, sizeof(inputs)); // Initialize all to safe default
-    //skip input 0 (EN) in reading, but initialize it
-    for (uint8_t i = 1; i < block->cfg.in_cnt; i++) {
-        if(block->cfg.in_connceted_mask & (1 << i)){
-            MEM_GET(&inputs[i], block->inputs[i]);
-            #ifdef LOG_INPUTS
-            LOG_I(TAG, "[%"PRIu16"] Input %d value: %f", block->cfg.block_idx, i, inputs[i]);
-            #endif
+    //only inputs used by expression, in type selected at compile
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        const logic_load_t *ld = &prog->load[i];
+        uint8_t in = ld->in;
+        logic_val_t *dst = &v[ld->val];
+        dst->i = 0;
+        switch (ld->type) {
+            case MEM_F:   BLOCK_IN_GET(&dst->f, block, in); break;
+            case MEM_U8:  {uint8_t x = 0;  BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_U16: {uint16_t x = 0; BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_U32: {uint32_t x = 0; BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_I16: {int16_t x = 0;  BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_I32: {int32_t x = 0;  BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_B:   {bool x = false; BLOCK_IN_GET(&x, block, in); dst->i = x; break;}
+            case MEM_Q:
+                if (block->ops[in].type == MEM_Q) {int32_t x = 0; res = block_in_get_q(block, in, &x); dst->i = x;}
+                else                              {res = block_in_get_int(block, in, &dst->i); dst->i *= MEM_Q_ONE;}
+                if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Input %d %s", block->cfg.block_idx, in, EMU_ERR_TO_STR(res.code));}
+                break;
         }
+        #ifdef LOG_INPUTS
+        LOG_I(TAG, "[%"PRIu16"] Input %d value: %f / %"PRId64"", block->cfg.block_idx, ld->in, dst->f, dst->i);
+        #endif
     }
 
-    float val_a, val_b; //temp variables for operations
-
-
-    for (int8_t i = 0; i < eval->count; i++) {
-        logic_instruction_t *ins = &(eval->code[i]);
-          
+    memset(bits, 0, prog->words * sizeof(uint32_t));
+    const logic_bit_ins_t *ins = prog->code;
+    const logic_bit_ins_t *end = ins + prog->count;
+    for (; ins < end; ins++) {
+        bool r;
         switch (ins->op) {
-            case CMP_OP_VAR:
-                if (over_top >= STACK_MAX_DEPTH) {
-                    RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "[%"PRIu16"] Stack overflow at VAR", block->cfg.block_idx);
-                }
-                stack[over_top++] = inputs[ins->input_index];
-                break;
-
-            case CMP_OP_CONST:
-                if (!eval->constant_table) {
-                    RET_ED(EMU_ERR_NULL_PTR, block->cfg.block_idx, 0, "[%"PRIu16"] Constant table is NULL (no constants packet received)", block->cfg.block_idx);
-                }
-                if (over_top >= STACK_MAX_DEPTH) {
-                    RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "[%"PRIu16"] Stack overflow at CONST", block->cfg.block_idx);
-                }
-                stack[over_top++] = eval->constant_table[ins->input_index];
-                break;
-              
-            case CMP_OP_GT:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(val_a > val_b); 
-                }
-                break;
-
-            case CMP_OP_LT:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(val_a < val_b);
-                }
-                break;
-
-            case CMP_OP_EQ:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(fabsf(val_a - val_b) < FLT_EPSILON);
-                }
-                break;
-
-            case CMP_OP_GTE:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(val_a >= val_b); 
-                }
-                break;
-
-            case CMP_OP_LTE:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(val_a <= val_b);
-                }
-                break;    
-            
-            case CMP_OP_AND:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(is_true(val_a) && is_true(val_b));
-                }
-                break;
-
-            case CMP_OP_OR:
-                if (over_top >= 2) {
-                    val_b = stack[--over_top];
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(is_true(val_a) || is_true(val_b));
+            case LG_GT_F: r = v[ins->a].f > v[ins->b].f; break;
+            case LG_LT_F: r = v[ins->a].f < v[ins->b].f; break;
+            case LG_EQ_F: r = fabsf(v[ins->a].f - v[ins->b].f) < FLT_EPSILON; break;
+            case LG_GE_F: r = v[ins->a].f >= v[ins->b].f; break;
+            case LG_LE_F: r = v[ins->a].f <= v[ins->b].f; break;
+            case LG_GT_I: r = v[ins->a].i > v[ins->b].i; break;
+            case LG_LT_I: r = v[ins->a].i < v[ins->b].i; break;
+            case LG_EQ_I: r = v[ins->a].i == v[ins->b].i; break;
+            case LG_GE_I: r = v[ins->a].i >= v[ins->b].i; break;
+            case LG_LE_I: r = v[ins->a].i <= v[ins->b].i; break;
+            case LG_TRUE_F: r = is_true(v[ins->a].f); break;
+            case LG_TRUE_I: r = v[ins->a].i > 0; break;
+            case LG_LOAD_BIT_F: v[ins->a].f = (float)(((bits[ins->b >> 5] >> (ins->b & 31)) & 1) ^ ins->dst); continue;
+            case LG_LOAD_BIT_I: v[ins->a].i = ((bits[ins->b >> 5] >> (ins->b & 31)) & 1) ^ ins->dst; continue;
+            case LG_LOAD_BIT_Q: v[ins->a].i = (int64_t)((((bits[ins->b >> 5] >> (ins->b & 31)) & 1) ^ ins->dst)) << MEM_Q_FRAC_BITS; continue;
+            case LG_ALL: {
+                const logic_term_t *t = &prog->terms[ins->a];
+                const logic_term_t *t_end = t + ins->b;
+                r = true;
+                for (; t < t_end; t++) {
+                    if (((bits[t->word] ^ t->inv) & t->mask) != t->mask) {r = false; break;}
                 }
                 break;
-
-            case CMP_OP_NOT: 
-                if (over_top >= 1) {
-                    val_a = stack[--over_top];
-                    stack[over_top++] = bool_to_float(!is_true(val_a));
+            }
+            case LG_ANY: {
+                const logic_term_t *t = &prog->terms[ins->a];
+                const logic_term_t *t_end = t + ins->b;
+                r = false;
+                for (; t < t_end; t++) {
+                    if ((bits[t->word] ^ t->inv) & t->mask) {r = true; break;}
                 }
                 break;
-
-            default:
-                RET_ED(EMU_ERR_INVALID_DATA, block->cfg.block_idx, 0, "[%"PRIu16"] Invalid instruction: %d", block->cfg.block_idx, ins->op);
+            }
+            default: continue;
         }
+        bits[ins->dst >> 5] |= (uint32_t)r << (ins->dst & 31);
     }
 
-    //get final result from top of stack
-    bool final_bool = (over_top > 0) ? is_true(stack[over_top - 1]) : false;
+    bool final_bool = prog->result_const ? prog->result_inv : (((bits[prog->result >> 5] >> (prog->result & 31)) & 1) ^ prog->result_inv);
     #ifdef LOG_RESULTS
     LOG_I(TAG, "[%"PRIu16"] Final logic result: %s", block->cfg.block_idx, final_bool ? "true" : "false");
     #endif
@@ -193,10 +231,13 @@ static emu_err_t _parse_logic_constants(const uint8_t *data, uint16_t len, logic
     uint8_t count = data[0];
     if (len < 1 + count * sizeof(float)) return EMU_ERR_PACKET_INCOMPLETE;
     
-    if (expr->constant_table) free(expr->constant_table);
-    expr->constant_table = (float*)calloc(count, sizeof(float));
-    if (!expr->constant_table) return EMU_ERR_NO_MEM;
+    //table in arena is reused when resent table fits
+    if (!expr->constant_table || count > expr->const_count) {
+        expr->constant_table = (float*)emu_arena_alloc(EMU_ARENA_BLOCKS, (count ? count : 1) * sizeof(float));
+        if (!expr->constant_table) return EMU_ERR_NO_MEM;
+    }
     
+    expr->const_count = count;
     for (uint8_t i = 0; i < count; i++) {
         memcpy(&expr->constant_table[i], &data[1 + i * sizeof(float)], sizeof(float));
     }
@@ -213,9 +254,10 @@ static emu_err_t _parse_logic_instructions(const uint8_t *data, uint16_t len, lo
     uint8_t count = data[0];
     if (len < 1 + count * 2) return EMU_ERR_PACKET_INCOMPLETE;
     
-    if (expr->code) free(expr->code);
-    expr->code = (logic_instruction_t*)calloc(count, sizeof(logic_instruction_t));
-    if (!expr->code) return EMU_ERR_NO_MEM;
+    if (!expr->code || count > expr->count) {
+        expr->code = (logic_instruction_t*)emu_arena_alloc(EMU_ARENA_BLOCKS, (count ? count : 1) * sizeof(logic_instruction_t));
+        if (!expr->code) return EMU_ERR_NO_MEM;
+    }
     
     expr->count = count;
     for (uint8_t i = 0; i < count; i++) {
@@ -240,7 +282,7 @@ emu_result_t block_logic_parse(const uint8_t *packet_data, const uint16_t packet
     
     // Allocate custom data only if it doesn't exist yet
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(logic_expression_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(logic_expression_t));
         if (!block->custom_data) {RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "[%"PRIu16"] No memory for logic custom_data", block->cfg.block_idx);}
     }
     
@@ -265,35 +307,471 @@ emu_result_t block_logic_parse(const uint8_t *packet_data, const uint16_t packet
     return EMU_RESULT_OK();
 }
 
+/*-------------------------------BLOCK COMPILER---------------------------------------------- */
+
+#define LOGIC_NONE  UINT8_MAX
+#define LOGIC_LIMIT UINT8_MAX   /*max bits / values / instructions / terms of program*/
+#define LOGIC_INT_LIMIT 1099511627776.0 /*2^40, integer thresholds are clamped (inputs are at most 32 bit)*/
+#define LOGIC_Q_LIMIT   72057594037927936.0 /*2^56, same for thresholds in Q16.16 units (inputs are at most 48 bit)*/
+
+/*How value of input / operand is read for instruction*/
+typedef enum {
+    LOGIC_AS_F = 0,
+    LOGIC_AS_I,
+    LOGIC_AS_Q,
+    LOGIC_AS_CNT,
+} logic_as_t;
+
+typedef enum {
+    LS_INPUT,   /*input value*/
+    LS_CONST,   /*number known at compile*/
+    LS_BOOL,    /*condition known at compile*/
+    LS_LIT,     /*condition bit*/
+    LS_GROUP,   /*AND / OR of literals, emitted when used by other operation*/
+} logic_slot_kind_t;
+
+typedef struct {
+    uint8_t bit;
+    bool inv;
+} logic_lit_t;
+
+/*Compile time stack entry*/
+typedef struct {
+    uint8_t kind;
+    uint8_t in;         /*LS_INPUT*/
+    float val;          /*LS_CONST*/
+    bool b;             /*LS_BOOL*/
+    logic_lit_t lit;    /*LS_LIT*/
+    bool any;           /*LS_GROUP: OR, else AND*/
+    uint16_t lit_cnt;   /*LS_GROUP: literals in lits[slot]*/
+} logic_slot_t;
+
+typedef struct {
+    block_handle_t block;
+    logic_slot_t stack[STACK_MAX_DEPTH];
+    logic_lit_t lits[STACK_MAX_DEPTH][LOGIC_LIMIT + 1];
+    logic_bit_ins_t code[LOGIC_LIMIT];
+    logic_term_t terms[LOGIC_LIMIT];
+    logic_val_t vals[LOGIC_LIMIT];
+    logic_load_t load[LOGIC_LIMIT];
+    uint8_t in_val[LOGIC_AS_CNT][UINT8_MAX + 1];   /*value of input read as logic_as_t*/
+    uint16_t code_cnt;
+    uint16_t term_cnt;
+    uint16_t val_cnt;
+    uint16_t load_cnt;
+    uint16_t bit_cnt;
+} logic_compiler_t;
+
+static bool _emit(logic_compiler_t *c, uint8_t op, uint8_t dst, uint8_t a, uint8_t b) {
+    if (c->code_cnt >= LOGIC_LIMIT) {return false;}
+    c->code[c->code_cnt++] = (logic_bit_ins_t){.op = op, .dst = dst, .a = a, .b = b};
+    return true;
+}
+
+static bool _new_bit(logic_compiler_t *c, uint8_t *bit) {
+    if (c->bit_cnt >= LOGIC_LIMIT) {return false;}
+    *bit = c->bit_cnt++;
+    return true;
+}
+
+static bool _new_val(logic_compiler_t *c, uint8_t *val) {
+    if (c->val_cnt >= LOGIC_LIMIT) {return false;}
+    *val = c->val_cnt++;
+    return true;
+}
+
+static __always_inline bool _input_is_int(logic_compiler_t *c, uint8_t in) {
+    return c->block->inputs[in]->instance->type != MEM_F;
+}
+
+static __always_inline bool _input_is_q(logic_compiler_t *c, uint8_t in) {
+    return c->block->inputs[in]->instance->type == MEM_Q;
+}
+
+/**
+ * @brief Value of input, loaded once per cycle as float, in its own integer type or as Q16.16
+ */
+static bool _input_val(logic_compiler_t *c, uint8_t in, logic_as_t as, uint8_t *val) {
+    if (c->in_val[as][in] != LOGIC_NONE) {*val = c->in_val[as][in]; return true;}
+    if (!_new_val(c, val)) {return false;}
+    uint8_t type = (as == LOGIC_AS_F) ? MEM_F : (as == LOGIC_AS_Q) ? MEM_Q : c->block->inputs[in]->instance->type;
+    c->load[c->load_cnt++] = (logic_load_t){.val = *val, .in = in, .type = type};
+    c->in_val[as][in] = *val;
+    return true;
+}
+
+/**
+ * @brief Emit group as ALL / ANY over words of condition vector, slot becomes literal of its result
+ */
+static bool _materialize(logic_compiler_t *c, uint8_t s) {
+    logic_slot_t *slot = &c->stack[s];
+    if (slot->kind != LS_GROUP) {return true;}
+    uint16_t first = c->term_cnt;
+    for (uint16_t i = 0; i < slot->lit_cnt; i++) {
+        const logic_lit_t *lit = &c->lits[s][i];
+        uint32_t m = 1u << (lit->bit & 31);
+        logic_term_t *t = NULL;
+        for (uint16_t k = first; k < c->term_cnt; k++) {
+            //same bit twice (a && !a) goes to separate term
+            if (c->terms[k].word == (lit->bit >> 5) && !(c->terms[k].mask & m)) {t = &c->terms[k]; break;}
+        }
+        if (!t) {
+            if (c->term_cnt >= LOGIC_LIMIT) {return false;}
+            t = &c->terms[c->term_cnt++];
+            *t = (logic_term_t){.word = lit->bit >> 5};
+        }
+        t->mask |= m;
+        if (lit->inv) {t->inv |= m;}
+    }
+    uint8_t bit;
+    if (!_new_bit(c, &bit) || !_emit(c, slot->any ? LG_ANY : LG_ALL, bit, first, c->term_cnt - first)) {return false;}
+    *slot = (logic_slot_t){.kind = LS_LIT, .lit = {.bit = bit}};
+    return true;
+}
+
+/**
+ * @brief Make slot condition (literal or known bool): number is true when > 0.5
+ */
+static bool _to_cond(logic_compiler_t *c, uint8_t s) {
+    logic_slot_t *slot = &c->stack[s];
+    switch (slot->kind) {
+        case LS_CONST:
+            *slot = (logic_slot_t){.kind = LS_BOOL, .b = is_true(slot->val)};
+            return true;
+        case LS_INPUT: {
+            uint8_t val, bit;
+            if (_input_is_q(c, slot->in)) {
+                //Q16.16 is true when > 0.5 like float
+                uint8_t half;
+                if (!_input_val(c, slot->in, LOGIC_AS_Q, &val) || !_new_val(c, &half) || !_new_bit(c, &bit)) {return false;}
+                c->vals[half].i = MEM_Q_ONE >> 1;
+                if (!_emit(c, LG_GT_I, bit, val, half)) {return false;}
+                *slot = (logic_slot_t){.kind = LS_LIT, .lit = {.bit = bit}};
+                return true;
+            }
+            bool as_int = _input_is_int(c, slot->in);
+            if (!_input_val(c, slot->in, as_int ? LOGIC_AS_I : LOGIC_AS_F, &val) || !_new_bit(c, &bit)) {return false;}
+            if (!_emit(c, as_int ? LG_TRUE_I : LG_TRUE_F, bit, val, 0)) {return false;}
+            *slot = (logic_slot_t){.kind = LS_LIT, .lit = {.bit = bit}};
+            return true;
+        }
+        case LS_GROUP:
+            return _materialize(c, s);
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief Value of number operand for compare
+ */
+static bool _operand_val(logic_compiler_t *c, const logic_slot_t *slot, logic_as_t as, uint8_t *val) {
+    if (slot->kind == LS_INPUT) {return _input_val(c, slot->in, as, val);}
+    if (!_new_val(c, val)) {return false;}
+    if (slot->kind == LS_CONST) {
+        c->vals[*val].f = slot->val;
+        return true;
+    }
+    //condition used as number 0 / 1, dst of load is inversion
+    static const uint8_t load_op[LOGIC_AS_CNT] = {[LOGIC_AS_F] = LG_LOAD_BIT_F, [LOGIC_AS_I] = LG_LOAD_BIT_I, [LOGIC_AS_Q] = LG_LOAD_BIT_Q};
+    return _emit(c, load_op[as], slot->lit.inv, *val, slot->lit.bit);
+}
+
+static bool _fold_cmp(uint8_t op, float a, float b) {
+    switch (op) {
+        case CMP_OP_GT:  return a > b;
+        case CMP_OP_LT:  return a < b;
+        case CMP_OP_EQ:  return fabsf(a - b) < FLT_EPSILON;
+        case CMP_OP_GTE: return a >= b;
+        default:         return a <= b;
+    }
+}
+
+/**
+ * @brief Compare of slots s (left) and s + 1 (right), result in slot s
+ */
+static bool _compile_cmp(logic_compiler_t *c, uint8_t op, uint8_t s) {
+    logic_slot_t *x = &c->stack[s];
+    logic_slot_t *y = &c->stack[s + 1];
+    for (uint8_t k = 0; k < 2; k++) {
+        logic_slot_t *o = k ? y : x;
+        if (o->kind == LS_GROUP && !_materialize(c, s + k)) {return false;}
+        if (o->kind == LS_BOOL) {*o = (logic_slot_t){.kind = LS_CONST, .val = o->b ? 1.0f : 0.0f};}
+    }
+    if (x->kind == LS_CONST && y->kind == LS_CONST) {
+        *x = (logic_slot_t){.kind = LS_BOOL, .b = _fold_cmp(op, x->val, y->val)};
+        return true;
+    }
+
+    //integer compare unless float input takes part (conditions are 0 / 1 integers)
+    bool as_int = !(x->kind == LS_INPUT && !_input_is_int(c, x->in)) && !(y->kind == LS_INPUT && !_input_is_int(c, y->in));
+    //Q16.16 input makes it integer compare in Q16.16 units
+    bool as_q = as_int && ((x->kind == LS_INPUT && _input_is_q(c, x->in)) || (y->kind == LS_INPUT && _input_is_q(c, y->in)));
+    uint8_t va, vb;
+    uint8_t lg_op;
+    if (as_int) {
+        //constant to right side, mirror operator
+        if (x->kind == LS_CONST) {
+            logic_slot_t t = *x; *x = *y; *y = t;
+            op = (op == CMP_OP_GT) ? CMP_OP_LT : (op == CMP_OP_LT) ? CMP_OP_GT : (op == CMP_OP_GTE) ? CMP_OP_LTE : (op == CMP_OP_LTE) ? CMP_OP_GTE : op;
+        }
+        int64_t th = 0;
+        if (y->kind == LS_CONST) {
+            double cv = as_q ? (double)y->val * MEM_Q_ONE : y->val;
+            double limit = as_q ? LOGIC_Q_LIMIT : LOGIC_INT_LIMIT;
+            if (isnan(cv) || (op == CMP_OP_EQ && cv != floor(cv))) {
+                *x = (logic_slot_t){.kind = LS_BOOL, .b = false};
+                return true;
+            }
+            //x > 2.5 is x > 2, x >= 2.5 is x >= 3 ...
+            cv = (op == CMP_OP_GT || op == CMP_OP_LTE) ? floor(cv) : ceil(cv);
+            if (cv > limit) {cv = limit;}
+            if (cv < -limit) {cv = -limit;}
+            th = (int64_t)cv;
+        }
+        logic_as_t as = as_q ? LOGIC_AS_Q : LOGIC_AS_I;
+        if (!_operand_val(c, x, as, &va) || !_operand_val(c, y, as, &vb)) {return false;}
+        if (y->kind == LS_CONST) {c->vals[vb].i = th;}
+        lg_op = LG_GT_I;
+    } else {
+        if (!_operand_val(c, x, LOGIC_AS_F, &va) || !_operand_val(c, y, LOGIC_AS_F, &vb)) {return false;}
+        lg_op = LG_GT_F;
+    }
+    switch (op) {
+        case CMP_OP_GT:  break;
+        case CMP_OP_LT:  lg_op += 1; break;
+        case CMP_OP_EQ:  lg_op += 2; break;
+        case CMP_OP_GTE: lg_op += 3; break;
+        default:         lg_op += 4; break;
+    }
+    uint8_t bit;
+    if (!_new_bit(c, &bit) || !_emit(c, lg_op, bit, va, vb)) {return false;}
+    *x = (logic_slot_t){.kind = LS_LIT, .lit = {.bit = bit}};
+    return true;
+}
+
+/**
+ * @brief AND / OR of slots s and s + 1, result in slot s (literals are merged into one group)
+ */
+static bool _compile_group(logic_compiler_t *c, bool any, uint8_t s) {
+    for (uint8_t k = 0; k < 2; k++) {
+        logic_slot_t *o = &c->stack[s + k];
+        if (o->kind == LS_GROUP && o->any == any) {continue;}
+        if (!_to_cond(c, s + k)) {return false;}
+    }
+    logic_slot_t *x = &c->stack[s];
+    logic_slot_t *y = &c->stack[s + 1];
+
+    //known operand: a && 1 = a, a && 0 = 0, a || 0 = a, a || 1 = 1
+    if (x->kind == LS_BOOL || y->kind == LS_BOOL) {
+        const logic_slot_t *known = (x->kind == LS_BOOL) ? x : y;
+        if (known->b == any) {
+            *x = (logic_slot_t){.kind = LS_BOOL, .b = any};
+        } else if (x->kind == LS_BOOL) {
+            *x = *y;
+            memcpy(c->lits[s], c->lits[s + 1], y->lit_cnt * sizeof(logic_lit_t));
+        }
+        return true;
+    }
+
+    if (x->kind == LS_LIT) {
+        c->lits[s][0] = x->lit;
+        *x = (logic_slot_t){.kind = LS_GROUP, .any = any, .lit_cnt = 1};
+    }
+    if (y->kind == LS_LIT) {
+        c->lits[s][x->lit_cnt++] = y->lit;
+    } else {
+        memcpy(&c->lits[s][x->lit_cnt], c->lits[s + 1], y->lit_cnt * sizeof(logic_lit_t));
+        x->lit_cnt += y->lit_cnt;
+    }
+    return true;
+}
+
+static void _compile_not(logic_compiler_t *c, uint8_t s) {
+    logic_slot_t *x = &c->stack[s];
+    switch (x->kind) {
+        case LS_BOOL:
+            x->b = !x->b;
+            break;
+        case LS_LIT:
+            x->lit.inv = !x->lit.inv;
+            break;
+        case LS_GROUP:
+            //De Morgan: !(a && b) = !a || !b
+            x->any = !x->any;
+            for (uint16_t i = 0; i < x->lit_cnt; i++) {c->lits[s][i].inv = !c->lits[s][i].inv;}
+            break;
+    }
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_block_logic_verify
+static emu_result_t _compile_logic(block_handle_t block, logic_expression_t *expr) {
+    uint16_t idx = block->cfg.block_idx;
+    logic_program_t *prog = &expr->prog;
+    logic_compiler_t *c = (logic_compiler_t*)calloc(1, sizeof(logic_compiler_t));
+    emu_err_t err = EMU_ERR_BLOCK_INVALID_PARAM;
+    uint8_t depth = 0;
+
+    if (!c) {RET_ED(EMU_ERR_NO_MEM, idx, 0, "[%"PRIu16"] No memory for logic compiler", idx);}
+    c->block = block;
+    memset(c->in_val, LOGIC_NONE, sizeof(c->in_val));
+
+    for (uint8_t i = 0; i < expr->count; i++) {
+        const logic_instruction_t *ins = &expr->code[i];
+        switch (ins->op) {
+            case CMP_OP_VAR:
+            case CMP_OP_CONST:
+                if (depth >= STACK_MAX_DEPTH) {LOG_E(TAG, "[%"PRIu16"] Stack overflow at %"PRIu8"", idx, i); goto fail;}
+                if (ins->op == CMP_OP_VAR) {
+                    if (ins->input_index >= block->cfg.in_cnt) {LOG_E(TAG, "[%"PRIu16"] Input %"PRIu8" out of range", idx, ins->input_index); goto fail;}
+                    //EN and not connected inputs read as 0
+                    if (ins->input_index == 0 || !((block->cfg.in_connceted_mask >> ins->input_index) & 1)) {
+                        c->stack[depth++] = (logic_slot_t){.kind = LS_CONST, .val = 0.0f};
+                    } else {
+                        c->stack[depth++] = (logic_slot_t){.kind = LS_INPUT, .in = ins->input_index};
+                    }
+                } else {
+                    if (!expr->constant_table || ins->input_index >= expr->const_count) {LOG_E(TAG, "[%"PRIu16"] Constant %"PRIu8" out of range", idx, ins->input_index); goto fail;}
+                    c->stack[depth++] = (logic_slot_t){.kind = LS_CONST, .val = expr->constant_table[ins->input_index]};
+                }
+                break;
+
+            case CMP_OP_GT:
+            case CMP_OP_LT:
+            case CMP_OP_EQ:
+            case CMP_OP_GTE:
+            case CMP_OP_LTE:
+            case CMP_OP_AND:
+            case CMP_OP_OR:
+                if (depth < 2) {LOG_E(TAG, "[%"PRIu16"] Stack underflow at %"PRIu8"", idx, i); goto fail;}
+                depth--;
+                if (ins->op == CMP_OP_AND || ins->op == CMP_OP_OR) {
+                    if (!_compile_group(c, ins->op == CMP_OP_OR, depth - 1)) {goto too_large;}
+                } else {
+                    if (!_compile_cmp(c, ins->op, depth - 1)) {goto too_large;}
+                }
+                break;
+
+            case CMP_OP_NOT:
+                if (depth < 1) {LOG_E(TAG, "[%"PRIu16"] Stack underflow at %"PRIu8"", idx, i); goto fail;}
+                if (c->stack[depth - 1].kind != LS_GROUP && !_to_cond(c, depth - 1)) {goto too_large;}
+                _compile_not(c, depth - 1);
+                break;
+
+            default:
+                LOG_E(TAG, "[%"PRIu16"] Invalid instruction 0x%02X at %"PRIu8"", idx, ins->op, i);
+                goto fail;
+        }
+    }
+
+    //values under result are never used, program is malformed
+    if (depth > 1) {LOG_E(TAG, "[%"PRIu16"] %"PRIu8" values left on stack", idx, depth); goto fail;}
+    //empty expression is false
+    if (!depth) {
+        c->stack[depth++] = (logic_slot_t){.kind = LS_BOOL, .b = false};
+    }
+    if (!_to_cond(c, depth - 1)) {goto too_large;}
+    logic_slot_t *top = &c->stack[depth - 1];
+    prog->result_const = (top->kind == LS_BOOL);
+    prog->result_inv = prog->result_const ? top->b : top->lit.inv;
+    prog->result = prog->result_const ? 0 : top->lit.bit;
+
+    prog->count = c->code_cnt;
+    prog->load_cnt = c->load_cnt;
+    prog->words = (c->bit_cnt + 31) / 32;
+    if (!prog->words) {prog->words = 1;}
+    prog->code = (logic_bit_ins_t*)calloc(c->code_cnt ? c->code_cnt : 1, sizeof(logic_bit_ins_t));
+    prog->terms = (logic_term_t*)calloc(c->term_cnt ? c->term_cnt : 1, sizeof(logic_term_t));
+    prog->vals = (logic_val_t*)calloc(c->val_cnt ? c->val_cnt : 1, sizeof(logic_val_t));
+    prog->load = (logic_load_t*)calloc(c->load_cnt ? c->load_cnt : 1, sizeof(logic_load_t));
+    prog->bits = (uint32_t*)calloc(prog->words, sizeof(uint32_t));
+    if (!prog->code || !prog->terms || !prog->vals || !prog->load || !prog->bits) {err = EMU_ERR_NO_MEM; goto fail;}
+    memcpy(prog->code, c->code, c->code_cnt * sizeof(logic_bit_ins_t));
+    memcpy(prog->terms, c->terms, c->term_cnt * sizeof(logic_term_t));
+    memcpy(prog->vals, c->vals, c->val_cnt * sizeof(logic_val_t));
+    memcpy(prog->load, c->load, c->load_cnt * sizeof(logic_load_t));
+    free(c);
+    return EMU_RESULT_OK();
+
+too_large:
+    LOG_E(TAG, "[%"PRIu16"] Expression exceeds %d conditions / values / terms", idx, LOGIC_LIMIT);
+fail:
+    free(c);
+    RET_ED(err, idx, 0, "[%"PRIu16"] Logic expression compile failed", idx);
+}
+
 /*-------------------------------BLOCK VERIFIER---------------------------------------------- */
 
+static void _clear_logic_program(logic_program_t *prog) {
+    free(prog->code);
+    free(prog->terms);
+    free(prog->vals);
+    free(prog->load);
+    free(prog->bits);
+    memset(prog, 0, sizeof(*prog));
+}
+
+/*access covers whole packed bool array (1D, static index 0, slice to end)*/
+static bool _is_whole_packed(const mem_access_t *access) {
+    if (!access || !access->whole_array || !access->is_index_resolved || !access->instance->packed) {return false;}
+    return access->indices_cnt == 1 && access->resolved_index == 0 && mem_access_slice(access)->count == mem_instance_el_cnt(access->instance);
+}
+
+/**
+ * @brief RESULT connected to whole packed array selects word kernel, expression has to be [VAR a][VAR b][AND | OR] of whole packed arrays
+ */
+static emu_err_t _prepare_packed(block_handle_t block, logic_expression_t *expr) {
+    logic_program_t *prog = &expr->prog;
+    if (block->cfg.q_cnt < 2 || !block->outputs[1] || !block->outputs[1]->whole_array) {return EMU_OK;}
+    if (!_is_whole_packed(block->outputs[1])) {return EMU_ERR_MEM_INVALID_DATATYPE;}
+    if (expr->count != 3 || expr->code[0].op != CMP_OP_VAR || expr->code[1].op != CMP_OP_VAR) {return EMU_ERR_BLOCK_INVALID_PARAM;}
+    uint8_t op = expr->code[2].op;
+    if (op != CMP_OP_AND && op != CMP_OP_OR) {return EMU_ERR_BLOCK_INVALID_PARAM;}
+    uint32_t cnt = mem_instance_el_cnt(block->outputs[1]->instance);
+    for (uint8_t i = 0; i < 2; i++) {
+        uint8_t in = expr->code[i].input_index;
+        if (in == 0 || in >= block->cfg.in_cnt || !((block->cfg.in_connceted_mask >> in) & 1)) {return EMU_ERR_BLOCK_INVALID_PARAM;}
+        if (!_is_whole_packed(block->inputs[in])) {return EMU_ERR_MEM_INVALID_DATATYPE;}
+        if (mem_instance_el_cnt(block->inputs[in]->instance) != cnt) {return EMU_ERR_MEM_OUT_OF_BOUNDS;}
+        prog->packed_in[i] = in;
+    }
+    prog->packed_op = (op == CMP_OP_AND ? MEM_PACKED_AND : MEM_PACKED_OR) + 1;
+    return EMU_OK;
+}
+
 #undef OWNER
 #define OWNER EMU_OWNER_block_logic_verify
 emu_result_t block_logic_verify(block_handle_t block) {
     if (!block->custom_data) {RET_ED(EMU_ERR_NULL_PTR, block->cfg.block_idx, 0, "Custom Data is NULL %d", block->cfg.block_idx);}
     logic_expression_t *data = (logic_expression_t*)block->custom_data;
-    if (data->count == 0) {RET_WD(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "Empty expression (count=0) %d", block->cfg.block_idx);}
 
     if (data->count > 0 && data->code == NULL) {RET_ED(EMU_ERR_NULL_PTR, block->cfg.block_idx, 0, "Code pointer is NULL, %d", block->cfg.block_idx);}
 
+    _clear_logic_program(&data->prog);
+    emu_result_t res = _compile_logic(block, data);
+    if (res.code != EMU_OK) {
+        _clear_logic_program(&data->prog);
+        return res;
+    }
+    emu_err_t err = _prepare_packed(block, data);
+    if (err != EMU_OK) {
+        _clear_logic_program(&data->prog);
+        RET_ED(err, block->cfg.block_idx, 0, "[%"PRIu16"] Packed array RESULT needs IN_a IN_b AND / OR of whole packed arrays", block->cfg.block_idx);
+    }
+
+    if (data->count == 0) {RET_WD(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "Empty expression (count=0) %d", block->cfg.block_idx);}
     return EMU_RESULT_OK();
 }
 
 /*-------------------------------BLOCK FREE FUNCTION---------------------------------------------- */
 
 
-static void _clear_logic_expression_internals(logic_expression_t* expr){
-    if(expr->code) free(expr->code);
-    if(expr->constant_table) free(expr->constant_table);
-}
-
 void block_logic_free(block_handle_t block){
     if(block && block->custom_data){
+        //expression and its tables are in arena, compiled program is on heap
         logic_expression_t* expr = (logic_expression_t*)block->custom_data;
-        _clear_logic_expression_internals(expr);
-        free(expr);
+        _clear_logic_program(&expr->prog);
         block->custom_data = NULL;
     }
 }
-
-
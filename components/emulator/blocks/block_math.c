@@ -2,6 +2,7 @@
 #include "emu_logging.h"
 #include "emu_variables_acces.h"
 #include "emu_blocks.h" 
+#include "emu_helpers.h"
 #include "esp_log.h"
 #include <math.h>
 #include <float.h>
@@ -39,82 +40,303 @@ typedef struct {
 } instruction_t;
 
 
+/*
+Register program compiled from RPN at verify (_compile_program).
+Register file: [temps: stack slots 0..STACK_MAX_DEPTH-1][inputs: REG_INPUTS + input index][constants]
+VAR / CONST don't generate instructions, they only give operand register to next operation. Constant only subtrees are folded,
+multiply followed by add / sub of its product is fused. Stack depth, underflow, balance (one value left) and operand indices
+are checked once at compile, so runtime executes instructions without any checks (only div by zero remains).
+*/
+#define REG_INPUTS STACK_MAX_DEPTH
+#define REG_MAX    UINT8_MAX
+
+typedef enum{
+    MATH_ADD,
+    MATH_SUB,
+    MATH_MUL,
+    MATH_DIV,
+    MATH_COS,
+    MATH_SIN,
+    MATH_POW,
+    MATH_ROOT,
+    MATH_MADD,  // a*b + c
+    MATH_MSUB,  // a*b - c
+    MATH_NMSUB, // c - a*b
+}math_reg_op_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t dst;
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+} math_reg_ins_t;
+
+typedef enum{
+    MATH_INT_NONE = 0,
+    MATH_INT_64,        /*whole numbers, int64_t registers (intermediates of int32 / u32 operands never saturate)*/
+    MATH_INT_Q,         /*Q16.16 result, int32_t registers hold raw fixed point values*/
+}math_int_mode_t;
+
+typedef struct {
+    math_reg_ins_t *code;
+    uint8_t count;
+    float *regs;        /*register file, temps and inputs written at runtime, constants set at compile*/
+    uint8_t reg_cnt;
+    uint8_t *load;      /*inputs used by program (read before run)*/
+    uint8_t load_cnt;
+    uint8_t result;     /*register with result*/
+    float *vregs;       /*vector mode: register columns [reg][MATH_VEC_CHUNK], NULL in scalar mode*/
+    uint16_t span_mask; /*vector mode: inputs read as spans, others are broadcast*/
+    void *iregs;        /*integer mode: int32_t / int64_t register file (int_mode), NULL when program runs on floats*/
+    uint8_t int_mode;   /*math_int_mode_t*/
+} math_program_t;
+
 typedef struct{
     instruction_t *code;
     uint8_t count;
     float *constant_table;
     uint8_t const_count;
+    math_program_t prog;
 } expression_t;
 
+/*
+Vector mode (RESULT output is span access, mem_get_span): same register program is run element-wise over spans.
+Every register is column of MATH_VEC_CHUNK floats, span inputs are loaded chunk by chunk, other inputs and constants are broadcast.
+Loops over columns have fixed length and no dependencies between lanes, so GCC vectorizes them (-O2 and above) where target has float SIMD.
+*/
+#define MATH_VEC_CHUNK 16
+#define MATH_VEC_MAX_INPUTS 16 /*span_mask bits*/
+#define VREG(v, r) ((v) + (size_t)(r) * MATH_VEC_CHUNK)
+
+static __always_inline void _column_fill(float *col, float val) {
+    for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {col[k] = val;}
+}
+
+static void _column_load(float *col, const mem_span_t *span, uint16_t first, uint16_t n) {
+    size_t s = span->stride;
+    size_t at = (size_t)first * s;
+    switch (span->type) {
+        case MEM_F:
+            if (s == 1) {memcpy(col, &span->data.f[first], n * sizeof(float)); break;}
+            for (uint16_t k = 0; k < n; k++) {col[k] = span->data.f[at + k * s];}
+            break;
+        case MEM_U8:  for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.u8[at + k * s];}  break;
+        case MEM_U16: for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.u16[at + k * s];} break;
+        case MEM_U32: for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.u32[at + k * s];} break;
+        case MEM_I16: for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.i16[at + k * s];} break;
+        case MEM_I32: for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.i32[at + k * s];} break;
+        case MEM_B:   for (uint16_t k = 0; k < n; k++) {col[k] = span->data.b[at + k * s] ? 1.0f : 0.0f;} break;
+        case MEM_Q:   for (uint16_t k = 0; k < n; k++) {col[k] = (float)span->data.q[at + k * s] * (1.0f / MEM_Q_ONE);} break;
+    }
+}
+
+static void _column_store(const mem_span_t *span, uint16_t first, const float *col, uint16_t n) {
+    size_t s = span->stride;
+    uint8_t size = MEM_TYPE_SIZES[span->type];
+    if (span->type == MEM_F && s == 1) {memcpy(&span->data.f[first], col, n * sizeof(float)); return;}
+    //same rounding / clamping as block_set_output
+    emu_conv_kernel_t kernel = emu_conv_kernels[MEM_F][span->type];
+    for (uint16_t k = 0; k < n; k++) {kernel(span->data.u8 + ((size_t)first + k) * s * size, &col[k]);}
+}
+
+/**
+ * @brief Run program on columns, lanes after n are computed too (values unused)
+ * @return false on div by zero in first n lanes
+ */
+static bool _run_columns(const math_program_t *prog, float *v, uint16_t n) {
+    const math_reg_ins_t *ins = prog->code;
+    const math_reg_ins_t *end = ins + prog->count;
+    for (; ins < end; ins++) {
+        //dst can be same column as operand (never partially overlapping), lanes are independent
+        float *d = VREG(v, ins->dst);
+        const float *a = VREG(v, ins->a), *b = VREG(v, ins->b), *c = VREG(v, ins->c);
+        switch (ins->op) {
+            case MATH_ADD:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] + b[k];}
+                break;
+            case MATH_SUB:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] - b[k];}
+                break;
+            case MATH_MUL:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] * b[k];}
+                break;
+            case MATH_DIV: {
+                bool zero = false;
+                for (uint16_t k = 0; k < n; k++) {zero |= is_zero(b[k]);}
+                if (zero) {return false;}
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] / b[k];}
+                break;
+            }
+            case MATH_COS:   for (uint16_t k = 0; k < n; k++) {d[k] = cosf(a[k]);} break;
+            case MATH_SIN:   for (uint16_t k = 0; k < n; k++) {d[k] = sinf(a[k]);} break;
+            case MATH_POW:   for (uint16_t k = 0; k < n; k++) {d[k] = powf(a[k], b[k]);} break;
+            case MATH_ROOT:  for (uint16_t k = 0; k < n; k++) {d[k] = sqrtf(a[k]);} break;
+            case MATH_MADD:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] * b[k] + c[k];}
+                break;
+            case MATH_MSUB:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = a[k] * b[k] - c[k];}
+                break;
+            case MATH_NMSUB:
+                _Pragma("GCC ivdep") for (uint8_t k = 0; k < MATH_VEC_CHUNK; k++) {d[k] = c[k] - a[k] * b[k];}
+                break;
+        }
+    }
+    return true;
+}
+
+/*
+Integer mode (selected at verify): result and every used input are integer types, constants are whole numbers and expression has only
++ - * / (and fused forms). Program is run on integer registers with saturating kernels (emu_helpers.h), so counts and timestamps
+above 2^24 keep every bit and targets without FPU don't use soft-float. Registers are int64_t, so product of two int32 / u32 values
+is exact and only result is clamped to output type. Division rounds like float result stored into integer, so it is allowed only as
+last instruction, division feeding other operation keeps program on floats ((7 / 2) * 2 is 7, not 8).
+Q16.16 result (MEM_Q) selects same program on raw fixed point registers, integer inputs are scaled on load, constants rounded at verify.
+*/
+#define MATH_INT_RUN(NAME, T, ADD, SUB, MUL, DIV) \
+static bool _run_##NAME(const math_program_t *prog, T *r) { \
+    const math_reg_ins_t *ins = prog->code; \
+    const math_reg_ins_t *end = ins + prog->count; \
+    for (; ins < end; ins++) { \
+        switch (ins->op) { \
+            case MATH_ADD:   r[ins->dst] = ADD(r[ins->a], r[ins->b]); break; \
+            case MATH_SUB:   r[ins->dst] = SUB(r[ins->a], r[ins->b]); break; \
+            case MATH_MUL:   r[ins->dst] = MUL(r[ins->a], r[ins->b]); break; \
+            case MATH_DIV: \
+                if (r[ins->b] == 0) {return false;} \
+                r[ins->dst] = DIV(r[ins->a], r[ins->b]); \
+                break; \
+            case MATH_MADD:  r[ins->dst] = ADD(MUL(r[ins->a], r[ins->b]), r[ins->c]); break; \
+            case MATH_MSUB:  r[ins->dst] = SUB(MUL(r[ins->a], r[ins->b]), r[ins->c]); break; \
+            case MATH_NMSUB: r[ins->dst] = SUB(r[ins->c], MUL(r[ins->a], r[ins->b])); break; \
+        } \
+    } \
+    return true; \
+}
+
+MATH_INT_RUN(i64, int64_t, emu_sat_add_i64, emu_sat_sub_i64, emu_sat_mul_i64, emu_sat_div_i64)
+MATH_INT_RUN(q,   int32_t, emu_sat_add_i32, emu_sat_sub_i32, emu_q_mul,       emu_q_div)
+
 /*-------------------------------BLOCK IMPLEMENTATION---------------------------------------------- */
 
 #undef OWNER
 #define OWNER EMU_OWNER_block_math
+static emu_result_t _block_math_int(block_handle_t block, const math_program_t *prog) {
+    uint16_t idx = block->cfg.block_idx;
+    int64_t result;
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        uint8_t in = prog->load[i];
+        int64_t x = 0;
+        emu_result_t res;
+        if (prog->int_mode == MATH_INT_Q) {
+            res = block_in_get_q(block, in, &((int32_t*)prog->iregs)[REG_INPUTS + in]);
+        } else {
+            res = block_in_get_int(block, in, &x);
+            ((int64_t*)prog->iregs)[REG_INPUTS + in] = x;
+        }
+        if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, ++res.depth, "[%"PRIu16"] Input %d %s", idx, in, EMU_ERR_TO_STR(res.code));}
+    }
+
+    bool ok;
+    switch (prog->int_mode) {
+        case MATH_INT_Q:
+            ok = _run_q(prog, (int32_t*)prog->iregs);
+            result = ((int32_t*)prog->iregs)[prog->result];
+            break;
+        default:
+            ok = _run_i64(prog, (int64_t*)prog->iregs);
+            result = ((int64_t*)prog->iregs)[prog->result];
+            break;
+    }
+    if (unlikely(!ok)) {RET_WD(EMU_ERR_BLOCK_DIV_BY_ZERO, idx, 0, "[%"PRIu16"] Div by zero", idx);}
+
+    mem_var_t v_res = block_int_var(result, block->ops[block->cfg.in_cnt + 1].type);
+    if (prog->int_mode == MATH_INT_Q) {v_res = (mem_var_t){.type = MEM_Q, .data.val.q = (int32_t)result};}
+    emu_result_t res = block_set_output(block, (mem_var_t){.type = MEM_B, .data.val.b = true}, 0);
+    res = block_set_output(block, v_res, 1);
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, 0, "[%"PRIu16"] Output set %s", idx, EMU_ERR_TO_STR(res.code));}
+    return EMU_RESULT_OK();
+}
+
+static emu_result_t _block_math_vector(block_handle_t block, const math_program_t *prog) {
+    uint16_t idx = block->cfg.block_idx;
+    mem_span_t out;
+    mem_span_t in[MATH_VEC_MAX_INPUTS];
+    emu_result_t res = mem_get_span(&out, block->outputs[1]);
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, ++res.depth, "[%"PRIu16"] Result span %s", idx, EMU_ERR_TO_STR(res.code));}
+
+    float *v = prog->vregs;
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        uint8_t num = prog->load[i];
+        if ((prog->span_mask >> num) & 1) {
+            res = mem_get_span(&in[num], block->inputs[num]);
+            if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, ++res.depth, "[%"PRIu16"] Input %d span %s", idx, num, EMU_ERR_TO_STR(res.code));}
+            if (unlikely(in[num].count != out.count)) {RET_ED(EMU_ERR_MEM_OUT_OF_BOUNDS, idx, 0, "[%"PRIu16"] Input %d has %d elements, result %d", idx, num, in[num].count, out.count);}
+        } else {
+            float x = 0.0f;
+            res = BLOCK_IN_GET(&x, block, num);
+            if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, idx, ++res.depth, "[%"PRIu16"] Input %d %s", idx, num, EMU_ERR_TO_STR(res.code));}
+            _column_fill(VREG(v, REG_INPUTS + num), x);
+        }
+    }
+
+    for (uint16_t first = 0; first < out.count; first += MATH_VEC_CHUNK) {
+        uint16_t n = (out.count - first < MATH_VEC_CHUNK) ? out.count - first : MATH_VEC_CHUNK;
+        for (uint8_t i = 0; i < prog->load_cnt; i++) {
+            uint8_t num = prog->load[i];
+            if ((prog->span_mask >> num) & 1) {_column_load(VREG(v, REG_INPUTS + num), &in[num], first, n);}
+        }
+        //elements of chunks before are already written, result is not marked updated
+        if (unlikely(!_run_columns(prog, v, n))) {RET_WD(EMU_ERR_BLOCK_DIV_BY_ZERO, idx, 0, "[%"PRIu16"] Div by zero at element %"PRIu16"", idx, first);}
+        _column_store(&out, first, VREG(v, prog->result), n);
+    }
+
+    mem_flag_set(block->ops[block->cfg.in_cnt + 1].updated);
+    return block_set_output(block, (mem_var_t){.type = MEM_B, .data.val.b = true}, 0);
+}
+
 emu_result_t block_math(block_handle_t block){
     //first check if inputs updated and first input true "enable"
     if (!emu_block_check_inputs_updated(block)||!block_check_in_true(block, 0)) {RET_OK_INACTIVE(block->cfg.block_idx);}
 
-    
     emu_result_t res = EMU_RESULT_OK();
-    expression_t* eval = (expression_t*)block->custom_data;
-
-    //stack and temporary variables
-    float stack[STACK_MAX_DEPTH];
-    int8_t over_top = 0;
-
-    //cache inputs except first (enable)
-    float inputs[block->cfg.in_cnt];
-    for(uint8_t i = 1; i < block->cfg.in_cnt; i++){
-        MEM_GET(&inputs[i], block->inputs[i]);
+    const math_program_t *prog = &((expression_t*)block->custom_data)->prog;
+    if (prog->int_mode) {return _block_math_int(block, prog);}
+    if (prog->vregs) {return _block_math_vector(block, prog);}
+    float *r = prog->regs;
+
+    //read only inputs used by expression
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        uint8_t in = prog->load[i];
+        BLOCK_IN_GET(&r[REG_INPUTS + in], block, in);
         #ifdef LOG_INPUTS
-        LOG_I(TAG, "[%"PRIu16"] Input %d value: %f", block->cfg.block_idx, i, inputs[i]);
+        LOG_I(TAG, "[%"PRIu16"] Input %d value: %f", block->cfg.block_idx, in, r[REG_INPUTS + in]);
         #endif
-    }   
-
-    float result = 0.0f;
+    }
 
-    for(uint16_t i = 0; i < eval->count; i++){
-        instruction_t *ins = &(eval->code[i]);
-        switch(ins->op){
-            case OP_VAR: {
-                if(over_top < 16) stack[over_top++] = inputs[ins->input_index];
-                break;
-            }
-            case OP_CONST:
-                if(over_top < 16) stack[over_top++] = eval->constant_table[ins->input_index];
-                break;
-            case OP_ADD:
-                if(over_top >= 2) { stack[over_top-2] += stack[over_top-1]; over_top--; }
-                break;
-            case OP_MUL:
-                if(over_top >= 2) { stack[over_top-2] *= stack[over_top-1]; over_top--; }
+    const math_reg_ins_t *ins = prog->code;
+    const math_reg_ins_t *end = ins + prog->count;
+    for (; ins < end; ins++) {
+        switch (ins->op) {
+            case MATH_ADD:   r[ins->dst] = r[ins->a] + r[ins->b]; break;
+            case MATH_SUB:   r[ins->dst] = r[ins->a] - r[ins->b]; break;
+            case MATH_MUL:   r[ins->dst] = r[ins->a] * r[ins->b]; break;
+            case MATH_DIV:
+                if (is_zero(r[ins->b])) {RET_WD(EMU_ERR_BLOCK_DIV_BY_ZERO, block->cfg.block_idx, 0, "[%"PRIu16"] Div by zero", block->cfg.block_idx);}
+                r[ins->dst] = r[ins->a] / r[ins->b];
                 break;
-            case OP_DIV:
-                if(over_top >= 2) {
-                    if(is_zero(stack[over_top-1])){RET_WD(EMU_ERR_BLOCK_DIV_BY_ZERO, block->cfg.block_idx, 0, "[%"PRIu16"] Div by zero", block->cfg.block_idx);}
-                    stack[over_top-2] /= stack[over_top-1];
-                    over_top--;
-                }
-                break;
-            case OP_COS:
-                if(over_top >= 1) stack[over_top-1] = cosf(stack[over_top-1]);
-                break;
-            case OP_SIN:
-                if(over_top >= 1) stack[over_top-1] = sinf(stack[over_top-1]);
-                break; 
-            case OP_POW:
-                if(over_top >= 2) { stack[over_top-2] = powf(stack[over_top-2], stack[over_top-1]); over_top--; }
-                break;
-            case OP_ROOT:
-                if(over_top >= 1) stack[over_top-1] = sqrtf(stack[over_top-1]);
-                break;
-            case OP_SUB:
-                if(over_top >= 2) { stack[over_top-2] -= stack[over_top-1]; over_top--; }
-                break; 
+            case MATH_COS:   r[ins->dst] = cosf(r[ins->a]); break;
+            case MATH_SIN:   r[ins->dst] = sinf(r[ins->a]); break;
+            case MATH_POW:   r[ins->dst] = powf(r[ins->a], r[ins->b]); break;
+            case MATH_ROOT:  r[ins->dst] = sqrtf(r[ins->a]); break;
+            case MATH_MADD:  r[ins->dst] = r[ins->a] * r[ins->b] + r[ins->c]; break;
+            case MATH_MSUB:  r[ins->dst] = r[ins->a] * r[ins->b] - r[ins->c]; break;
+            case MATH_NMSUB: r[ins->dst] = r[ins->c] - r[ins->a] * r[ins->b]; break;
         }
     }
 
-    result = (over_top > 0) ? stack[over_top-1] : 0.0f;
+    float result = r[prog->result];
     
     // Set Outputs
     mem_var_t v_eno = { .type = MEM_B, .data.val.b = true };
@@ -141,8 +363,11 @@ static emu_err_t _parse_constants(const uint8_t *data, uint16_t len, expression_
     if (len < 1 + count * sizeof(float)) return EMU_ERR_PACKET_INCOMPLETE;
     
 
-    expr->constant_table = (float*)calloc(count, sizeof(float));
-    if (!expr->constant_table) return EMU_ERR_NO_MEM;
+    //table in arena is reused when resent table fits
+    if (!expr->constant_table || count > expr->const_count) {
+        expr->constant_table = (float*)emu_arena_alloc(EMU_ARENA_BLOCKS, (count ? count : 1) * sizeof(float));
+        if (!expr->constant_table) return EMU_ERR_NO_MEM;
+    }
     
     //Copy whole table
     expr->const_count = count;
@@ -162,9 +387,10 @@ static emu_err_t _parse_instructions(const uint8_t *data, uint16_t len, expressi
     uint8_t count = data[0];
     if (len < 1 + count * 2*sizeof(uint8_t)) return EMU_ERR_PACKET_INCOMPLETE;
     
-    if (expr->code) free(expr->code);
-    expr->code = (instruction_t*)calloc(count, sizeof(instruction_t));
-    if (!expr->code) return EMU_ERR_NO_MEM;
+    if (!expr->code || count > expr->count) {
+        expr->code = (instruction_t*)emu_arena_alloc(EMU_ARENA_BLOCKS, (count ? count : 1) * sizeof(instruction_t));
+        if (!expr->code) return EMU_ERR_NO_MEM;
+    }
     
     expr->count = count;
     for (uint8_t i = 0; i < count; i++) {
@@ -191,7 +417,7 @@ emu_result_t block_math_parse(const uint8_t *packet_data, const uint16_t packet_
     
     // Allocate custom data if not exists
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(expression_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(expression_t));
         if (!block->custom_data) {
             RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "[%"PRIu16"] No memory for custom_data",  block->cfg.block_idx);
         }
@@ -219,8 +445,267 @@ emu_result_t block_math_parse(const uint8_t *packet_data, const uint16_t packet_
 }
 
 
+/*-------------------------------BLOCK COMPILER---------------------------------------------- */
+
+typedef enum {
+    SLOT_REG,       /*value in register (input or temp)*/
+    SLOT_CONST,     /*value known at compile*/
+} math_slot_kind_t;
+
+/*Compile time stack entry*/
+typedef struct {
+    uint8_t kind;
+    uint8_t reg;
+    float val;
+} math_slot_t;
+
+typedef struct {
+    math_program_t *prog;
+    float consts[REG_MAX];  /*constant registers values*/
+    uint8_t const_cnt;
+    uint8_t const_base;
+    int16_t mul_ins;        /*last instruction if it is MUL (can be fused with next ADD / SUB), else -1*/
+} math_compiler_t;
+
+static bool _fold(uint8_t op, float a, float b, float *out) {
+    switch (op) {
+        case OP_ADD:  *out = a + b; return true;
+        case OP_SUB:  *out = a - b; return true;
+        case OP_MUL:  *out = a * b; return true;
+        case OP_DIV:
+            //div by zero is left for runtime (reported each cycle as before)
+            if (is_zero(b)) {return false;}
+            *out = a / b;
+            return true;
+        case OP_POW:  *out = powf(a, b); return true;
+        case OP_COS:  *out = cosf(a); return true;
+        case OP_SIN:  *out = sinf(a); return true;
+        case OP_ROOT: *out = sqrtf(a); return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Register of slot, constant gets register (same values share one)
+ */
+static bool _slot_reg(math_compiler_t *c, const math_slot_t *slot, uint8_t *reg) {
+    if (slot->kind == SLOT_REG) {*reg = slot->reg; return true;}
+    for (uint8_t i = 0; i < c->const_cnt; i++) {
+        if (memcmp(&c->consts[i], &slot->val, sizeof(float)) == 0) {*reg = c->const_base + i; return true;}
+    }
+    if ((uint16_t)c->const_base + c->const_cnt >= REG_MAX) {return false;}
+    c->consts[c->const_cnt] = slot->val;
+    *reg = c->const_base + c->const_cnt++;
+    return true;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_block_math_verify
+static emu_result_t _compile_program(block_handle_t block, expression_t *expr) {
+    uint16_t idx = block->cfg.block_idx;
+    uint8_t in_cnt = block->cfg.in_cnt;
+    math_program_t *prog = &expr->prog;
+    math_compiler_t *c = NULL;
+    math_slot_t stack[STACK_MAX_DEPTH];
+    uint8_t depth = 0;
+    bool used[UINT8_MAX + 1] = {0};
+    emu_err_t err = EMU_ERR_BLOCK_INVALID_PARAM;
+
+    if (REG_INPUTS + in_cnt >= REG_MAX) {RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, idx, 0, "[%"PRIu16"] Too many inputs %"PRIu8"", idx, in_cnt);}
+    c = (math_compiler_t*)calloc(1, sizeof(math_compiler_t));
+    prog->code = (math_reg_ins_t*)calloc(expr->count ? expr->count : 1, sizeof(math_reg_ins_t));
+    prog->load = (uint8_t*)calloc(in_cnt ? in_cnt : 1, sizeof(uint8_t));
+    if (!c || !prog->code || !prog->load) {err = EMU_ERR_NO_MEM; goto fail;}
+    c->prog = prog;
+    c->const_base = REG_INPUTS + in_cnt;
+    c->mul_ins = -1;
+
+    for (uint8_t i = 0; i < expr->count; i++) {
+        const instruction_t *ins = &expr->code[i];
+        switch (ins->op) {
+            case OP_VAR:
+            case OP_CONST:
+                if (depth >= STACK_MAX_DEPTH) {LOG_E(TAG, "[%"PRIu16"] Stack overflow at %"PRIu8"", idx, i); goto fail;}
+                if (ins->op == OP_VAR) {
+                    //input 0 is EN
+                    if (ins->input_index == 0 || ins->input_index >= in_cnt) {LOG_E(TAG, "[%"PRIu16"] Input %"PRIu8" out of range", idx, ins->input_index); goto fail;}
+                    used[ins->input_index] = true;
+                    stack[depth++] = (math_slot_t){.kind = SLOT_REG, .reg = REG_INPUTS + ins->input_index};
+                } else {
+                    if (!expr->constant_table || ins->input_index >= expr->const_count) {LOG_E(TAG, "[%"PRIu16"] Constant %"PRIu8" out of range", idx, ins->input_index); goto fail;}
+                    stack[depth++] = (math_slot_t){.kind = SLOT_CONST, .val = expr->constant_table[ins->input_index]};
+                }
+                break;
+
+            case OP_COS:
+            case OP_SIN:
+            case OP_ROOT: {
+                if (depth < 1) {LOG_E(TAG, "[%"PRIu16"] Stack underflow at %"PRIu8"", idx, i); goto fail;}
+                math_slot_t *x = &stack[depth - 1];
+                float v;
+                if (x->kind == SLOT_CONST && _fold(ins->op, x->val, 0.0f, &v)) {x->val = v; break;}
+                math_reg_ins_t *out = &prog->code[prog->count++];
+                out->op = (ins->op == OP_COS) ? MATH_COS : (ins->op == OP_SIN) ? MATH_SIN : MATH_ROOT;
+                if (!_slot_reg(c, x, &out->a)) {goto too_large;}
+                out->dst = depth - 1;
+                *x = (math_slot_t){.kind = SLOT_REG, .reg = out->dst};
+                c->mul_ins = -1;
+                break;
+            }
+
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+            case OP_POW: {
+                if (depth < 2) {LOG_E(TAG, "[%"PRIu16"] Stack underflow at %"PRIu8"", idx, i); goto fail;}
+                math_slot_t *x = &stack[depth - 2];
+                math_slot_t *y = &stack[depth - 1];
+                uint8_t dst = depth - 2;
+                depth--;
+                float v;
+                if (x->kind == SLOT_CONST && y->kind == SLOT_CONST && _fold(ins->op, x->val, y->val, &v)) {x->val = v; break;}
+
+                uint8_t ra, rb;
+                if (!_slot_reg(c, x, &ra) || !_slot_reg(c, y, &rb)) {goto too_large;}
+
+                //product computed by previous instruction is operand of add / sub: fuse
+                if ((ins->op == OP_ADD || ins->op == OP_SUB) && c->mul_ins >= 0) {
+                    math_reg_ins_t *mul = &prog->code[c->mul_ins];
+                    if (x->kind == SLOT_REG && ra == mul->dst) {
+                        mul->op = (ins->op == OP_ADD) ? MATH_MADD : MATH_MSUB;
+                        mul->c = rb;
+                        mul->dst = dst;
+                        *x = (math_slot_t){.kind = SLOT_REG, .reg = dst};
+                        c->mul_ins = -1;
+                        break;
+                    }
+                    if (y->kind == SLOT_REG && rb == mul->dst) {
+                        mul->op = (ins->op == OP_ADD) ? MATH_MADD : MATH_NMSUB;
+                        mul->c = ra;
+                        mul->dst = dst;
+                        *x = (math_slot_t){.kind = SLOT_REG, .reg = dst};
+                        c->mul_ins = -1;
+                        break;
+                    }
+                }
+
+                math_reg_ins_t *out = &prog->code[prog->count];
+                switch (ins->op) {
+                    case OP_ADD: out->op = MATH_ADD; break;
+                    case OP_SUB: out->op = MATH_SUB; break;
+                    case OP_MUL: out->op = MATH_MUL; break;
+                    case OP_DIV: out->op = MATH_DIV; break;
+                    default:     out->op = MATH_POW; break;
+                }
+                out->dst = dst;
+                out->a = ra;
+                out->b = rb;
+                c->mul_ins = (ins->op == OP_MUL) ? prog->count : -1;
+                prog->count++;
+                *x = (math_slot_t){.kind = SLOT_REG, .reg = dst};
+                break;
+            }
+
+            default:
+                LOG_E(TAG, "[%"PRIu16"] Unknown op 0x%02X at %"PRIu8"", idx, ins->op, i);
+                goto fail;
+        }
+    }
+
+    //values under result are never used, program is malformed
+    if (depth > 1) {LOG_E(TAG, "[%"PRIu16"] %"PRIu8" values left on stack", idx, depth); goto fail;}
+    //empty expression gives 0 (as before)
+    math_slot_t top = depth ? stack[depth - 1] : (math_slot_t){.kind = SLOT_CONST, .val = 0.0f};
+    if (!_slot_reg(c, &top, &prog->result)) {goto too_large;}
+
+    for (uint8_t in = 1; in < in_cnt; in++) {
+        if (used[in]) {prog->load[prog->load_cnt++] = in;}
+    }
+    prog->reg_cnt = c->const_base + c->const_cnt;
+    prog->regs = (float*)calloc(prog->reg_cnt, sizeof(float));
+    if (!prog->regs) {err = EMU_ERR_NO_MEM; goto fail;}
+    memcpy(&prog->regs[c->const_base], c->consts, c->const_cnt * sizeof(float));
+    free(c);
+    return EMU_RESULT_OK();
+
+too_large:
+    LOG_E(TAG, "[%"PRIu16"] Expression needs more than %d registers", idx, REG_MAX);
+fail:
+    free(c);
+    RET_ED(err, idx, 0, "[%"PRIu16"] Expression compile failed", idx);
+}
+
+
 /*-------------------------------BLOCK VERIFIER---------------------------------------------- */
 
+static void _clear_program(math_program_t *prog) {
+    free(prog->code);
+    free(prog->regs);
+    free(prog->load);
+    free(prog->vregs);
+    free(prog->iregs);
+    memset(prog, 0, sizeof(*prog));
+}
+
+/**
+ * @brief Integer mode when result, used inputs and constants are whole numbers, program has no float only op and division is last,
+ * Q16.16 mode when result is MEM_Q and inputs are Q16.16 / integers (constants fit Q range)
+ */
+static emu_err_t _prepare_int(block_handle_t block, math_program_t *prog) {
+    if (prog->vregs || block->cfg.q_cnt < 2) {return EMU_OK;}
+    uint8_t out_type = block->ops[block->cfg.in_cnt + 1].type;
+    bool q = (out_type == MEM_Q);
+    if (!q && !MEM_TYPE_IS_INT(out_type)) {return EMU_OK;}
+
+    for (uint8_t i = 0; i < prog->count; i++) {
+        switch (prog->code[i].op) {
+            case MATH_COS: case MATH_SIN: case MATH_POW: case MATH_ROOT: return EMU_OK;
+            //rounded quotient used by next operation would differ from float program (Q16.16 quotient keeps fraction)
+            case MATH_DIV: if (!q && i != prog->count - 1) {return EMU_OK;} break;
+            default: break;
+        }
+    }
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        uint8_t type = block->ops[prog->load[i]].type;
+        if (!MEM_TYPE_IS_INT(type) && !(q && type == MEM_Q)) {return EMU_OK;}
+    }
+    uint8_t const_base = REG_INPUTS + block->cfg.in_cnt;
+    for (uint16_t r = const_base; r < prog->reg_cnt; r++) {
+        float c = prog->regs[r];
+        if (q) {
+            if (!(c >= -32768.0f && c < 32768.0f)) {return EMU_OK;}
+        } else if (c != truncf(c) || c < -2147483648.0f || c >= 2147483648.0f) {
+            return EMU_OK;
+        }
+    }
+
+    prog->iregs = calloc(prog->reg_cnt, q ? sizeof(int32_t) : sizeof(int64_t));
+    if (!prog->iregs) {return EMU_ERR_NO_MEM;}
+    for (uint16_t r = const_base; r < prog->reg_cnt; r++) {
+        if (q) {((int32_t*)prog->iregs)[r] = emu_float_to_q(prog->regs[r]);}
+        else   {((int64_t*)prog->iregs)[r] = (int64_t)prog->regs[r];}
+    }
+    prog->int_mode = q ? MATH_INT_Q : MATH_INT_64;
+    return EMU_OK;
+}
+
+/**
+ * @brief Vector mode when RESULT is span access: columns for all registers, constants broadcast once
+ */
+static emu_err_t _prepare_vector(block_handle_t block, math_program_t *prog) {
+    if (block->cfg.q_cnt < 2 || !block->outputs[1]->whole_array) {return EMU_OK;}
+    if (block->cfg.in_cnt > MATH_VEC_MAX_INPUTS) {return EMU_ERR_BLOCK_INVALID_PARAM;}
+    prog->vregs = (float*)calloc((size_t)prog->reg_cnt * MATH_VEC_CHUNK, sizeof(float));
+    if (!prog->vregs) {return EMU_ERR_NO_MEM;}
+    for (uint8_t r = REG_INPUTS + block->cfg.in_cnt; r < prog->reg_cnt; r++) {_column_fill(VREG(prog->vregs, r), prog->regs[r]);}
+    for (uint8_t i = 0; i < prog->load_cnt; i++) {
+        uint8_t num = prog->load[i];
+        if (block->inputs[num]->whole_array) {prog->span_mask |= 1u << num;}
+    }
+    return EMU_OK;
+}
+
 #undef OWNER
 #define OWNER EMU_OWNER_block_math_verify
 emu_result_t block_math_verify(block_handle_t block) {
@@ -228,25 +713,33 @@ emu_result_t block_math_verify(block_handle_t block) {
 
     expression_t *data = (expression_t*)block->custom_data;
 
-    if (data->count == 0) {RET_WD(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "[%"PRIu16"] Empty expression (count=0)", block->cfg.block_idx);}
-
     if (data->count > 0 && data->code == NULL) {RET_ED(EMU_ERR_NULL_PTR, block->cfg.block_idx, 0, "[%"PRIu16"] Code pointer is NULL", block->cfg.block_idx);}
-    RET_OKD(block->cfg.block_idx, "[%"PRIu16"] verified", block->cfg.block_idx);
+
+    _clear_program(&data->prog);
+    emu_result_t res = _compile_program(block, data);
+    if (res.code != EMU_OK) {
+        _clear_program(&data->prog);
+        return res;
+    }
+    emu_err_t err = _prepare_vector(block, &data->prog);
+    if (err == EMU_OK) {err = _prepare_int(block, &data->prog);}
+    if (err != EMU_OK) {
+        _clear_program(&data->prog);
+        RET_ED(err, block->cfg.block_idx, 0, "[%"PRIu16"] Vector / integer mode not prepared", block->cfg.block_idx);
+    }
+
+    if (data->count == 0) {RET_WD(EMU_ERR_BLOCK_INVALID_PARAM, block->cfg.block_idx, 0, "[%"PRIu16"] Empty expression (count=0)", block->cfg.block_idx);}
+    RET_OKD(block->cfg.block_idx, "[%"PRIu16"] verified, %"PRIu8" ops compiled to %"PRIu8" instructions%s", block->cfg.block_idx, data->count, data->prog.count, data->prog.vregs ? " (vector)" : (data->prog.int_mode == MATH_INT_Q) ? " (Q16.16)" : data->prog.int_mode ? " (integer)" : "");
 }
 
 
 /*-------------------------------BLOCK FREE FUNCTION---------------------------------------------- */
 
-static void _clear_expression_internals(expression_t* expr){
-    if(expr->code) free(expr->code);
-    if(expr->constant_table) free(expr->constant_table);
-}
-
 void block_math_free(block_handle_t block){
     if(block && block->custom_data){
+        //expression and its tables are in arena, compiled program is on heap
         expression_t* expr = (expression_t*)block->custom_data;
-        _clear_expression_internals(expr);
-        free(expr);
+        _clear_program(&expr->prog);
         block->custom_data = NULL;
     }
-}
\ No newline at end of file
+}
@@ -13,11 +13,15 @@ static const char *TAG = __FILE_NAME__;
 #define OWNER EMU_OWNER_block_q_selector
 emu_result_t block_q_selector(block_handle_t block){
     
+    // Outputs are written through block_set_output (output can be element of array, packed too)
+    mem_var_t v_off = { .type = MEM_B, .data.val.b = false };
+    mem_var_t v_on = { .type = MEM_B, .data.val.b = true };
+
     // Check EN input first (in_0)
     if (!block_check_in_true(block, BLOCK_Q_SEL_EN)) {
         for (uint8_t i = 0; i < block->cfg.q_cnt; i++){
-            *block->outputs[i]->instance->data.b = false;
-            block->outputs[i]->instance->updated = 0;
+            block_set_output(block, v_off, i);
+            block_mark_output(block, i, false);
         }
         RET_OK_INACTIVE(block->cfg.block_idx);}
     
@@ -25,10 +29,10 @@ emu_result_t block_q_selector(block_handle_t block){
     if (block_in_updated(block, BLOCK_Q_SEL_SEL)){
         // Fetch selector value
         uint8_t selector = 0; 
-        MEM_GET(&selector, block->inputs[BLOCK_Q_SEL_SEL]);
+        BLOCK_IN_GET(&selector, block, BLOCK_Q_SEL_SEL);
         for (uint8_t i = 0; i < block->cfg.q_cnt; i++){
-            *block->outputs[i]->instance->data.b = false;
-            block->outputs[i]->instance->updated = 0;
+            block_set_output(block, v_off, i);
+            block_mark_output(block, i, false);
         }
         // Check bounds
         if (selector >= block->cfg.q_cnt){
@@ -36,8 +40,8 @@ emu_result_t block_q_selector(block_handle_t block){
         }
         
         // Mark ONLY the selected output as true and updated
-        *block->outputs[selector]->instance->data.b = true;
-        block->outputs[selector]->instance->updated = 1;
+        emu_result_t res = block_set_output(block, v_on, selector);
+        if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Failed to set output %u", block->cfg.block_idx, selector);}
     }
     
     return EMU_RESULT_OK();
@@ -12,16 +12,75 @@ static const char* TAG = __FILE_NAME__;
 #define BLOCK_SET_VALUE    1
 #define BLOCK_SET_TARGET   2
 
+/*-------------------------------SPAN HELPERS------------------------------------------------------ */
+
+static void _span_copy(const mem_span_t *dst, const mem_span_t *src) {
+    uint8_t d_size = MEM_TYPE_SIZES[dst->type];
+    uint8_t s_size = MEM_TYPE_SIZES[src->type];
+    if (dst->type == src->type && dst->stride == 1 && src->stride == 1) {
+        memmove(dst->data.u8, src->data.u8, (size_t)dst->count * d_size);
+        return;
+    }
+    emu_conv_kernel_t kernel = emu_conv_kernels[src->type][dst->type];
+    for (uint16_t i = 0; i < dst->count; i++) {
+        kernel(dst->data.u8 + (size_t)i * dst->stride * d_size, src->data.u8 + (size_t)i * src->stride * s_size);
+    }
+}
+
+static void _span_fill(const mem_span_t *dst, const mem_var_t *value) {
+    mem_types_val_u v;
+    emu_conv_kernels[value->type][dst->type](&v, &value->data.val);
+    uint16_t stride = dst->stride;
+    switch (MEM_TYPE_SIZES[dst->type]) {
+        case 1:
+            if (stride == 1) {memset(dst->data.u8, v.u8, dst->count); break;}
+            for (uint16_t i = 0; i < dst->count; i++) {dst->data.u8[i * stride] = v.u8;}
+            break;
+        case 2: for (uint16_t i = 0; i < dst->count; i++) {dst->data.u16[i * stride] = v.u16;} break;
+        case 4: for (uint16_t i = 0; i < dst->count; i++) {dst->data.u32[i * stride] = v.u32;} break;
+    }
+}
+
 /*-------------------------------BLOCK IMPLEMENTATION---------------------------------------------- */
 
 #undef OWNER
 #define OWNER EMU_OWNER_block_set
+static emu_result_t _block_set_span(block_handle_t block, const mem_access_t *tgt_access) {
+    mem_span_t dst;
+    emu_result_t res = mem_get_span(&dst, tgt_access);
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Failed to get target span: %s", block->cfg.block_idx, EMU_ERR_TO_STR(res.code));}
+
+    mem_var_t v_source;
+    if (!block->custom_data) {
+        if (!block_in_updated(block, BLOCK_SET_VALUE)) {RET_OK_INACTIVE(block->cfg.block_idx);}
+        const mem_access_t *src_access = block->inputs[BLOCK_SET_VALUE];
+        if (src_access->whole_array) {
+            mem_span_t src;
+            res = mem_get_span(&src, src_access);
+            if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Failed to get source span: %s", block->cfg.block_idx, EMU_ERR_TO_STR(res.code));}
+            if (unlikely(src.count != dst.count)) {RET_ED(EMU_ERR_MEM_OUT_OF_BOUNDS, block->cfg.block_idx, 0, "[%"PRIu16"] Span length %d into %d", block->cfg.block_idx, src.count, dst.count);}
+            mem_flag_set(block->ops[BLOCK_SET_TARGET].updated);
+            _span_copy(&dst, &src);
+            return EMU_RESULT_OK();
+        }
+        res = mem_get(&v_source, src_access, false);
+        if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Failed to get source: %s", block->cfg.block_idx, EMU_ERR_TO_STR(res.code));}
+    } else {
+        v_source = *(mem_var_t*)block->custom_data;
+    }
+    mem_flag_set(block->ops[BLOCK_SET_TARGET].updated);
+    _span_fill(&dst, &v_source);
+    return EMU_RESULT_OK();
+}
+
+
 emu_result_t block_set(block_handle_t block) {
     // Check EN input first (in_0)
     if (!block_check_in_true(block, BLOCK_SET_EN)) {RET_OK_INACTIVE(block->cfg.block_idx);}
 
     mem_access_t *tgt_access = block->inputs[BLOCK_SET_TARGET];
-    mem_instance_t *tgt_inst = tgt_access->instance;
+    const emu_operand_t *tgt = &block->ops[BLOCK_SET_TARGET];
+    if (unlikely(tgt_access->whole_array)) {return _block_set_span(block, tgt_access);}
 
     // Had to be created before if, cause both situtions use them
     mem_var_t v_source;
@@ -32,29 +91,25 @@ emu_result_t block_set(block_handle_t block) {
         if(!block_in_updated(block, BLOCK_SET_VALUE)) {RET_OK_INACTIVE(block->cfg.block_idx);}
 
         mem_access_t *src_access = block->inputs[BLOCK_SET_VALUE];
-        mem_instance_t *src_inst = src_access->instance;
+        const emu_operand_t *src = &block->ops[BLOCK_SET_VALUE];
         
-        // ULTRA-FAST PATH: Both resolved and types match - direct pointer copy
-        if(likely(src_access->is_index_resolved && tgt_access->is_index_resolved && 
-                src_inst->type == tgt_inst->type)) {
-            
-            uint16_t src_offset = src_access->resolved_index;
-            uint16_t tgt_offset = tgt_access->resolved_index;
-            uint8_t type = src_inst->type;
-            
-            // Mark target as updated
-            tgt_inst->updated = 1;
-            
-            // Direct memory copy based on type
-            switch(type) {
-                case MEM_B:   tgt_inst->data.b[tgt_offset]   = src_inst->data.b[src_offset];   return EMU_RESULT_OK();
-                case MEM_F:   tgt_inst->data.f[tgt_offset]   = src_inst->data.f[src_offset];   return EMU_RESULT_OK();
-                case MEM_U8:  tgt_inst->data.u8[tgt_offset]  = src_inst->data.u8[src_offset];  return EMU_RESULT_OK();
-                case MEM_U16: tgt_inst->data.u16[tgt_offset] = src_inst->data.u16[src_offset]; return EMU_RESULT_OK();
-                case MEM_U32: tgt_inst->data.u32[tgt_offset] = src_inst->data.u32[src_offset]; return EMU_RESULT_OK();
-                case MEM_I16: tgt_inst->data.i16[tgt_offset] = src_inst->data.i16[src_offset]; return EMU_RESULT_OK();
-                case MEM_I32: tgt_inst->data.i32[tgt_offset] = src_inst->data.i32[src_offset]; return EMU_RESULT_OK();
-            }  
+        // ULTRA-FAST PATH: Both addresses resolved at verify - direct copy or one conversion kernel
+        if(likely(src->ptr && tgt->ptr)) {
+            mem_flag_set(tgt->updated);
+            if(likely(src->type == tgt->type)) {
+                switch(src->type) {
+                    case MEM_B:   *(bool*)tgt->ptr     = *(const bool*)src->ptr;     return EMU_RESULT_OK();
+                    case MEM_F:   *(float*)tgt->ptr    = *(const float*)src->ptr;    return EMU_RESULT_OK();
+                    case MEM_U8:  *(uint8_t*)tgt->ptr  = *(const uint8_t*)src->ptr;  return EMU_RESULT_OK();
+                    case MEM_U16: *(uint16_t*)tgt->ptr = *(const uint16_t*)src->ptr; return EMU_RESULT_OK();
+                    case MEM_U32: *(uint32_t*)tgt->ptr = *(const uint32_t*)src->ptr; return EMU_RESULT_OK();
+                    case MEM_I16: *(int16_t*)tgt->ptr  = *(const int16_t*)src->ptr;  return EMU_RESULT_OK();
+                    case MEM_I32: *(int32_t*)tgt->ptr  = *(const int32_t*)src->ptr;  return EMU_RESULT_OK();
+                    case MEM_Q:   *(int32_t*)tgt->ptr  = *(const int32_t*)src->ptr;  return EMU_RESULT_OK();
+                }
+            }
+            emu_conv_kernels[src->type][tgt->type](tgt->ptr, src->ptr);
+            return EMU_RESULT_OK();
         }
         
         // STANDARD PATH: Need mem_get for dynamic resolution or type conversion
@@ -62,6 +117,8 @@ emu_result_t block_set(block_handle_t block) {
         if(unlikely(res.code != EMU_OK)){
             RET_ED(res.code, block->cfg.block_idx, ++res.depth, "[%"PRIu16"] Failed to get source: %s", block->cfg.block_idx, EMU_ERR_TO_STR(res.code));
         }
+        // Packed bool target has no address, mem_set writes the bit
+        if(unlikely(tgt_access->instance->packed)) {return mem_set(v_source, tgt_access);}
         
         // Get target pointer directly (by_reference=true)
         res = mem_get(&v_target, tgt_access, true);
@@ -72,6 +129,14 @@ emu_result_t block_set(block_handle_t block) {
     else
     {
         v_source = *(mem_var_t*)block->custom_data;
+        if(unlikely(tgt_access->instance->packed)) {return mem_set(v_source, tgt_access);}
+
+        // FAST PATH: constant into target with address resolved at verify (type checked at parse)
+        if(likely(tgt->ptr)) {
+            mem_flag_set(tgt->updated);
+            emu_conv_kernels[v_source.type][tgt->type](tgt->ptr, &v_source.data.val);
+            return EMU_RESULT_OK();
+        }
 
         emu_result_t res = mem_get(&v_target, tgt_access, true);
         if(unlikely(res.code != EMU_OK)){
@@ -79,7 +144,7 @@ emu_result_t block_set(block_handle_t block) {
         }
     }
     // Mark target as updated
-    tgt_inst->updated = 1;
+    mem_flag_set(tgt->updated);
     
     // Fast path: matching types - direct copy without conversion
     if(likely(v_source.type == v_target.type)) {
@@ -91,38 +156,16 @@ emu_result_t block_set(block_handle_t block) {
             case MEM_U32: *v_target.data.ptr.u32 = v_source.data.val.u32; break;
             case MEM_I16: *v_target.data.ptr.i16 = v_source.data.val.i16; break;
             case MEM_I32: *v_target.data.ptr.i32 = v_source.data.val.i32; break;
+            case MEM_Q:   *v_target.data.ptr.q   = v_source.data.val.q;   break;
         }
         return EMU_RESULT_OK();
     }
     
-    // Slow path: type conversion required (consider usage of double for intermediate to preserve range as for now stay with float for simplicity)
-    float src_val = MEM_CAST(v_source, (float)0);
-    
-    switch (v_target.type) {
-        case MEM_U8:  
-            *v_target.data.ptr.u8  = CLAMP_CAST(roundf(src_val), 0, UINT8_MAX, uint8_t); 
-            break;
-        case MEM_U16: 
-            *v_target.data.ptr.u16 = CLAMP_CAST(roundf(src_val), 0, UINT16_MAX, uint16_t); 
-            break;
-        case MEM_U32: 
-            *v_target.data.ptr.u32 = CLAMP_CAST(roundf(src_val), 0, UINT32_MAX, uint32_t); 
-            break;
-        case MEM_I16: 
-            *v_target.data.ptr.i16 = CLAMP_CAST(roundf(src_val), INT16_MIN, INT16_MAX, int16_t); 
-            break;
-        case MEM_I32: 
-            *v_target.data.ptr.i32 = CLAMP_CAST(roundf(src_val), INT32_MIN, INT32_MAX, int32_t); 
-            break;
-        case MEM_F:   
-            *v_target.data.ptr.f   = src_val; 
-            break;
-        case MEM_B:   
-            *v_target.data.ptr.b   = (src_val != 0.0f); 
-            break;
-        default:
-            RET_ED(EMU_ERR_MEM_INVALID_DATATYPE, block->cfg.block_idx, 0, "[%"PRIu16"] Invalid type %d", block->cfg.block_idx, v_target.type);
+    // Slow path: type conversion required, same kernel as operand path (integers and Q16.16 are not converted through float)
+    if (unlikely(v_source.type >= MEM_TYPES_COUNT || v_target.type >= MEM_TYPES_COUNT)) {
+        RET_ED(EMU_ERR_MEM_INVALID_DATATYPE, block->cfg.block_idx, 0, "[%"PRIu16"] Invalid type %d", block->cfg.block_idx, v_target.type);
     }
+    emu_conv_kernels[v_source.type][v_target.type](v_target.data.ptr.raw, &v_source.data.val);
 
     return EMU_RESULT_OK();
 }
@@ -143,7 +186,7 @@ emu_result_t block_set_parse(const uint8_t *packet_data, const uint16_t packet_l
     
     // Allocate custom data if not exists
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(mem_var_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(mem_var_t));
         if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "Alloc failed");
     }
 
@@ -155,6 +198,7 @@ emu_result_t block_set_parse(const uint8_t *packet_data, const uint16_t packet_l
         config_value->by_reference = false;
         uint8_t tmp = payload[0];
         config_value->type = tmp & 0x0F;
+        if(config_value->type >= MEM_TYPES_COUNT) RET_ED(EMU_ERR_MEM_INVALID_DATATYPE, block->cfg.block_idx, 0, "Invalid value type %d", config_value->type);
 
         memcpy(&config_value->data.val, &payload[1], MEM_TYPE_SIZES[config_value->type]);
 
@@ -175,12 +219,4 @@ emu_result_t block_set_verify(block_handle_t block) {
 }
 /*-------------------------------BLOCK FREE FUNCTION------------------------------------------------ */
 //handled by generic 
-void block_set_free(block_handle_t block){
-    if(block && block->custom_data){
-        free(block->custom_data);
-        block->custom_data = NULL;
-        LOG_D(TAG, "[%d]Cleared set block data", block->cfg.block_idx);
-    }
-    return;
-}
 
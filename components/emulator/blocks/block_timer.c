@@ -60,10 +60,10 @@ emu_result_t block_timer(block_handle_t block) {
 
     // RST (Reset)
     bool RST = false;
-    if(block_in_updated(block, BLOCK_TIMER_IN_RST)){MEM_GET(&RST, block->inputs[BLOCK_TIMER_IN_RST]);}
+    if(block_in_updated(block, BLOCK_TIMER_IN_RST)){BLOCK_IN_GET(&RST, block, BLOCK_TIMER_IN_RST);}
 
     uint32_t PT = data->default_pt; 
-    if(block_in_updated(block, BLOCK_TIMER_IN_PT)){MEM_GET(&PT, block->inputs[BLOCK_TIMER_IN_PT]);}
+    if(block_in_updated(block, BLOCK_TIMER_IN_PT)){BLOCK_IN_GET(&PT, block, BLOCK_TIMER_IN_PT);}
 
     block_timer_type_t type = data->type;
 
@@ -155,7 +155,8 @@ emu_result_t block_timer(block_handle_t block) {
         RET_ED(res.code, block->cfg.block_idx, 0, "Output acces error %s", EMU_ERR_TO_STR(res.code));
     }
     
-    mem_var_t v_et = { .type = MEM_F, .data.val.f = (float)data->delta_time };
+    //ET in ms is integer, no float conversion on FPU-less targets
+    mem_var_t v_et = { .type = MEM_U32, .data.val.u32 = data->delta_time };
     res = block_set_output(block, v_et, BLOCK_TIMER_OUT_ET);
     if (unlikely(res.code != EMU_OK)) {
          RET_ED(res.code, block->cfg.block_idx, 0, "Output ET error %s", EMU_ERR_TO_STR(res.code));
@@ -181,7 +182,7 @@ emu_result_t block_timer_parse(const uint8_t *packet_data, const uint16_t packet
     
     // Allocate custom data if not exists
     if (!block->custom_data) {
-        block->custom_data = calloc(1, sizeof(block_timer_t));
+        block->custom_data = emu_arena_alloc(EMU_ARENA_BLOCKS, sizeof(block_timer_t));
         if (!block->custom_data) RET_ED(EMU_ERR_NO_MEM, block->cfg.block_idx, 0, "Custom data alloc failed");
     }
     
@@ -215,13 +216,4 @@ emu_result_t block_timer_verify(block_handle_t block) {
     return EMU_RESULT_OK();
 }
 
-/*-------------------------------BLOCK FREE FUNCTION---------------------------------------------- */
-
-
-void block_timer_free(block_handle_t block) {
-    if (block->custom_data) {
-        free(block->custom_data);
-        block->custom_data = NULL;
-    }
-}
 
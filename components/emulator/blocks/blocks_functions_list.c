@@ -33,15 +33,11 @@ emu_block_parse_func emu_block_parsers_table[255]={
 };
 /**
  * @brief Table for block specific free functions (cleanup/reset)
+ * @note Only for heap data of block, custom_data itself is in program arena
  */
 emu_block_free_func emu_block_free_table[255]={
     [BLOCK_LOGIC]=block_logic_free,
     [BLOCK_MATH]=block_math_free,
-    [BLOCK_FOR]=block_for_free,
-    [BLOCK_TIMER]=block_timer_free,
-    [BLOCK_COUNTER]=block_counter_free,
-    [BLOCK_CLOCK]=block_clock_free,
-    [BLOCK_LATCH] = block_latch_free,
 };
 
 /**
@@ -57,4 +53,29 @@ emu_block_verify_func emu_block_verify_table[255]={
     [BLOCK_LATCH] = block_latch_verify,
 };
 
+/**
+ * @brief Table for dirty execution mode, describes when block type can do something (not listed = always executed) and how it touches memory
+ */
+emu_block_sched_info_t emu_block_sched_table[255]={
+    [BLOCK_LOGIC]       = {.trigger = BLOCK_TRIGGER_ALL_INPUTS},
+    [BLOCK_MATH]        = {.trigger = BLOCK_TRIGGER_ALL_INPUTS},
+    [BLOCK_FOR]         = {.trigger = BLOCK_TRIGGER_EN},
+    [BLOCK_SET]         = {.trigger = BLOCK_TRIGGER_EN, .written_inputs = (1u << 2)}, /*target*/
+    [BLOCK_IN_SELECTOR] = {.trigger = BLOCK_TRIGGER_EN, .moves_outputs = true}, /*output instance is copy of selected option*/
+    [BLOCK_LATCH]       = {.trigger = BLOCK_TRIGGER_EN},
+    /*TIMER, CLOCK: time driven, COUNTER: edge state changes without inputs, Q_SELECTOR: clears outputs when disabled*/
+};
+
+/**
+ * @brief Table for blocks that execute following blocks themselves, main loop jumps over them (see emu_code_compile)
+ */
+emu_block_chain_func emu_block_chain_table[255]={
+    [BLOCK_FOR]=block_for_chain_len,
+};
 
+/**
+ * @brief Table for blocks with state outside of outputs, called after retained values are restored (emu_retain.h)
+ */
+emu_block_restore_func emu_block_restore_table[255]={
+    [BLOCK_COUNTER]=block_counter_restore,
+};
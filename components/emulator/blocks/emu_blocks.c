@@ -1,6 +1,7 @@
 #include "emu_blocks.h"
 #include "blocks_functions_list.h"
 #include "emu_helpers.h"
+#include "emu_arena.h"
 #include "esp_log.h"
 #include <string.h>
 #include <stdlib.h>
@@ -17,7 +18,7 @@ emu_result_t emu_block_parse_create_list(const uint8_t *data, const uint16_t el_
     size_t data_pool_size = count * sizeof(block_data_t);
 
     //blob to store both pointers and data pool at onec
-    void *blobs = calloc(1, ptr_list_size + data_pool_size);
+    void *blobs = emu_arena_alloc(EMU_ARENA_BLOCKS, ptr_list_size + data_pool_size);
     if(!blobs){RET_E(EMU_ERR_NO_MEM, "Not enough memory to create block list with %d blocks", count);}
 
     code->blocks_list = (block_handle_t*)blobs;
@@ -46,9 +47,12 @@ emu_result_t emu_block_parse_cfg(const uint8_t *data, const uint16_t el_cnt, voi
     block_handle_t block = code->blocks_list[idx];
     
     *block = block_tmp;
-    block -> inputs = (mem_access_t**)calloc(block_tmp.cfg.in_cnt, sizeof(mem_access_t*));
-    block -> outputs = (mem_access_t**)calloc(block_tmp.cfg.q_cnt, sizeof(mem_access_t*));
-    if((!block->inputs && block_tmp.cfg.in_cnt > 0) || (!block->outputs && block_tmp.cfg.q_cnt > 0)){RET_ED(EMU_ERR_NO_MEM, idx, 0, "Not enough memory for block %d inputs/outputs", idx);}
+    block -> inputs = block_tmp.cfg.in_cnt ? (mem_access_t**)emu_arena_alloc(EMU_ARENA_BLOCKS, block_tmp.cfg.in_cnt * sizeof(mem_access_t*)) : NULL;
+    block -> outputs = block_tmp.cfg.q_cnt ? (mem_access_t**)emu_arena_alloc(EMU_ARENA_BLOCKS, block_tmp.cfg.q_cnt * sizeof(mem_access_t*)) : NULL;
+    //filled at verify (emu_operands_build)
+    uint16_t ops_cnt = block_tmp.cfg.in_cnt + block_tmp.cfg.q_cnt;
+    block -> ops = ops_cnt ? (emu_operand_t*)emu_arena_alloc(EMU_ARENA_BLOCKS, ops_cnt * sizeof(emu_operand_t)) : NULL;
+    if((!block->inputs && block_tmp.cfg.in_cnt > 0) || (!block->outputs && block_tmp.cfg.q_cnt > 0) || (!block->ops && ops_cnt > 0)){RET_ED(EMU_ERR_NO_MEM, idx, 0, "Not enough memory for block %d inputs/outputs", idx);}
     LOG_I(TAG, "Parsed block cfg idx %d type %d (in:%d out:%d)", idx, block->cfg.block_type, block->cfg.in_cnt, block->cfg.q_cnt);
     return EMU_RESULT_OK();
 }
@@ -92,14 +96,15 @@ emu_result_t emu_block_parse_output(const uint8_t *data, const uint16_t el_cnt,
 
 void block_free(block_handle_t block){
     if(block){
-        if(block->inputs){free(block->inputs);}
-        if(block->outputs){free(block->outputs);}
+        //inputs / outputs and custom_data are in arena, only heap parts of block data are freed here
+        emu_block_free_func free_fn = emu_block_free_table[block->cfg.block_type];
+        if(free_fn){free_fn(block);}
     }
-    //add free with already created 
 }
 
 /**
  * @brief Free all blocks in code handle
+ * @note Block list itself is in arena, released by emu_arena_reset_code
  */
 void emu_blocks_free_all(void* emu_code_handle){
     emu_code_handle_t code = (emu_code_handle_t)emu_code_handle;
@@ -107,8 +112,17 @@ void emu_blocks_free_all(void* emu_code_handle){
         for(uint16_t i=0;i<code->total_blocks;i++){
             block_free(code->blocks_list[i]);
         }
-        free(code->blocks_list);
         code->blocks_list = NULL;
     }
     code->total_blocks = 0;
 }
+
+void emu_blocks_restore_all(void* emu_code_handle){
+    emu_code_handle_t code = (emu_code_handle_t)emu_code_handle;
+    if(!code->blocks_list){return;}
+    for(uint16_t i=0;i<code->total_blocks;i++){
+        block_handle_t block = code->blocks_list[i];
+        emu_block_restore_func restore_fn = emu_block_restore_table[block->cfg.block_type];
+        if(restore_fn){restore_fn(block);}
+    }
+}
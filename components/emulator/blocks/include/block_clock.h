@@ -78,10 +78,4 @@ emu_result_t block_clock_parse(const uint8_t *packet_data, const uint16_t packet
  */
 emu_result_t block_clock_verify(block_handle_t block);
 
-/**
- * @brief Free function for clock block
- * @param block Handle to the block instance to free
- */
-void block_clock_free(block_handle_t block);
-
 
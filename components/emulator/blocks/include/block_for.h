@@ -37,6 +37,7 @@ FOR_OP_DIV        = 0x04,
 NOTE:
 Start, Stop, Step can be hardcoded
 Operator is hardcoded
+chain_len blocks after FOR run only inside FOR, main loop jumps over them (emu_code_compile), nested FOR runs its own chain, it has to end inside chain of outer FOR (verify rejects code otherwise)
 
 OUTPUTS:
 ENO = EN state - here connect blocks that has to run in for loop
@@ -65,5 +66,5 @@ for(int i = 0; i< 10; i++){
 emu_result_t block_for(block_handle_t block);
 
 emu_result_t block_for_parse(const uint8_t *packet_data, const uint16_t packet_len, void *block);
-void block_for_free(block_handle_t block);
 emu_result_t block_for_verify(block_handle_t block);
+uint16_t block_for_chain_len(block_handle_t block);
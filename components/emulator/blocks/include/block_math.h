@@ -46,6 +46,12 @@ While EN is true "MATH" is executed and result of expression is on output RESULT
 NOTE: 
 BLOCK can have only one input: EN input, then it has hardcoded expression like "cos(0.5)+0.2137"
 
+VECTOR MODE:
+When RESULT is span access (slice / row, mem_get_span) expression is evaluated element-wise in one call.
+VAL inputs given as spans need the same element count as RESULT, other VAL inputs are same for every element.
+["ADC"[0:256]]->[VAL1][MATH "in_1*in_1*0.02+in_1*1.5-3"][RESULT]->["CAL"[0:256]]
+On div by zero elements before faulty chunk are already written, RESULT is not marked updated.
+
 ****************************************************************************/
 
 /**
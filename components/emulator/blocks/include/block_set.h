@@ -17,6 +17,8 @@ INPUTS:
 - EN (BOOL): Enable input. Block only executes when EN is true.
 - VAL (ANY): Value to be set. Can be of any type.
 - TARGET (ANY): Target variable to set. Can be of any type but should be compatible with VAL for speed.
+  Span access (slice / row, mem_get_span) as TARGET sets all its elements: from VAL span of same length
+  (copied element by element, memmove when types match and both are contiguous) or from one VAL value (fill).
 OUTPUTS:
 - None (SET block has no outputs, including no ENO)
 ****************************************************************************/
@@ -30,7 +32,6 @@ emu_result_t block_set(block_handle_t block_data);
 
 emu_result_t block_set_verify(block_handle_t block);
 
-void block_set_free(block_handle_t block);
 
 emu_result_t block_set_parse(const uint8_t *packet_data, const uint16_t packet_len, void *block_ptr);
 
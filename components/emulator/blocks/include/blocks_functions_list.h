@@ -24,6 +24,9 @@ extern emu_block_func blocks_main_functions_table[255];
 extern emu_block_parse_func emu_block_parsers_table[255];
 extern emu_block_free_func emu_block_free_table[255];
 extern emu_block_verify_func emu_block_verify_table[255];
+extern emu_block_sched_info_t emu_block_sched_table[255];
+extern emu_block_chain_func emu_block_chain_table[255];
+extern emu_block_restore_func emu_block_restore_table[255];
 
 
 
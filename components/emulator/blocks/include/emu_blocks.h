@@ -4,6 +4,8 @@
 #include "emu_logging.h"
 #include "emu_body.h"
 #include "emu_variables_acces.h"
+#include "emu_arena.h"
+#include "emu_operands.h"
 
 /**
 * @brief Block type identification code
@@ -38,6 +40,25 @@ typedef enum {
     BLOCK_PKT_OPTIONS_BASE   = 0x20,  // Selector options: 0x20 + option_index
 } block_packet_id_t;
 
+/**
+ * @brief When block can do anything, used by dirty execution mode (see emu_sched.h)
+ * @note Default (0) is always, so new block types are executed every cycle until described
+ */
+typedef enum {
+    BLOCK_TRIGGER_ALWAYS    = 0, /*time driven or keeps state even without inputs (timer, counter...)*/
+    BLOCK_TRIGGER_EN        = 1, /*returns RET_OK_INACTIVE without side effects when input 0 not updated*/
+    BLOCK_TRIGGER_ALL_INPUTS= 2, /*returns RET_OK_INACTIVE without side effects when any connected input not updated*/
+} block_trigger_t;
+
+/**
+ * @brief Scheduling description of block type
+ */
+typedef struct {
+    block_trigger_t trigger;
+    uint16_t written_inputs; /*mask of inputs block writes through (not only outputs), like SET target*/
+    bool moves_outputs;      /*block replaces its output instances at runtime (data address too), readers can not cache address (emu_operands.h)*/
+} emu_block_sched_info_t;
+
 /**
  * @brief Function pointer for block code execution
  */
@@ -58,6 +79,14 @@ typedef void (*emu_block_free_func)(block_handle_t block);
  * @brief Function pointer for block verification function
  */
 typedef emu_result_t (*emu_block_verify_func)(block_handle_t block);
+/**
+ * @brief Function pointer for block restore function, block takes back state kept in custom_data from its retained outputs (emu_retain.h)
+ */
+typedef void (*emu_block_restore_func)(block_handle_t block);
+/**
+ * @brief Function pointer returning count of blocks after this one that block executes itself (FOR chain)
+ */
+typedef uint16_t (*emu_block_chain_func)(block_handle_t block);
 
 /**
  * @brief Parse and create list for all blocks
@@ -100,6 +129,11 @@ emu_result_t emu_block_parse_output(const uint8_t *data, const uint16_t packet_l
  */
 void emu_blocks_free_all(void* emu_code_handle);
 
+/**
+ * @brief Call restore functions of all blocks, after retained values are restored and before loop starts
+ */
+void emu_blocks_restore_all(void* emu_code_handle);
+
 
 /****************************************************************************************************************
  * Helper inline functions for blocks operations
@@ -113,13 +147,13 @@ void emu_blocks_free_all(void* emu_code_handle);
 
 /**
  * @brief Check if all inputs in block updated (this is required for most blocks to run (like in PLC) / behaves like "IF PREV EXECUTED I CAN RUN")
- * @note This checks instances of blocks outputs in context memory (s_mem_contexts)[1] only
+ * @note Flags are read from context bitmaps through operand table (resolved at verify)
  */
 static __always_inline bool emu_block_check_inputs_updated(block_handle_t block) {
     uint16_t mask = block->cfg.in_connceted_mask;
 
     for (uint8_t i = 0; i < block->cfg.in_cnt; i++) {
-        if ((mask & 1) && !block->inputs[i]->instance->updated) {return false;}
+        if ((mask & 1) && !mem_flag_get(block->ops[i].updated)) {return false;}
         mask >>= 1;
     }
     return true;
@@ -127,11 +161,11 @@ static __always_inline bool emu_block_check_inputs_updated(block_handle_t block)
 
 
 /**
- * @brief Check if specific input in block is updated (look into mem instance updated flag)
+ * @brief Check if specific input in block is updated (look into updated bitmap of instance)
  */
 static __always_inline bool block_in_updated(block_handle_t block, uint8_t num) {
     if (unlikely(num >= block->cfg.in_cnt)) { return false; }
-    return (((block->cfg.in_connceted_mask>>num) & 1) && block->inputs[num]->instance->updated);
+    return (((block->cfg.in_connceted_mask>>num) & 1) && mem_flag_get(block->ops[num].updated));
 }
 
 
@@ -141,7 +175,7 @@ static __always_inline bool block_in_updated(block_handle_t block, uint8_t num)
 static __always_inline bool block_check_in_true(block_handle_t block, uint8_t num) {
     if (!block_in_updated(block, num)) {return false;}
     bool en = false; 
-    emu_result_t err = MEM_GET(&en, block->inputs[num]);
+    emu_result_t err = BLOCK_IN_GET(&en, block, num);
 
     //we report error but still return the value (false if error occurs)
     if (unlikely(err.code != EMU_OK)) {
@@ -152,13 +186,98 @@ static __always_inline bool block_check_in_true(block_handle_t block, uint8_t nu
 
 
 /**
- * @brief Set output value in block (wrapper around mem_set just to clarify usage)
+ * @brief Set output value in block (var has to be by value)
+ * @note Output with address in operand table is written directly (kernel when types differ), others go through mem_set
  */
 static __always_inline emu_result_t block_set_output(block_handle_t block, mem_var_t var, uint8_t num) {
     //check if output can even exist
     if (unlikely(num >= block->cfg.q_cnt)) {EMU_RETURN_CRITICAL(EMU_ERR_BLOCK_INVALID_PARAM, EMU_OWNER_block_set_output, block->cfg.block_idx, 0, "block_set_output", "num exceeds total outs");}
-    //as said just wrapper around mem_set
-    return mem_set(var, block->outputs[num]);
+    const emu_operand_t *op = &block->ops[block->cfg.in_cnt + num];
+    if (unlikely(!op->ptr)) {return mem_set(var, block->outputs[num]);}
+    mem_flag_set(op->updated);
+    if (likely(var.type == op->type)) {
+        switch (var.type) {
+            case MEM_B:   *(bool*)op->ptr     = var.data.val.b;   return EMU_RESULT_OK();
+            case MEM_F:   *(float*)op->ptr    = var.data.val.f;   return EMU_RESULT_OK();
+            case MEM_U8:  *(uint8_t*)op->ptr  = var.data.val.u8;  return EMU_RESULT_OK();
+            case MEM_U16: *(uint16_t*)op->ptr = var.data.val.u16; return EMU_RESULT_OK();
+            case MEM_U32: *(uint32_t*)op->ptr = var.data.val.u32; return EMU_RESULT_OK();
+            case MEM_I16: *(int16_t*)op->ptr  = var.data.val.i16; return EMU_RESULT_OK();
+            case MEM_I32: *(int32_t*)op->ptr  = var.data.val.i32; return EMU_RESULT_OK();
+            case MEM_Q:   *(int32_t*)op->ptr  = var.data.val.q;   return EMU_RESULT_OK();
+        }
+    }
+    if (unlikely(var.type >= MEM_TYPES_COUNT)) {EMU_RETURN_CRITICAL(EMU_ERR_MEM_INVALID_DATATYPE, EMU_OWNER_block_set_output, block->cfg.block_idx, 0, "block_set_output", "Invalid source type %d", var.type);}
+    emu_conv_kernels[var.type][op->type](op->ptr, &var.data.val);
+    return EMU_RESULT_OK();
+}
+
+/**
+ * @brief Get block input as whole number without going through float (integer paths of blocks)
+ * @note Float input (only possible when IN_SELECTOR swaps instance) is rounded and clamped to int32 like MEM_CAST
+ */
+static __always_inline emu_result_t block_in_get_int(block_handle_t block, uint8_t num, int64_t *dst) {
+    const emu_operand_t *op = &block->ops[num];
+    mem_var_t v;
+    if (likely(op->ptr)) {
+        v.type = op->type;
+        v.by_reference = 1;
+        v.data.ptr.u8 = (uint8_t*)op->ptr;
+    } else {
+        emu_result_t res = mem_get(&v, block->inputs[num], false);
+        if (unlikely(res.code != EMU_OK)) {return res;}
+    }
+    switch (v.type) {
+        case MEM_U8:  *dst = GET_VAL(v, u8);  break;
+        case MEM_U16: *dst = GET_VAL(v, u16); break;
+        case MEM_U32: *dst = GET_VAL(v, u32); break;
+        case MEM_I16: *dst = GET_VAL(v, i16); break;
+        case MEM_I32: *dst = GET_VAL(v, i32); break;
+        case MEM_B:   *dst = GET_VAL(v, b);   break;
+        default:      *dst = emu_var_to_i32(v); break;
+    }
+    return EMU_RESULT_OK();
+}
+
+/**
+ * @brief Get block input as Q16.16 raw value (fixed point paths of blocks), integers are scaled without float
+ */
+static __always_inline emu_result_t block_in_get_q(block_handle_t block, uint8_t num, int32_t *dst) {
+    const emu_operand_t *op = &block->ops[num];
+    mem_var_t v;
+    if (likely(op->ptr)) {
+        v.type = op->type;
+        v.by_reference = 1;
+        v.data.ptr.u8 = (uint8_t*)op->ptr;
+    } else {
+        emu_result_t res = mem_get(&v, block->inputs[num], false);
+        if (unlikely(res.code != EMU_OK)) {return res;}
+    }
+    *dst = emu_var_to_q(v);
+    return EMU_RESULT_OK();
+}
+
+/**
+ * @brief Whole number as mem_var_t for output of type out_type (U32 output gets u32, others i32, block_set_output narrows with clamp)
+ */
+static __always_inline mem_var_t block_int_var(int64_t val, uint8_t out_type) {
+    mem_var_t v = {0};
+    if (out_type == MEM_U32) {
+        v.type = MEM_U32;
+        v.data.val.u32 = (val < 0) ? 0 : (val > UINT32_MAX) ? UINT32_MAX : (uint32_t)val;
+    } else {
+        v.type = MEM_I32;
+        v.data.val.i32 = (val < INT32_MIN) ? INT32_MIN : (val > INT32_MAX) ? INT32_MAX : (int32_t)val;
+    }
+    return v;
+}
+
+/**
+ * @brief Set or clear output "updated" status without writing value (selectors)
+ */
+static __always_inline void block_mark_output(block_handle_t block, uint8_t num, bool updated) {
+    mem_flag_ref_t flag = block->ops[block->cfg.in_cnt + num].updated;
+    if (updated) {mem_flag_set(flag);} else {mem_flag_clear(flag);}
 }
 
 /**
@@ -170,8 +289,9 @@ static __always_inline void emu_block_reset_outputs_status(block_handle_t block)
 
     for (uint8_t i = 0; i < block->cfg.q_cnt; i++) {
         //we can clear only if instance says so 
-        if (block->outputs[i]->instance->can_clear) {
-            block->outputs[i]->instance->updated = 0;
+        const emu_operand_t *op = &block->ops[block->cfg.in_cnt + i];
+        if (op->clear_mask) {
+            mem_flag_clear(op->updated);
         }
     }
 }
@@ -0,0 +1,58 @@
+#include "emu_arena.h"
+#include "emu_logging.h"
+#include <string.h>
+
+static const char* TAG = __FILE_NAME__;
+
+static data_pool_t arena;
+static size_t region_used[EMU_ARENA_REGIONS_CNT];
+static uint32_t region_allocs[EMU_ARENA_REGIONS_CNT];
+static uint32_t failed;
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_arena_init
+emu_result_t emu_arena_init(size_t size) {
+    if (arena.data) {return EMU_RESULT_OK();}
+    emu_err_t err = pool_create(&arena, size, EMU_ARENA_ALIGN);
+    if (err != EMU_OK) {RET_E(err, "Failed to create program arena of %zu bytes", size);}
+    RET_OK("Program arena created, %zu bytes", arena.pool_size);
+}
+
+void *emu_arena_alloc(emu_arena_region_t region, size_t size) {
+    if (!arena.data || region >= EMU_ARENA_REGIONS_CNT) {return NULL;}
+    uint8_t *ptr = NULL;
+    //contexts outlive code, so they grow from other end and code can be released alone
+    emu_err_t err = (region == EMU_ARENA_CONTEXTS) ? pool_alloc(&arena, &ptr, size) : pool_alloc_top(&arena, &ptr, size);
+    if (err != EMU_OK) {
+        failed++;
+        LOG_E(TAG, "Arena full, %zu bytes requested, %zu free", size, POOL_FREE(&arena));
+        return NULL;
+    }
+    region_used[region] += (size + EMU_ARENA_ALIGN - 1) & ~(size_t)(EMU_ARENA_ALIGN - 1);
+    region_allocs[region]++;
+    return ptr;
+}
+
+void emu_arena_reset_code(void) {
+    pool_reset_top(&arena);
+    region_used[EMU_ARENA_ACCESS] = region_used[EMU_ARENA_BLOCKS] = 0;
+    region_allocs[EMU_ARENA_ACCESS] = region_allocs[EMU_ARENA_BLOCKS] = 0;
+    LOG_I(TAG, "Code released from arena, %zu bytes used, peak %zu", POOL_USED(&arena), arena.peak);
+}
+
+void emu_arena_reset(void) {
+    pool_reset(&arena);
+    memset(region_used, 0, sizeof(region_used));
+    memset(region_allocs, 0, sizeof(region_allocs));
+    LOG_I(TAG, "Arena released, peak %zu of %zu bytes", arena.peak, arena.pool_size);
+}
+
+void emu_arena_get_stats(emu_arena_stats_t *stats) {
+    stats->size = arena.pool_size;
+    stats->used = arena.data ? POOL_USED(&arena) : 0;
+    stats->peak = arena.peak;
+    stats->free = arena.data ? POOL_FREE(&arena) : 0;
+    memcpy(stats->region_used, region_used, sizeof(region_used));
+    memcpy(stats->region_allocs, region_allocs, sizeof(region_allocs));
+    stats->failed = failed;
+}
@@ -7,96 +7,229 @@
 #include "block_types.h"
 #include "emu_body.h"
 #include "blocks_functions_list.h"
+#include "emu_profiler.h"
+#include "emu_sched.h"
+#include "emu_partition.h"
+#include "emu_arena.h"
 
 static const char *TAG = __FILE_NAME__;
 
 static emu_code_handle_t global_code_ctx;
 
 /** 
- * * @brief execute list of funinctions and corresponding block structs
+ * * @brief index of block where execution stopped (error, watchdog), total_blocks after full pass
  */
 uint64_t emu_loop_iterator;
 
+/*watchdog is checked once per this many plan entries, not for every block*/
+#define EMU_PLAN_WTD_STRIDE 32
+
+/**
+ * @brief Reset outputs and run one plan entry (with profiler if enabled)
+ */
+static __always_inline emu_result_t _execute_entry(const emu_plan_entry_t *entry){
+    //we need to reset outputs updated status before execution of block to ensure proper tracking of updates
+    emu_block_reset_outputs_status(entry->block);
+
+    #ifdef ENABLE_BLOCK_PROFILER
+    emu_block_profile_t *prof = emu_profiler_table();
+    if (unlikely(prof)) {
+        uint32_t start = emu_profiler_now();
+        emu_result_t res = entry->func(entry->block);
+        emu_profiler_record(prof, entry->block->cfg.block_idx, res, emu_profiler_now() - start);
+        return res;
+    }
+    #endif
+    return entry->func(entry->block);
+}
+
 #undef OWNER
 #define OWNER EMU_OWNER_emu_execute_code
-__attribute__((hot)) static emu_result_t emu_execute_code(emu_code_handle_t code){
+/**
+ * @brief Dirty mode pass, visit only blocks scheduled by emu_sched (see emu_sched.h)
+ */
+static emu_result_t _execute_code_dirty(emu_code_handle_t code){
+    emu_sched_t *sched = code->sched;
+    emu_result_t res;
 
-    emu_result_t res = {.code = EMU_OK};
- 
-    //don't execute if code is null
-    if (unlikely(!code)) {RET_E(EMU_ERR_NULL_PTR, "Block struct list is NULL");}
-    
-    //execute all blocks in list
-    for (emu_loop_iterator = 0; emu_loop_iterator < code->total_blocks; emu_loop_iterator++) {
-        block_handle_t block = code->blocks_list[emu_loop_iterator];
-        
-        //we need to reset outputs updated status before execution of block to ensure proper tracking of updates
-        emu_block_reset_outputs_status(block);
-
-        //execute only if watchdog not triggered
-        if(likely(!emu_loop_wtd_status())){
-            // Cache function pointer to avoid table lookup overhead
-            emu_block_func exec_func = blocks_main_functions_table[block->cfg.block_type];
-            res = exec_func(block);
-            
-            //check for errors return only if abort flag is set
+    emu_sched_cycle_begin(sched);
+
+    for (uint16_t w = 0; w < sched->words; w++) {
+        //one bitmap word is one watchdog stride
+        if (unlikely(sched->pending[w] && emu_loop_wtd_status())) {
+            emu_loop_iterator = (w << 5) + __builtin_ctz(sched->pending[w]);
+            emu_sched_visit_all(sched);
+            RET_ED(EMU_ERR_BLOCK_WTD_TRIGGERED, emu_loop_iterator, 0, 
+                                "While executing loop %lld, after block %lld, watchdog triggered, total running time %lld ms, wtd is set to %lld ms",
+                                emu_loop_get_iteration(), emu_loop_iterator,
+                                emu_loop_get_time(), (uint64_t)(emu_loop_get_wtd_max_skipped() * emu_loop_get_period()) / 1000);
+        }
+        while (sched->pending[w]) {
+            uint16_t idx = (w << 5) + __builtin_ctz(sched->pending[w]);
+            sched->pending[w] &= sched->pending[w] - 1;
+            const emu_plan_entry_t *entry = &code->plan[idx];
+
+            res = _execute_entry(entry);
             if (unlikely(res.abort)){
+                //pending blocks of this cycle are lost, start again from full pass
+                emu_loop_iterator = idx;
+                emu_sched_visit_all(sched);
                 RET_ED(res.code, emu_loop_iterator, ++res.depth, 
                                     "Block %lld (error owner idx: %d) failed during execution, error: %s", 
                                     emu_loop_iterator, res.owner_idx, EMU_ERR_TO_STR(res.code));
             }
 
-        //If watchdog triggered during execution of block, abort further execution
-        } else {
-            LOG_E(TAG,"chuj");
-            RET_ED(EMU_ERR_BLOCK_WTD_TRIGGERED, emu_loop_iterator, 0, 
-                                "While executing loop %lld, after block %lld, watchdog triggered, total running time %lld ms, wtd is set to %lld ms",
-                                emu_loop_get_iteration(), emu_loop_iterator,
+            //FOR executed its chain, those are done for this cycle
+            uint16_t last = idx + entry->skip - 1;
+            if (unlikely(last != idx)) {emu_sched_drop(sched, idx + 1, last);}
+            for (uint16_t b = idx; b <= last; b++) {
+                emu_sched_propagate(sched, b, last);
+            }
+        }
+    }
+    emu_loop_iterator = code->total_blocks;
+    return EMU_RESULT_OK();
+}
+
+__attribute__((hot)) emu_result_t emu_execute_plan(const emu_plan_entry_t *plan, uint16_t cnt){
+
+    emu_result_t res = {.code = EMU_OK};
+    const emu_plan_entry_t *entry = plan;
+    const emu_plan_entry_t *end = plan + cnt;
+    while (entry < end) {
+
+        //If watchdog triggered during execution of previous blocks, abort further execution
+        if (unlikely(emu_loop_wtd_status())) {
+            RET_ED(EMU_ERR_BLOCK_WTD_TRIGGERED, entry->block->cfg.block_idx, 0, 
+                                "While executing loop %lld, after block %"PRIu16", watchdog triggered, total running time %lld ms, wtd is set to %lld ms",
+                                emu_loop_get_iteration(), entry->block->cfg.block_idx,
                                 emu_loop_get_time(), (uint64_t)(emu_loop_get_wtd_max_skipped() * emu_loop_get_period()) / 1000);
         }
+
+        const emu_plan_entry_t *stride_end = (end - entry > EMU_PLAN_WTD_STRIDE) ? entry + EMU_PLAN_WTD_STRIDE : end;
+        while (entry < stride_end) {
+            res = _execute_entry(entry);
+            
+            //check for errors return only if abort flag is set
+            if (unlikely(res.abort)){
+                RET_ED(res.code, entry->block->cfg.block_idx, ++res.depth, 
+                                    "Block %"PRIu16" (error owner idx: %d) failed during execution, error: %s", 
+                                    entry->block->cfg.block_idx, res.owner_idx, EMU_ERR_TO_STR(res.code));
+            }
+            entry += entry->skip;
+        }
+    }
+    return EMU_RESULT_OK();
+}
+
+__attribute__((hot)) emu_result_t emu_execute_code(emu_code_handle_t code){
+
+    emu_result_t res;
+ 
+    //don't execute if code is null
+    if (unlikely(!code)) {RET_E(EMU_ERR_NULL_PTR, "Block struct list is NULL");}
+    if (unlikely(!code->plan)) {RET_E(EMU_ERR_INVALID_STATE, "Code not compiled, verify code before start");}
+
+    if (code->exec_mode == EMU_EXEC_DIRTY && code->sched) {return _execute_code_dirty(code);}
+
+    if (emu_partition_active(code)) {
+        res = emu_partition_execute(code);
+    } else {
+        res = emu_execute_plan(code->plan, code->total_blocks);
     }
+    emu_loop_iterator = res.abort ? res.owner_idx : code->total_blocks;
     return res;
 }
 
+__attribute__((hot)) emu_result_t emu_execute_class(emu_code_handle_t code, uint8_t cls){
+    uint16_t first, cnt;
+    if (likely(!emu_loop_class_range(cls, &first, &cnt))) {return emu_execute_code(code);}
+
+    if (unlikely(!code)) {RET_E(EMU_ERR_NULL_PTR, "Block struct list is NULL");}
+    if (unlikely(!code->plan)) {RET_E(EMU_ERR_INVALID_STATE, "Code not compiled, verify code before start");}
+
+    emu_result_t res = emu_execute_plan(&code->plan[first], cnt);
+    //iterator is reported by main class only
+    if (cls == 0) {emu_loop_iterator = res.abort ? res.owner_idx : (uint64_t)first + cnt;}
+    return res;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_code_compile
+emu_result_t emu_code_compile(emu_code_handle_t code){
+    if (!code || !code->blocks_list) {RET_E(EMU_ERR_NULL_PTR, "No code to compile");}
+
+    free(code->plan);
+    code->plan = (emu_plan_entry_t*)calloc(code->total_blocks, sizeof(emu_plan_entry_t));
+    if (!code->plan) {RET_E(EMU_ERR_NO_MEM, "No memory for plan of %"PRIu16" blocks", code->total_blocks);}
+
+    for (uint16_t i = 0; i < code->total_blocks; i++) {
+        block_handle_t block = code->blocks_list[i];
+        emu_block_chain_func chain_fn = emu_block_chain_table[block->cfg.block_type];
+        uint16_t chain = chain_fn ? chain_fn(block) : 0;
+
+        if ((uint32_t)i + chain >= code->total_blocks) {
+            free(code->plan);
+            code->plan = NULL;
+            RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, i, 0, "Block[%"PRIu16"] chain of %"PRIu16" blocks exceeds code (%"PRIu16" blocks)", i, chain, code->total_blocks);
+        }
+        code->plan[i] = (emu_plan_entry_t){
+            .func  = blocks_main_functions_table[block->cfg.block_type],
+            .block = block,
+            .skip  = chain + 1,
+        };
+    }
+
+    //nested chain has to end inside chain of its FOR, both FOR and main loop jump over chains by skip
+    for (uint16_t i = 0; i < code->total_blocks; i++) {
+        uint32_t end = (uint32_t)i + code->plan[i].skip;
+        for (uint32_t k = (uint32_t)i + 1; k < end; k += code->plan[k].skip) {
+            if (k + code->plan[k].skip <= end) {continue;}
+            uint32_t k_last = k + code->plan[k].skip - 1;
+            free(code->plan);
+            code->plan = NULL;
+            RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, k, 0, "Block[%"PRIu32"] chain ends at block %"PRIu32", beyond chain of block %"PRIu16" (ends at %"PRIu32")", k, k_last, i, end - 1);
+        }
+    }
+    RET_OK("Compiled plan of %"PRIu16" blocks", code->total_blocks);
+}
+
 /**
  * @brief Main loop task for emulator execution
  */
 void emu_body_loop_task(void* params){
     while(1){
         if(emu_loop_wait_for_cycle_start(portMAX_DELAY)==true){ 
-            int64_t start_time = esp_timer_get_time();
-
-            emu_execute_code(global_code_ctx);
+            emu_execute_class(global_code_ctx, 0);
+            emu_loop_mark_exec_end();
 
-            //int64_t end_time = esp_timer_get_time();
-            //ESP_LOGI(TAG, "Loop completed in %lld us", (end_time - start_time));
             emu_subscribe_send();
-            // Request logger to dump accumulated logs/reports and wait until it's done
-            if (logger_task_handle) {
-                xTaskNotifyGive(logger_task_handle);
-                if (logger_done_sem) {
-                    xSemaphoreTake(logger_done_sem, portMAX_DELAY);
-                }
-            } else if (logger_request_sem) {
-                xSemaphoreGive(logger_request_sem);
-                if (logger_done_sem) {
-                    xSemaphoreTake(logger_done_sem, portMAX_DELAY);
-                }
-            }
+            emu_profiler_cycle_end(global_code_ctx);
+            //logs of this cycle are already in log rings, logger task sends them on its own schedule
 
             if (emu_loop_wtd_status()) {
                     REP_ED(EMU_ERR_BLOCK_WTD_TRIGGERED, emu_loop_iterator > 0 ? emu_loop_iterator - 1 : 0, 0,
                         "After full loop pass, watchdog triggered, total running time %lld ms, wtd is set to %lld ms",
                         emu_loop_get_time(), (uint64_t)(emu_loop_get_wtd_max_skipped() * emu_loop_get_period()) / 1000);
             }
-            int64_t total_time = esp_timer_get_time();
-            ESP_LOGI(TAG, "Loop completed in %lld us", (total_time- start_time));
             emu_loop_notify_cycle_end();
             taskYIELD();
         }
     }
 }
 
+/**
+ * @brief Task of additional task class, no publish / logger / statistics (done by main class)
+ */
+void emu_body_class_task(void* params){
+    uint8_t cls = (uint8_t)(uintptr_t)params;
+    while(1){
+        if(emu_loop_class_wait(cls, portMAX_DELAY)==true){
+            emu_execute_class(global_code_ctx, cls);
+            emu_loop_class_cycle_end(cls);
+        }
+    }
+}
 
 /**
  * @brief Get current code context
@@ -115,10 +248,18 @@ emu_code_handle_t emu_get_current_code_ctx(){
  */
 void emu_reset_code_ctx(){
     if (global_code_ctx){
+        emu_profiler_free();
+        emu_sched_free(global_code_ctx);
+        emu_partition_free(global_code_ctx);
+        free(global_code_ctx->plan);
         emu_blocks_free_all(global_code_ctx);
         free(global_code_ctx);
         global_code_ctx = NULL;
     }
+    //access nodes, block list and block data of old code
+    emu_arena_reset_code();
+    //outputs of old code must not trigger blocks of next one
+    for (uint8_t ctx = 0; ctx < MAX_CONTEXTS; ctx++) {mem_context_clear_updated(ctx);}
 }
 
 
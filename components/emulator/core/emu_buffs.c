@@ -10,7 +10,7 @@ static const char *TAG = __FILE_NAME__;
 
 /* ---- msg_packet globals ---- */
 size_t mtu_size = 0;
-msg_packet_t emu_in_msg_packet = {0};
+static msg_packet_t emu_in_msg_slots[EMU_IN_MSG_SLOTS] = {0};
 msg_packet_t emu_out_msg_packet = {0};
 
 #define IS_POWER_OF_TWO(x) (((x) != 0) && (((x) & ((x) - 1)) == 0))
@@ -27,28 +27,55 @@ emu_err_t pool_create(data_pool_t* pool, size_t pool_size, size_t alignment) {
     pool->data = (uint8_t*)aligned_alloc(alignment, aligned_size);
     if (!pool->data) return EMU_ERR_NO_MEM;
 
-    memset(pool->data, 0, aligned_size);
-
     pool->pool_size = aligned_size;
     pool->alignment = alignment;
     pool->next_address = 0;
+    pool->top_address = aligned_size;
+    pool->peak = 0;
 
     return EMU_OK;
 }
 
+static inline void _pool_track_peak(data_pool_t* pool) {
+    size_t used = POOL_USED(pool);
+    if (used > pool->peak) {pool->peak = used;}
+}
+
 emu_err_t pool_alloc(data_pool_t* pool, uint8_t** result, size_t size) {
     if (!pool || !result || size == 0) return EMU_ERR_INVALID_ARG;
 
     size_t align = (size_t)pool->alignment;
     size_t aligned_size = (size + align - 1) & ~(align - 1);
 
-    if (aligned_size > pool->pool_size - pool->next_address) {
+    if (aligned_size > POOL_FREE(pool)) {
         *result = NULL;
         return EMU_ERR_NO_MEM;
     }
 
     *result = pool->data + pool->next_address;
     pool->next_address += aligned_size;
+    //zeroed here, reset does not touch memory
+    memset(*result, 0, aligned_size);
+    _pool_track_peak(pool);
+
+    return EMU_OK;
+}
+
+emu_err_t pool_alloc_top(data_pool_t* pool, uint8_t** result, size_t size) {
+    if (!pool || !result || size == 0) return EMU_ERR_INVALID_ARG;
+
+    size_t align = (size_t)pool->alignment;
+    size_t aligned_size = (size + align - 1) & ~(align - 1);
+
+    if (aligned_size > POOL_FREE(pool)) {
+        *result = NULL;
+        return EMU_ERR_NO_MEM;
+    }
+
+    pool->top_address -= aligned_size;
+    *result = pool->data + pool->top_address;
+    memset(*result, 0, aligned_size);
+    _pool_track_peak(pool);
 
     return EMU_OK;
 }
@@ -56,7 +83,12 @@ emu_err_t pool_alloc(data_pool_t* pool, uint8_t** result, size_t size) {
 void pool_reset(data_pool_t* pool) {
     if (!pool) return;
     pool->next_address = 0;
-    memset(pool->data, 0, pool->pool_size); 
+    pool->top_address = pool->pool_size;
+}
+
+void pool_reset_top(data_pool_t* pool) {
+    if (!pool) return;
+    pool->top_address = pool->pool_size;
 }
 
 emu_err_t pool_destroy(data_pool_t* pool) {
@@ -66,6 +98,8 @@ emu_err_t pool_destroy(data_pool_t* pool) {
     pool->data = NULL;
     pool->pool_size = 0;
     pool->next_address = 0;
+    pool->top_address = 0;
+    pool->peak = 0;
     pool->alignment = 0;
     
     return EMU_OK;
@@ -75,24 +109,27 @@ emu_err_t pool_destroy(data_pool_t* pool) {
 
 esp_err_t emu_msg_buffs_init(size_t mtu){
     mtu_size = mtu;
-    if(emu_in_msg_packet.data || emu_out_msg_packet.data){
-        free(emu_in_msg_packet.data);
-        free(emu_out_msg_packet.data);
-    }
-
-    emu_in_msg_packet.data = malloc(mtu_size);
-    if (!emu_in_msg_packet.data) {return ESP_ERR_NO_MEM;}
+    //slots share one allocation, slot 0 owns it
+    free(emu_in_msg_slots[0].data);
+    free(emu_out_msg_packet.data);
+    memset(emu_in_msg_slots, 0, sizeof(emu_in_msg_slots));
+    emu_out_msg_packet.data = NULL;
+
+    uint8_t *ring = malloc(mtu_size * EMU_IN_MSG_SLOTS);
+    if (!ring) {return ESP_ERR_NO_MEM;}
+    for (uint8_t i = 0; i < EMU_IN_MSG_SLOTS; i++) {emu_in_msg_slots[i].data = &ring[i * mtu_size];}
     emu_out_msg_packet.data = malloc(mtu_size);
     if (!emu_out_msg_packet.data) {
-        free(emu_in_msg_packet.data);
+        free(ring);
+        memset(emu_in_msg_slots, 0, sizeof(emu_in_msg_slots));
         return ESP_ERR_NO_MEM;
     }
-    ESP_LOGI(TAG, "Message buffers initialized with MTU size: %zu bytes", mtu_size);
+    ESP_LOGI(TAG, "Message buffers initialized with MTU size: %zu bytes, %d receive slots", mtu_size, EMU_IN_MSG_SLOTS);
     return ESP_OK;
 }
 
-msg_packet_t* emu_get_in_msg_packet(void){
-    return &emu_in_msg_packet;
+msg_packet_t* emu_get_in_msg_slot(uint16_t idx){
+    return &emu_in_msg_slots[idx % EMU_IN_MSG_SLOTS];
 }
 
 msg_packet_t* emu_get_out_msg_packet(void){
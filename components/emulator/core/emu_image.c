@@ -0,0 +1,283 @@
+#include "emu_image.h"
+#include "emu_parse.h"
+#include "emu_body.h"
+#include "emu_logging.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "emu_helpers.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char* TAG = __FILE_NAME__;
+
+#define IMAGE_RECORD_HEAD sizeof(uint16_t)
+
+static uint8_t *journal;
+static uint32_t journal_len;
+static uint32_t journal_cap;
+static uint32_t journal_records;
+static bool journal_overflow;
+static bool journal_hold;       /*uploaded image is replayed, it becomes journal itself*/
+
+static uint8_t *upload;
+static uint32_t upload_len;
+static uint32_t upload_total;
+static bool replaying;
+
+/*-------------------------------JOURNAL------------------------------------------------------------ */
+
+/*Packets that build program: parsed ones and orders that change code / loop state, replayed at boot in same order*/
+static bool _is_program_record(const msg_packet_t *packet) {
+    switch ((packet_header_t)packet->data[0]) {
+        case PACKET_H_CONTEXT_CFG:
+        case PACKET_H_INSTANCE:
+        case PACKET_H_INSTANCE_SCALAR_DATA:
+        case PACKET_H_INSTANCE_ARR_DATA:
+        case PACKET_H_LOOP_CFG:
+        case PACKET_H_CODE_CFG:
+        case PACKET_H_BLOCK_HEADER:
+        case PACKET_H_BLOCK_INPUTS:
+        case PACKET_H_BLOCK_OUTPUTS:
+        case PACKET_H_BLOCK_DATA:
+        case PACKET_H_SUBSCRIPTION_INIT:
+        case PACKET_H_SUBSCRIPTION_ADD:
+            return true;
+        default:
+            break;
+    }
+    uint16_t order;
+    memcpy(&order, packet->data, sizeof(order));
+    switch ((emu_order_t)order) {
+        case ORD_RESET_BLOCKS:
+        case ORD_EMU_LOOP_INIT:
+        case ORD_EMU_LOOP_START:
+        case ORD_EMU_LOOP_STOP:
+        case ORD_EMU_SET_EXEC_MODE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void emu_image_journal_reset(void) {
+    free(journal);
+    journal = NULL;
+    journal_len = journal_cap = journal_records = 0;
+    journal_overflow = false;
+}
+
+void emu_image_journal_add(const msg_packet_t *packet) {
+    if (journal_hold || journal_overflow || !packet || packet->len < 2 || !_is_program_record(packet)) {return;}
+    uint32_t need = journal_len + IMAGE_RECORD_HEAD + packet->len;
+    if (packet->len > UINT16_MAX || need > EMU_IMAGE_JOURNAL_MAX) {
+        journal_overflow = true;
+        LOG_W(TAG, "Upload exceeds %d bytes of image journal, program can't be saved", EMU_IMAGE_JOURNAL_MAX);
+        return;
+    }
+    if (need > journal_cap) {
+        uint32_t cap = journal_cap ? journal_cap : 1024;
+        while (cap < need) {cap *= 2;}
+        if (cap > EMU_IMAGE_JOURNAL_MAX) {cap = EMU_IMAGE_JOURNAL_MAX;}
+        uint8_t *grown = (uint8_t*)realloc(journal, cap);
+        if (!grown) {
+            journal_overflow = true;
+            LOG_W(TAG, "No memory for image journal, program can't be saved");
+            return;
+        }
+        journal = grown;
+        journal_cap = cap;
+    }
+    uint16_t len = (uint16_t)packet->len;
+    memcpy(&journal[journal_len], &len, IMAGE_RECORD_HEAD);
+    memcpy(&journal[journal_len + IMAGE_RECORD_HEAD], packet->data, len);
+    journal_len = need;
+    journal_records++;
+}
+
+/*-------------------------------REPLAY------------------------------------------------------------- */
+
+/*Records are processed in place, parsers copy what they keep*/
+static emu_result_t _replay(const uint8_t *rec, const emu_image_header_t *head, emu_image_process_cb process, uint32_t *done) {
+    emu_result_t res = EMU_RESULT_OK();
+    uint32_t offset = 0, records = 0;
+    replaying = true;
+    //errors and warnings still print, per item info would take longer than parsing itself
+    emu_log_info_muted = true;
+    while (records < head->records && offset + IMAGE_RECORD_HEAD <= head->size) {
+        uint16_t len;
+        memcpy(&len, &rec[offset], IMAGE_RECORD_HEAD);
+        offset += IMAGE_RECORD_HEAD;
+        if (len < 2 || offset + len > head->size) {break;}
+        msg_packet_t packet = {.data = (uint8_t*)&rec[offset], .len = len};
+        res = process(&packet);
+        if (res.code != EMU_OK && res.abort) {break;}
+        offset += len;
+        records++;
+    }
+    replaying = false;
+    emu_log_info_muted = false;
+    *done = records;
+    return res;
+}
+
+/*-------------------------------PARTITION---------------------------------------------------------- */
+
+static const esp_partition_t *_image_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, EMU_IMAGE_PARTITION_LABEL);
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_image_save
+emu_result_t emu_image_save(void) {
+    emu_code_handle_t code = emu_get_current_code_ctx();
+    if (!code || !code->plan) {RET_E(EMU_ERR_INVALID_STATE, "Only verified code can be saved");}
+    if (journal_overflow) {RET_E(EMU_ERR_NO_MEM, "Upload was not fully recorded, image not saved");}
+    if (!journal_records) {RET_E(EMU_ERR_INVALID_STATE, "Nothing recorded since reset");}
+
+    const esp_partition_t *part = _image_partition();
+    if (!part) {RET_E(EMU_ERR_INVALID_STATE, "No \"%s\" partition", EMU_IMAGE_PARTITION_LABEL);}
+    uint32_t total = sizeof(emu_image_header_t) + journal_len;
+    if (total > part->size) {RET_E(EMU_ERR_NO_MEM, "Image of %"PRIu32" bytes exceeds partition (%"PRIu32")", total, (uint32_t)part->size);}
+
+    uint32_t erase = (total + part->erase_size - 1) / part->erase_size * part->erase_size;
+    esp_err_t err = esp_partition_erase_range(part, 0, erase);
+    if (err == ESP_OK) {err = esp_partition_write(part, sizeof(emu_image_header_t), journal, journal_len);}
+    //header last, interrupted save leaves erased (invalid) header
+    emu_image_header_t head = {
+        .magic     = EMU_IMAGE_MAGIC,
+        .version   = EMU_IMAGE_VERSION,
+        .types_cnt = MEM_TYPES_COUNT,
+        .records   = journal_records,
+        .size      = journal_len,
+        .crc       = esp_rom_crc32_le(0, journal, journal_len),
+    };
+    if (err == ESP_OK) {err = esp_partition_write(part, 0, &head, sizeof(head));}
+    if (err != ESP_OK) {RET_E(EMU_ERR_ORD_FAILED, "Flash write failed: %s", esp_err_to_name(err));}
+    RET_OK("Image saved, %"PRIu32" records, %"PRIu32" bytes", journal_records, total);
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_image_erase
+emu_result_t emu_image_erase(void) {
+    const esp_partition_t *part = _image_partition();
+    if (!part) {RET_E(EMU_ERR_INVALID_STATE, "No \"%s\" partition", EMU_IMAGE_PARTITION_LABEL);}
+    esp_err_t err = esp_partition_erase_range(part, 0, part->erase_size);
+    if (err != ESP_OK) {RET_E(EMU_ERR_ORD_FAILED, "Flash erase failed: %s", esp_err_to_name(err));}
+    RET_OK("Image erased");
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_image_boot
+emu_result_t emu_image_boot(emu_image_process_cb process) {
+    if (!process) {RET_E(EMU_ERR_NULL_PTR, "No packet processing");}
+    int64_t start = esp_timer_get_time();
+    const esp_partition_t *part = _image_partition();
+    if (!part) {RET_OK("No \"%s\" partition, waiting for upload", EMU_IMAGE_PARTITION_LABEL);}
+
+    emu_image_header_t head;
+    if (esp_partition_read(part, 0, &head, sizeof(head)) != ESP_OK || head.magic != EMU_IMAGE_MAGIC) {RET_OK("No program image, waiting for upload");}
+    if (head.version != EMU_IMAGE_VERSION || head.types_cnt != MEM_TYPES_COUNT) {
+        RET_W(EMU_ERR_INVALID_DATA, "Image version %u / %u types not supported by firmware, ignored", head.version, head.types_cnt);
+    }
+    if (head.size > part->size - sizeof(head)) {RET_E(EMU_ERR_INVALID_DATA, "Image size %"PRIu32" exceeds partition", head.size);}
+
+    const void *map = NULL;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, sizeof(head) + head.size, ESP_PARTITION_MMAP_DATA, &map, &handle);
+    if (err != ESP_OK) {RET_E(EMU_ERR_ORD_FAILED, "Image mmap failed: %s", esp_err_to_name(err));}
+
+    const uint8_t *rec = (const uint8_t*)map + sizeof(head);
+    if (esp_rom_crc32_le(0, rec, head.size) != head.crc) {
+        esp_partition_munmap(handle);
+        RET_E(EMU_ERR_INVALID_DATA, "Image crc mismatch, ignored");
+    }
+
+    uint32_t records = 0;
+    emu_result_t res = _replay(rec, &head, process, &records);
+    esp_partition_munmap(handle);
+
+    if (res.code != EMU_OK && res.abort) {RET_ED(res.code, 0, ++res.depth, "Image record %"PRIu32" failed", records);}
+    if (records != head.records) {RET_E(EMU_ERR_INVALID_DATA, "Image truncated at record %"PRIu32" of %"PRIu32"", records, head.records);}
+    RET_OK("Image of %"PRIu32" records booted in %"PRId64" us", records, esp_timer_get_time() - start);
+}
+
+/*-------------------------------UPLOAD------------------------------------------------------------- */
+
+static void _upload_drop(void) {
+    free(upload);
+    upload = NULL;
+    upload_len = upload_total = 0;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_image_upload
+emu_result_t emu_image_upload(const uint8_t *data, uint16_t len, bool *complete) {
+    *complete = false;
+    if (replaying) {RET_E(EMU_ERR_INVALID_STATE, "Image upload inside image");}
+    if (len < sizeof(uint32_t)) {RET_E(EMU_ERR_PACKET_INCOMPLETE, "Image chunk without offset");}
+    uint32_t offset = parse_get_u32(data, 0);
+    data += sizeof(uint32_t);
+    len -= sizeof(uint32_t);
+
+    if (offset == 0) {
+        _upload_drop();
+        emu_image_header_t head;
+        if (len < sizeof(head)) {RET_E(EMU_ERR_PACKET_INCOMPLETE, "First image chunk shorter than header");}
+        memcpy(&head, data, sizeof(head));
+        if (head.magic != EMU_IMAGE_MAGIC || head.version != EMU_IMAGE_VERSION || head.types_cnt != MEM_TYPES_COUNT) {
+            RET_E(EMU_ERR_INVALID_DATA, "Image version %u / %u types not supported by firmware", head.version, head.types_cnt);
+        }
+        if (head.size > EMU_IMAGE_JOURNAL_MAX) {RET_E(EMU_ERR_NO_MEM, "Image of %"PRIu32" bytes exceeds %d", head.size, EMU_IMAGE_JOURNAL_MAX);}
+        upload = (uint8_t*)malloc(sizeof(head) + head.size);
+        if (!upload) {RET_E(EMU_ERR_NO_MEM, "No memory for image of %"PRIu32" bytes", head.size);}
+        upload_total = sizeof(head) + head.size;
+    } else if (!upload || offset != upload_len) {
+        RET_E(EMU_ERR_INVALID_DATA, "Image chunk at %"PRIu32", expected %"PRIu32"", offset, upload_len);
+    }
+    if (upload_len + len > upload_total) {
+        _upload_drop();
+        RET_E(EMU_ERR_INVALID_DATA, "Image chunk past end of image");
+    }
+    memcpy(&upload[upload_len], data, len);
+    upload_len += len;
+    *complete = (upload_len == upload_total);
+    return EMU_RESULT_OK();
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_image_upload_run
+emu_result_t emu_image_upload_run(emu_image_process_cb process) {
+    if (!process) {RET_E(EMU_ERR_NULL_PTR, "No packet processing");}
+    if (!upload || upload_len != upload_total) {RET_E(EMU_ERR_INVALID_STATE, "No complete image uploaded");}
+    int64_t start = esp_timer_get_time();
+    emu_image_header_t head;
+    memcpy(&head, upload, sizeof(head));
+    const uint8_t *rec = &upload[sizeof(head)];
+    if (esp_rom_crc32_le(0, rec, head.size) != head.crc) {
+        _upload_drop();
+        RET_E(EMU_ERR_INVALID_DATA, "Image crc mismatch");
+    }
+
+    uint32_t records = 0;
+    journal_hold = true;
+    emu_result_t res = _replay(rec, &head, process, &records);
+    journal_hold = false;
+
+    if ((res.code != EMU_OK && res.abort) || records != head.records) {
+        _upload_drop();
+        if (res.code != EMU_OK && res.abort) {RET_ED(res.code, 0, ++res.depth, "Image record %"PRIu32" failed", records);}
+        RET_E(EMU_ERR_INVALID_DATA, "Image truncated at record %"PRIu32" of %"PRIu32"", records, head.records);
+    }
+
+    //buffer is kept as journal, records moved over header
+    emu_image_journal_reset();
+    memmove(upload, rec, head.size);
+    journal = upload;
+    journal_len = head.size;
+    journal_cap = upload_total;
+    journal_records = head.records;
+    upload = NULL;
+    upload_len = upload_total = 0;
+    RET_OK("Image of %"PRIu32" records loaded in %"PRId64" us", records, esp_timer_get_time() - start);
+}
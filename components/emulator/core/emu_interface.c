@@ -11,6 +11,13 @@
 #include "emu_parse.h"
 #include "emu_logging.h"
 #include "emu_buffs.h"
+#include "emu_profiler.h"
+#include "emu_sched.h"
+#include "emu_arena.h"
+#include "emu_image.h"
+#include "emu_retain.h"
+#include "emu_rx.h"
+#include "emu_subscribe.h"
 
 /* Definitions for globals declared extern in emu_buffs.h */
 
@@ -18,20 +25,179 @@ static const char * TAG = __FILE_NAME__;
 
 chr_msg_buffer_t *source = NULL; // Source buffer pointer
 
-/* Callback invoked after each packet is processed (signals BLE peer to send next) */
-static void (*packet_done_cb)(void) = NULL;
-
-void emu_interface_set_packet_done_cb(void (*cb)(void)) { packet_done_cb = cb; }
-static inline void _notify_done(void) { if (packet_done_cb) packet_done_cb(); }
-
 /* Interface task handle (used for notifications) */
 static TaskHandle_t emu_interface_task_handle = NULL;
 
 
+/* ============================================================================
+    PACKET PROCESSING
+   ============================================================================ */
+
+static emu_result_t _reset_all(void) {
+    emu_result_t res = emu_loop_stop();
+    emu_loop_deinit();
+    emu_retain_reset();
+    emu_reset_code_ctx();
+    emu_subscribe_reset();
+    mem_contexts_reset_all();
+    emu_image_journal_reset();
+    return res;
+}
+
+/**
+ * @brief Parse packet or order, same path for BLE packets and program image records at boot
+ */
+static emu_result_t _process_packet(msg_packet_t *packet) {
+    emu_result_t res = EMU_RESULT_OK();
+    uint16_t header;
+
+    /*Detect parse-path packet by checking data[0] against known packet headers*/
+    if (emu_is_parse_header(packet->data[0])) {
+        LOG_I(TAG, "Detected parser packet header: 0x%02X", packet->data[0]);
+        res = emu_parse_manager(packet, 0, emu_get_current_code_ctx(), NULL);
+        if (res.code == EMU_OK || !res.abort) {emu_image_journal_add(packet);}
+        return res;
+    }
+
+    memcpy(&header, packet->data, sizeof(header));
+    ESP_LOGI(TAG, "Processing order: 0x%04X", header);
+
+    switch (header){     
+        
+        case ORD_EMU_LOOP_INIT:
+            res = emu_loop_init(10000);
+            break;
+
+        case ORD_EMU_LOOP_START:
+            //verify rebuilds plan and block programs the loop task executes, running loop only gets start error
+            if (!emu_loop_can_start()) {res = emu_loop_start(); break;}
+            //blocks run without runtime checks, only code that passed verify can start
+            res = emu_parse_verify_code(emu_get_current_code_ctx());
+            if (res.code != EMU_OK && res.abort) {break;}
+            //retained values are back before first cycle, failure only means they are not kept
+            emu_retain_start();
+            emu_blocks_restore_all(emu_get_current_code_ctx());
+            res = emu_loop_start();
+            break;
+
+        case ORD_EMU_LOOP_STOP:
+            res = emu_loop_stop();
+            break;
+
+        // --- 4. UTILITY ---
+        case ORD_RESET_ALL: 
+            ESP_LOGI(TAG, "RESET ALL ORDER");
+            res = _reset_all();
+            break;
+
+        case ORD_RESET_BLOCKS:
+            res = emu_loop_stop();
+            emu_reset_code_ctx();
+            break;
+
+        case ORD_EMU_PROFILER_START: {
+            uint16_t send_every = 0;
+            if (packet->len >= 4) {memcpy(&send_every, &packet->data[2], sizeof(send_every));}
+            res = emu_profiler_start(emu_get_current_code_ctx(), send_every);
+            break;
+        }
+
+        case ORD_EMU_PROFILER_STOP:
+            emu_profiler_stop();
+            break;
+
+        case ORD_EMU_PROFILER_SEND:
+            res = emu_profiler_send(emu_get_current_code_ctx());
+            break;
+
+        case ORD_EMU_LOOP_STATS_GET:
+            if (packet->len >= 4) {
+                uint16_t send_every;
+                memcpy(&send_every, &packet->data[2], sizeof(send_every));
+                emu_loop_stats_set_send_every(send_every);
+            }
+            res = emu_loop_stats_send();
+            break;
+
+        case ORD_EMU_LOOP_STATS_RESET:
+            emu_loop_stats_reset();
+            break;
+
+        case ORD_EMU_SET_EXEC_MODE:
+            if (packet->len < 3) {ESP_LOGW(TAG, "Execution mode order without mode"); break;}
+            res = emu_sched_set_mode(emu_get_current_code_ctx(), (emu_exec_mode_t)packet->data[2]);
+            break;
+
+        case ORD_EMU_IMAGE_SAVE:
+            res = emu_image_save();
+            break;
+
+        case ORD_EMU_IMAGE_ERASE:
+            res = emu_image_erase();
+            break;
+
+        case ORD_EMU_IMAGE_UPLOAD: {
+            bool complete;
+            res = emu_image_upload(&packet->data[2], packet->len - 2, &complete);
+            if (res.code != EMU_OK || !complete) {break;}
+            //image brings whole program, old one goes away like on ORD_RESET_ALL
+            _reset_all();
+            res = emu_image_upload_run(_process_packet);
+            if (res.code != EMU_OK && res.abort) {_reset_all();}
+            break;
+        }
+
+
+        default:
+            //ESP_LOGW(TAG, "Unknown order: 0x%04X", current_order);
+            break;
+    }
+    if (res.code == EMU_OK || !res.abort) {emu_image_journal_add(packet);}
+    return res;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_interface_frames
+/**
+ * @brief Process write carrying many packets: [PACKET_H_FRAMES] + n * ([uint16_t len][packet]), frames are processed in place in order
+ * @note Stops at first aborting error, frames before it stay processed (same as separate writes would), error tells how many were applied
+ * @return First not OK result (warning of earlier frame is not hidden by later OK ones)
+ */
+static emu_result_t _process_frames(msg_packet_t *packet) {
+    emu_result_t first = EMU_RESULT_OK();
+    uint16_t offset = 1, frames = 0;
+    while (offset < packet->len) {
+        uint16_t len;
+        if (offset + sizeof(len) > packet->len) {RET_E(EMU_ERR_PACKET_INCOMPLETE, "Frame %"PRIu16" header cut at byte %"PRIu16", %"PRIu16" frames applied", frames, offset, frames);}
+        memcpy(&len, &packet->data[offset], sizeof(len));
+        offset += sizeof(len);
+        if (len < 2 || offset + len > packet->len) {RET_E(EMU_ERR_PACKET_INCOMPLETE, "Frame %"PRIu16" of %"PRIu16" bytes does not fit in write, %"PRIu16" frames applied", frames, len, frames);}
+        //nested wrapper would only hide frame boundaries
+        if (packet->data[offset] == PACKET_H_FRAMES) {RET_E(EMU_ERR_INVALID_DATA, "Frame %"PRIu16" is frames wrapper again, %"PRIu16" frames applied", frames, frames);}
+
+        msg_packet_t frame = {.data = &packet->data[offset], .len = len};
+        emu_result_t res = _process_packet(&frame);
+        if (res.code != EMU_OK && res.abort) {
+            RET_ED(res.code, 0, ++res.depth, "Frame %"PRIu16" (header 0x%02X) failed, %"PRIu16" frames applied", frames, frame.data[0], frames);
+        }
+        if (res.code != EMU_OK && first.code == EMU_OK) {first = res;}
+        offset += len;
+        frames++;
+    }
+    LOG_I(TAG, "Processed %"PRIu16" frames in one write", frames);
+    return first;
+}
+
 /* ============================================================================
     MAIN INTERFACE TASK
    ============================================================================ */
 
+emu_result_t emu_interface_boot_image(void) {
+    emu_result_t res = emu_image_boot(_process_packet);
+    if (res.code != EMU_OK && res.abort) {_reset_all();}
+    return res;
+}
+
 void emu_interface_task(void* params){
     emu_result_t res = EMU_RESULT_OK();
     
@@ -46,73 +212,41 @@ void emu_interface_task(void* params){
     /* store our task handle so other modules can notify us */
     emu_interface_task_handle = xTaskGetCurrentTaskHandle();
 
-    mem_access_allocate_space(1000, 500);
+    //program arena lives for whole runtime, uploads only reset it
+    res = emu_arena_init(EMU_ARENA_SIZE);
+    if (res.code != EMU_OK) {
+        ESP_LOGE(TAG, "Failed to create program arena");
+        vTaskDelete(NULL);
+    }
+
+    res = emu_retain_init();
+    if (res.code != EMU_OK) {ESP_LOGW(TAG, "Retained variables are not saved");}
+
+    //program saved in flash is built (and started if it was running when saved) without upload
+    res = emu_interface_boot_image();
+    if (res.code != EMU_OK && res.abort) {ESP_LOGE(TAG, "Program image not booted: %s", EMU_ERR_TO_STR(res.code));}
 
-    static uint16_t header;
     static msg_packet_t* in_packet;
 
 
     while(true){
             ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-            in_packet = emu_get_in_msg_packet();
+            //writes that arrived meanwhile are processed in order, each one is acknowledged by emu_rx_done
+            while ((in_packet = emu_rx_next()) != NULL) {
+                if (in_packet->len < 2) {
+                    ESP_LOGW(TAG, "Received packet too short to contain anything usefull");
+                    emu_rx_done();
+                    continue;
+                }
 
-            if (in_packet->len < 2) {
-                ESP_LOGW(TAG, "Received packet too short to contain anything usefull");
-                _notify_done();
-                continue;
+                //one write may carry many packets, peer gets one ACK for all of them
+                res = (in_packet->data[0] == PACKET_H_FRAMES) ? _process_frames(in_packet) : _process_packet(in_packet);
+                if (res.code != EMU_OK && res.abort) {
+                    ESP_LOGE(TAG, "Packet with header 0x%02X failed: %s", in_packet->data[0], EMU_ERR_TO_STR(res.code));
+                }
+                emu_rx_done();
             }
-
-            /*Detect parse-path packet by checking data[0] against known packet headers*/
-            if (emu_is_parse_header(in_packet->data[0])) {
-                LOG_I(TAG, "Detected parser packet header: 0x%02X", in_packet->data[0]);
-                res = emu_parse_manager(in_packet, 0, emu_get_current_code_ctx(), NULL);
-                _notify_done();
-                continue;
-            }
-
-            memcpy(&header, in_packet->data, sizeof(header));
-            ESP_LOGI(TAG, "Processing order: 0x%04X", header);
-
-            switch (header){     
-                
-                case ORD_EMU_LOOP_INIT:
-                    res = emu_loop_init(10000);
-                    break;
-
-                case ORD_EMU_LOOP_START:
-                    emu_parse_verify_code(emu_get_current_code_ctx());
-                    res = emu_loop_start();
-                    break;
-
-                case ORD_EMU_LOOP_STOP:
-                    res = emu_loop_stop();
-                    break;
-
-                // --- 4. UTILITY ---
-                case ORD_RESET_ALL: 
-                    ESP_LOGI(TAG, "RESET ALL ORDER");
-                    res = emu_loop_stop();
-                    emu_loop_deinit();
-                    emu_reset_code_ctx();
-                    break;
-
-                case ORD_RESET_BLOCKS:
-                    res = emu_loop_stop();
-                    emu_reset_code_ctx();
-                    break;
-
-
-                default:
-                    //ESP_LOGW(TAG, "Unknown order: 0x%04X", current_order);
-                    break;
-            }
-
-            if (res.code != EMU_OK && res.abort) {
-                ESP_LOGE(TAG, "Packet with header 0x%02X failed: %s", in_packet->data[0], EMU_ERR_TO_STR(res.code));
-            }
-            _notify_done();
-        
     }
 }
 
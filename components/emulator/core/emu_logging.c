@@ -3,156 +3,211 @@
 #include "emu_loop.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
-#include "freertos/ringbuf.h"
 #include "string.h"
+#include <stdlib.h>
 
-RingbufHandle_t error_logs_buff_t=NULL; 
-RingbufHandle_t status_logs_buff_t=NULL;
-SemaphoreHandle_t logger_request_sem = NULL;
-SemaphoreHandle_t logger_done_sem = NULL;
+_Static_assert((LOG_QUEUE_SIZE & (LOG_QUEUE_SIZE - 1)) == 0, "LOG_QUEUE_SIZE must be power of 2");
+_Static_assert((REPORT_QUEUE_SIZE & (REPORT_QUEUE_SIZE - 1)) == 0, "REPORT_QUEUE_SIZE must be power of 2");
+
+emu_log_ring_t error_logs_ring;
+emu_log_ring_t status_logs_ring;
 TaskHandle_t logger_task_handle = NULL;
+bool emu_log_info_muted = false;
+
+/*packet under construction, owned by logger task (independent of interface out packet)*/
+static log_ble_buff_t log_packet;
+/*ring drop counters already reported to app*/
+static uint32_t dropped_reported[2];
 
 static void send_via_ble(uint8_t what);
 
-//todo implement proper logger task
 static const char *TAG = "emu_logger";
 
-static void vLoggerTask(void *pvParameters){
-    __unused emu_result_t error_item;
-    #ifdef ENABLE_STATUS_BUFF
-        __unused emu_report_t report_item;
-    #endif
+bool IRAM_ATTR emu_log_ring_push(emu_log_ring_t *ring, const void *item, size_t size) {
+    emu_log_cell_t *cells = __atomic_load_n(&ring->cells, __ATOMIC_ACQUIRE);
+    if (unlikely(!cells || size > sizeof(cells[0].item))) {return false;}
 
+    emu_log_cell_t *cell;
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
     while (1) {
-        // Wait until emulator body notifies logger task
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-        
-            // Dump all error logs
-            #ifndef ENABLE_SENDING_LOGS
-            while (error_logs_buff_t) {
-                size_t item_size = 0;
-                void *item = xRingbufferReceive(error_logs_buff_t, &item_size, 0);
-                if (!item) break;
-                
-                if (item_size == sizeof(emu_result_t)) {
-                    memcpy(&error_item, item, sizeof(error_item));
-                    const char *owner_s = EMU_OWNER_TO_STR(error_item.owner);
-                    const char *code_s = EMU_ERR_TO_STR(error_item.code);
-                    if (error_item.abort) {
-                        ESP_LOGE(TAG, "ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u",
-                                 owner_s, error_item.owner_idx, code_s,
-                                 error_item.depth, error_item.abort, error_item.warning, error_item.notice);
-                    } else if (error_item.warning) {
-                        ESP_LOGE(TAG, "ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u",
-                                 owner_s, error_item.owner_idx, code_s,
-                                 error_item.depth, error_item.abort, error_item.warning, error_item.notice);
-                    } else if (error_item.notice) {
-                        ESP_LOGI(TAG, "ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u",
-                                 owner_s, error_item.owner_idx, code_s,
-                                 error_item.depth, error_item.abort, error_item.warning, error_item.notice);
-                    } else {
-                        ESP_LOGW(TAG, "ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u",
-                                 owner_s, error_item.owner_idx, code_s,
-                                 error_item.depth, error_item.abort, error_item.warning, error_item.notice);
-                    }
-                }
-            
-                //logger_add_to_packet(&error_item, sizeof(emu_result_t), &log_ble_err_buff);
-                vRingbufferReturnItem(error_logs_buff_t, item);
-            }
-
-                #ifdef ENABLE_STATUS_BUFF
-                while (status_logs_buff_t) {
-                    size_t item_size = 0;
-                    void *item = xRingbufferReceive(status_logs_buff_t, &item_size, 0);
-                    if (!item) break;
-                    
-                    if (item_size == sizeof(emu_report_t)) {
-                        memcpy(&report_item, item, sizeof(report_item));
-                        ESP_LOGI(TAG, "RPT %s owner:%s idx:%u",
-                                EMU_LOG_TO_STR(report_item.log), EMU_OWNER_TO_STR(report_item.owner), report_item.owner_idx);
-                    }
-                
-                    logger_add_to_packet(&report_item, sizeof(emu_report_t), &log_ble_status_buff);
-                    vRingbufferReturnItem(status_logs_buff_t, item);
-                #endif
-            #else
-            send_via_ble(0);
-            send_via_ble(1);
-            #endif
-
-
-            if (logger_done_sem) {
-                xSemaphoreGive(logger_done_sem);
-            }
+        cell = &cells[pos & ring->mask];
+        int32_t diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            //cell free at pos, reserve it
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {break;}
+        } else if (diff < 0) {
+            //cell of previous lap not released by logger yet, ring full
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
         }
+    }
+    cell->time = emu_loop_get_time();
+    cell->cycle = emu_loop_get_iteration();
+    memcpy(&cell->item, item, size);
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
 }
 
+emu_log_cell_t *emu_log_ring_peek(emu_log_ring_t *ring) {
+    if (!ring->cells) {return NULL;}
+    emu_log_cell_t *cell = &ring->cells[ring->tail & ring->mask];
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != ring->tail + 1) {return NULL;}
+    return cell;
+}
 
-//todo finish init function
-BaseType_t logger_task_init(void) {
-    error_logs_buff_t = xRingbufferCreate(LOG_QUEUE_SIZE * sizeof(emu_result_t), RINGBUF_TYPE_BYTEBUF);
+void emu_log_ring_release(emu_log_ring_t *ring, emu_log_cell_t *cell) {
+    __atomic_store_n(&cell->seq, ring->tail + ring->mask + 1, __ATOMIC_RELEASE);
+    ring->tail++;
+}
 
-    #ifdef ENABLE_STATUS_BUFF
-    status_logs_buff_t        = xRingbufferCreate(REPORT_QUEUE_SIZE * sizeof(emu_report_t), RINGBUF_TYPE_BYTEBUF);
-    #endif
+static bool _ring_create(emu_log_ring_t *ring, uint32_t capacity) {
+    emu_log_cell_t *cells = (emu_log_cell_t*)calloc(capacity, sizeof(emu_log_cell_t));
+    if (!cells) {return false;}
+    for (uint32_t i = 0; i < capacity; i++) {cells[i].seq = i;}
+    ring->mask = capacity - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    //producers start using ring once cells are visible
+    __atomic_store_n(&ring->cells, cells, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Put drops counted since last report to status ring (sent as EMU_LOG_error_logs_dropped / EMU_LOG_status_logs_dropped, owner_idx = count)
+ */
+static void _report_dropped(void) {
+    static const emu_log_t logs[2] = {EMU_LOG_error_logs_dropped, EMU_LOG_status_logs_dropped};
+    emu_log_ring_t *rings[2] = {&error_logs_ring, &status_logs_ring};
+
+    for (uint8_t i = 0; i < 2; i++) {
+        uint32_t delta = __atomic_load_n(&rings[i]->dropped, __ATOMIC_RELAXED) - dropped_reported[i];
+        if (!delta) {continue;}
+        if (delta > 0xFFFF) {delta = 0xFFFF;}
+        emu_report_t rep = {.log = logs[i], .owner = EMU_OWNER_emu_logger, .owner_idx = (uint16_t)delta};
+        if (emu_log_ring_push(&status_logs_ring, &rep, sizeof(rep))) {
+            dropped_reported[i] += delta;
+        }
+        ESP_LOGW(TAG, "%s %"PRIu32" items dropped (log ring full)", i ? "Status" : "Error", delta);
+    }
+}
+
+#ifndef ENABLE_SENDING_LOGS
+static void _print_logs(void) {
+    emu_log_cell_t *cell;
+    while ((cell = emu_log_ring_peek(&error_logs_ring))) {
+        const emu_result_t *error_item = &cell->item.err;
+        const char *owner_s = EMU_OWNER_TO_STR(error_item->owner);
+        const char *code_s = EMU_ERR_TO_STR(error_item->code);
+        if (error_item->abort || error_item->warning) {
+            ESP_LOGE(TAG, "[%"PRIu64"] ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u", cell->cycle,
+                     owner_s, error_item->owner_idx, code_s,
+                     error_item->depth, error_item->abort, error_item->warning, error_item->notice);
+        } else if (error_item->notice) {
+            ESP_LOGI(TAG, "[%"PRIu64"] ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u", cell->cycle,
+                     owner_s, error_item->owner_idx, code_s,
+                     error_item->depth, error_item->abort, error_item->warning, error_item->notice);
+        } else {
+            ESP_LOGW(TAG, "[%"PRIu64"] ERR owner:%s idx:%u code:%s depth:%u abort:%u warn:%u notice:%u", cell->cycle,
+                     owner_s, error_item->owner_idx, code_s,
+                     error_item->depth, error_item->abort, error_item->warning, error_item->notice);
+        }
+        emu_log_ring_release(&error_logs_ring, cell);
+    }
+
+    while ((cell = emu_log_ring_peek(&status_logs_ring))) {
+        const emu_report_t *report_item = &cell->item.rep;
+        ESP_LOGI(TAG, "[%"PRIu64"] RPT %s owner:%s idx:%u", cell->cycle,
+                 EMU_LOG_TO_STR(report_item->log), EMU_OWNER_TO_STR(report_item->owner), report_item->owner_idx);
+        emu_log_ring_release(&status_logs_ring, cell);
+    }
+}
+#endif
+
+static void vLoggerTask(void *pvParameters){
+    while (1) {
+        // Runs on its own schedule, loop only appends to log rings and never waits for logger
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOGGER_FLUSH_PERIOD_MS));
+
+        #ifdef ENABLE_SENDING_LOGS
+        send_via_ble(0);
+        send_via_ble(1);
+        #else
+        _print_logs();
+        #endif
+        //drops are reported after drain, so report has free cell (sent with next flush)
+        _report_dropped();
+    }
+}
 
-    logger_request_sem = xSemaphoreCreateBinary();
-    logger_done_sem = xSemaphoreCreateBinary();
 
-    if (error_logs_buff_t == NULL || logger_request_sem == NULL || logger_done_sem == NULL) {
+BaseType_t logger_task_init(void) {
+    if (!_ring_create(&error_logs_ring, LOG_QUEUE_SIZE)) {
         return pdFAIL;
     }
-    ESP_LOGI(TAG, "Logger queues and semaphores created");
-    // Create logger task
-    if (xTaskCreate(vLoggerTask, "emu_logger", 2048, NULL, tskIDLE_PRIORITY + 1, &logger_task_handle) != pdPASS) {
+    #ifdef ENABLE_STATUS_BUFF
+    if (!_ring_create(&status_logs_ring, REPORT_QUEUE_SIZE)) {
+        return pdFAIL;
+    }
+    #endif
+    ESP_LOGI(TAG, "Log rings created (%d errors, %d reports)", LOG_QUEUE_SIZE, REPORT_QUEUE_SIZE);
+
+    // Lowest priority above idle, logger is preempted by loop tasks
+    if (xTaskCreate(vLoggerTask, "emu_logger", LOGGER_TASK_STACK, NULL, tskIDLE_PRIORITY + 1, &logger_task_handle) != pdPASS) {
         return pdFAIL;
     }
 
     return pdPASS;
 }
 
+void logger_add_to_packet(const void *data, size_t size, log_ble_buff_t *buff) {
+    memcpy(&buff->buf[buff->offset], data, size);
+    buff->offset += size;
+}
 
-static void send_via_ble(uint8_t what){
-    msg_packet_t* out_packet = emu_get_out_msg_packet();
-    if (!out_packet || !out_packet->data) return;
 
-    RingbufHandle_t rb;
+static void send_via_ble(uint8_t what){
+    emu_log_ring_t *ring;
     uint8_t header;
     size_t el_size;
 
     if (what == 0) {
-        rb = error_logs_buff_t;
+        ring = &error_logs_ring;
         header = PACKET_H_ERROR_LOG;
         el_size = sizeof(emu_result_t);
     } else {
-        rb = status_logs_buff_t;
+        ring = &status_logs_ring;
         header = PACKET_H_STATUS_LOG;
         el_size = sizeof(emu_report_t);
     }
 
-    if (!rb) return;
-
     size_t mtu = emu_get_mtu_size();
+    if (mtu > sizeof(log_packet.buf)) {mtu = sizeof(log_packet.buf);}
     /* packet layout: [header 1B][time 8B][cycle 8B][items...] = 17B overhead */
     const size_t overhead = 1 + sizeof(uint64_t) + sizeof(uint64_t);
-    size_t max_payload = ((mtu - overhead) / el_size) * el_size;
-    if (max_payload == 0) return;
-
-    out_packet->data[0] = header;
-    /* snapshot time and cycle once for the whole send_via_ble call */
-    uint64_t t = emu_loop_get_time();
-    uint64_t c = emu_loop_get_iteration();
-    memcpy(out_packet->data + 1, &t, sizeof(t));
-    memcpy(out_packet->data + 1 + sizeof(t), &c, sizeof(c));
-
-    // drain ring buffer: each iteration sends one BLE notification
-    while (1) {
-        void *chunk = xRingbufferReceiveUpTo(rb, &out_packet->len, 0, max_payload);
-        if (!chunk || out_packet->len == 0) break;
-        memcpy(out_packet->data + overhead, chunk, out_packet->len);
-        vRingbufferReturnItem(rb, chunk);
-        gatt_send_notify(out_packet->data, out_packet->len + overhead);
+    if (mtu < overhead + el_size) return;
+
+    // drain ring: items of one cycle share packet, new packet when cycle changes or packet is full
+    emu_log_cell_t *cell;
+    uint64_t cycle = 0;
+    log_packet.offset = 0;
+    while ((cell = emu_log_ring_peek(ring))) {
+        if (log_packet.offset && (cell->cycle != cycle || log_packet.offset + el_size > mtu)) {
+            gatt_send_notify(log_packet.buf, log_packet.offset);
+            log_packet.offset = 0;
+        }
+        if (!log_packet.offset) {
+            cycle = cell->cycle;
+            logger_add_to_packet(&header, sizeof(header), &log_packet);
+            logger_add_to_packet(&cell->time, sizeof(cell->time), &log_packet);
+            logger_add_to_packet(&cell->cycle, sizeof(cell->cycle), &log_packet);
+        }
+        logger_add_to_packet(&cell->item, el_size, &log_packet);
+        emu_log_ring_release(ring, cell);
     }
-}
\ No newline at end of file
+    if (log_packet.offset) {
+        gatt_send_notify(log_packet.buf, log_packet.offset);
+    }
+}
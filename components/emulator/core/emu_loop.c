@@ -4,7 +4,11 @@
 #include "emu_interface.h"
 #include "emu_body.h"
 #include "emu_parse.h"
+#include "emu_helpers.h"
+#include "emu_partition.h"
+#include "gatt_svc.h"
 #include "string.h"
+#include <stdio.h>
 #include "esp_timer.h"
 #include "esp_log.h"
 
@@ -12,86 +16,280 @@ static const char *TAG = "emu_LOOP";
 
 static const uint32_t stack_depth = 10*1024;
 
+/*priority of slowest class, every class with shorter period gets one more (rate monotonic)*/
+static const UBaseType_t loop_priority = 4;
+
+/*[header][cycles][skipped][period] + 3 metrics * [avg][p50][p99][max]*/
+#define LOOP_STATS_PKT_SIZE (sizeof(uint8_t) + 3*sizeof(uint32_t) + 3*4*sizeof(uint32_t))
+
+/*[period_us:u32][first_block:u16][blocks_cnt:u16][wtd_max_skipped:u8]*/
+#define LOOP_CFG_CLASS_SIZE (sizeof(uint32_t) + 2*sizeof(uint16_t) + sizeof(uint8_t))
+
 /**
 *@brief Watchdog structure loops skipped and max skipped before trigger and is triggered flag
 */
 typedef struct {
     uint8_t loops_skipped;
-    uint8_t max_skipp; 
+    uint8_t max_skipp;
     bool wtd_triggered;
     bool wtd_active;
-} emu_wtd_t; 
+} emu_wtd_t;
 
 /**
- * @brief Timer structure for emulator loop timing and status
+ * @brief Timer structure for task class timing
  */
 typedef struct {
     esp_timer_handle_t timer_handle;
-    loop_status_t loop_status;
     uint64_t loop_period;
     uint64_t time;
     uint64_t loop_counter;
 } emu_timer_t;
 
 /**
- * @brief Emulator loop handle structure containing semaphores, timer, watchdog, and task handle
+ * @brief Tick handoff from ISR to loop task, written before sem_loop_start is given (semaphore orders access)
  */
-typedef struct emu_loop_handle_s {
+typedef struct {
+    int64_t tick_time;      /*when cycle start was released (ISR / start / run_once)*/
+    uint8_t loops_skipped;  /*wtd.loops_skipped before reset by this tick*/
+} emu_tick_info_t;
+
+/**
+ * @brief Task class: own timer, watchdog and task running its range of blocks
+ */
+typedef struct {
     SemaphoreHandle_t sem_loop_start;
     SemaphoreHandle_t sem_loop_wtd;
     emu_timer_t timer;
     emu_wtd_t wtd;
-    bool can_loop_run;
+    emu_tick_info_t tick;
     TaskHandle_t loop_task_handle;
+    uint16_t first_block;
+    uint16_t blocks_cnt;
+} emu_loop_class_t;
+
+/**
+ * @brief Emulator loop handle structure containing task classes (class 0 is main class) and loop status
+ */
+typedef struct emu_loop_handle_s {
+    emu_loop_class_t cls[EMU_LOOP_CLASSES_MAX];
+    uint8_t cls_cnt;
+    bool ranged;            /*classes run block ranges from loop_cfg, else class 0 runs whole code*/
+    uint32_t cfg_version;   /*loop_cfg.version applied to classes*/
+    loop_status_t loop_status;
+    uint64_t time;          /*latest class time*/
+    bool can_loop_run;
 } emu_loop_def_t;
 
+/**
+ * @brief Task class configuration from PACKET_H_LOOP_CFG
+ */
+typedef struct {
+    uint32_t period;
+    uint16_t first_block;
+    uint16_t blocks_cnt;
+    uint8_t max_skipp;
+} emu_loop_class_cfg_t;
+
 
 /**
  * @brief Static pointer to the emulator loop handle this is globally used within the loop functions and hidden from outside
  */
 static emu_loop_def_t *loop_handle = NULL;
 
+/**
+ * @brief Task classes requested by host, kept over loop reinit, applied at loop start (cnt 0 = single class running whole code)
+ */
+static struct {
+    uint8_t cnt;
+    uint32_t version;
+    emu_loop_class_cfg_t cls[EMU_LOOP_CLASSES_MAX];
+} loop_cfg;
+
+/**
+ * @brief Loop statistics, single writer (loop task), readers use seq (odd while writing)
+ */
+static struct {
+    volatile uint32_t seq;
+    volatile bool reset_request;
+    emu_loop_stats_t data;
+    uint16_t send_every;
+    uint16_t cycles_since_send;
+} loop_stats;
+
+/**
+ * @brief Timestamps of current cycle, used only by loop task
+ */
+static struct {
+    emu_tick_info_t tick;
+    int64_t wake;
+    int64_t exec_end;
+} cycle_times;
+
+static inline void _loop_metric_add(emu_loop_metric_t *m, int64_t us) {
+    uint32_t val = (us < 0) ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    uint8_t bucket = val ? (31 - __builtin_clz(val)) : 0;
+    if (bucket >= EMU_LOOP_HIST_BUCKETS) {bucket = EMU_LOOP_HIST_BUCKETS - 1;}
+    m->hist[bucket]++;
+    m->total_us += val;
+    m->last_us = val;
+    if (val > m->max_us) {m->max_us = val;}
+}
+
+static void _loop_stats_commit(int64_t cycle_end) {
+    uint32_t seq = loop_stats.seq;
+    __atomic_store_n(&loop_stats.seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (loop_stats.reset_request) {
+        memset(&loop_stats.data, 0, sizeof(loop_stats.data));
+        loop_stats.reset_request = false;
+    }
+    emu_loop_stats_t *s = &loop_stats.data;
+    s->cycles++;
+    s->skipped += cycle_times.tick.loops_skipped;
+    _loop_metric_add(&s->wake, cycle_times.wake - cycle_times.tick.tick_time);
+    _loop_metric_add(&s->exec, cycle_times.exec_end - cycle_times.wake);
+    _loop_metric_add(&s->tail, cycle_end - cycle_times.exec_end);
+
+    __atomic_store_n(&loop_stats.seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Class of calling task, main class for tasks that are not class tasks (interface, logger, worker)
+ */
+static inline emu_loop_class_t *_loop_current_class(void) {
+    if (likely(loop_handle->cls_cnt == 1)) {return &loop_handle->cls[0];}
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 1; i < loop_handle->cls_cnt; i++) {
+        if (loop_handle->cls[i].loop_task_handle == self) {return &loop_handle->cls[i];}
+    }
+    return &loop_handle->cls[0];
+}
+
+static void IRAM_ATTR _loop_timers_stop(emu_loop_def_t *ctx) {
+    for (uint8_t i = 0; i < ctx->cls_cnt; i++) {
+        esp_timer_stop(ctx->cls[i].timer.timer_handle);
+    }
+}
+
 #undef OWNER
 #define OWNER EMU_OWNER_emu_loop_init
 
 /**
- * @brief Interrupt handler for the loop timer tick 
+ * @brief Interrupt handler for the loop timer tick (one timer per task class)
  */
 static void IRAM_ATTR loop_tick_intr_handler(void *arg) {
-    emu_loop_def_t *ctx = (emu_loop_def_t *)arg;
-    
+    emu_loop_class_t *cls = (emu_loop_class_t *)arg;
+    emu_loop_def_t *ctx = loop_handle;
+
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    //calculate running time in ms (time stretching possible)
-    ctx->timer.time += (ctx->timer.loop_period / 1000);
-    
-    //This is WTD check normally this shold run as default 
-    if (xSemaphoreTakeFromISR(ctx->sem_loop_wtd, &xHigherPriorityTaskWoken) == pdTRUE) {
-        ctx->wtd.loops_skipped = 0;
-        ctx->wtd.wtd_triggered = 0;
-        ctx->timer.loop_counter++;
-        xSemaphoreGiveFromISR(ctx->sem_loop_start, &xHigherPriorityTaskWoken);
+    //calculate running time in ms (time stretching possible), loop time follows fastest class
+    cls->timer.time += (cls->timer.loop_period / 1000);
+    if (cls->timer.time > ctx->time) {ctx->time = cls->timer.time;}
+
+    //This is WTD check normally this shold run as default
+    if (xSemaphoreTakeFromISR(cls->sem_loop_wtd, &xHigherPriorityTaskWoken) == pdTRUE) {
+        cls->tick.tick_time = esp_timer_get_time();
+        cls->tick.loops_skipped = cls->wtd.loops_skipped;
+        cls->wtd.loops_skipped = 0;
+        cls->wtd.wtd_triggered = 0;
+        cls->timer.loop_counter++;
+        xSemaphoreGiveFromISR(cls->sem_loop_start, &xHigherPriorityTaskWoken);
     }
     else {
         // Watchdog active, increment skipped loops
-        if (ctx->wtd.wtd_active) {
-            ctx->wtd.loops_skipped++;
-            // Check if max skipped loops exceeded and stoop the loop if so
-            if (ctx->wtd.loops_skipped > ctx->wtd.max_skipp) {
-                ctx->wtd.wtd_triggered = 1;
-                esp_timer_stop(ctx->timer.timer_handle);
-                ctx->timer.loop_status = LOOP_HALTED;
+        if (cls->wtd.wtd_active) {
+            cls->wtd.loops_skipped++;
+            // Check if max skipped loops exceeded and stop the loop (all classes) if so
+            if (cls->wtd.loops_skipped > cls->wtd.max_skipp) {
+                cls->wtd.wtd_triggered = 1;
+                _loop_timers_stop(ctx);
+                ctx->loop_status = LOOP_HALTED;
             }
         }
     }
     if (xHigherPriorityTaskWoken) portYIELD_FROM_ISR();
 }
 
+/**
+ * @brief Stop and delete timer, task and semaphores of class
+ */
+static void _loop_class_destroy(emu_loop_class_t *cls) {
+    if (cls->timer.timer_handle) {
+        esp_timer_stop(cls->timer.timer_handle);
+        esp_timer_delete(cls->timer.timer_handle);
+    }
+    if (cls->loop_task_handle) vTaskDelete(cls->loop_task_handle);
+    if (cls->sem_loop_start) vSemaphoreDelete(cls->sem_loop_start);
+    if (cls->sem_loop_wtd) vSemaphoreDelete(cls->sem_loop_wtd);
+    memset(cls, 0, sizeof(emu_loop_class_t));
+}
+
+/**
+ * @brief Create semaphores, task and timer of class (class 0 runs emu_body_loop_task)
+ */
+static emu_result_t _loop_class_create(uint8_t idx, uint64_t period_us, uint8_t max_skipp) {
+    emu_loop_class_t *cls = &loop_handle->cls[idx];
+    memset(cls, 0, sizeof(emu_loop_class_t));
+
+    cls->wtd.max_skipp = max_skipp;
+    cls->wtd.wtd_active = 1;
+    cls->timer.loop_period = period_us;
+    cls->timer.time = loop_handle->time;
+
+    cls->sem_loop_start = xSemaphoreCreateBinary();
+    cls->sem_loop_wtd = xSemaphoreCreateBinary();
+    if (!cls->sem_loop_start || !cls->sem_loop_wtd) {
+        _loop_class_destroy(cls);
+        RET_E(EMU_ERR_NO_MEM, "Failed to create semaphores of class %u", idx);
+    }
+
+    // Create Task for class execution
+    char name[configMAX_TASK_NAME_LEN];
+    snprintf(name, sizeof(name), "EMU_LOOP%u", idx);
+    BaseType_t task_res = xTaskCreatePinnedToCore(idx ? emu_body_class_task : emu_body_loop_task, idx ? name : "EMU_LOOP", stack_depth,
+                                                  (void*)(uintptr_t)idx, loop_priority, &cls->loop_task_handle, EMU_LOOP_CORE);
+    if (task_res != pdPASS) {
+        cls->loop_task_handle = NULL;
+        _loop_class_destroy(cls);
+        RET_E(EMU_ERR_MEM_ALLOC, "Failed to create task of class %u", idx);
+    }
 
+    // Create hardware timer for class timing
+    const esp_timer_create_args_t timer_args = {
+        .callback = &loop_tick_intr_handler,
+        .arg = (void*)cls,
+        .name = "EMU_TIMER",
+        .dispatch_method = ESP_TIMER_ISR
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &cls->timer.timer_handle);
+    if (err != ESP_OK) {
+        cls->timer.timer_handle = NULL;
+        _loop_class_destroy(cls);
+        RET_E(EMU_ERR_INVALID_STATE, "Timer create failed: %s", esp_err_to_name(err));
+    }
+    return EMU_RESULT_OK();
+}
+
+/**
+ * @brief Shorter period = higher priority, so slow class never delays fast one
+ */
+static void _loop_classes_set_priority(void) {
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        UBaseType_t prio = loop_priority;
+        for (uint8_t j = 0; j < loop_handle->cls_cnt; j++) {
+            if (loop_handle->cls[j].timer.loop_period > loop_handle->cls[i].timer.loop_period) {prio++;}
+        }
+        vTaskPrioritySet(loop_handle->cls[i].loop_task_handle, prio);
+    }
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_loop_init
 emu_result_t emu_loop_init(uint64_t period_us) {
     // Cleanup previous loop if exists this allows reinitialization
     if(loop_handle){
-        vSemaphoreDelete(loop_handle->sem_loop_start);
-        vSemaphoreDelete(loop_handle->sem_loop_wtd);
+        for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {_loop_class_destroy(&loop_handle->cls[i]);}
         free(loop_handle);
         loop_handle = NULL;
         REP_N(EMU_LOG_loop_reinitialized, "Previous loop handle existed, reinitializing");
@@ -100,59 +298,83 @@ emu_result_t emu_loop_init(uint64_t period_us) {
     loop_handle = calloc(1, sizeof(emu_loop_def_t));
     if (!loop_handle) {RET_E(EMU_ERR_NO_MEM, "Failed to allocate loop handle");}
 
-    // Default settings
-    loop_handle->wtd.max_skipp = 2;
-    loop_handle->wtd.wtd_active = 1;
-    loop_handle->wtd.wtd_triggered = 0;
-    
-    loop_handle->timer.loop_period = period_us;
-    loop_handle->timer.loop_status = LOOP_CREATED;
-    
-    //and new semaphores
-    loop_handle->sem_loop_start = xSemaphoreCreateBinary();
-    loop_handle->sem_loop_wtd = xSemaphoreCreateBinary();
-
-    if (!loop_handle->sem_loop_start || !loop_handle->sem_loop_wtd) {
-        if (loop_handle->sem_loop_start) vSemaphoreDelete(loop_handle->sem_loop_start);
-        if (loop_handle->sem_loop_wtd) vSemaphoreDelete(loop_handle->sem_loop_wtd);
-        vTaskDelete(loop_handle->loop_task_handle);
+    loop_handle->loop_status = LOOP_CREATED;
+    emu_loop_stats_reset();
+
+    // Main class runs whole code until task classes are applied at start, default 2 skipped cycles
+    emu_result_t res = _loop_class_create(0, period_us, 2);
+    if (res.code != EMU_OK) {
         free(loop_handle);
         loop_handle = NULL;
-        RET_E(EMU_ERR_NO_MEM, "Failed to create semaphores");
+        RET_ED(res.code, 0, ++res.depth, "Failed to create main class");
     }
+    loop_handle->cls_cnt = 1;
 
-    // Create Task for loop execution
-    BaseType_t task_res = xTaskCreate(emu_body_loop_task, "EMU_LOOP", stack_depth, NULL, 4, &loop_handle->loop_task_handle);
-    if (task_res != pdPASS) {
-        vSemaphoreDelete(loop_handle->sem_loop_start);
-        vSemaphoreDelete(loop_handle->sem_loop_wtd);
-        vTaskDelete(loop_handle->loop_task_handle);
-        free(loop_handle);
-        loop_handle = NULL;
-        RET_E(EMU_ERR_MEM_ALLOC, "Failed to create loop task");
+    //second core share of code (if split at verify), code still runs on single core without worker
+    emu_partition_worker_init();
+
+    RET_OK("Loop initialized with period %llu us", period_us);
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_loop_classes_apply
+/**
+ * @brief Check loop_cfg against compiled code and (re)create classes when config changed
+ */
+static emu_result_t _loop_classes_apply(void) {
+    emu_code_handle_t code = emu_get_current_code_ctx();
+
+    //ranges have to cover code in block order and end on plan entry (FOR chain stays in one class)
+    uint16_t next = 0;
+    for (uint8_t i = 0; i < loop_cfg.cnt; i++) {
+        const emu_loop_class_cfg_t *c = &loop_cfg.cls[i];
+        if (!code || !code->plan) {RET_E(EMU_ERR_INVALID_STATE, "Task classes need compiled code, verify code before start");}
+        if (c->first_block != next) {
+            RET_E(EMU_ERR_INVALID_ARG, "Class %u starts at block %"PRIu16", expected %"PRIu16, i, c->first_block, next);
+        }
+        uint32_t end = (uint32_t)c->first_block + c->blocks_cnt;
+        if (end > code->total_blocks) {
+            RET_E(EMU_ERR_INVALID_ARG, "Class %u ends at block %"PRIu32", code has %"PRIu16" blocks", i, end, code->total_blocks);
+        }
+        uint32_t b = c->first_block;
+        while (b < end) {b += code->plan[b].skip;}
+        if (b != end) {
+            RET_ED(EMU_ERR_BLOCK_INVALID_PARAM, end - 1, 0, "Class %u ends inside FOR chain (next entry at %"PRIu32")", i, b);
+        }
+        next = (uint16_t)end;
     }
-    
-    // Create hardware timer for loop timing
-    const esp_timer_create_args_t timer_args = {
-        .callback = &loop_tick_intr_handler,
-        .arg = (void*)loop_handle,
-        .name = "EMU_TIMER",
-        .dispatch_method = ESP_TIMER_ISR
-    };
-    
-    //create tiemer and pass handle to loop handle
-    esp_err_t err = esp_timer_create(&timer_args, &loop_handle->timer.timer_handle);
-    if (err != ESP_OK) {
-        // Task cleanup is complex (need task handle), log and fail critically
-        vSemaphoreDelete(loop_handle->sem_loop_start);
-        vSemaphoreDelete(loop_handle->sem_loop_wtd);
-        vTaskDelete(loop_handle->loop_task_handle);
-        free(loop_handle);
-        loop_handle = NULL;
-        RET_E(EMU_ERR_INVALID_STATE, "Timer create failed: %s", esp_err_to_name(err));
+    if (loop_cfg.cnt && next != code->total_blocks) {
+        RET_E(EMU_ERR_INVALID_ARG, "Classes cover %"PRIu16" of %"PRIu16" blocks", next, code->total_blocks);
     }
 
-    RET_OK("Loop initialized with period %llu us", period_us);
+    if (loop_handle->cfg_version == loop_cfg.version) {return EMU_RESULT_OK();}
+
+    for (uint8_t i = 1; i < loop_handle->cls_cnt; i++) {_loop_class_destroy(&loop_handle->cls[i]);}
+    loop_handle->cls_cnt = 1;
+    loop_handle->ranged = false;
+
+    if (loop_cfg.cnt) {
+        emu_loop_class_t *main_cls = &loop_handle->cls[0];
+        main_cls->timer.loop_period = loop_cfg.cls[0].period;
+        main_cls->wtd.max_skipp = loop_cfg.cls[0].max_skipp;
+        for (uint8_t i = 1; i < loop_cfg.cnt; i++) {
+            emu_result_t res = _loop_class_create(i, loop_cfg.cls[i].period, loop_cfg.cls[i].max_skipp);
+            if (res.code != EMU_OK) {
+                for (uint8_t k = 1; k < i; k++) {_loop_class_destroy(&loop_handle->cls[k]);}
+                loop_handle->cls_cnt = 1;
+                RET_ED(res.code, 0, ++res.depth, "Task classes not created");
+            }
+        }
+        for (uint8_t i = 0; i < loop_cfg.cnt; i++) {
+            loop_handle->cls[i].first_block = loop_cfg.cls[i].first_block;
+            loop_handle->cls[i].blocks_cnt = loop_cfg.cls[i].blocks_cnt;
+        }
+        loop_handle->cls_cnt = loop_cfg.cnt;
+        loop_handle->ranged = true;
+    }
+    _loop_classes_set_priority();
+    loop_handle->cfg_version = loop_cfg.version;
+    RET_OK("%u task classes applied", loop_handle->cls_cnt);
 }
 
 
@@ -160,49 +382,49 @@ emu_result_t emu_loop_init(uint64_t period_us) {
 #define OWNER EMU_OWNER_emu_loop_start
 emu_result_t emu_loop_start() {
     // Check if loop is initialized
-    emu_result_t res = EMU_RESULT_OK();
     if (!loop_handle) {
         RET_W(EMU_ERR_LOOP_NOT_INITIALIZED, "Loop not initialized");
     }
-    // Check if loop can run (parsed and ready)
 
-    if (res.code != EMU_OK) {RET_W(EMU_ERR_DENY, "Loop start denied");}
+    loop_status_t prev_status = loop_handle->loop_status;
+    if (prev_status != LOOP_CREATED && prev_status != LOOP_STOPPED && prev_status != LOOP_HALTED) {
+        RET_E(EMU_ERR_INVALID_STATE, "Loop start requested but state is %d", prev_status);
+    }
 
-    bool should_start_timer = false;
+    // Check if task classes match code (parsed and ready)
+    emu_result_t res = _loop_classes_apply();
+    if (res.code != EMU_OK) {RET_ED(EMU_ERR_DENY, 0, ++res.depth, "Loop start denied");}
 
-    if (loop_handle->timer.loop_status == LOOP_CREATED) {
+    if (prev_status == LOOP_CREATED) {
         REP_N(EMU_LOG_loop_starting, "Starting loop (First Time)");
-        loop_handle->timer.loop_status = LOOP_RUNNING;
-        should_start_timer = true;
     }
-    else if (loop_handle->timer.loop_status == LOOP_STOPPED) {
+    else if (prev_status == LOOP_STOPPED) {
         REP_N(EMU_LOG_loop_starting, "Resuming loop (From Stopped)");
-        loop_handle->timer.loop_status = LOOP_RUNNING;
-        should_start_timer = true;
     }
-    else if (loop_handle->timer.loop_status == LOOP_HALTED) {
+    else {
         LOG_I(TAG, "Resuming loop (From Halted)");
         /* Reset WTD flags on resume */
-        loop_handle->wtd.wtd_triggered = 0;
-        loop_handle->wtd.loops_skipped = 0;
-        loop_handle->timer.loop_status = LOOP_RUNNING;
-        should_start_timer = true;
-    }
-    else {
-        RET_E(EMU_ERR_INVALID_STATE, "Loop start requested but state is %d", loop_handle->timer.loop_status);
+        for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+            loop_handle->cls[i].wtd.wtd_triggered = 0;
+            loop_handle->cls[i].wtd.loops_skipped = 0;
+        }
     }
-
-    if (should_start_timer) {
-        xSemaphoreTake(loop_handle->sem_loop_wtd, 0);
-        xSemaphoreGive(loop_handle->sem_loop_start);
-        esp_err_t err = esp_timer_start_periodic(loop_handle->timer.timer_handle, loop_handle->timer.loop_period);
+    loop_handle->loop_status = LOOP_RUNNING;
+
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        emu_loop_class_t *cls = &loop_handle->cls[i];
+        xSemaphoreTake(cls->sem_loop_wtd, 0);
+        cls->tick = (emu_tick_info_t){.tick_time = esp_timer_get_time()};
+        xSemaphoreGive(cls->sem_loop_start);
+        esp_err_t err = esp_timer_start_periodic(cls->timer.timer_handle, cls->timer.loop_period);
         if (err != ESP_OK) {
-            loop_handle->timer.loop_status = LOOP_STOPPED;
-            RET_E(EMU_ERR_INVALID_STATE, "Failed to start hardware timer: %s", esp_err_to_name(err));
+            _loop_timers_stop(loop_handle);
+            loop_handle->loop_status = LOOP_STOPPED;
+            RET_E(EMU_ERR_INVALID_STATE, "Failed to start hardware timer of class %u: %s", i, esp_err_to_name(err));
         }
     }
-    
-    RET_OK("Loop started with period %llu us", loop_handle->timer.loop_period);
+
+    RET_OK("Loop started with period %llu us, %u task classes", loop_handle->cls[0].timer.loop_period, loop_handle->cls_cnt);
 }
 
 #undef OWNER
@@ -213,17 +435,32 @@ emu_result_t emu_loop_stop() {
         RET_W(EMU_ERR_LOOP_NOT_INITIALIZED, "Loop not initialized");
     }
     // Check if loop is running
-    if (loop_handle->timer.loop_status != LOOP_RUNNING) {
-        RET_W(EMU_ERR_INVALID_STATE, "Attempted to stop loop, but state is %d (Not Running)", loop_handle->timer.loop_status);
+    if (loop_handle->loop_status != LOOP_RUNNING) {
+        RET_W(EMU_ERR_INVALID_STATE, "Attempted to stop loop, but state is %d (Not Running)", loop_handle->loop_status);
     }
 
     ESP_LOGI(TAG, "Stopping loop");
-    loop_handle->timer.loop_status = LOOP_STOPPED;
+    loop_handle->loop_status = LOOP_STOPPED;
 
     //check esp timer stop
-    if (unlikely(esp_timer_stop(loop_handle->timer.timer_handle) != ESP_OK)) {
+    bool stopped = true;
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        if (unlikely(esp_timer_stop(loop_handle->cls[i].timer.timer_handle) != ESP_OK)) {stopped = false;}
+    }
+    if (!stopped) {
         RET_W(EMU_ERR_INVALID_STATE, "Failed to stop hardware timer");
     }
+
+    //cycle already released keeps running, caller verifies / frees code after stop, wtd semaphore is back when cycle ends
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        emu_loop_class_t *cls = &loop_handle->cls[i];
+        TickType_t timeout_ticks = pdMS_TO_TICKS((cls->wtd.max_skipp * cls->timer.loop_period) / 1000);
+        if (timeout_ticks == 0) timeout_ticks = 1;
+        if (xSemaphoreTake(cls->sem_loop_wtd, timeout_ticks) != pdTRUE) {
+            loop_handle->loop_status = LOOP_HALTED;
+            RET_E(EMU_ERR_WTD_TRIGGERED, "Loop stopped but cycle of class %u did not end", i);
+        }
+    }
     RET_OK("Loop stopped successfully");
 }
 
@@ -241,90 +478,101 @@ emu_result_t emu_loop_set_period(uint64_t period_us) {
         REP_N(EMU_LOG_loop_period_set, "Clamping period %llu -> %llu us (Too Slow)", period_us, (uint64_t)LOOP_PERIOD_MAX);
         period_us = LOOP_PERIOD_MAX;
         was_clamped = true;
-    } 
+    }
     else if (period_us < LOOP_PERIOD_MIN) {
         REP_N(EMU_LOG_loop_period_set, "Clamping period %llu -> %llu us (Too Fast)", period_us, (uint64_t)LOOP_PERIOD_MIN);
         period_us = LOOP_PERIOD_MIN;
         was_clamped = true;
     }
 
-    (void)loop_handle->timer.loop_period; /* old_period unused */
-    loop_handle->timer.loop_period = period_us;
+    //period of main class, kept in task classes config so it survives reapply
+    emu_loop_class_t *main_cls = &loop_handle->cls[0];
+    main_cls->timer.loop_period = period_us;
+    if (loop_cfg.cnt) {loop_cfg.cls[0].period = period_us;}
+    _loop_classes_set_priority();
+
+    if (loop_handle->loop_status == LOOP_RUNNING) {
+        esp_timer_stop(main_cls->timer.timer_handle);
 
-    if (loop_handle->timer.loop_status == LOOP_RUNNING) {
-        esp_timer_stop(loop_handle->timer.timer_handle);
-        
-        esp_err_t err = esp_timer_start_periodic(loop_handle->timer.timer_handle, loop_handle->timer.loop_period);
+        esp_err_t err = esp_timer_start_periodic(main_cls->timer.timer_handle, main_cls->timer.loop_period);
         if (err != ESP_OK) {
-            loop_handle->timer.loop_status = LOOP_HALTED;
+            _loop_timers_stop(loop_handle);
+            loop_handle->loop_status = LOOP_HALTED;
             RET_E(EMU_ERR_INVALID_STATE, "Failed to restart timer: %d", err);
         }
-        
-        //REP_N(EMU_LOG_loop_period_set, "Period updated live: %llu -> %llu us", old_period, loop_handle->timer.loop_period);
-    } else {
-        //REP_N(EMU_LOG_loop_period_set, "Period config updated: %llu -> %llu us (Next start)", old_period, loop_handle->timer.loop_period);
     }
 
     if (was_clamped) {
-        RET_W(EMU_ERR_INVALID_ARG, "Period was clamped to %llu us", loop_handle->timer.loop_period);
+        RET_W(EMU_ERR_INVALID_ARG, "Period was clamped to %llu us", main_cls->timer.loop_period);
     }
 
-    RET_OK("Loop period set to %llu us", loop_handle->timer.loop_period);
+    RET_OK("Loop period set to %llu us", main_cls->timer.loop_period);
 }
 
 #undef OWNER
 #define OWNER EMU_OWNER_emu_loop_run_once
 emu_result_t emu_loop_run_once() {
-    emu_result_t res = EMU_RESULT_OK();
-    if (!loop_handle) { 
+    if (!loop_handle) {
         RET_W(EMU_ERR_LOOP_NOT_INITIALIZED, "Handle is NULL");
     }
 
-    if (loop_handle->timer.loop_status == LOOP_RUNNING) {
+    if (loop_handle->loop_status == LOOP_RUNNING) {
         RET_W(EMU_ERR_INVALID_STATE, "Cannot run_once while loop is RUNNING. Stop it first");
     }
 
-    if (res.code != EMU_OK) {RET_W(EMU_ERR_DENY, "Loop run_once denied"); }
+    emu_result_t res = _loop_classes_apply();
+    if (res.code != EMU_OK) {RET_ED(EMU_ERR_DENY, 0, ++res.depth, "Loop run_once denied");}
 
-    xSemaphoreGive(loop_handle->sem_loop_start);
+    //one cycle of every class, in class order
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        emu_loop_class_t *cls = &loop_handle->cls[i];
+        cls->tick = (emu_tick_info_t){.tick_time = esp_timer_get_time()};
+        xSemaphoreGive(cls->sem_loop_start);
 
-    TickType_t timeout_ticks = pdMS_TO_TICKS((loop_handle->wtd.max_skipp * loop_handle->timer.loop_period) / 1000);
-    if (timeout_ticks == 0) timeout_ticks = 1; 
-    
-    if (xSemaphoreTake(loop_handle->sem_loop_wtd, timeout_ticks) == pdTRUE) {
-        loop_handle->timer.loop_counter++;
-        loop_handle->timer.time += loop_handle->timer.loop_period / 1000;
-        RET_OK("Loop run_once completed successfully");
-    } else {
-        loop_handle->wtd.wtd_triggered = 1;
-        loop_handle->timer.loop_status = LOOP_HALTED;
-        RET_E(EMU_ERR_WTD_TRIGGERED, "One loop wtd triggered, loop took too long to execute");
+        TickType_t timeout_ticks = pdMS_TO_TICKS((cls->wtd.max_skipp * cls->timer.loop_period) / 1000);
+        if (timeout_ticks == 0) timeout_ticks = 1;
+
+        if (xSemaphoreTake(cls->sem_loop_wtd, timeout_ticks) != pdTRUE) {
+            cls->wtd.wtd_triggered = 1;
+            loop_handle->loop_status = LOOP_HALTED;
+            RET_E(EMU_ERR_WTD_TRIGGERED, "One loop wtd triggered, class %u took too long to execute", i);
+        }
+        cls->timer.loop_counter++;
+        cls->timer.time += cls->timer.loop_period / 1000;
+        if (cls->timer.time > loop_handle->time) {loop_handle->time = cls->timer.time;}
     }
+    RET_OK("Loop run_once completed successfully");
 }
 
 uint64_t emu_loop_get_time() {
     if (!loop_handle) return 0;
-    return loop_handle->timer.time;
+    return loop_handle->time;
 }
 
 uint64_t emu_loop_get_iteration() {
     if (!loop_handle) return 0;
-    return loop_handle->timer.loop_counter;
+    return _loop_current_class()->timer.loop_counter;
 }
 
 bool emu_loop_is_running() {
     if (!loop_handle) return false;
-    return (loop_handle->timer.loop_status == LOOP_RUNNING);
+    return (loop_handle->loop_status == LOOP_RUNNING);
+}
+
+bool emu_loop_can_start() {
+    if (!loop_handle) return false;
+    loop_status_t status = loop_handle->loop_status;
+    return (status == LOOP_CREATED || status == LOOP_STOPPED || status == LOOP_HALTED);
 }
 
 bool emu_loop_is_halted() {
     if (!loop_handle) return false;
-    return (loop_handle->timer.loop_status == LOOP_HALTED);
+    return (loop_handle->loop_status == LOOP_HALTED);
 }
 
 bool emu_loop_is_stopped() {
     if (!loop_handle) return false;
-    return (loop_handle->timer.loop_status == LOOP_STOPPED);
+    return (loop_handle->loop_status == LOOP_STOPPED);
 }
 
 bool emu_loop_is_initialized() {
@@ -333,9 +581,60 @@ bool emu_loop_is_initialized() {
 
 bool emu_loop_wtd_status() {
     if (!loop_handle) return false;
-    return loop_handle->wtd.wtd_triggered;
+    return _loop_current_class()->wtd.wtd_triggered;
 }
 
+bool emu_loop_classes_active() {
+    return loop_cfg.cnt > 0;
+}
+
+bool emu_loop_class_range(uint8_t cls, uint16_t *first_block, uint16_t *blocks_cnt) {
+    if (!loop_handle || !loop_handle->ranged) {return false;}
+    *first_block = loop_handle->cls[cls].first_block;
+    *blocks_cnt = loop_handle->cls[cls].blocks_cnt;
+    return true;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_loop_parse_cfg
+emu_result_t emu_loop_parse_cfg(const uint8_t *data, const uint16_t data_len, void *emu_code_handle) {
+    if (emu_loop_is_running()) {
+        RET_W(EMU_ERR_DENY, "Loop is running, stop it before changing task classes");
+    }
+    if (data_len < 1) {
+        RET_E(EMU_ERR_PACKET_INCOMPLETE, "Loop config packet too short: %d bytes", data_len);
+    }
+    uint8_t cnt = data[0];
+    if (cnt > EMU_LOOP_CLASSES_MAX) {
+        RET_E(EMU_ERR_INVALID_ARG, "%u task classes requested, max is %d", cnt, EMU_LOOP_CLASSES_MAX);
+    }
+    if (data_len < 1 + cnt * LOOP_CFG_CLASS_SIZE) {
+        RET_E(EMU_ERR_PACKET_INCOMPLETE, "Loop config of %u classes needs %d bytes, got %d", cnt, (int)(1 + cnt * LOOP_CFG_CLASS_SIZE), data_len);
+    }
+
+    emu_loop_class_cfg_t cls[EMU_LOOP_CLASSES_MAX];
+    uint16_t offset = 1;
+    for (uint8_t i = 0; i < cnt; i++) {
+        cls[i].period      = parse_get_u32(data, offset); offset += sizeof(uint32_t);
+        cls[i].first_block = parse_get_u16(data, offset); offset += sizeof(uint16_t);
+        cls[i].blocks_cnt  = parse_get_u16(data, offset); offset += sizeof(uint16_t);
+        cls[i].max_skipp   = data[offset++];
+
+        //main class also publishes and flushes logs, others only execute blocks
+        uint32_t min = i ? LOOP_CLASS_PERIOD_MIN : LOOP_PERIOD_MIN;
+        if (cls[i].period < min || cls[i].period > LOOP_PERIOD_MAX) {
+            RET_E(EMU_ERR_INVALID_ARG, "Class %u period %"PRIu32" us out of range [%"PRIu32", %d]", i, cls[i].period, min, LOOP_PERIOD_MAX);
+        }
+        if (cls[i].blocks_cnt == 0) {
+            RET_E(EMU_ERR_INVALID_ARG, "Class %u has no blocks", i);
+        }
+    }
+
+    memcpy(loop_cfg.cls, cls, cnt * sizeof(emu_loop_class_cfg_t));
+    loop_cfg.cnt = cnt;
+    loop_cfg.version++;
+    RET_OK("%u task classes configured, applied at loop start", cnt);
+}
 
 
 #undef OWNER
@@ -344,13 +643,14 @@ emu_result_t emu_loop_deinit() {
     if (!loop_handle) {
         RET_W(EMU_ERR_LOOP_NOT_INITIALIZED, "Loop not initialized");
     }
-    esp_err_t err = esp_timer_delete(loop_handle->timer.timer_handle);
-    if (err != ESP_OK) {
-        RET_E(EMU_ERR_INVALID_STATE, "Failed to delete timer: %s", esp_err_to_name(err));
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {
+        esp_err_t err = esp_timer_delete(loop_handle->cls[i].timer.timer_handle);
+        if (err != ESP_OK) {
+            RET_E(EMU_ERR_INVALID_STATE, "Failed to delete timer: %s", esp_err_to_name(err));
+        }
+        loop_handle->cls[i].timer.timer_handle = NULL;
     }
-    vSemaphoreDelete(loop_handle->sem_loop_start);
-    vSemaphoreDelete(loop_handle->sem_loop_wtd);
-    vTaskDelete(loop_handle->loop_task_handle);
+    for (uint8_t i = 0; i < loop_handle->cls_cnt; i++) {_loop_class_destroy(&loop_handle->cls[i]);}
     free(loop_handle);
     loop_handle = NULL;
     RET_OK("Loop deinitialized");
@@ -360,14 +660,45 @@ bool emu_loop_wait_for_cycle_start(BaseType_t ticks_to_wait) {
     if (!loop_handle) {
         return false;
     }
-    return xSemaphoreTake(loop_handle->sem_loop_start, ticks_to_wait) == pdTRUE;
+    emu_loop_class_t *main_cls = &loop_handle->cls[0];
+    if (xSemaphoreTake(main_cls->sem_loop_start, ticks_to_wait) != pdTRUE) {
+        return false;
+    }
+    cycle_times.wake = esp_timer_get_time();
+    cycle_times.tick = main_cls->tick;
+    return true;
+}
+
+void emu_loop_mark_exec_end() {
+    cycle_times.exec_end = esp_timer_get_time();
 }
 
 bool emu_loop_notify_cycle_end() {
     if (!loop_handle) {
         return false;
     }
-    xSemaphoreGive(loop_handle->sem_loop_wtd);
+    _loop_stats_commit(esp_timer_get_time());
+    xSemaphoreGive(loop_handle->cls[0].sem_loop_wtd);
+
+    //periodic report is sent after wtd release so it is not counted to cycle
+    if (loop_stats.send_every && ++loop_stats.cycles_since_send >= loop_stats.send_every) {
+        emu_loop_stats_send();
+    }
+    return true;
+}
+
+bool emu_loop_class_wait(uint8_t cls, BaseType_t ticks_to_wait) {
+    if (!loop_handle) {
+        return false;
+    }
+    return xSemaphoreTake(loop_handle->cls[cls].sem_loop_start, ticks_to_wait) == pdTRUE;
+}
+
+bool emu_loop_class_cycle_end(uint8_t cls) {
+    if (!loop_handle) {
+        return false;
+    }
+    xSemaphoreGive(loop_handle->cls[cls].sem_loop_wtd);
     return true;
 }
 
@@ -375,13 +706,85 @@ uint8_t emu_loop_get_wtd_max_skipped() {
     if (!loop_handle) {
         return 0;
     }
-    return loop_handle->wtd.max_skipp;
+    return _loop_current_class()->wtd.max_skipp;
 }
 
 uint64_t emu_loop_get_period() {
     if (!loop_handle) {
         return 0;
     }
-    return loop_handle->timer.loop_period;
+    return _loop_current_class()->timer.loop_period;
 }
 
+void emu_loop_stats_get(emu_loop_stats_t *out) {
+    uint32_t seq_start, seq_end;
+    do {
+        seq_start = __atomic_load_n(&loop_stats.seq, __ATOMIC_ACQUIRE);
+        memcpy(out, &loop_stats.data, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq_end = __atomic_load_n(&loop_stats.seq, __ATOMIC_RELAXED);
+    } while ((seq_start & 1) || seq_start != seq_end);
+}
+
+void emu_loop_stats_reset() {
+    //applied by loop task on next commit, if loop is not running there is no writer
+    if (loop_handle && loop_handle->loop_status == LOOP_RUNNING) {
+        loop_stats.reset_request = true;
+    } else {
+        memset(&loop_stats.data, 0, sizeof(loop_stats.data));
+    }
+}
+
+void emu_loop_stats_set_send_every(uint16_t send_every) {
+    loop_stats.send_every = send_every;
+    loop_stats.cycles_since_send = 0;
+}
+
+uint32_t emu_loop_metric_percentile(const emu_loop_metric_t *metric, uint8_t percent) {
+    uint64_t cnt = 0;
+    for (uint8_t i = 0; i < EMU_LOOP_HIST_BUCKETS; i++) {cnt += metric->hist[i];}
+    if (cnt == 0) {return 0;}
+
+    uint64_t target = (cnt * percent + 99) / 100;
+    uint64_t acc = 0;
+    for (uint8_t i = 0; i < EMU_LOOP_HIST_BUCKETS; i++) {
+        acc += metric->hist[i];
+        if (acc >= target) {
+            //upper bound of bucket, never more than real max
+            uint32_t upper = (i == EMU_LOOP_HIST_BUCKETS - 1) ? UINT32_MAX : ((2u << i) - 1);
+            return (upper < metric->max_us) ? upper : metric->max_us;
+        }
+    }
+    return metric->max_us;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_loop_stats_send
+emu_result_t emu_loop_stats_send() {
+    emu_loop_stats_t stats;
+    emu_loop_stats_get(&stats);
+
+    uint32_t period = (uint32_t)emu_loop_get_period();
+    uint16_t offset = 0;
+    //loop task (send_every) and interface task (ORD_EMU_LOOP_STATS_GET) send stats, each builds packet on own stack
+    uint8_t buff[LOOP_STATS_PKT_SIZE];
+    buff[offset++] = PACKET_H_LOOP_STATS;
+    memcpy(&buff[offset], &stats.cycles, sizeof(uint32_t));  offset += sizeof(uint32_t);
+    memcpy(&buff[offset], &stats.skipped, sizeof(uint32_t)); offset += sizeof(uint32_t);
+    memcpy(&buff[offset], &period, sizeof(uint32_t));        offset += sizeof(uint32_t);
+
+    const emu_loop_metric_t *metrics[] = {&stats.wake, &stats.exec, &stats.tail};
+    for (uint8_t i = 0; i < sizeof(metrics)/sizeof(metrics[0]); i++) {
+        uint32_t vals[4] = {
+            stats.cycles ? (uint32_t)(metrics[i]->total_us / stats.cycles) : 0,
+            emu_loop_metric_percentile(metrics[i], 50),
+            emu_loop_metric_percentile(metrics[i], 99),
+            metrics[i]->max_us,
+        };
+        memcpy(&buff[offset], vals, sizeof(vals));
+        offset += sizeof(vals);
+    }
+    gatt_send_notify(buff, offset);
+    loop_stats.cycles_since_send = 0;
+    RET_OK("Loop stats sent, %"PRIu32" cycles", stats.cycles);
+}
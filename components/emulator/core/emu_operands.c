@@ -0,0 +1,112 @@
+#include "emu_operands.h"
+#include "emu_logging.h"
+#include "blocks_functions_list.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char* TAG = __FILE_NAME__;
+
+/*-------------------------------CONVERSION KERNELS------------------------------------------------ */
+
+/*value is wrapped in mem_var_t so every kernel converts exactly like MEM_CAST*/
+#define CONV_KERNEL(S, S_TYPE, S_ID, D, D_TYPE) \
+static void _conv_##S##_##D(void *dst, const void *src) { \
+    mem_var_t v = {.type = S_ID, .by_reference = 0}; \
+    v.data.val.S = *(const S_TYPE*)src; \
+    *(D_TYPE*)dst = emu_var_to_##D(v); \
+}
+
+#define CONV_KERNELS_FROM(S, S_TYPE, S_ID) \
+    CONV_KERNEL(S, S_TYPE, S_ID, u8,  uint8_t)  \
+    CONV_KERNEL(S, S_TYPE, S_ID, u16, uint16_t) \
+    CONV_KERNEL(S, S_TYPE, S_ID, u32, uint32_t) \
+    CONV_KERNEL(S, S_TYPE, S_ID, i16, int16_t)  \
+    CONV_KERNEL(S, S_TYPE, S_ID, i32, int32_t)  \
+    CONV_KERNEL(S, S_TYPE, S_ID, b,   bool)     \
+    CONV_KERNEL(S, S_TYPE, S_ID, f,   float)    \
+    CONV_KERNEL(S, S_TYPE, S_ID, q,   int32_t)
+
+CONV_KERNELS_FROM(u8,  uint8_t,  MEM_U8)
+CONV_KERNELS_FROM(u16, uint16_t, MEM_U16)
+CONV_KERNELS_FROM(u32, uint32_t, MEM_U32)
+CONV_KERNELS_FROM(i16, int16_t,  MEM_I16)
+CONV_KERNELS_FROM(i32, int32_t,  MEM_I32)
+CONV_KERNELS_FROM(b,   bool,     MEM_B)
+CONV_KERNELS_FROM(f,   float,    MEM_F)
+CONV_KERNELS_FROM(q,   int32_t,  MEM_Q)
+
+/*columns in mem_types_t order*/
+#define CONV_ROW(S) {_conv_##S##_u8, _conv_##S##_u16, _conv_##S##_u32, _conv_##S##_i16, _conv_##S##_i32, _conv_##S##_b, _conv_##S##_f, _conv_##S##_q}
+
+const emu_conv_kernel_t emu_conv_kernels[MEM_TYPES_COUNT][MEM_TYPES_COUNT] = {
+    [MEM_U8]  = CONV_ROW(u8),
+    [MEM_U16] = CONV_ROW(u16),
+    [MEM_U32] = CONV_ROW(u32),
+    [MEM_I16] = CONV_ROW(i16),
+    [MEM_I32] = CONV_ROW(i32),
+    [MEM_B]   = CONV_ROW(b),
+    [MEM_F]   = CONV_ROW(f),
+    [MEM_Q]   = CONV_ROW(q),
+};
+
+_Static_assert(MEM_U8 == 0 && MEM_U16 == 1 && MEM_U32 == 2 && MEM_I16 == 3 && MEM_I32 == 4 && MEM_B == 5 && MEM_F == 6 && MEM_Q == 7, "CONV_ROW columns follow mem_types_t order");
+
+/*-------------------------------OPERAND TABLE------------------------------------------------------ */
+
+static void _operand_set(emu_operand_t *op, const mem_access_t *access, mem_instance_t **moved, uint16_t moved_cnt) {
+    memset(op, 0, sizeof(*op));
+    if (!access || !access->instance) {return;}
+    mem_instance_t *inst = access->instance;
+    op->inst = inst;
+    op->type = inst->type;
+    op->updated = mem_instance_flag_ref(inst);
+    op->clear_mask = mem_instance_can_clear(inst) ? op->updated.mask : 0;
+    //packed bool element has no address
+    if (!access->is_index_resolved || inst->packed) {return;}
+    for (uint16_t m = 0; m < moved_cnt; m++) {
+        if (moved[m] == inst) {return;}
+    }
+    op->ptr = inst->data.u8 + (size_t)access->resolved_index * MEM_TYPE_SIZES[inst->type];
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_operands_build
+emu_result_t emu_operands_build(emu_code_handle_t code) {
+    //outputs of blocks that replace instance (data address included) at runtime
+    uint16_t moved_cnt = 0;
+    for (uint16_t b = 0; b < code->total_blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        if (emu_block_sched_table[block->cfg.block_type].moves_outputs) {moved_cnt += block->cfg.q_cnt;}
+    }
+    mem_instance_t **moved = NULL;
+    if (moved_cnt) {
+        moved = (mem_instance_t**)calloc(moved_cnt, sizeof(mem_instance_t*));
+        if (!moved) {RET_E(EMU_ERR_NO_MEM, "No memory to build operand tables");}
+        moved_cnt = 0;
+        for (uint16_t b = 0; b < code->total_blocks; b++) {
+            block_handle_t block = code->blocks_list[b];
+            if (!emu_block_sched_table[block->cfg.block_type].moves_outputs) {continue;}
+            for (uint8_t q = 0; q < block->cfg.q_cnt; q++) {moved[moved_cnt++] = block->outputs[q]->instance;}
+        }
+    }
+
+    uint32_t cached = 0, total = 0;
+    for (uint16_t b = 0; b < code->total_blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        if (!block->ops) {continue;}
+        for (uint8_t i = 0; i < block->cfg.in_cnt; i++) {
+            const mem_access_t *access = ((block->cfg.in_connceted_mask >> i) & 1) ? block->inputs[i] : NULL;
+            _operand_set(&block->ops[i], access, moved, moved_cnt);
+        }
+        for (uint8_t q = 0; q < block->cfg.q_cnt; q++) {
+            _operand_set(&block->ops[block->cfg.in_cnt + q], block->outputs[q], moved, moved_cnt);
+        }
+        for (uint8_t o = 0; o < block->cfg.in_cnt + block->cfg.q_cnt; o++) {
+            if (block->ops[o].inst && !block->ops[o].updated.word) {free(moved); RET_ED(EMU_ERR_NULL_PTR, b, 0, "Block[%"PRIu16"] operand %u instance is not in any context", b, o);}
+            if (block->ops[o].inst) {total++;}
+            if (block->ops[o].ptr) {cached++;}
+        }
+    }
+    free(moved);
+    RET_OK("Operand tables built, %"PRIu32" of %"PRIu32" operands resolved to address", cached, total);
+}
@@ -0,0 +1,50 @@
+#include "emu_packed.h"
+#include "emu_variables.h"
+#include "emu_logging.h"
+
+static const char* TAG = __FILE_NAME__;
+
+uint32_t mem_instance_el_cnt(const mem_instance_t *inst) {
+    //dims are kept in context of instance (copy made by IN_SELECTOR keeps context of source)
+    const uint16_t *dims = mem_contexts[inst->context].types[inst->type].dims_pool;
+    uint32_t cnt = 1;
+    for (uint8_t i = 0; i < inst->dims_cnt; i++) {cnt *= dims[inst->dims_idx + i];}
+    return cnt;
+}
+
+uint32_t mem_instance_data_size(const mem_instance_t *inst) {
+    uint32_t cnt = mem_instance_el_cnt(inst);
+    return inst->packed ? MEM_PACKED_WORDS(cnt) * sizeof(uint32_t) : cnt * MEM_TYPE_SIZES[inst->type];
+}
+
+void mem_packed_from_bytes(mem_instance_t *inst, uint32_t start, const uint8_t *src, uint32_t items) {
+    uint32_t i = 0;
+    //leading elements up to word boundary
+    for (; i < items && ((start + i) & 31); i++) {mem_packed_put(inst, start + i, src[i] != 0);}
+    //whole words
+    for (; i + 32 <= items; i += 32) {
+        uint32_t word = 0;
+        for (uint8_t b = 0; b < 32; b++) {word |= (uint32_t)(src[i + b] != 0) << b;}
+        inst->data.u32[(start + i) >> 5] = word;
+    }
+    for (; i < items; i++) {mem_packed_put(inst, start + i, src[i] != 0);}
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_mem_packed_op
+emu_result_t mem_packed_op(mem_instance_t *dst, const mem_instance_t *a, const mem_instance_t *b, mem_packed_op_t op) {
+    if (!dst || !a || !b) {RET_E(EMU_ERR_NULL_PTR, "NULL instance");}
+    if (!dst->packed || !a->packed || !b->packed) {RET_E(EMU_ERR_MEM_INVALID_DATATYPE, "Packed bool arrays required");}
+    uint32_t cnt = mem_instance_el_cnt(dst);
+    if (mem_instance_el_cnt(a) != cnt || mem_instance_el_cnt(b) != cnt) {RET_E(EMU_ERR_MEM_OUT_OF_BOUNDS, "Arrays sizes differ");}
+
+    uint32_t *d = dst->data.u32;
+    const uint32_t *x = a->data.u32, *y = b->data.u32;
+    uint32_t words = MEM_PACKED_WORDS(cnt);
+    switch (op) {
+        case MEM_PACKED_AND: for (uint32_t w = 0; w < words; w++) {d[w] = x[w] & y[w];} break;
+        case MEM_PACKED_OR:  for (uint32_t w = 0; w < words; w++) {d[w] = x[w] | y[w];} break;
+        default: RET_E(EMU_ERR_INVALID_ARG, "Unknown packed op %d", op);
+    }
+    return EMU_RESULT_OK();
+}
@@ -7,8 +7,13 @@
 #include "emu_helpers.h"
 #include "blocks_functions_list.h"
 #include <string.h>
+#include <stdlib.h>
 #include "emu_subscribe.h"
 #include "emu_buffs.h"
+#include "emu_sched.h"
+#include "emu_partition.h"
+#include "emu_operands.h"
+#include "emu_loop.h"
 
 static const char *TAG = __FILE_NAME__;
 
@@ -78,7 +83,7 @@ static emu_parse_func parse_dispatch_table[255] = {
     [PACKET_H_INSTANCE_SCALAR_DATA]  = emu_mem_fill_instance_scalar, 
     [PACKET_H_INSTANCE_ARR_DATA]     = emu_mem_fill_instance_array,
 
-    [PACKET_H_LOOP_CFG]              = NULL,
+    [PACKET_H_LOOP_CFG]              = emu_loop_parse_cfg,
     [PACKET_H_CODE_CFG]              = emu_block_parse_create_list,
 
     [PACKET_H_BLOCK_HEADER]          = emu_block_parse_cfg,
@@ -165,11 +170,26 @@ emu_result_t emu_parse_verify_code(emu_code_handle_t code){
                 }
             }
         }
+    }
+
+    // ---- 5. Old plan is dropped, code runs again only when every block program is verified below ----
+    free(code->plan);
+    code->plan = NULL;
+
+    // ---- 6. Operand tables, all accesses are checked above ----
+    emu_result_t res = emu_operands_build(code);
+    if (res.code != EMU_OK) {
+        RET_ED(res.code, 0, ++res.depth, "Operand tables not built");
+    }
+
+    for (uint16_t i = 0; i < code->total_blocks; i++) {
+        block_handle_t block = code->blocks_list[i];
+        uint8_t btype = block->cfg.block_type;
 
-        // ---- 5. Dispatch block-specific verify if registered ----
+        // ---- 7. Dispatch block-specific verify if registered ----
         emu_block_verify_func verify_fn = emu_block_verify_table[btype];
         if (verify_fn) {
-            emu_result_t res = verify_fn(block);
+            res = verify_fn(block);
             if (res.code != EMU_OK) {
                 RET_ED(res.code, i, ++res.depth,
                        "Block[%"PRIu16"] type %u verify failed", i, btype);
@@ -180,5 +200,23 @@ emu_result_t emu_parse_verify_code(emu_code_handle_t code){
     }
 
     LOG_I(TAG, "All %"PRIu16" blocks verified OK", code->total_blocks);
+
+    // ---- 8. Execution plan ----
+    res = emu_code_compile(code);
+    if (res.code != EMU_OK) {
+        RET_ED(res.code, 0, ++res.depth, "Execution plan not compiled");
+    }
+
+    // ---- 9. Dirty execution graph (or free it when full mode selected) ----
+    res = emu_sched_update(code);
+    if (res.code != EMU_OK && res.abort) {
+        RET_WD(res.code, 0, ++res.depth, "Execution graph not built, code runs in full mode");
+    }
+
+    // ---- 10. Split between cores ----
+    res = emu_partition_update(code);
+    if (res.code != EMU_OK && res.abort) {
+        RET_WD(res.code, 0, ++res.depth, "Core split not built, code runs on single core");
+    }
     return EMU_RESULT_OK();
 }
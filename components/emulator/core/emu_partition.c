@@ -0,0 +1,287 @@
+#include "emu_partition.h"
+#include "emu_loop.h"
+#include "emu_logging.h"
+#include "emu_blocks.h"
+#include "blocks_functions_list.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = __FILE_NAME__;
+
+static const uint32_t worker_stack_depth = 10*1024;
+
+/**
+ * @brief Instance used by block, used only while building
+ */
+typedef struct {
+    mem_instance_t *inst;
+    uint16_t block;
+    bool write;
+} part_ref_t;
+
+/**
+ * @brief Worker running core 1 share, job is written before notify and read after join (notify orders access)
+ */
+static struct {
+    TaskHandle_t task;
+    TaskHandle_t caller;
+    const emu_plan_entry_t *plan;
+    uint16_t cnt;
+    emu_result_t res;
+} worker;
+
+static int _ref_cmp(const void *a, const void *b) {
+    const part_ref_t *ra = a, *rb = b;
+    if (ra->inst != rb->inst) {return ((uintptr_t)ra->inst < (uintptr_t)rb->inst) ? -1 : 1;}
+    return (int)ra->block - (int)rb->block;
+}
+
+static uint16_t _find(uint16_t *parent, uint16_t b) {
+    while (parent[b] != b) {
+        parent[b] = parent[parent[b]];
+        b = parent[b];
+    }
+    return b;
+}
+
+static void _union(uint16_t *parent, uint16_t a, uint16_t b) {
+    a = _find(parent, a);
+    b = _find(parent, b);
+    if (a != b) {parent[(a > b) ? a : b] = (a > b) ? b : a;}
+}
+
+/**
+ * @brief Count instances reachable from access (instance and dynamic indices)
+ */
+static uint32_t _access_refs_cnt(const mem_access_t *access) {
+    if (!access) {return 0;}
+    uint32_t cnt = 1;
+    for (uint8_t i = 0; i < access->indices_cnt; i++) {
+        if (!((access->is_idx_static_mask >> i) & 1)) {cnt += _access_refs_cnt(access->indices_values[i].dynamic_index);}
+    }
+    return cnt;
+}
+
+/**
+ * @brief Add instance of access and instances of its dynamic indices (always read)
+ */
+static void _access_refs_add(const mem_access_t *access, uint16_t block, bool write, part_ref_t *refs, uint32_t *n) {
+    if (!access) {return;}
+    refs[(*n)++] = (part_ref_t){.inst = access->instance, .block = block, .write = write};
+    for (uint8_t i = 0; i < access->indices_cnt; i++) {
+        if (!((access->is_idx_static_mask >> i) & 1)) {_access_refs_add(access->indices_values[i].dynamic_index, block, false, refs, n);}
+    }
+}
+
+static void _worker_task(void *params) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        worker.res = emu_execute_plan(worker.plan, worker.cnt);
+        xTaskNotifyGive(worker.caller);
+    }
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_partition_worker_init
+emu_result_t emu_partition_worker_init(void) {
+    #if EMU_PARALLEL_ENABLED
+    if (worker.task) {return EMU_RESULT_OK();}
+    if (xTaskCreatePinnedToCore(_worker_task, "EMU_WORKER", worker_stack_depth, NULL, 4, &worker.task, EMU_WORKER_CORE) != pdPASS) {
+        worker.task = NULL;
+        RET_E(EMU_ERR_MEM_ALLOC, "Failed to create worker task, code runs on single core");
+    }
+    RET_OK("Worker task created on core %d", EMU_WORKER_CORE);
+    #else
+    return EMU_RESULT_OK();
+    #endif
+}
+
+void emu_partition_free(emu_code_handle_t code) {
+    if (!code || !code->parts) {return;}
+    for (uint8_t c = 0; c < EMU_PARALLEL_CORES; c++) {free(code->parts->plan[c]);}
+    free(code->parts);
+    code->parts = NULL;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_partition_build
+static emu_result_t _partition_build(emu_code_handle_t code) {
+    const uint16_t blocks = code->total_blocks;
+    uint16_t *parent = NULL;
+    part_ref_t *refs = NULL;
+    uint16_t *group_of = NULL;
+    uint32_t *group_size = NULL;
+    uint16_t *order = NULL;
+    uint8_t *core_of = NULL;
+    emu_partition_t *p = NULL;
+
+    //1. every block alone, chain blocks with their FOR
+    parent = (uint16_t*)calloc(blocks, sizeof(uint16_t));
+    if (!parent) {goto no_mem;}
+    for (uint16_t b = 0; b < blocks; b++) {parent[b] = b;}
+    for (uint16_t b = 0; b < blocks; b += code->plan[b].skip) {
+        for (uint16_t c = b + 1; c < b + code->plan[b].skip; c++) {_union(parent, b, c);}
+    }
+
+    //2. blocks sharing instance that is written by any of them are joined
+    uint32_t ref_cnt = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        for (uint8_t q = 0; q < block->cfg.q_cnt; q++) {ref_cnt += _access_refs_cnt(block->outputs[q]);}
+        for (uint8_t in = 0; in < block->cfg.in_cnt; in++) {
+            if ((block->cfg.in_connceted_mask >> in) & 1) {ref_cnt += _access_refs_cnt(block->inputs[in]);}
+        }
+    }
+    refs = (part_ref_t*)calloc(ref_cnt ? ref_cnt : 1, sizeof(part_ref_t));
+    if (!refs) {goto no_mem;}
+
+    uint32_t n = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        uint16_t written = emu_block_sched_table[block->cfg.block_type].written_inputs;
+        for (uint8_t q = 0; q < block->cfg.q_cnt; q++) {_access_refs_add(block->outputs[q], b, true, refs, &n);}
+        for (uint8_t in = 0; in < block->cfg.in_cnt; in++) {
+            if ((block->cfg.in_connceted_mask >> in) & 1) {_access_refs_add(block->inputs[in], b, (written >> in) & 1, refs, &n);}
+        }
+    }
+    qsort(refs, n, sizeof(part_ref_t), _ref_cmp);
+
+    for (uint32_t i = 0; i < n;) {
+        uint32_t end = i;
+        bool written = false;
+        while (end < n && refs[end].inst == refs[i].inst) {
+            if (refs[end].write) {written = true;}
+            end++;
+        }
+        //only read by code (user variables written by host) do not join blocks
+        if (written) {
+            for (uint32_t k = i + 1; k < end; k++) {_union(parent, refs[i].block, refs[k].block);}
+        }
+        i = end;
+    }
+
+    //3. groups and their sizes
+    group_of = (uint16_t*)calloc(blocks, sizeof(uint16_t));
+    group_size = (uint32_t*)calloc(blocks, sizeof(uint32_t));
+    order = (uint16_t*)calloc(blocks, sizeof(uint16_t));
+    core_of = (uint8_t*)calloc(blocks, sizeof(uint8_t));
+    p = (emu_partition_t*)calloc(1, sizeof(emu_partition_t));
+    if (!group_of || !group_size || !order || !core_of || !p) {goto no_mem;}
+
+    uint16_t groups = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        uint16_t root = _find(parent, b);
+        if (root == b) {group_of[b] = groups++;}
+        group_size[group_of[root]]++;
+        group_of[b] = group_of[root];
+    }
+    p->groups = groups;
+
+    //4. largest group first to core with less blocks
+    for (uint16_t g = 0; g < groups; g++) {order[g] = g;}
+    for (uint16_t i = 1; i < groups; i++) {
+        uint16_t g = order[i];
+        int32_t k = i - 1;
+        while (k >= 0 && group_size[order[k]] < group_size[g]) {order[k + 1] = order[k]; k--;}
+        order[k + 1] = g;
+    }
+    uint32_t load[EMU_PARALLEL_CORES] = {0};
+    for (uint16_t i = 0; i < groups; i++) {
+        uint8_t best = 0;
+        for (uint8_t c = 1; c < EMU_PARALLEL_CORES; c++) {
+            if (load[c] < load[best]) {best = c;}
+        }
+        core_of[order[i]] = best;
+        load[best] += group_size[order[i]];
+    }
+
+    uint32_t min_load = load[0];
+    for (uint8_t c = 1; c < EMU_PARALLEL_CORES; c++) {
+        if (load[c] < min_load) {min_load = load[c];}
+    }
+    if (min_load < EMU_PARALLEL_MIN_BLOCKS) {
+        LOG_I(TAG, "%"PRIu16" independent subgraphs, smaller share %"PRIu32" blocks, code runs on single core", groups, min_load);
+        free(p);
+        p = NULL;
+        goto done;
+    }
+
+    //5. core shares, chain is single entry (FOR runs it from code plan)
+    for (uint16_t b = 0; b < blocks; b += code->plan[b].skip) {p->cnt[core_of[group_of[b]]]++;}
+    for (uint8_t c = 0; c < EMU_PARALLEL_CORES; c++) {
+        p->plan[c] = (emu_plan_entry_t*)calloc(p->cnt[c], sizeof(emu_plan_entry_t));
+        if (!p->plan[c]) {goto no_mem;}
+        p->cnt[c] = 0;
+    }
+    for (uint16_t b = 0; b < blocks; b += code->plan[b].skip) {
+        uint8_t c = core_of[group_of[b]];
+        p->plan[c][p->cnt[c]] = code->plan[b];
+        p->plan[c][p->cnt[c]].skip = 1;
+        p->cnt[c]++;
+    }
+
+done:
+    free(parent);
+    free(refs);
+    free(group_of);
+    free(group_size);
+    free(order);
+    free(core_of);
+    code->parts = p;
+    if (p) {
+        RET_OK("Split %"PRIu16" subgraphs: core 0 %"PRIu32" blocks, core 1 %"PRIu32" blocks", groups, load[0], load[1]);
+    }
+    return EMU_RESULT_OK();
+
+no_mem:
+    free(parent);
+    free(refs);
+    free(group_of);
+    free(group_size);
+    free(order);
+    free(core_of);
+    if (p) {
+        code->parts = p;
+        emu_partition_free(code);
+    }
+    RET_E(EMU_ERR_NO_MEM, "No memory to split %"PRIu16" blocks between cores", blocks);
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_partition_build
+emu_result_t emu_partition_update(emu_code_handle_t code) {
+    if (!code) {RET_E(EMU_ERR_NULL_PTR, "No code");}
+    if (emu_loop_is_running()) {RET_W(EMU_ERR_DENY, "Loop is running, core split not changed");}
+
+    emu_partition_free(code);
+    //task classes run their ranges on loop core, split is for single class only
+    if (!EMU_PARALLEL_ENABLED || !code->plan || code->total_blocks < 2 * EMU_PARALLEL_MIN_BLOCKS || emu_loop_classes_active()) {
+        return EMU_RESULT_OK();
+    }
+    return _partition_build(code);
+}
+
+emu_result_t emu_partition_execute(emu_code_handle_t code) {
+    emu_partition_t *p = code->parts;
+    bool released = false;
+
+    if (likely(worker.task)) {
+        worker.caller = xTaskGetCurrentTaskHandle();
+        worker.plan = p->plan[1];
+        worker.cnt = p->cnt[1];
+        xTaskNotifyGive(worker.task);
+        released = true;
+    }
+
+    emu_result_t res = emu_execute_plan(p->plan[0], p->cnt[0]);
+
+    //barrier, worker share has to be done before outputs are published
+    emu_result_t res_worker;
+    if (released) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        res_worker = worker.res;
+    } else {
+        res_worker = emu_execute_plan(p->plan[1], p->cnt[1]);
+    }
+    return res.abort ? res : res_worker;
+}
@@ -0,0 +1,118 @@
+#include "emu_profiler.h"
+#include "emu_parse.h"
+#include "emu_loop.h"
+#include "gatt_svc.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char* TAG = __FILE_NAME__;
+
+#define PROFILE_PKT_BUFF_SIZE 512
+#define PROFILE_PKT_HEAD_SIZE (sizeof(uint8_t) + 2*sizeof(uint16_t) + sizeof(uint8_t) + sizeof(uint16_t))
+#define PROFILE_PKT_MAX_ENTRIES ((PROFILE_PKT_BUFF_SIZE - PROFILE_PKT_HEAD_SIZE) / sizeof(emu_profile_entry_t))
+
+#if CONFIG_IDF_TARGET_LINUX
+#define PROFILE_CYCLES_PER_US 1000
+#else
+#define PROFILE_CYCLES_PER_US CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#endif
+
+emu_block_profile_t *emu_profile_active = NULL;
+
+static struct{
+    emu_block_profile_t *table;
+    uint16_t table_size;
+    uint16_t send_every;
+    uint16_t cycles_since_send;
+}profiler;
+
+static __always_inline void _profiler_set_active(emu_block_profile_t *table){
+    __atomic_store_n(&emu_profile_active, table, __ATOMIC_RELEASE);
+}
+
+static void _profiler_clear(void){
+    for (uint16_t i = 0; i < profiler.table_size; i++) {
+        profiler.table[i] = (emu_block_profile_t){.min_cycles = UINT32_MAX};
+    }
+    profiler.cycles_since_send = 0;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_profiler_start
+emu_result_t emu_profiler_start(emu_code_handle_t code, uint16_t send_every){
+    if (!code || !code->blocks_list || code->total_blocks == 0) {RET_E(EMU_ERR_NULL_PTR, "No code to profile");}
+    //loop task may still record into table it read, it is replaced only while loop is stopped
+    if (profiler.table && profiler.table_size != code->total_blocks && emu_loop_is_running()) {RET_E(EMU_ERR_INVALID_STATE, "Stop loop before profiling other code");}
+    _profiler_set_active(NULL);
+
+    //code could be reloaded since last start
+    if (profiler.table_size != code->total_blocks) {
+        emu_profiler_free();
+        profiler.table = (emu_block_profile_t*)calloc(code->total_blocks, sizeof(emu_block_profile_t));
+        if (!profiler.table) {RET_E(EMU_ERR_NO_MEM, "No memory for profile of %"PRIu16" blocks", code->total_blocks);}
+        profiler.table_size = code->total_blocks;
+    }
+    _profiler_clear();
+    profiler.send_every = send_every;
+    _profiler_set_active(profiler.table);
+    RET_OK("Profiling %"PRIu16" blocks, report every %"PRIu16" cycles", code->total_blocks, send_every);
+}
+
+void emu_profiler_stop(void){
+    _profiler_set_active(NULL);
+}
+
+void emu_profiler_free(void){
+    _profiler_set_active(NULL);
+    if (profiler.table) {free(profiler.table);}
+    profiler.table = NULL;
+    profiler.table_size = 0;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_profiler_send
+emu_result_t emu_profiler_send(emu_code_handle_t code){
+    if (!profiler.table || !code || profiler.table_size != code->total_blocks) {RET_W(EMU_ERR_INVALID_STATE, "Profiler not started for current code");}
+
+    //loop task (send_every) and interface task (ORD_EMU_PROFILER_SEND) can send at same time, packet is built on stack
+    uint8_t buff[PROFILE_PKT_BUFF_SIZE];
+    uint16_t first = 0;
+    while (first < profiler.table_size) {
+        uint16_t left = profiler.table_size - first;
+        uint8_t cnt = (left > PROFILE_PKT_MAX_ENTRIES) ? PROFILE_PKT_MAX_ENTRIES : left;
+        uint16_t cycles_per_us = PROFILE_CYCLES_PER_US;
+
+        uint16_t offset = 0;
+        buff[offset++] = PACKET_H_PROFILE;
+        memcpy(&buff[offset], &profiler.table_size, sizeof(uint16_t)); offset += sizeof(uint16_t);
+        memcpy(&buff[offset], &first, sizeof(uint16_t));               offset += sizeof(uint16_t);
+        buff[offset++] = cnt;
+        memcpy(&buff[offset], &cycles_per_us, sizeof(uint16_t));       offset += sizeof(uint16_t);
+
+        for (uint16_t i = first; i < first + cnt; i++) {
+            emu_block_profile_t *p = &profiler.table[i];
+            emu_profile_entry_t entry = {
+                .block_idx  = i,
+                .block_type = code->blocks_list[i]->cfg.block_type,
+                .calls      = p->calls,
+                .active     = p->active,
+                .min_cycles = p->calls ? p->min_cycles : 0,
+                .avg_cycles = p->calls ? (uint32_t)(p->total_cycles / p->calls) : 0,
+                .max_cycles = p->max_cycles,
+            };
+            memcpy(&buff[offset], &entry, sizeof(entry));
+            offset += sizeof(entry);
+        }
+        gatt_send_notify(buff, offset);
+        first += cnt;
+    }
+    profiler.cycles_since_send = 0;
+    RET_OK("Sent profile of %"PRIu16" blocks", profiler.table_size);
+}
+
+void emu_profiler_cycle_end(emu_code_handle_t code){
+    if (!emu_profiler_table() || profiler.send_every == 0) {return;}
+    if (++profiler.cycles_since_send >= profiler.send_every) {
+        emu_profiler_send(code);
+    }
+}
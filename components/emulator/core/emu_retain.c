@@ -0,0 +1,216 @@
+#include "emu_retain.h"
+#include "emu_variables.h"
+#include "emu_packed.h"
+#include "emu_logging.h"
+#include "nvs.h"
+#include "esp_rom_crc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char* TAG = __FILE_NAME__;
+
+#define RETAIN_KEY_SIG "sig"
+
+typedef struct {
+    const mem_instance_t *inst;
+    uint8_t *data;          /*instance data*/
+    mem_flag_ref_t flag;    /*updated flag, set when value is restored*/
+    uint32_t size;          /*bytes of instance data*/
+    uint32_t saved;         /*offset of last saved value in shadow*/
+    bool dirty;             /*changed since last successful save*/
+    bool restored;          /*value came from NVS at start*/
+    char key[12];           /*"ctx.type.idx"*/
+} retain_entry_t;
+
+static struct {
+    retain_entry_t *entries;
+    uint16_t cnt;
+    uint8_t *shadow;        /*values as they are in NVS*/
+    bool started;
+    SemaphoreHandle_t lock; /*table is used by interface task (start / reset) and retain task (flush)*/
+    TaskHandle_t task;
+} retain;
+
+static uint32_t _instance_bytes(const type_manager_t *mgr, const mem_instance_t *inst) {
+    uint32_t elements = 1;
+    for (uint8_t d = 0; d < inst->dims_cnt; d++) {elements *= mgr->dims_pool[inst->dims_idx + d];}
+    if (inst->packed) {return MEM_PACKED_WORDS(elements) * sizeof(uint32_t);}
+    return elements * MEM_TYPE_SIZES[inst->type];
+}
+
+static void _table_free(void) {
+    free(retain.entries);
+    free(retain.shadow);
+    retain.entries = NULL;
+    retain.shadow = NULL;
+    retain.cnt = 0;
+    retain.started = false;
+}
+
+static void _retain_task(void *params) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(EMU_RETAIN_PERIOD_MS));
+        emu_retain_flush();
+    }
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_retain_init
+emu_result_t emu_retain_init(void) {
+    if (retain.lock) {return EMU_RESULT_OK();}
+    retain.lock = xSemaphoreCreateMutex();
+    if (!retain.lock) {RET_E(EMU_ERR_MEM_ALLOC, "Failed to create retain lock");}
+    //lowest priority above idle, flash writes never delay loop tasks
+    if (xTaskCreate(_retain_task, "emu_retain", EMU_RETAIN_TASK_STACK, NULL, tskIDLE_PRIORITY + 1, &retain.task) != pdPASS) {
+        RET_E(EMU_ERR_MEM_ALLOC, "Failed to create retain task, retained values are restored but not saved");
+    }
+    return EMU_RESULT_OK();
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_retain_start
+static emu_result_t _start_locked(void) {
+    if (retain.started) {return EMU_RESULT_OK();}
+    retain.started = true;
+
+    uint16_t cnt = 0;
+    uint32_t bytes = 0;
+    for (uint8_t c = 0; c < MAX_CONTEXTS; c++) {
+        for (uint8_t t = 0; t < MEM_TYPES_COUNT; t++) {
+            const type_manager_t *mgr = &mem_contexts[c].types[t];
+            for (uint16_t i = 0; i < mgr->instances_cursor; i++) {
+                if (!mgr->instances[i].retain) {continue;}
+                cnt++;
+                bytes += _instance_bytes(mgr, &mgr->instances[i]);
+            }
+        }
+    }
+    if (!cnt) {return EMU_RESULT_OK();}
+    if (bytes > EMU_RETAIN_MAX_BYTES) {RET_W(EMU_ERR_NO_MEM, "%"PRIu32" bytes of retained data exceeds %d, nothing retained", bytes, EMU_RETAIN_MAX_BYTES);}
+
+    retain.entries = (retain_entry_t*)calloc(cnt, sizeof(retain_entry_t));
+    retain.shadow = (uint8_t*)malloc(bytes);
+    if (!retain.entries || !retain.shadow) {
+        _table_free();
+        retain.started = true;
+        RET_E(EMU_ERR_NO_MEM, "No memory for %"PRIu16" retained instances", cnt);
+    }
+
+    //signature of layout, values of other program are not restored
+    uint32_t sig = 0, offset = 0;
+    for (uint8_t c = 0; c < MAX_CONTEXTS; c++) {
+        for (uint8_t t = 0; t < MEM_TYPES_COUNT; t++) {
+            const type_manager_t *mgr = &mem_contexts[c].types[t];
+            for (uint16_t i = 0; i < mgr->instances_cursor; i++) {
+                if (!mgr->instances[i].retain) {continue;}
+                retain_entry_t *e = &retain.entries[retain.cnt++];
+                e->inst = &mgr->instances[i];
+                e->data = mgr->instances[i].data.u8;
+                e->flag = mem_type_flag_ref(mgr, i);
+                e->size = _instance_bytes(mgr, &mgr->instances[i]);
+                e->saved = offset;
+                snprintf(e->key, sizeof(e->key), "%u.%u.%u", c, t, i);
+                memcpy(&retain.shadow[offset], e->data, e->size);
+                offset += e->size;
+                uint32_t id[4] = {c, t, i, e->size};
+                sig = esp_rom_crc32_le(sig, (const uint8_t*)id, sizeof(id));
+            }
+        }
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(EMU_RETAIN_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {RET_W(EMU_ERR_ORD_FAILED, "NVS not available (%s), retained values not restored", esp_err_to_name(err));}
+
+    uint32_t stored_sig;
+    uint16_t restored = 0;
+    if (nvs_get_u32(nvs, RETAIN_KEY_SIG, &stored_sig) == ESP_OK && stored_sig == sig) {
+        for (uint16_t n = 0; n < retain.cnt; n++) {
+            retain_entry_t *e = &retain.entries[n];
+            size_t len = e->size;
+            //instance never changed has no key, keeps initial value
+            if (nvs_get_blob(nvs, e->key, &retain.shadow[e->saved], &len) == ESP_OK && len == e->size) {
+                memcpy(e->data, &retain.shadow[e->saved], e->size);
+                mem_flag_set(e->flag);
+                e->restored = true;
+                restored++;
+            } else {
+                memcpy(&retain.shadow[e->saved], e->data, e->size);
+            }
+        }
+    } else {
+        err = nvs_erase_all(nvs);
+        if (err == ESP_OK) {err = nvs_set_u32(nvs, RETAIN_KEY_SIG, sig);}
+        if (err == ESP_OK) {err = nvs_commit(nvs);}
+    }
+    nvs_close(nvs);
+    if (err != ESP_OK) {RET_W(EMU_ERR_ORD_FAILED, "Retain signature not saved: %s", esp_err_to_name(err));}
+    RET_OK("%"PRIu16" retained instances (%"PRIu32" bytes), %"PRIu16" restored", retain.cnt, bytes, restored);
+}
+
+emu_result_t emu_retain_start(void) {
+    if (!retain.lock) {return EMU_RESULT_OK();}
+    xSemaphoreTake(retain.lock, portMAX_DELAY);
+    emu_result_t res = _start_locked();
+    xSemaphoreGive(retain.lock);
+    return res;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_retain_flush
+static emu_result_t _flush_locked(void) {
+    uint16_t dirty = 0;
+    for (uint16_t n = 0; n < retain.cnt; n++) {
+        retain_entry_t *e = &retain.entries[n];
+        if (memcmp(&retain.shadow[e->saved], e->data, e->size)) {
+            memcpy(&retain.shadow[e->saved], e->data, e->size);
+            e->dirty = true;
+        }
+        dirty += e->dirty;
+    }
+    if (!dirty) {return EMU_RESULT_OK();}
+
+    //all changed instances in one commit, failed ones stay dirty for next period
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(EMU_RETAIN_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {RET_E(EMU_ERR_ORD_FAILED, "NVS not available: %s", esp_err_to_name(err));}
+    for (uint16_t n = 0; n < retain.cnt && err == ESP_OK; n++) {
+        retain_entry_t *e = &retain.entries[n];
+        if (e->dirty) {err = nvs_set_blob(nvs, e->key, &retain.shadow[e->saved], e->size);}
+    }
+    if (err == ESP_OK) {err = nvs_commit(nvs);}
+    nvs_close(nvs);
+    if (err != ESP_OK) {RET_E(EMU_ERR_ORD_FAILED, "Retained values not saved: %s", esp_err_to_name(err));}
+
+    for (uint16_t n = 0; n < retain.cnt; n++) {retain.entries[n].dirty = false;}
+    LOG_I(TAG, "%"PRIu16" retained instances saved", dirty);
+    return EMU_RESULT_OK();
+}
+
+emu_result_t emu_retain_flush(void) {
+    if (!retain.lock) {return EMU_RESULT_OK();}
+    xSemaphoreTake(retain.lock, portMAX_DELAY);
+    emu_result_t res = _flush_locked();
+    xSemaphoreGive(retain.lock);
+    return res;
+}
+
+bool emu_retain_restored(const mem_instance_t *inst) {
+    if (!retain.lock) {return false;}
+    bool res = false;
+    xSemaphoreTake(retain.lock, portMAX_DELAY);
+    for (uint16_t n = 0; n < retain.cnt && !res; n++) {res = (retain.entries[n].inst == inst && retain.entries[n].restored);}
+    xSemaphoreGive(retain.lock);
+    return res;
+}
+
+void emu_retain_reset(void) {
+    if (!retain.lock) {return;}
+    xSemaphoreTake(retain.lock, portMAX_DELAY);
+    _table_free();
+    xSemaphoreGive(retain.lock);
+}
@@ -0,0 +1,180 @@
+#include "emu_rx.h"
+#include "emu_parse.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char* TAG = __FILE_NAME__;
+
+typedef enum {
+    RX_FREE = 0,
+    RX_FILLING,     /*claimed, BLE task copies write into it*/
+    RX_READY,       /*waits for interface task*/
+    RX_BUSY,        /*processed by interface task*/
+} rx_state_t;
+
+typedef struct {
+    msg_packet_t view;  /*write without seq header, given to interface task*/
+    uint16_t seq;
+    uint8_t state;
+    bool sequenced;
+    bool nacked;        /*write of this slot reported missing, one NACK per gap*/
+    bool stale;         /*busy write of stream that was restarted, does not move window*/
+} rx_slot_t;
+
+static struct {
+    rx_slot_t slots[EMU_IN_MSG_SLOTS];
+    uint16_t next;      /*seq processed next, everything before is acknowledged*/
+    int8_t busy;        /*slot processed by interface task, -1 none*/
+    SemaphoreHandle_t lock; /*slots are claimed by BLE task and released by interface task*/
+    emu_rx_notify_cb notify;
+} rx = {.busy = -1};
+
+static void _reply(uint8_t type, uint16_t seq) {
+    if (!rx.notify) {return;}
+    uint8_t msg[EMU_RX_SEQ_HEAD] = {type, (uint8_t)seq, (uint8_t)(seq >> 8)};
+    rx.notify(msg, sizeof(msg));
+}
+
+static bool _idle(void) {
+    for (uint8_t i = 0; i < EMU_IN_MSG_SLOTS; i++) {
+        if (rx.slots[i].state != RX_FREE) {return false;}
+    }
+    return true;
+}
+
+/*claim, commit and reset run in BLE host task, no slot is being filled here*/
+static void _restart(void) {
+    for (uint8_t i = 0; i < EMU_IN_MSG_SLOTS; i++) {
+        rx_slot_t *s = &rx.slots[i];
+        if (s->state == RX_BUSY) {s->stale = true;}
+        else {s->state = RX_FREE;}
+        s->nacked = false;
+    }
+    rx.next = 0;
+}
+
+void emu_rx_init(emu_rx_notify_cb notify) {
+    rx.notify = notify;
+    if (!rx.lock) {rx.lock = xSemaphoreCreateMutex();}
+}
+
+void emu_rx_reset(void) {
+    if (!rx.lock) {return;}
+    xSemaphoreTake(rx.lock, portMAX_DELAY);
+    _restart();
+    xSemaphoreGive(rx.lock);
+}
+
+msg_packet_t *emu_rx_claim(const uint8_t *head, size_t len) {
+    if (!rx.lock || len == 0 || len > emu_get_mtu_size()) {return NULL;}
+    bool sequenced = (head[0] == PACKET_H_SEQ);
+    if (sequenced && len <= EMU_RX_SEQ_HEAD) {return NULL;}
+    uint16_t seq = sequenced ? (uint16_t)(head[1] | (head[2] << 8)) : 0;
+
+    uint16_t nack[EMU_IN_MSG_SLOTS];
+    uint8_t nack_cnt = 0;
+    bool ack = false, busy = false;
+    rx_slot_t *s = NULL;
+
+    xSemaphoreTake(rx.lock, portMAX_DELAY);
+    if (!sequenced) {
+        //stop-and-wait peer, writes of window go first, sequenced stream after this write starts at 0
+        if (_idle()) {
+            _restart();
+            s = &rx.slots[0];
+        } else {
+            busy = true;
+        }
+    } else {
+        uint16_t ahead = seq - rx.next;
+        if (ahead >= EMU_IN_MSG_SLOTS) {
+            ack = true; //processed already (ACK lost) or peer ahead of window
+        } else if (rx.slots[seq % EMU_IN_MSG_SLOTS].state == RX_FREE) {
+            s = &rx.slots[seq % EMU_IN_MSG_SLOTS];
+            for (uint16_t a = 0; a < ahead; a++) {
+                rx_slot_t *gap = &rx.slots[(uint16_t)(rx.next + a) % EMU_IN_MSG_SLOTS];
+                if (gap->state == RX_FREE && !gap->nacked) {
+                    gap->nacked = true;
+                    nack[nack_cnt++] = rx.next + a;
+                }
+            }
+        } else if (rx.slots[seq % EMU_IN_MSG_SLOTS].stale) {
+            //slot still held by write of restarted stream, this one is not buffered and peer has to resend it
+            nack[nack_cnt++] = seq;
+        }
+        //else same write is buffered already
+    }
+    if (s) {
+        s->state = RX_FILLING;
+        s->seq = seq;
+        s->sequenced = sequenced;
+        s->nacked = false;
+        s->stale = false;
+    }
+    uint16_t next = rx.next;
+    xSemaphoreGive(rx.lock);
+
+    if (ack) {_reply(EMU_RX_ACK, next);}
+    if (busy) {_reply(EMU_RX_BUSY, next);}
+    for (uint8_t n = 0; n < nack_cnt; n++) {_reply(EMU_RX_NACK, nack[n]);}
+    if (!s) {
+        if (busy) {ESP_LOGW(TAG, "Plain write dropped, sequenced writes are not processed yet");}
+        return NULL;
+    }
+
+    msg_packet_t *slot = emu_get_in_msg_slot(s - rx.slots);
+    slot->len = len;
+    return slot;
+}
+
+void emu_rx_commit(msg_packet_t *slot) {
+    uint16_t idx = slot - emu_get_in_msg_slot(0);
+    rx_slot_t *s = &rx.slots[idx];
+    uint8_t skip = s->sequenced ? EMU_RX_SEQ_HEAD : 0;
+
+    xSemaphoreTake(rx.lock, portMAX_DELAY);
+    s->view.data = slot->data + skip;
+    s->view.len = slot->len - skip;
+    s->state = RX_READY;
+    xSemaphoreGive(rx.lock);
+}
+
+msg_packet_t *emu_rx_next(void) {
+    if (!rx.lock) {return NULL;}
+    msg_packet_t *res = NULL;
+    xSemaphoreTake(rx.lock, portMAX_DELAY);
+    uint8_t idx = rx.next % EMU_IN_MSG_SLOTS;
+    rx_slot_t *s = &rx.slots[idx];
+    if (rx.busy < 0 && s->state == RX_READY && (!s->sequenced || s->seq == rx.next)) {
+        s->state = RX_BUSY;
+        rx.busy = idx;
+        res = &s->view;
+    }
+    xSemaphoreGive(rx.lock);
+    return res;
+}
+
+void emu_rx_done(void) {
+    if (!rx.lock) {return;}
+    xSemaphoreTake(rx.lock, portMAX_DELAY);
+    if (rx.busy < 0) {
+        xSemaphoreGive(rx.lock);
+        return;
+    }
+    rx_slot_t *s = &rx.slots[rx.busy];
+    rx.busy = -1;
+    s->state = RX_FREE;
+    bool sequenced = s->sequenced;
+    if (sequenced && !s->stale && s->seq == rx.next) {rx.next++;}
+    uint16_t next = rx.next;
+    xSemaphoreGive(rx.lock);
+
+    if (!sequenced) {
+        static const uint8_t ready = EMU_RX_READY;
+        if (rx.notify) {rx.notify(&ready, sizeof(ready));}
+        return;
+    }
+    _reply(EMU_RX_ACK, next);
+}
@@ -0,0 +1,233 @@
+#include "emu_sched.h"
+#include "emu_loop.h"
+#include "emu_logging.h"
+#include "emu_blocks.h"
+#include "blocks_functions_list.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = __FILE_NAME__;
+
+#define SCHED_REF_OWNER  0x01 /*instance is block output*/
+#define SCHED_REF_WRITER 0x02 /*block writes instance through input*/
+#define SCHED_REF_READER 0x04 /*instance is trigger input of block*/
+
+/**
+ * @brief One block <-> instance reference, used only while building
+ */
+typedef struct {
+    mem_instance_t *inst;
+    uint16_t block;
+    uint8_t role;
+} sched_ref_t;
+
+static int _ref_cmp(const void *a, const void *b) {
+    const sched_ref_t *ra = a, *rb = b;
+    if (ra->inst != rb->inst) {return ((uintptr_t)ra->inst < (uintptr_t)rb->inst) ? -1 : 1;}
+    return (int)ra->block - (int)rb->block;
+}
+
+static bool _input_is_trigger(block_trigger_t trigger, uint8_t in) {
+    return (trigger == BLOCK_TRIGGER_ALL_INPUTS) || (trigger == BLOCK_TRIGGER_EN && in == 0);
+}
+
+void emu_sched_free(emu_code_handle_t code) {
+    if (!code || !code->sched) {return;}
+    emu_sched_t *s = code->sched;
+    free(s->pending);
+    free(s->pending_next);
+    free(s->always);
+    free(s->inst_blocks);
+    free(s->write_start);
+    free(s->writes);
+    free(s);
+    code->sched = NULL;
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_sched_set_mode
+emu_result_t emu_sched_set_mode(emu_code_handle_t code, emu_exec_mode_t mode) {
+    if (!code) {RET_E(EMU_ERR_NULL_PTR, "No code");}
+    if (mode > EMU_EXEC_DIRTY) {RET_E(EMU_ERR_INVALID_ARG, "Unknown execution mode %d", mode);}
+    code->exec_mode = mode;
+    RET_OK("Execution mode set to %s (applied at loop start)", (mode == EMU_EXEC_DIRTY) ? "dirty" : "full");
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_sched_build
+static emu_result_t _sched_build(emu_code_handle_t code) {
+    const uint16_t blocks = code->total_blocks;
+    sched_ref_t *refs = NULL;
+    mem_instance_t **uniq = NULL;
+    int32_t *uniq_id = NULL;
+    uint32_t *inst_start = NULL;
+    uint32_t *fill = NULL;
+    uint16_t *head = NULL;
+    emu_sched_t *s = NULL;
+
+    //1. collect all references that matter for scheduling
+    uint32_t ref_cnt = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        ref_cnt += block->cfg.q_cnt + __builtin_popcount(block->cfg.in_connceted_mask);
+    }
+    refs = (sched_ref_t*)calloc(ref_cnt ? ref_cnt : 1, sizeof(sched_ref_t));
+    if (!refs) {goto no_mem;}
+
+    uint32_t n = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        const emu_block_sched_info_t *info = &emu_block_sched_table[block->cfg.block_type];
+        for (uint8_t q = 0; q < block->cfg.q_cnt; q++) {
+            refs[n++] = (sched_ref_t){.inst = block->outputs[q]->instance, .block = b, .role = SCHED_REF_OWNER};
+        }
+        for (uint8_t in = 0; in < block->cfg.in_cnt; in++) {
+            if (!((block->cfg.in_connceted_mask >> in) & 1)) {continue;}
+            uint8_t role = 0;
+            if ((info->written_inputs >> in) & 1) {role |= SCHED_REF_WRITER;}
+            if (_input_is_trigger(info->trigger, in)) {role |= SCHED_REF_READER;}
+            if (role) {refs[n++] = (sched_ref_t){.inst = block->inputs[in]->instance, .block = b, .role = role};}
+        }
+    }
+    qsort(refs, n, sizeof(sched_ref_t), _ref_cmp);
+
+    //blocks in chain (FOR) run only inside chain owner, they are scheduled as it
+    head = (uint16_t*)calloc(blocks, sizeof(uint16_t));
+    if (!head) {goto no_mem;}
+    for (uint16_t b = 0; b < blocks; b += code->plan[b].skip) {
+        for (uint16_t c = b; c < b + code->plan[b].skip; c++) {head[c] = b;}
+    }
+
+    //2. unique instances, tracked = clearable and cleared by owner block, rest is sticky
+    uint32_t uniq_cnt = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (i == 0 || refs[i].inst != refs[i-1].inst) {uniq_cnt++;}
+    }
+    uniq = (mem_instance_t**)calloc(uniq_cnt ? uniq_cnt : 1, sizeof(mem_instance_t*));
+    uniq_id = (int32_t*)calloc(uniq_cnt ? uniq_cnt : 1, sizeof(int32_t));
+    s = (emu_sched_t*)calloc(1, sizeof(emu_sched_t));
+    if (!uniq || !uniq_id || !s) {goto no_mem;}
+
+    uint32_t tracked = 0;
+    for (uint32_t i = 0, u = 0; i < n; u++) {
+        uint32_t end = i;
+        bool owned = false;
+        while (end < n && refs[end].inst == refs[i].inst) {
+            if (refs[end].role & SCHED_REF_OWNER) {owned = true;}
+            end++;
+        }
+        uniq[u] = refs[i].inst;
+        uniq_id[u] = (owned && mem_instance_can_clear(refs[i].inst)) ? (int32_t)tracked++ : -1;
+        i = end;
+    }
+
+    //3. blocks executed every cycle
+    s->blocks_cnt = blocks;
+    s->words = (blocks + 31) / 32;
+    s->pending      = (uint32_t*)calloc(s->words, sizeof(uint32_t));
+    s->pending_next = (uint32_t*)calloc(s->words, sizeof(uint32_t));
+    s->always       = (uint32_t*)calloc(s->words, sizeof(uint32_t));
+    if (!s->pending || !s->pending_next || !s->always) {goto no_mem;}
+
+    uint16_t always_cnt = 0;
+    for (uint16_t b = 0; b < blocks; b++) {
+        block_handle_t block = code->blocks_list[b];
+        block_trigger_t trigger = emu_block_sched_table[block->cfg.block_type].trigger;
+        bool always = (trigger == BLOCK_TRIGGER_ALWAYS);
+        if (!always) {
+            //always if every connected trigger input is sticky (no trigger input = never active)
+            uint8_t inputs = 0, sticky = 0;
+            for (uint8_t in = 0; in < block->cfg.in_cnt; in++) {
+                if (!((block->cfg.in_connceted_mask >> in) & 1) || !_input_is_trigger(trigger, in)) {continue;}
+                inputs++;
+                mem_instance_t *inst = block->inputs[in]->instance;
+                uint32_t lo = 0, hi = uniq_cnt;
+                while (lo < hi) {
+                    uint32_t mid = (lo + hi) / 2;
+                    if ((uintptr_t)uniq[mid] < (uintptr_t)inst) {lo = mid + 1;} else {hi = mid;}
+                }
+                if (uniq_id[lo] < 0) {sticky++;}
+            }
+            always = inputs && (inputs == sticky);
+        }
+        if (always && !((s->always[head[b] >> 5] >> (head[b] & 31)) & 1)) {emu_sched_set(s->always, head[b]); always_cnt++;}
+    }
+
+    //4. interested blocks of every tracked instance (readers of not always blocks and owners), sorted by block
+    inst_start = (uint32_t*)calloc(tracked + 1, sizeof(uint32_t));
+    s->inst_blocks = (uint16_t*)calloc(n ? n : 1, sizeof(uint16_t));
+    s->write_start = (uint32_t*)calloc(blocks + 1, sizeof(uint32_t));
+    if (!inst_start || !s->inst_blocks || !s->write_start) {goto no_mem;}
+
+    uint32_t out = 0, writes = 0;
+    for (uint32_t i = 0, u = 0; i < n; u++) {
+        int32_t id = uniq_id[u];
+        mem_instance_t *inst = refs[i].inst;
+        if (id >= 0) {inst_start[id] = out;}
+        for (; i < n && refs[i].inst == inst; i++) {
+            if (id < 0) {continue;}
+            uint16_t b = head[refs[i].block];
+            bool owner = refs[i].role & SCHED_REF_OWNER;
+            bool reader = (refs[i].role & SCHED_REF_READER) && !((s->always[b >> 5] >> (b & 31)) & 1);
+            if ((owner || reader) && (out == inst_start[id] || s->inst_blocks[out - 1] != b)) {s->inst_blocks[out++] = b;}
+            if (refs[i].role & (SCHED_REF_OWNER | SCHED_REF_WRITER)) {s->write_start[refs[i].block + 1]++; writes++;}
+        }
+    }
+    inst_start[tracked] = out;
+
+    //5. instances every block can write
+    for (uint16_t b = 0; b < blocks; b++) {s->write_start[b + 1] += s->write_start[b];}
+    s->writes = (emu_sched_write_t*)calloc(writes ? writes : 1, sizeof(emu_sched_write_t));
+    fill = (uint32_t*)calloc(blocks, sizeof(uint32_t));
+    if (!s->writes || !fill) {goto no_mem;}
+    for (uint32_t i = 0, u = 0; i < n; u++) {
+        int32_t id = uniq_id[u];
+        mem_instance_t *inst = refs[i].inst;
+        mem_flag_ref_t updated = (id >= 0) ? mem_instance_flag_ref(inst) : (mem_flag_ref_t){0};
+        for (; i < n && refs[i].inst == inst; i++) {
+            uint16_t b = refs[i].block;
+            if (id >= 0 && (refs[i].role & (SCHED_REF_OWNER | SCHED_REF_WRITER))) {
+                s->writes[s->write_start[b] + fill[b]++] = (emu_sched_write_t){.updated = updated, .first = inst_start[id], .end = inst_start[id + 1]};
+            }
+        }
+    }
+
+    //first cycle visits everything
+    emu_sched_visit_all(s);
+
+    free(refs);
+    free(uniq);
+    free(uniq_id);
+    free(inst_start);
+    free(fill);
+    free(head);
+    code->sched = s;
+    RET_OK("Dirty mode: %"PRIu16" blocks, %"PRIu16" always, %"PRIu32" tracked instances", blocks, always_cnt, tracked);
+
+no_mem:
+    free(refs);
+    free(uniq);
+    free(uniq_id);
+    free(inst_start);
+    free(fill);
+    free(head);
+    if (s) {
+        code->sched = s;
+        emu_sched_free(code);
+    }
+    RET_E(EMU_ERR_NO_MEM, "No memory for dirty mode graph of %"PRIu16" blocks", blocks);
+}
+
+#undef OWNER
+#define OWNER EMU_OWNER_emu_sched_build
+emu_result_t emu_sched_update(emu_code_handle_t code) {
+    if (!code) {RET_E(EMU_ERR_NULL_PTR, "No code");}
+    if (emu_loop_is_running()) {RET_W(EMU_ERR_DENY, "Loop is running, execution mode graph not changed");}
+
+    emu_sched_free(code);
+    if (code->exec_mode != EMU_EXEC_DIRTY || !code->plan || code->total_blocks == 0) {
+        return EMU_RESULT_OK();
+    }
+    if (emu_loop_classes_active()) {RET_W(EMU_ERR_DENY, "Task classes configured, code runs in full mode");}
+    return _sched_build(code);
+}
@@ -2,7 +2,10 @@
 #include "emu_parse.h"
 #include "emu_helpers.h"
 #include "mem_types.h"
+#include "emu_variables.h"
+#include "emu_packed.h"
 #include "emu_types_info.h"
+#include "emu_loop.h"
 #include "gatt_svc.h"
 
 #define TAG __FILE_NAME__
@@ -22,8 +25,10 @@ typedef struct pub_instance_t{
         uint8_t updated   : 1;  /*Updated flag can be used for block output variables*/
     }head;
     void *data; //instance data pointer
+    mem_flag_ref_t updated_flag; //head.updated is refreshed from it when sending
 
     uint16_t el_cnt; //;for fast data copy, no dims iteration during sending
+    uint16_t data_size; //bytes of data (packed bool array is words)
 
 }pub_instance_t;
 
@@ -64,16 +69,35 @@ struct{
 #define OWNER EMU_OWNER_emu_subscribe_parse_init
 emu_result_t emu_subscribe_parse_init(const uint8_t *packet_data, const uint16_t packet_len, void* nothing){
 
+    if(packet_len < 2) RET_E(EMU_ERR_PACKET_INCOMPLETE, "Packet too short");
     uint16_t sub_list_size = parse_get_u16(packet_data, 0);
-    sub_manager_t.sub_list_max_size = sub_list_size;
+    //init sent again replaces list, loop task reads it while sending
+    if(emu_loop_is_running()) RET_E(EMU_ERR_INVALID_STATE, "Stop loop before subscription init");
+    emu_subscribe_reset();
     sub_manager_t.sub_list = (pub_instance_t *)calloc(sub_list_size, sizeof(pub_instance_t));
+    sub_manager_t.pub_pack = (uint8_t *)calloc(sub_list_size, sizeof(uint8_t));
+    if(sub_list_size && (!sub_manager_t.sub_list || !sub_manager_t.pub_pack)){
+        emu_subscribe_reset();
+        RET_E(EMU_ERR_NO_MEM, "No memory for %"PRIu16" subscriptions", sub_list_size);
+    }
+    sub_manager_t.sub_list_max_size = sub_list_size;
+    sub_manager_t.pub_pack_max_size = sub_list_size;
+    RET_OK("Initialized with max size: %"PRIu16"", sub_list_size);
+}
 
-    sub_manager_t.pub_pack_max_size =sub_list_size;
-    sub_manager_t.pub_pack = (uint8_t *)calloc(sub_manager_t.pub_pack_max_size, sizeof(uint8_t));
-
+#undef OWNER
+#define OWNER EMU_OWNER_emu_subscribe_reset
+emu_result_t emu_subscribe_reset(){
+    //entries point into context heaps and flag bitmaps, they go away with contexts
+    free(sub_manager_t.sub_list);
+    free(sub_manager_t.pub_pack);
+    sub_manager_t.sub_list = NULL;
+    sub_manager_t.pub_pack = NULL;
+    sub_manager_t.sub_list_max_size = 0;
+    sub_manager_t.pub_pack_max_size = 0;
     sub_manager_t.next_free_sub_idx = 0;
     sub_manager_t.pub_pack_size = 0;
-    RET_OK("Initialized with max size: %"PRIu16"", sub_list_size);
+    return EMU_RESULT_OK();
 }
 
 #undef OWNER
@@ -101,8 +125,10 @@ emu_result_t emu_subscribe_parse_register(const uint8_t *packet_data, const uint
         sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].head.inst_idx = inst_idx;
         sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].head.context = ctx;
         sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].head.type = type;
-        sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].head.updated = mem_contexts[ctx].types[type].instances[inst_idx].updated;
+        sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].updated_flag = mem_type_flag_ref(&mem_contexts[ctx].types[type], inst_idx);
+        sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].head.updated = mem_flag_get(sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].updated_flag);
         sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].el_cnt = el_cnt; 
+        sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].data_size = mem_instance_data_size(&mem_contexts[ctx].types[type].instances[inst_idx]);
         sub_manager_t.sub_list[sub_manager_t.next_free_sub_idx].data = mem_contexts[ctx].types[type].instances[inst_idx].data.raw;
     
         payload += 3;
@@ -126,7 +152,7 @@ emu_result_t emu_subscribe_process()
         size_t total_size = 0;
         while(total_size < PKT_BUFF_SIZE-1 && i < sub_manager_t.next_free_sub_idx)
         {
-            size_t next_size  = sizeof(((pub_instance_t *)0)->head) + sizeof(uint16_t) + sub_manager_t.sub_list[i].el_cnt * MEM_TYPE_SIZES[sub_manager_t.sub_list[i].head.type];
+            size_t next_size  = sizeof(((pub_instance_t *)0)->head) + sizeof(uint16_t) + sub_manager_t.sub_list[i].data_size;
             if(next_size> PKT_BUFF_SIZE-1) {
                 REP_W(EMU_LOG_to_large_to_sub, "Instance data to large for single packet %"PRIu16"", sub_manager_t.sub_list[i].el_cnt);
             }
@@ -155,12 +181,13 @@ emu_result_t emu_subscribe_send(){
     for(int packet = 0; packet < sub_manager_t.pub_pack_size; packet++){
         sub_manager_t.packet_buff[0] = PACKET_H_PUBLISH;
         while(instance < sub_manager_t.pub_pack[packet]){ //config.pub_pack[0] - ilosc pakietow do wyslania
+            sub_manager_t.sub_list[instance].head.updated = mem_flag_get(sub_manager_t.sub_list[instance].updated_flag);
             memcpy(sub_manager_t.packet_buff+offset, &sub_manager_t.sub_list[instance].head, sizeof(((pub_instance_t *)0)->head));
             offset+= sizeof(((pub_instance_t *)0)->head);
             memcpy(sub_manager_t.packet_buff+offset, &sub_manager_t.sub_list[instance].el_cnt, sizeof(uint16_t));
             offset+= sizeof(uint16_t);
-            memcpy(sub_manager_t.packet_buff+offset, sub_manager_t.sub_list[instance].data, sub_manager_t.sub_list[instance].el_cnt * MEM_TYPE_SIZES[sub_manager_t.sub_list[instance].head.type]);
-            offset+= sub_manager_t.sub_list[instance].el_cnt * MEM_TYPE_SIZES[sub_manager_t.sub_list[instance].head.type];
+            memcpy(sub_manager_t.packet_buff+offset, sub_manager_t.sub_list[instance].data, sub_manager_t.sub_list[instance].data_size);
+            offset+= sub_manager_t.sub_list[instance].data_size;
             instance++;
         }
         //send buff with offset length
@@ -7,18 +7,20 @@ const uint8_t MEM_TYPE_SIZES[DATA_TYPES_CNT] = {
     sizeof(uint32_t), // UI32
     sizeof(int16_t),  // I16
     sizeof(int32_t),  // I32
+    sizeof(bool),     // B
     sizeof(float),    // F
-    sizeof(bool)      // B
+    sizeof(int32_t)   // Q
 };
 
-const char *MEM_TYPES_TO_STR[7] = {
+const char *MEM_TYPES_TO_STR[DATA_TYPES_CNT] = {
     "MEM_U8",
     "MEM_U16",
     "MEM_U32",
     "MEM_I16",
     "MEM_I32",
+    "MEM_B",
     "MEM_F",
-    "MEM_B"
+    "MEM_Q"
 };
 
 // ;--; idk
@@ -169,6 +171,30 @@ const char* EMU_OWNER_TO_STR(emu_owner_t owner) {
         case EMU_OWNER_emu_subscribe_process: return "subscribe_process";
         case EMU_OWNER_emu_subscribe_reset: return "subscribe_reset";
         case EMU_OWNER_emu_subscribe_send: return "subscribe_send";
+        case EMU_OWNER_emu_profiler_start: return "profiler_start";
+        case EMU_OWNER_emu_profiler_send: return "profiler_send";
+        case EMU_OWNER_emu_loop_stats_send: return "loop_stats_send";
+        case EMU_OWNER_emu_sched_set_mode: return "sched_set_mode";
+        case EMU_OWNER_emu_sched_build: return "sched_build";
+        case EMU_OWNER_emu_code_compile: return "code_compile";
+        case EMU_OWNER_emu_partition_worker_init: return "partition_worker_init";
+        case EMU_OWNER_emu_partition_build: return "partition_build";
+        case EMU_OWNER_emu_loop_parse_cfg: return "loop_parse_cfg";
+        case EMU_OWNER_emu_loop_classes_apply: return "loop_classes_apply";
+        case EMU_OWNER_emu_logger: return "logger";
+        case EMU_OWNER_emu_arena_init: return "arena_init";
+        case EMU_OWNER_emu_operands_build: return "operands_build";
+        case EMU_OWNER_mem_packed_op: return "packed_op";
+        case EMU_OWNER_mem_get_span: return "mem_get_span";
+        case EMU_OWNER_emu_image_save: return "emu_image_save";
+        case EMU_OWNER_emu_image_erase: return "emu_image_erase";
+        case EMU_OWNER_emu_image_boot: return "emu_image_boot";
+        case EMU_OWNER_emu_image_upload: return "emu_image_upload";
+        case EMU_OWNER_emu_image_upload_run: return "emu_image_upload_run";
+        case EMU_OWNER_emu_retain_init: return "emu_retain_init";
+        case EMU_OWNER_emu_retain_start: return "emu_retain_start";
+        case EMU_OWNER_emu_retain_flush: return "emu_retain_flush";
+        case EMU_OWNER_emu_interface_frames: return "emu_interface_frames";
         default: return "UNKNOWN_OWNER";
     }
 }
@@ -245,6 +271,8 @@ const char* EMU_LOG_TO_STR(emu_log_t log) {
         case EMU_LOG_clock_out_active: return "clock_out_active";
         case EMU_LOG_clock_out_inactive: return "clock_out_inactive";
         case EMU_LOG_to_large_to_sub: return "to_large_to_sub";
+        case EMU_LOG_error_logs_dropped: return "error_logs_dropped";
+        case EMU_LOG_status_logs_dropped: return "status_logs_dropped";
         default: return "UNKNOWN_LOG";
     }
 }
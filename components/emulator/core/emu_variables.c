@@ -2,6 +2,8 @@
 #include "emu_logging.h"
 #include <string.h>
 #include "emu_helpers.h"
+#include "emu_arena.h"
+#include "emu_packed.h"
 
 static const char *TAG = __FILE_NAME__;
 
@@ -15,44 +17,75 @@ typedef struct {
     uint16_t max_dims[MEM_TYPES_COUNT];       /*Sum of dimensions for every non scalar instance dims>0*/
 } mem_ctx_config_t;
 
-// CTX ID (uint8_t) + TYPES CNT (9)* mem_ctx_config_t members
-#define CTX_CFG_PACKET_SIZE  sizeof(uint8_t)+MEM_TYPES_COUNT*(sizeof(uint32_t) + sizeof(uint16_t)+ sizeof(uint16_t))
+// CTX ID (uint8_t) + TYPES CNT * mem_ctx_config_t members
+#define CTX_CFG_PACKET_SIZE(types_cnt)  (sizeof(uint8_t)+(types_cnt)*(sizeof(uint32_t) + sizeof(uint16_t)+ sizeof(uint16_t)))
+// Hosts older than MEM_Q send config of first 7 types only
+#define CTX_CFG_LEGACY_TYPES_CNT  (MEM_Q)
+
+#define CTX_PART_SIZE(cnt, el_size) __builtin_align_up((size_t)(cnt) * (el_size), EMU_ARENA_ALIGN)
 
 #undef OWNER
 #define OWNER EMU_OWNER_mem_context_delete
 void mem_context_delete(uint8_t ctx_id){
     if (ctx_id >= MAX_CONTEXTS) {REP_WD(EMU_ERR_CTX_INVALID_ID, ctx_id, 0, "Invalid Context ID %d", ctx_id);}
-    //get selected context
-    mem_context_t* ctx = &mem_contexts[ctx_id];
-    for (uint8_t i = 0; i < MEM_TYPES_COUNT; i++) {
-        //for each type struct perform cleanup
-        type_manager_t* mgr = &ctx->types[i];
+    //space of context stays in arena until emu_arena_reset (ORD_RESET_ALL)
+    memset(&mem_contexts[ctx_id], 0, sizeof(mem_context_t));
+    is_ctx_allocated[ctx_id] = 0;
+    REP_OKD(ctx_id, "Context %d destroyed/cleaned", ctx_id);
 
-        if (mgr->data_heap.raw != NULL) {
-            free(mgr->data_heap.raw);
-            mgr->data_heap.raw = NULL;
-        }
-        mgr->data_heap_cap   = 0;
-        mgr->data_heap_cursor = 0;
+}
 
-        if (mgr->instances != NULL) {
-            free(mgr->instances);
-            mgr->instances = NULL;
-        }
-        mgr->instances_cap   = 0;
-        mgr->instances_cursor = 0;
+void mem_contexts_reset_all(void){
+    memset(mem_contexts, 0, sizeof(mem_contexts));
+    memset(is_ctx_allocated, 0, sizeof(is_ctx_allocated));
+    emu_arena_reset();
+}
 
-        if (mgr->dims_pool != NULL) {
-            free(mgr->dims_pool);
-            mgr->dims_pool = NULL;
+static bool _instance_slot(const mem_instance_t *inst, const type_manager_t **mgr_out, uint16_t *idx_out){
+    //fast guess from instance itself, it is wrong only for instance that holds copy of other one
+    if (inst->context < MAX_CONTEXTS) {
+        const type_manager_t *mgr = &mem_contexts[inst->context].types[inst->type % MEM_TYPES_COUNT];
+        if (mgr->instances && inst >= mgr->instances && inst < mgr->instances + mgr->instances_cursor) {
+            *mgr_out = mgr;
+            *idx_out = inst - mgr->instances;
+            return true;
+        }
+    }
+    for (uint8_t c = 0; c < MAX_CONTEXTS; c++) {
+        for (uint8_t t = 0; t < MEM_TYPES_COUNT; t++) {
+            const type_manager_t *mgr = &mem_contexts[c].types[t];
+            if (mgr->instances && inst >= mgr->instances && inst < mgr->instances + mgr->instances_cursor) {
+                *mgr_out = mgr;
+                *idx_out = inst - mgr->instances;
+                return true;
+            }
         }
-        mgr->dims_cursor = 0;
-        mgr->dims_cap =0;
     }
+    return false;
+}
 
-    is_ctx_allocated[ctx_id] = 0;
-    REP_OKD(ctx_id, "Context %d destroyed/cleaned", ctx_id);
+mem_flag_ref_t mem_instance_flag_ref(const mem_instance_t *inst){
+    const type_manager_t *mgr;
+    uint16_t idx;
+    if (!inst || !_instance_slot(inst, &mgr, &idx)) {return (mem_flag_ref_t){0};}
+    return mem_type_flag_ref(mgr, idx);
+}
 
+bool mem_instance_can_clear(const mem_instance_t *inst){
+    const type_manager_t *mgr;
+    uint16_t idx;
+    if (!inst || !_instance_slot(inst, &mgr, &idx)) {return false;}
+    return (mgr->clear_bits[idx >> 5] >> (idx & 31)) & 1;
+}
+
+void mem_context_clear_updated(uint8_t ctx_id){
+    if (ctx_id >= MAX_CONTEXTS || !is_ctx_allocated[ctx_id]) {return;}
+    for (uint8_t t = 0; t < MEM_TYPES_COUNT; t++) {
+        type_manager_t *mgr = &mem_contexts[ctx_id].types[t];
+        for (uint32_t w = 0; w < MEM_FLAG_WORDS(mgr->instances_cursor); w++) {
+            mgr->updated_bits[w] &= ~mgr->clear_bits[w];
+        }
+    }
 }
 
 
@@ -65,40 +98,54 @@ emu_result_t mem_context_allocate(uint8_t ctx_id, const mem_ctx_config_t* config
         return EMU_RESULT_OK();
     }
     mem_context_t* ctx = &mem_contexts[ctx_id];
-    //for each type create space of provided size
+
+    //whole context is one arena block, heaps / instances / dims of every type are carved from it
+    size_t total = 0;
     for (uint8_t i = 0; i < MEM_TYPES_COUNT; i++) {
+        total += CTX_PART_SIZE(config->heap_elements[i], MEM_TYPE_SIZES[i]);
+        total += CTX_PART_SIZE(config->max_instances[i], sizeof(mem_instance_t));
+        total += CTX_PART_SIZE(config->max_dims[i], sizeof(uint16_t));
+        total += 2 * CTX_PART_SIZE(MEM_FLAG_WORDS(config->max_instances[i]), sizeof(uint32_t));
+    }
+    uint8_t *space = total ? (uint8_t*)emu_arena_alloc(EMU_ARENA_CONTEXTS, total) : NULL;
+    if (total && !space) {RET_ED(EMU_ERR_NO_MEM, ctx_id, 0, "falied to create space context id %d (%zu bytes)", ctx_id, total);}
+
+    for (uint8_t i = 0; i < MEM_TYPES_COUNT; i++) {
+        type_manager_t* mgr = &ctx->types[i];
+        memset(mgr, 0, sizeof(type_manager_t));
 
         if(config->heap_elements[i]){
-            ctx->types[i].data_heap.raw = calloc(config->heap_elements[i], MEM_TYPE_SIZES[i]);
-            ctx->types[i].data_heap_cap = config->heap_elements[i];
-            if(!ctx->types[i].data_heap.raw ){goto ERROR;}
+            mgr->data_heap.raw = space;
+            mgr->data_heap_cap = config->heap_elements[i];
+            space += CTX_PART_SIZE(config->heap_elements[i], MEM_TYPE_SIZES[i]);
         }
         if(config->max_instances[i]){
-            ctx->types[i].instances  = (mem_instance_t*)calloc(config->max_instances[i], sizeof(mem_instance_t));
-            ctx->types[i].instances_cap = config->max_instances[i];
-            if(!ctx->types[i].instances){goto ERROR;}
+            mgr->instances = (mem_instance_t*)space;
+            mgr->instances_cap = config->max_instances[i];
+            space += CTX_PART_SIZE(config->max_instances[i], sizeof(mem_instance_t));
+            mgr->updated_bits = (uint32_t*)space;
+            space += CTX_PART_SIZE(MEM_FLAG_WORDS(config->max_instances[i]), sizeof(uint32_t));
+            mgr->clear_bits = (uint32_t*)space;
+            space += CTX_PART_SIZE(MEM_FLAG_WORDS(config->max_instances[i]), sizeof(uint32_t));
         }
         if(config->max_dims[i]){
-            ctx->types[i].dims_pool = (uint16_t*)calloc(config->max_dims[i], sizeof(uint16_t));
-            ctx->types[i].dims_cap = config->max_dims[i];
-            if(!ctx->types[i].dims_pool){goto ERROR;}
+            mgr->dims_pool = (uint16_t*)space;
+            mgr->dims_cap = config->max_dims[i];
+            space += CTX_PART_SIZE(config->max_dims[i], sizeof(uint16_t));
         }
         LOG_I(TAG, "Created: ctx: %d, type: %s, instances: %d, total elements: %ld, total dims: %d", ctx_id, MEM_TYPES_TO_STR[i], config->max_instances[i], config->heap_elements[i], config->max_dims[i]);
     }
     //mark that context is created
     is_ctx_allocated[ctx_id] = 1;
     RET_OKD(ctx_id, "context %d created", ctx_id);
-
-    //in case of any calloc error delete context 
-    ERROR:
-    mem_context_delete(ctx_id);
-    RET_ED(EMU_ERR_NO_MEM, ctx_id, 0, "falied to create space context id %d", ctx_id);
 }
 
 
 //Instances indices are determined by packet order 
-static emu_err_t context_create_instance(uint8_t ctx_id, uint8_t type, uint8_t dims_cnt, uint16_t* dims_size, bool can_clear){
+static emu_err_t context_create_instance(uint8_t ctx_id, uint8_t type, uint8_t dims_cnt, uint16_t* dims_size, bool can_clear, bool packed, bool retain){
     if(type>MEM_TYPES_COUNT || dims_cnt>MAX_DIMS){return EMU_ERR_INVALID_ARG;}
+    //only bool arrays can be packed
+    if(packed && (type != MEM_B || dims_cnt == 0)){return EMU_ERR_INVALID_ARG;}
     if(!is_ctx_allocated[ctx_id]){return EMU_ERR_CTX_INVALID_ID;}
     mem_context_t* ctx = &mem_contexts[ctx_id];
     type_manager_t* mgr = &ctx->types[type];
@@ -107,25 +154,37 @@ static emu_err_t context_create_instance(uint8_t ctx_id, uint8_t type, uint8_t d
     uint32_t total_size = 1;
     for(uint8_t i = 0; i<dims_cnt; i++){total_size *= dims_size[i];}
 
+    //packed array is whole words (MEM_B heap is counted in bytes), starting at word boundary
+    uint32_t heap_start = mgr->data_heap_cursor;
+    if(packed){
+        heap_start = __builtin_align_up(heap_start, sizeof(uint32_t));
+        total_size = MEM_PACKED_WORDS(total_size) * sizeof(uint32_t);
+    }
+
     //check is there space (should be but who knows)
-    if(mgr->data_heap_cursor+total_size > mgr->data_heap_cap) {return EMU_ERR_NO_MEM;}
+    if(heap_start+total_size > mgr->data_heap_cap) {return EMU_ERR_NO_MEM;}
     if(mgr->instances_cursor==mgr->instances_cap){return EMU_ERR_NO_MEM;}
     if (mgr->dims_cursor + dims_cnt > mgr->dims_cap) { return EMU_ERR_NO_MEM; }
 
     
 
-    mem_instance_t *instance = &mgr->instances[mgr->instances_cursor];
+    uint16_t inst_idx = mgr->instances_cursor;
+    mem_instance_t *instance = &mgr->instances[inst_idx];
     mgr->instances_cursor++;
 
     instance->dims_cnt = dims_cnt;
     instance->context = ctx_id;
     instance->type = type;
+    instance->packed = packed;
+    instance->retain = retain;
+    //not clearable instance is updated from start
+    mem_flag_ref_t flag = mem_type_flag_ref(mgr, inst_idx);
     if (can_clear){
-        instance->updated   = 0;
-        instance->can_clear = 1;
+        mgr->clear_bits[inst_idx >> 5] |= flag.mask;
+        mem_flag_clear(flag);
     }else{
-        instance->updated   = 1;
-        instance->can_clear = 0;
+        mgr->clear_bits[inst_idx >> 5] &= ~flag.mask;
+        mem_flag_set(flag);
     }
     
     instance->dims_idx = mgr->dims_cursor;
@@ -134,10 +193,10 @@ static emu_err_t context_create_instance(uint8_t ctx_id, uint8_t type, uint8_t d
     mgr->dims_cursor += dims_cnt;
 
     uint8_t* base_addr = (uint8_t*)mgr->data_heap.raw;
-    uint32_t byte_offset = mgr->data_heap_cursor * MEM_TYPE_SIZES[type];
+    uint32_t byte_offset = heap_start * MEM_TYPE_SIZES[type];
 
     instance->data.raw = (void*)(base_addr + byte_offset);
-    mgr->data_heap_cursor += total_size;
+    mgr->data_heap_cursor = heap_start + total_size;
     return EMU_OK;
 }
 
@@ -150,7 +209,9 @@ typedef struct __packed {
     uint16_t type      : 4;
     uint16_t updated   : 1;
     uint16_t can_clear : 1;
-    uint16_t reserved  : 3;
+    uint16_t packed    : 1; /*MEM_B array 1 bit per element*/
+    uint16_t retain    : 1; /*value kept in NVS, restored at loop start*/
+    uint16_t reserved  : 1;
 }instance_head_t;
 
 
@@ -187,7 +248,9 @@ emu_result_t emu_mem_parse_instance_packet(const uint8_t *data,const uint16_t pa
             head.type, 
             head.dims_cnt, 
             dim_sizes, 
-            head.can_clear
+            head.can_clear,
+            head.packed,
+            head.retain
         );
         LOG_I(TAG, "Created instance in ctx %d, type %s, dims cnt %d", head.context, MEM_TYPES_TO_STR[head.type], head.dims_cnt);
         if(err != EMU_OK){RET_ED(err, 0, 1, "While creating instance error: %s", EMU_ERR_TO_STR(err));}
@@ -198,18 +261,19 @@ emu_result_t emu_mem_parse_instance_packet(const uint8_t *data,const uint16_t pa
 }
 
 
-#define CTX_CFG_PACKET_SIZE  sizeof(uint8_t)+MEM_TYPES_COUNT*(sizeof(uint32_t) + sizeof(uint16_t)+ sizeof(uint16_t))
-
 #undef OWNER
 #define OWNER EMU_OWNER_emu_mem_parse_create_context
 emu_result_t emu_mem_parse_create_context(const uint8_t *data,const uint16_t packet_length, void *nothing){
-    if (packet_length != CTX_CFG_PACKET_SIZE){RET_E(EMU_ERR_INVALID_PACKET_SIZE, "Invalid packet size for ctx config");}
+    uint8_t types_cnt;
+    if (packet_length == CTX_CFG_PACKET_SIZE(MEM_TYPES_COUNT)) {types_cnt = MEM_TYPES_COUNT;}
+    else if (packet_length == CTX_CFG_PACKET_SIZE(CTX_CFG_LEGACY_TYPES_CNT)) {types_cnt = CTX_CFG_LEGACY_TYPES_CNT;}
+    else {RET_E(EMU_ERR_INVALID_PACKET_SIZE, "Invalid packet size for ctx config");}
 
     mem_ctx_config_t cfg = {0};
     uint16_t idx = 0;
     uint8_t ctx_id = data[idx++];
-    //get info from packet into helper struct 
-    for(uint8_t i = 0; i<MEM_TYPES_COUNT; i++){
+    //get info from packet into helper struct, types not sent stay empty
+    for(uint8_t i = 0; i<types_cnt; i++){
         cfg.heap_elements[i]=parse_get_u32(data, idx);
         idx+= sizeof(uint32_t);
         cfg.max_instances[i]=parse_get_u16(data, idx);
@@ -247,7 +311,7 @@ emu_result_t emu_mem_fill_instance_scalar(const uint8_t* data, const uint16_t pa
 
         memcpy(instance->data.raw, data + idx, el_size);
         idx += el_size;
-        instance->updated = 1;
+        mem_flag_set(mem_type_flag_ref(mgr, inst_idx));
         LOG_I(TAG, "Filled scalar instance %d in ctx %d of type %s", inst_idx, ctx_id, MEM_TYPES_TO_STR[type]);
     }
     return EMU_RESULT_OK();
@@ -279,10 +343,11 @@ emu_result_t emu_mem_fill_instance_array(const uint8_t* data, const uint16_t pac
         uint16_t items = parse_get_u16(data, idx);
         idx += sizeof(uint16_t);
 
-        //copy required size into instance data 
-        memcpy(instance->data.u8 + start_idx*el_size, data + idx, items*el_size);
+        //copy required size into instance data (packed array gets 1 byte per element too)
+        if (instance->packed) {mem_packed_from_bytes(instance, start_idx, data + idx, items);}
+        else {memcpy(instance->data.u8 + start_idx*el_size, data + idx, items*el_size);}
         idx += items*el_size;
-        instance->updated = 1; 
+        mem_flag_set(mem_type_flag_ref(mgr, inst_idx));
         LOG_I(TAG, "Filled array instance %d in ctx %d of type %s, items %d from index %d", inst_idx, ctx_id, MEM_TYPES_TO_STR[type], items, start_idx);
     }
     return EMU_RESULT_OK();
@@ -308,7 +373,7 @@ emu_err_t emu_mem_fill_instance_scalar_fast(const uint8_t* data) {
         memcpy(inst->data.raw, data + idx, el_size);
         
         idx += el_size;
-        inst->updated = 1;
+        mem_flag_set(mem_type_flag_ref(mgr, inst_idx));
     }
     return EMU_OK;
 }
@@ -336,12 +401,15 @@ emu_err_t emu_mem_fill_instance_array_fast(const uint8_t* data) {
         if (inst_idx >= max_inst) {return EMU_ERR_MEM_INVALID_IDX;}
 
         mem_instance_t* inst = &mgr->instances[inst_idx];
-        uint8_t* dst = inst->data.u8 + (start_idx * el_size);
-        
-        memcpy(dst, data + idx, payload_bytes);
+        if (inst->packed) {
+            mem_packed_from_bytes(inst, start_idx, data + idx, items);
+        } else {
+            uint8_t* dst = inst->data.u8 + (start_idx * el_size);
+            memcpy(dst, data + idx, payload_bytes);
+        }
         
         idx += payload_bytes;
-        inst->updated = 1;
+        mem_flag_set(mem_type_flag_ref(mgr, inst_idx));
     }
     return EMU_OK;
 }
@@ -3,54 +3,56 @@
 #include "emu_helpers.h"
 #include "emu_variables.h"
 #include "emu_variables_acces.h"
+#include "emu_arena.h"
+#include "emu_packed.h"
+#include "emu_operands.h"
 #include "string.h"
 static const char* TAG = __FILE_NAME__;
 
 /******************************************************************************************************************************
- * Slab alocator is common for all mem_access_t struct among code,
+ * mem_access_t nodes are taken from program arena (EMU_ARENA_ACCESS region, emu_arena.h) and released with code,
  * total_indices describe extra indices used to fetch value from table
  * 
  * 
  *****************************************************************************************************************************/
 
-static struct{
-    uint8_t* data_slab;
-    uint32_t capacity;
-    uint32_t next_addr;
-    bool created;
-}mem_access_data;
-
 #define PKT_ACCES_DATA_SIZE 2*sizeof(uint16_t)
 
-void mem_access_free_space(void){
-    if (mem_access_data.data_slab) {free(mem_access_data.data_slab);}
-    mem_access_data.data_slab = NULL;
-    mem_access_data.created = 0;
-    mem_access_data.capacity =0;
-    mem_access_data.next_addr=0;
-}
-
 #undef OWNER
 #define OWNER EMU_OWNER_mem_access_allocate_space
 emu_result_t mem_access_allocate_space(uint16_t references_count, uint16_t total_indices){
-    uint32_t total_bytes = (references_count* __builtin_align_up(sizeof(mem_access_t),4)) + (total_indices*sizeof(uint32_t));
-    if (mem_access_data.created) {mem_access_free_space();}
-    mem_access_data.data_slab = (uint8_t*)calloc(total_bytes, sizeof(uint8_t));
-    if (!mem_access_data.data_slab){RET_E(EMU_ERR_NO_MEM, "Not enough space for all references");}
-    mem_access_data.created = 1;
-    mem_access_data.capacity = references_count;
+    //nodes are allocated one by one, only check that announced references fit
+    size_t total_bytes = (references_count* __builtin_align_up(sizeof(mem_access_t), EMU_ARENA_ALIGN)) + (total_indices*sizeof(idx_val_t));
+    emu_arena_stats_t stats;
+    emu_arena_get_stats(&stats);
+    if (total_bytes > stats.free){RET_E(EMU_ERR_NO_MEM, "Not enough space for all references (%zu bytes, %zu free)", total_bytes, stats.free);}
     return EMU_RESULT_OK();
 }
 
-mem_access_t* mem_access_new(uint8_t extra_indices){
-    if (!mem_access_data.created) return NULL;
-    //we calculate for ptr but can use space for normal "values"
-    uint8_t size_to_take = sizeof(mem_access_t)+extra_indices*sizeof(mem_access_t*);
-    uint8_t size_aligned = __builtin_align_up(size_to_take, 4);
-    if(size_aligned + mem_access_data.next_addr > mem_access_data.capacity){return NULL;}
-    mem_access_t* tmp = (mem_access_t*)&mem_access_data.data_slab[mem_access_data.next_addr];
-    mem_access_data.next_addr += size_aligned;
-    return tmp;
+mem_access_t* mem_access_new(uint8_t extra_indices, bool index_cache, bool slice){
+    //we calculate for ptr but can use space for normal "values", dynamic access keeps its index cache after indices, span access its slice after that
+    size_t size = sizeof(mem_access_t) + extra_indices*sizeof(idx_val_t) + (index_cache ? sizeof(mem_index_cache_t) : 0) + (slice ? sizeof(mem_slice_t) : 0);
+    return (mem_access_t*)emu_arena_alloc(EMU_ARENA_ACCESS, size);
+}
+
+static __always_inline uint32_t _geometry_key(const mem_instance_t *instance){
+    return ((uint32_t)instance->dims_idx << 7) | ((uint32_t)instance->type << 3) | instance->context;
+}
+
+/**
+ * @brief Take dims and strides of current instance into index cache, drops memoized offset
+ */
+static void _index_cache_geometry(mem_index_cache_t *cache, const mem_access_t *access){
+    const mem_instance_t *instance = access->instance;
+    const uint16_t *pool = mem_contexts[instance->context].types[instance->type].dims_pool;
+    uint16_t stride = 1;
+    for (int8_t i = access->indices_cnt - 1; i >= 0; i--) {
+        cache->dims[i] = pool ? pool[instance->dims_idx + i] : 0; /*no dims in context, every index is out of bounds*/
+        cache->strides[i] = stride;
+        stride *= cache->dims[i];
+    }
+    cache->geometry = _geometry_key(instance);
+    cache->valid = 0;
 }
 
 
@@ -69,7 +71,8 @@ typedef struct __packed{
     uint8_t  is_index_resolved:1;
     uint8_t  dims_cnt   :3;
     uint8_t  idx_type   :3;
-    uint8_t  reserved   :2; 
+    uint8_t  whole_array:1; /*span access, indices followed by [slice_dim:u8][count:u16]*/
+    uint8_t  reserved   :1; 
     uint16_t instance_idx;
 }access_packet;
 
@@ -83,8 +86,12 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
     memcpy(&head, data + *idx, sizeof(access_packet));
     *idx += sizeof(access_packet);
 
+    if (head.dims_cnt > MAX_DIMS) return EMU_ERR_MEM_INVALID_IDX;
+    if (head.whole_array && head.dims_cnt == 0) return EMU_ERR_MEM_INVALID_IDX;
+    bool all_static = ((head.idx_type & ((1u << head.dims_cnt) - 1)) == ((1u << head.dims_cnt) - 1));
+
     // 3. Allocate this Node
-    mem_access_t* me = mem_access_new(head.dims_cnt);
+    mem_access_t* me = mem_access_new(head.dims_cnt, !all_static, head.whole_array);
     if (!me) return EMU_ERR_NO_MEM;
 
     // Link Target (Look up the actual instance pointer from global context)
@@ -101,8 +108,6 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
     }
 
     // 5. Recursive Case: Array Access
-    bool all_static = true;
-
     for (uint8_t i = 0; i < head.dims_cnt; i++) {
         // Check Bitmask: Is this index Static (1) or Dynamic (0)?
         // Note: idx_type is only 3 bits, so this only works for 3 dims!
@@ -114,12 +119,22 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
             *idx += 2;
         } 
         else {
-            all_static = false;
             emu_err_t err = emu_mem_parse_access(data, packet_length, idx, &me->indices_values[i].dynamic_index);
             if (err != EMU_OK) return err;
         }
     }
 
+    uint8_t slice_dim = 0;
+    uint16_t slice_count = 0, slice_stride = 1;
+    if (head.whole_array) {
+        if (*idx + 3 > packet_length) return EMU_ERR_INVALID_PACKET_SIZE;
+        slice_dim = data[*idx];
+        slice_count = parse_get_u16(data, *idx + 1);
+        *idx += 3;
+        if (slice_dim >= head.dims_cnt) return EMU_ERR_MEM_INVALID_IDX;
+        me->whole_array = 1;
+    }
+
     if (all_static) {
         uint32_t final_offset = 0;
         uint32_t stride = 1;
@@ -130,6 +145,11 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
             uint16_t dim_size = mem_contexts[head.ctx_id].types[head.type].dims_pool[me->instance->dims_idx + i];
 
             if (index_val >= dim_size) {return EMU_ERR_MEM_OUT_OF_BOUNDS;}
+            if (head.whole_array && i == slice_dim) {
+                if (slice_count == 0) {slice_count = dim_size - index_val;}
+                if (index_val + slice_count > dim_size) {return EMU_ERR_MEM_OUT_OF_BOUNDS;}
+                slice_stride = stride;
+            }
 
             final_offset += index_val * stride;
             stride *= dim_size; // Accumulate stride for next dimension
@@ -140,6 +160,17 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
     } else {
         me->is_index_resolved = 0;
         me->resolved_index = 0;
+        mem_index_cache_t *cache = mem_access_index_cache(me);
+        _index_cache_geometry(cache, me);
+        for (uint8_t i = 0; i < head.dims_cnt; i++) {
+            cache->last_idx[i] = ((head.idx_type >> i) & 0x01) ? me->indices_values[i].static_index : 0;
+        }
+    }
+    if (head.whole_array) {
+        mem_slice_t *slice = mem_access_slice(me);
+        slice->dim = slice_dim;
+        slice->count = slice_count;
+        slice->stride = slice_stride;
     }
     *out_ptr = me;
     return EMU_OK;
@@ -147,59 +178,85 @@ emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length
 
 #undef OWNER
 #define OWNER EMU_OWNER_mem_get
-emu_result_t mem_get(mem_var_t *result, const mem_access_t *search, bool by_reference){
+/**
+ * @brief Element offset of access in instance data (resolved or computed from dynamic indices)
+ */
+static __always_inline emu_result_t _mem_offset(const mem_access_t *search, uint16_t *el_offset){
     mem_instance_t *instance = search->instance;
-    uint8_t type = instance->type;
-    uint16_t el_offset = 0;
-    
+    *el_offset = 0;
+
     // Fast path: resolved index (scalars or pre-computed arrays)
     if (likely(search->is_index_resolved)) {
-        el_offset = search->resolved_index;
+        *el_offset = search->resolved_index;
     }
 
-    // Slow path: dynamic index resolution
+    // Dynamic indices: offset memoized in index cache, computed again only when some index value changed
     else if (unlikely(search->indices_cnt > 0)) {
+        mem_index_cache_t *cache = mem_access_index_cache(search);
+        //IN_SELECTOR output can get instance of other shape
+        if (unlikely(cache->geometry != _geometry_key(instance))) {_index_cache_geometry(cache, search);}
 
-        uint16_t *dims_pool = mem_contexts[instance->context].types[type].dims_pool;
-        uint16_t dims_base = instance->dims_idx;
-        uint16_t stride = 1; 
-        
-        for (int8_t i = search->indices_cnt - 1; i >= 0; i--) {
-            uint16_t index_val;
-            uint16_t dim_size = dims_pool[dims_base + i];  
-            
-            if((search->is_idx_static_mask >> i) & 0x01){
-                index_val = search->indices_values[i].static_index;
-            }else{
-                mem_var_t v;
-                emu_result_t res = mem_get(&v, search->indices_values[i].dynamic_index, false);
-                if(unlikely(res.code != EMU_OK)){RET_ED(res.code, 0, ++res.depth, "Recursive mem_get failed %s", EMU_ERR_TO_STR(res.code));}
-                index_val = MEM_CAST(v, (uint16_t)0);
+        bool changed = !cache->valid;
+        for (uint8_t i = 0; i < search->indices_cnt; i++) {
+            if ((search->is_idx_static_mask >> i) & 0x01) {continue;}
+            const mem_access_t *index = search->indices_values[i].dynamic_index;
+            mem_var_t v;
+            if (likely(index->is_index_resolved && !index->instance->packed)) {
+                //index variable read in place, any type
+                v.type = index->instance->type;
+                v.by_reference = 1;
+                v.data.ptr.u8 = index->instance->data.u8 + index->resolved_index * MEM_TYPE_SIZES[v.type];
+            } else {
+                emu_result_t res = mem_get(&v, index, false);
+                if (unlikely(res.code != EMU_OK)) {cache->valid = 0; RET_ED(res.code, 0, ++res.depth, "Recursive mem_get failed %s", EMU_ERR_TO_STR(res.code));}
             }
-            
-            if (unlikely(index_val >= dim_size)) {RET_E(EMU_ERR_MEM_OUT_OF_BOUNDS, "Index OOB %d>=%d", index_val, dim_size);}
-            el_offset += index_val * stride;
-            stride *= dim_size;
+            uint16_t index_val = MEM_CAST(v, (uint16_t)0);
+            if (index_val != cache->last_idx[i]) {cache->last_idx[i] = index_val; changed = true;}
         }
+
+        if (unlikely(changed)) {
+            uint16_t offset = 0;
+            cache->valid = 0;
+            for (uint8_t i = 0; i < search->indices_cnt; i++) {
+                if (unlikely(cache->last_idx[i] >= cache->dims[i])) {RET_E(EMU_ERR_MEM_OUT_OF_BOUNDS, "Index OOB %d>=%d", cache->last_idx[i], cache->dims[i]);}
+                offset += cache->last_idx[i] * cache->strides[i];
+            }
+            cache->offset = offset;
+            cache->valid = 1;
+        }
+        *el_offset = cache->offset;
     }
+    return EMU_RESULT_OK();
+}
+
+emu_result_t mem_get(mem_var_t *result, const mem_access_t *search, bool by_reference){
+    mem_instance_t *instance = search->instance;
+    uint8_t type = instance->type;
+    uint16_t el_offset = 0;
+
+    emu_result_t res = _mem_offset(search, &el_offset);
+    if (unlikely(res.code != EMU_OK)) {return res;}
     
     // Build result
     result->type = type;
     
     if(by_reference){
+        //single bit of packed array has no address, write it with mem_set
+        if (unlikely(instance->packed)) {RET_E(EMU_ERR_MEM_INVALID_DATATYPE, "Packed bool element can not be referenced");}
         result->by_reference = true;
         result->data.ptr.u8 = instance->data.u8 + el_offset * MEM_TYPE_SIZES[type];
     }else{
         result->by_reference = false;
         // Direct pointer arithmetic instead of switch for better performance
         switch (type) {
-            case MEM_B:   result->data.val.b   = instance->data.b[el_offset];   break;
+            case MEM_B:   result->data.val.b   = instance->packed ? mem_packed_get(instance, el_offset) : instance->data.b[el_offset]; break;
             case MEM_F:   result->data.val.f   = instance->data.f[el_offset];   break;
             case MEM_U8:  result->data.val.u8  = instance->data.u8[el_offset];  break;
             case MEM_U16: result->data.val.u16 = instance->data.u16[el_offset]; break;
             case MEM_U32: result->data.val.u32 = instance->data.u32[el_offset]; break;
             case MEM_I16: result->data.val.i16 = instance->data.i16[el_offset]; break;
             case MEM_I32: result->data.val.i32 = instance->data.i32[el_offset]; break;
+            case MEM_Q:   result->data.val.q   = instance->data.q[el_offset];   break;
         }
     }
     
@@ -207,6 +264,41 @@ emu_result_t mem_get(mem_var_t *result, const mem_access_t *search, bool by_refe
 }
 
 
+#undef OWNER
+#define OWNER EMU_OWNER_mem_get_span
+emu_result_t mem_get_span(mem_span_t *span, const mem_access_t *access){
+    mem_instance_t *instance = access->instance;
+    //span is addressed by elements, bits of packed array are not
+    if (unlikely(instance->packed)) {RET_E(EMU_ERR_MEM_INVALID_DATATYPE, "Packed bool array has no span");}
+
+    uint16_t el_offset = 0;
+    emu_result_t res = _mem_offset(access, &el_offset);
+    if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, 0, ++res.depth, "Span start not resolved %s", EMU_ERR_TO_STR(res.code));}
+
+    span->type = instance->type;
+    span->data.u8 = instance->data.u8 + el_offset * MEM_TYPE_SIZES[instance->type];
+    span->count = 1;
+    span->stride = 1;
+    if (!access->whole_array) {return EMU_RESULT_OK();}
+
+    const mem_slice_t *slice = mem_access_slice(access);
+    if (likely(access->is_index_resolved)) {
+        //bounds checked at parse
+        span->count = slice->count;
+        span->stride = slice->stride;
+    } else {
+        //start is index value read by _mem_offset, dims of current instance in index cache
+        const mem_index_cache_t *cache = mem_access_index_cache(access);
+        uint16_t start = cache->last_idx[slice->dim];
+        uint16_t dim = cache->dims[slice->dim];
+        span->count = slice->count ? slice->count : dim - start;
+        span->stride = cache->strides[slice->dim];
+        if (unlikely(start + span->count > dim)) {RET_E(EMU_ERR_MEM_OUT_OF_BOUNDS, "Span %d+%d leaves dim %d", start, span->count, dim);}
+    }
+    return EMU_RESULT_OK();
+}
+
+
 /**
  * @brief Sets a value in memory based on a mem_access_t descriptor
  * @param to_set The value to write (variable type)
@@ -216,13 +308,25 @@ emu_result_t mem_get(mem_var_t *result, const mem_access_t *search, bool by_refe
 #define OWNER EMU_OWNER_mem_set
 emu_result_t mem_set(const mem_var_t to_set, const mem_access_t *target) {
     mem_var_t dst;
+
+    // Packed bool array: element is one bit, no reference to it
+    if (unlikely(target->instance->packed)) {
+        uint16_t el_offset;
+        emu_result_t res = _mem_offset(target, &el_offset);
+        if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, 0, ++res.depth, "Failed to resolve target: %s", EMU_ERR_TO_STR(res.code));}
+        mem_flag_ref_t flag = mem_instance_flag_ref(target->instance);
+        if (likely(flag.word)) {mem_flag_set(flag);}
+        mem_packed_put(target->instance, el_offset, MEM_CAST(to_set, (bool)0));
+        return EMU_RESULT_OK();
+    }
     
     // Get target pointer (by_reference=true for direct write)
     emu_result_t res = mem_get(&dst, target, true);
     if (unlikely(res.code != EMU_OK)) {RET_ED(res.code, 0, 0, "Failed to resolve target: %s", EMU_ERR_TO_STR(res.code));}
     
-    // Always mark as updated
-    target->instance->updated = 1;
+    // Always mark as updated (slot lookup, hot paths use flag ref resolved at verify)
+    mem_flag_ref_t flag = mem_instance_flag_ref(target->instance);
+    if (likely(flag.word)) {mem_flag_set(flag);}
     
     // Fast path: matching types - direct copy without conversion
     if (likely(to_set.type == dst.type)) {
@@ -234,37 +338,13 @@ emu_result_t mem_set(const mem_var_t to_set, const mem_access_t *target) {
             case MEM_U32: *dst.data.ptr.u32 = to_set.data.val.u32; return EMU_RESULT_OK();
             case MEM_I16: *dst.data.ptr.i16 = to_set.data.val.i16; return EMU_RESULT_OK();
             case MEM_I32: *dst.data.ptr.i32 = to_set.data.val.i32; return EMU_RESULT_OK();
+            case MEM_Q:   *dst.data.ptr.q   = to_set.data.val.q;   return EMU_RESULT_OK();
         }
     }
     
-    // Slow path: type conversion required
-    float src_val = MEM_CAST(to_set, (float)0);
-    
-    switch (dst.type) {
-        case MEM_U8:  
-            *dst.data.ptr.u8  = CLAMP_CAST(roundf(src_val), 0, UINT8_MAX, uint8_t); 
-            break;
-        case MEM_U16: 
-            *dst.data.ptr.u16 = CLAMP_CAST(roundf(src_val), 0, UINT16_MAX, uint16_t); 
-            break;
-        case MEM_U32: 
-            *dst.data.ptr.u32 = CLAMP_CAST(roundf(src_val), 0, UINT32_MAX, uint32_t); 
-            break;
-        case MEM_I16: 
-            *dst.data.ptr.i16 = CLAMP_CAST(roundf(src_val), INT16_MIN, INT16_MAX, int16_t); 
-            break;
-        case MEM_I32: 
-            *dst.data.ptr.i32 = CLAMP_CAST(roundf(src_val), INT32_MIN, INT32_MAX, int32_t); 
-            break;
-        case MEM_F:   
-            *dst.data.ptr.f   = src_val; 
-            break;
-        case MEM_B:   
-            *dst.data.ptr.b   = (src_val != 0.0f); 
-            break;
-        default: 
-            RET_E(EMU_ERR_MEM_INVALID_DATATYPE, "Invalid Destination Type %d", dst.type);
-    }
+    // Slow path: type conversion required, kernel converts like MEM_CAST (integers and Q16.16 without float)
+    if (unlikely(to_set.type >= MEM_TYPES_COUNT || dst.type >= MEM_TYPES_COUNT)) {RET_E(EMU_ERR_MEM_INVALID_DATATYPE, "Invalid type %d -> %d", to_set.type, dst.type);}
+    emu_conv_kernels[to_set.type][dst.type](dst.data.ptr.raw, &to_set.data.val);
     
     return EMU_RESULT_OK();
 }
@@ -8,6 +8,7 @@ typedef struct{
     mem_access_t **inputs; /*Instances to use*/
     mem_access_t **outputs; /*Instances to store result*/
     void *custom_data; /*block specific data*/
+    struct emu_operand_s *ops; /*inputs then outputs resolved at verify (emu_operands.h)*/
     __packed struct {
         uint16_t block_idx; /*index of block in code*/
         uint16_t in_connceted_mask; /*connected inputs (those that have instance)*/
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "error_types.h"
+#include "emu_buffs.h"
+
+/*************************************************************************************************************************************************************************
+Program arena
+
+One data_pool_t created once at interface start (EMU_ARENA_SIZE) and never freed, so uploading new code again and again does not fragment heap.
+Everything that lives as long as uploaded program is taken from it:
+    - EMU_ARENA_CONTEXTS  context data heaps, instances and dims (bottom end), released by ORD_RESET_ALL
+    - EMU_ARENA_ACCESS    mem_access_t nodes (top end), released with code
+    - EMU_ARENA_BLOCKS    block list, inputs/outputs tables, block custom data (top end), released with code
+
+Code (ORD_RESET_BLOCKS) and whole program (ORD_RESET_ALL) are released in O(1) by moving end of pool back, no free per allocation.
+Allocations are zeroed and aligned to EMU_ARENA_ALIGN. Data rebuilt at every verify (plan, schedule, core split, compiled block programs) stays on heap.
+************************************************************************************************************************************************************************/
+
+#ifndef EMU_ARENA_SIZE
+#define EMU_ARENA_SIZE (96 * 1024)
+#endif
+#define EMU_ARENA_ALIGN 8
+
+typedef enum {
+    EMU_ARENA_CONTEXTS = 0,
+    EMU_ARENA_ACCESS,
+    EMU_ARENA_BLOCKS,
+    EMU_ARENA_REGIONS_CNT
+} emu_arena_region_t;
+
+/**
+ * @brief Arena usage, bytes
+ */
+typedef struct {
+    size_t size;
+    size_t used;
+    size_t peak;                                  /*max used since init*/
+    size_t free;
+    size_t region_used[EMU_ARENA_REGIONS_CNT];
+    uint32_t region_allocs[EMU_ARENA_REGIONS_CNT];
+    uint32_t failed;                              /*allocations refused since init*/
+} emu_arena_stats_t;
+
+/**
+ * @brief Create arena, does nothing when already created
+ */
+emu_result_t emu_arena_init(size_t size);
+
+/**
+ * @brief Take zeroed, aligned space from region
+ * @return NULL when arena is not created or full
+ */
+void *emu_arena_alloc(emu_arena_region_t region, size_t size);
+
+/**
+ * @brief Release code regions (access, blocks), contexts stay
+ */
+void emu_arena_reset_code(void);
+
+/**
+ * @brief Release all regions
+ */
+void emu_arena_reset(void);
+
+void emu_arena_get_stats(emu_arena_stats_t *stats);
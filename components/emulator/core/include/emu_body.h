@@ -1,21 +1,65 @@
 #pragma once
 #include "block_types.h"
+#include "error_types.h"
 /**
 *@brief This task runs all blocks parsed and is managed by internally by emulator loop
 */
 void emu_body_loop_task(void* params);
 
+/**
+*@brief Task of additional task class (params is class index), runs only blocks of its class
+*/
+void emu_body_class_task(void* params);
+
+/**
+ * @brief One block in execution plan, plan is blocks_list compiled at verify (emu_code_compile)
+ */
+typedef struct{
+    emu_result_t (*func)(block_handle_t block); /*main function of block type*/
+    block_handle_t block;
+    uint16_t skip;                              /*offset to next entry to run: 1, or 1 + chain executed by block itself (FOR)*/
+}emu_plan_entry_t;
+
 typedef struct code_ctx_s{
     uint16_t total_blocks;
     block_handle_t* blocks_list; 
+    emu_plan_entry_t *plan;      /*total_blocks entries, same order as blocks_list*/
+    uint8_t exec_mode;           /*emu_exec_mode_t (emu_sched.h)*/
+    struct emu_sched_s *sched;   /*dirty mode graph, built at verify*/
+    struct emu_partition_s *parts; /*dual core split, built at verify, NULL = single core*/
 } code_ctx_s;
 
 typedef  code_ctx_s *emu_code_handle_t;
 
 emu_code_handle_t emu_get_current_code_ctx();
 
+/**
+ * @brief Execute one full pass over all blocks in code
+ * @note Called by emu_body_loop_task once per cycle, exposed so host benchmark can drive it without loop/timer
+ */
+emu_result_t emu_execute_code(emu_code_handle_t code);
+
+/**
+ * @brief Execute blocks of task class, whole code (emu_execute_code) when task classes are not used
+ */
+emu_result_t emu_execute_class(emu_code_handle_t code, uint8_t cls);
+
+/**
+ * @brief Execute plan entries in order (whole code or share of one core)
+ */
+emu_result_t emu_execute_plan(const emu_plan_entry_t *plan, uint16_t cnt);
 
+/**
+ * @brief Compile blocks_list into execution plan (function, block, jump over chain)
+ * @note Called at end of emu_parse_verify_code, blocks must be verified
+ */
+emu_result_t emu_code_compile(emu_code_handle_t code);
 
+
+
+/**
+ * @brief Free code context and release code regions of program arena (access nodes, blocks), contexts stay with clearable updated flags cleared
+ */
 void emu_reset_code_ctx(void);
 
 
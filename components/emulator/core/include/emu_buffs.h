@@ -11,33 +11,58 @@ typedef struct msg_packet_t {
     size_t len;
 } msg_packet_t;
 
-extern msg_packet_t emu_in_msg_packet;
-extern msg_packet_t emu_out_msg_packet;
+#define EMU_IN_MSG_SLOTS 8 /*ring of received writes (MTU each), receive window of sequenced upload (emu_rx.h)*/
 
+extern msg_packet_t emu_out_msg_packet;
 
-/*
-Unified slab allocator will be implemented later
-*/
 
+/**
+ * @brief Double ended bump pool, bottom grows up from data, top grows down from data + pool_size
+ * @note Every allocation is zeroed and aligned to pool alignment, ends are released only as whole (O(1) reset)
+ */
 typedef struct{
     uint8_t* data;
     size_t pool_size;
-    size_t next_address;
+    size_t next_address; /*bottom end, first free byte*/
+    size_t top_address;  /*top end, first used byte (pool_size when top is empty)*/
+    size_t peak;         /*max bytes used by both ends since create*/
     size_t alignment;
 }data_pool_t;
 
 emu_err_t pool_create(data_pool_t* pool, size_t pool_size, size_t alignment);
 
+/**
+ * @brief Take size bytes from bottom end
+ */
 emu_err_t pool_alloc(data_pool_t* pool, uint8_t** result, size_t size);
 
+/**
+ * @brief Take size bytes from top end
+ */
+emu_err_t pool_alloc_top(data_pool_t* pool, uint8_t** result, size_t size);
+
+/**
+ * @brief Release both ends
+ */
 void pool_reset(data_pool_t* pool);
 
+/**
+ * @brief Release top end only
+ */
+void pool_reset_top(data_pool_t* pool);
+
 emu_err_t pool_destroy(data_pool_t* pool);
 
+#define POOL_USED(pool) ((pool)->next_address + (pool)->pool_size - (pool)->top_address)
+#define POOL_FREE(pool) ((pool)->top_address - (pool)->next_address)
+
 /* msg_packet buffer management */
 
 esp_err_t emu_msg_buffs_init(size_t mtu);
-msg_packet_t* emu_get_in_msg_packet(void);
+/**
+ * @brief Slot idx % EMU_IN_MSG_SLOTS of receive ring, data has MTU bytes
+ */
+msg_packet_t* emu_get_in_msg_slot(uint16_t idx);
 msg_packet_t* emu_get_out_msg_packet(void);
 size_t emu_get_mtu_size(void);
 
@@ -47,3 +47,54 @@ static inline double parse_get_d(const uint8_t *data, uint16_t offset) {
 
 
 
+/**
+ * @brief Saturating integer arithmetic for integer paths of blocks (emu_sat_add_i32, emu_sat_div_i64 ...)
+ * @note Division needs b != 0, quotient is rounded half away from zero like float result stored into integer instance
+ */
+#define EMU_SAT_OPS(SFX, T, U, T_MIN, T_MAX) \
+static inline T emu_sat_add_##SFX(T a, T b) {T r; return __builtin_add_overflow(a, b, &r) ? ((b > 0) ? T_MAX : T_MIN) : r;} \
+static inline T emu_sat_sub_##SFX(T a, T b) {T r; return __builtin_sub_overflow(a, b, &r) ? ((b < 0) ? T_MAX : T_MIN) : r;} \
+static inline T emu_sat_mul_##SFX(T a, T b) {T r; return __builtin_mul_overflow(a, b, &r) ? (((a < 0) != (b < 0)) ? T_MIN : T_MAX) : r;} \
+static inline T emu_sat_div_##SFX(T a, T b) { \
+    if (b == -1) {return emu_sat_sub_##SFX(0, a);} \
+    T q = a / b, rem = a % b; \
+    if (rem != 0) { \
+        U ar = (rem < 0) ? -(U)rem : (U)rem; \
+        U ab = (b < 0) ? -(U)b : (U)b; \
+        if (ar >= ab - ar) {q += ((a < 0) == (b < 0)) ? 1 : -1;} \
+    } \
+    return q; \
+}
+
+EMU_SAT_OPS(i32, int32_t, uint32_t, INT32_MIN, INT32_MAX)
+EMU_SAT_OPS(i64, int64_t, uint64_t, INT64_MIN, INT64_MAX)
+
+/**
+ * @brief Float config value as int64 for integer paths (rounded, +-inf / out of range clamped, NaN gives 0)
+ */
+static inline int64_t emu_float_to_i64(float v) {
+    if (v != v) {return 0;}
+    if (v >= 9223372036854775807.0f) {return INT64_MAX;}
+    if (v <= -9223372036854775808.0f) {return INT64_MIN;}
+    return (int64_t)((v < 0) ? v - 0.5f : v + 0.5f);
+}
+
+/**
+ * @brief Q16.16 (MEM_Q) arithmetic on raw int32_t values, results are rounded half away from zero and saturated to Q range
+ * @note Add / sub are emu_sat_add_i32 / emu_sat_sub_i32, division needs b != 0
+ */
+static inline int32_t emu_q_sat(int64_t v) {return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : (int32_t)v;}
+
+static inline int32_t emu_q_mul(int32_t a, int32_t b) {
+    int64_t p = (int64_t)a * b;
+    int64_t r = (((p < 0) ? -p : p) + (MEM_Q_ONE >> 1)) >> MEM_Q_FRAC_BITS;
+    return emu_q_sat((p < 0) ? -r : r);
+}
+
+static inline int32_t emu_q_div(int32_t a, int32_t b) {
+    return emu_q_sat(emu_sat_div_i64((int64_t)a * MEM_Q_ONE, b));
+}
+
+static inline int32_t emu_float_to_q(float v) {
+    return emu_q_sat(emu_float_to_i64(v * (float)MEM_Q_ONE));
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "error_types.h"
+#include "emu_buffs.h"
+
+/*************************************************************************************************************************************************************************
+Program image in flash
+
+Upload session (everything received since ORD_RESET_ALL that builds program: parse packets and orders that change program state) is kept
+in RAM journal as records. ORD_EMU_IMAGE_SAVE writes journal of verified code into data partition EMU_IMAGE_PARTITION_LABEL, at boot partition
+is mapped (esp_partition_mmap) and records are given to same packet processing as BLE ones, straight from flash (parsers copy what they keep).
+Boot takes parse + verify time only, no BLE round trips per packet.
+
+Image: [emu_image_header_t][records], record = [uint16_t len][len bytes of packet as received]. Header is written last, so interrupted save
+leaves no valid image. Image of other EMU_IMAGE_VERSION / MEM_TYPES_COUNT is ignored (packet formats may differ).
+
+Same image is upload format: host builds it (PythonDump FullDump.get_image) and sends it in ORD_EMU_IMAGE_UPLOAD chunks, hundreds of
+MTU sized packets instead of one packet per instance / block input. Complete image is checked (crc) and replayed like at boot, then it
+becomes journal, so ORD_EMU_IMAGE_SAVE can store it right away. LOG_I is muted during replay, boot / upload time is parse + verify only.
+************************************************************************************************************************************************************************/
+
+#define EMU_IMAGE_PARTITION_LABEL "emu_image"
+#define EMU_IMAGE_MAGIC           0x494D5545u /*"EUMI"*/
+#define EMU_IMAGE_VERSION         1
+#define EMU_IMAGE_JOURNAL_MAX     (128 * 1024) /*RAM journal limit, bigger upload can't be saved*/
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t types_cnt;     /*MEM_TYPES_COUNT of firmware that saved image*/
+    uint32_t records;
+    uint32_t size;          /*bytes of records after header*/
+    uint32_t crc;           /*crc32 of records*/
+} emu_image_header_t;
+
+/**
+ * @brief Processing of one record, same function handles packets from BLE
+ */
+typedef emu_result_t (*emu_image_process_cb)(msg_packet_t *packet);
+
+/**
+ * @brief Drop journal, new upload session starts (ORD_RESET_ALL)
+ */
+void emu_image_journal_reset(void);
+
+/**
+ * @brief Add processed packet to journal when it builds program (parse packet or program state order), others are skipped
+ */
+void emu_image_journal_add(const msg_packet_t *packet);
+
+/**
+ * @brief Write journal into image partition
+ * @note Code has to be verified, flash write stalls tasks running from flash for its duration
+ */
+emu_result_t emu_image_save(void);
+
+/**
+ * @brief Invalidate saved image (next boot waits for upload)
+ */
+emu_result_t emu_image_erase(void);
+
+/**
+ * @brief Store chunk of uploaded image: [offset:u32][bytes], offset 0 starts new upload (header first), chunks come in order
+ * @note Chunk at other offset than next expected byte is rejected and upload keeps waiting for that byte (peer resends from there)
+ * @param complete Set when last byte of image arrived, caller resets program and runs emu_image_upload_run()
+ */
+emu_result_t emu_image_upload(const uint8_t *data, uint16_t len, bool *complete);
+
+/**
+ * @brief Replay complete uploaded image through process, on success image becomes journal
+ * @note On failure program is partially built, caller resets it
+ */
+emu_result_t emu_image_upload_run(emu_image_process_cb process);
+
+/**
+ * @brief Replay saved image through process, no image is not an error (EMU_OK with nothing done)
+ * @note On failure program is partially built, caller resets it
+ */
+emu_result_t emu_image_boot(emu_image_process_cb process);
@@ -4,6 +4,7 @@
 #include "emu_buffs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "error_types.h"
 
 /**
 *@brief Freertos task to acces emulator 
@@ -11,10 +12,13 @@
 void emu_interface_task(void* params);
 
 
+/**
+ * @brief Wake interface task, writes committed into receive ring (emu_rx.h) are processed in order
+ */
 BaseType_t emu_interface_process_packet();
 
-/** Register a callback invoked after each packet is fully processed.
- *  Intended to send a BLE ready-ACK so the peer knows it can send the next packet. */
-void emu_interface_set_packet_done_cb(void (*cb)(void));
-
-
+/**
+ * @brief Build program saved in flash through same packet processing as BLE (emu_image_boot), interface task does it at start
+ * @note Not while interface task processes writes, failed boot resets program
+ */
+emu_result_t emu_interface_boot_image(void);
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "error_types.h"
+
+/*************************************************************************************************************************************************************************
+Bounded lock-free log ring
+
+Producers (error / report macros from loop tasks, worker, interface task, ISR) only reserve a cell with CAS on head, copy item with
+time and cycle of the moment it was logged and publish the cell with its sequence number. Nothing blocks and nothing is sent from producer.
+Single consumer (logger task) drains published cells on its own schedule (LOGGER_FLUSH_PERIOD_MS) and sends them over BLE.
+
+Capacity is fixed at init (power of 2), when ring is full new item is dropped and counted in dropped (oldest items stay).
+Cell sequence (bounded MPMC queue scheme): seq == pos free for write at pos, seq == pos + 1 published, seq == pos + capacity free for next lap.
+************************************************************************************************************************************************************************/
+
+/**
+ * @brief One log item with moment it was logged
+ */
+typedef struct {
+    volatile uint32_t seq;
+    uint64_t time;
+    uint64_t cycle;
+    union {
+        emu_result_t err;
+        emu_report_t rep;
+    } item;
+} emu_log_cell_t;
+
+/**
+ * @brief Log ring, head is shared by producers, tail is owned by logger task
+ */
+typedef struct {
+    emu_log_cell_t *cells;
+    uint32_t mask;              /*capacity - 1*/
+    volatile uint32_t head;     /*next position to reserve*/
+    uint32_t tail;              /*next position to read (logger task only)*/
+    volatile uint32_t dropped;  /*items rejected because ring was full (total since init)*/
+} emu_log_ring_t;
+
+extern emu_log_ring_t error_logs_ring;
+extern emu_log_ring_t status_logs_ring;
+
+/**
+ * @brief Append item to ring, safe from any task, core and ISR, never waits
+ * @return false when ring is not created or full (item dropped)
+ */
+bool emu_log_ring_push(emu_log_ring_t *ring, const void *item, size_t size);
+
+/**
+ * @brief Oldest published cell or NULL (logger task only), cell stays valid until emu_log_ring_release
+ */
+emu_log_cell_t *emu_log_ring_peek(emu_log_ring_t *ring);
+
+/**
+ * @brief Free cell returned by emu_log_ring_peek for producers (logger task only)
+ */
+void emu_log_ring_release(emu_log_ring_t *ring, emu_log_cell_t *cell);
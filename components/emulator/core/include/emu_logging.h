@@ -6,17 +6,19 @@
 #include "emu_logs_config.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
-#include "freertos/ringbuf.h"
+#include "emu_log_ring.h"
 #include "inttypes.h"
 #include "gatt_svc.h"
 
 /*********************************************************************************************** *
 IDEA: we have 2 structs for logging: emu_result_t for errors and emu_report_t for reports / success logs
-We have 2 ring buffers: error_logs_buff_t and status_logs_buff_t (if ENABLE_STATUS_BUFF is defined)
+We have 2 lock-free log rings (emu_log_ring.h): error_logs_ring and status_logs_ring (if ENABLE_STATUS_BUFF is defined)
 
-Now we can read errors directly via serial console (ESP_LOGx) or send them via BLE to app 
-
-We can also read reports if ENABLE_STATUS_BUFF is defined then we can send reports to app as well 
+Error / report macros only append item to ring (stamped with loop time and cycle), they never wait, so log bursts don't stretch cycle.
+Logger task drains rings every LOGGER_FLUSH_PERIOD_MS (own schedule, lowest priority) and sends them via BLE to app (one packet per cycle)
+or prints them via serial console (ESP_LOGx) when ENABLE_SENDING_LOGS is not defined.
+Rings have fixed size (LOG_QUEUE_SIZE / REPORT_QUEUE_SIZE), items logged to full ring are dropped and counted,
+count is sent as report EMU_LOG_error_logs_dropped / EMU_LOG_status_logs_dropped (owner logger, owner_idx = dropped items).
 
 LIVEDEBUGGING: We can enable ENABLE_LOG_X_FROM_ERROR_MACROS and ENABLE_LOG_X_FROM_STATUS_MACROS to have extra logs in serial console for debugging purposes
 
@@ -26,10 +28,6 @@ typedef struct{
         uint16_t offset;
 }log_ble_buff_t;
 
-extern RingbufHandle_t error_logs_buff_t; 
-extern RingbufHandle_t status_logs_buff_t;
-extern SemaphoreHandle_t logger_request_sem;
-extern SemaphoreHandle_t logger_done_sem;
 extern TaskHandle_t logger_task_handle;
 
 // Logger Task Initialization
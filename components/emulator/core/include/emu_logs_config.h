@@ -20,6 +20,9 @@
 
 #define ENABLE_SENDING_LOGS
 
-#define LOG_QUEUE_SIZE 128
-#define REPORT_QUEUE_SIZE 128
+#define ENABLE_BLOCK_PROFILER //per block timing in emu_execute_code (still needs ORD_EMU_PROFILER_START to record)
+
+#define LOG_QUEUE_SIZE 128 //log ring capacity (power of 2)
+#define REPORT_QUEUE_SIZE 128 //report ring capacity (power of 2)
 #define LOGGER_TASK_STACK 4096
+#define LOGGER_FLUSH_PERIOD_MS 50 //logger drains log rings at least this often
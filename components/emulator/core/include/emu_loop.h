@@ -25,10 +25,51 @@ Resolution of timing in blocks is defined by loop period. so if loop period is 1
 All loop control functions return emu_result_t structure containing error code and additional info.
 Loop struct is opaque and managed internally. User can only interact with it via provided API functions.
 
+Loop statistics (nothing is logged per cycle):
+wake - time from timer tick (ISR) to loop task start, exec - emu_execute_code, tail - subscribe/profiler after execution (logger only appends to log rings, emu_log_ring.h).
+Each is tracked as last/max/avg and log2 histogram (bucket n = [2^n, 2^(n+1)) us) used for p50/p99.
+Stats are written only by loop task and published with sequence counter, so any task can read them without locks.
+Sent as PACKET_H_LOOP_STATS on ORD_EMU_LOOP_STATS_GET or every N cycles.
+
+Task classes (PLC style multi-rate, PACKET_H_LOOP_CFG):
+Code can be split into up to EMU_LOOP_CLASSES_MAX classes, each owning contiguous range of blocks (in block order, covering whole code,
+FOR chain can't cross class end). Every class has its own timer, task, wtd (max skipped, skipped counter) and iteration counter.
+Class with shorter period has higher task priority, so slow class (telemetry) is preempted by fast one (control) and never delays it.
+Class 0 is main class: it publishes subscriptions and collects loop statistics (LOOP_PERIOD_MIN applies),
+other classes only execute their blocks (LOOP_CLASS_PERIOD_MIN). Config is applied at loop start, emu_loop_set_period changes main class.
+WTD trigger of any class halts whole loop. Loop time follows fastest class, wtd status / iteration / period are of calling task class.
+With task classes code runs in full mode on loop core (dirty mode and core split are not built).
+
 ************************************************************************************************************************************************************************/
 
 #define LOOP_PERIOD_MIN 10000
 #define LOOP_PERIOD_MAX 1000000
+#define LOOP_CLASS_PERIOD_MIN 1000
+
+#define EMU_LOOP_CLASSES_MAX 4
+
+#define EMU_LOOP_HIST_BUCKETS 20
+
+/**
+ * @brief One measured time of loop cycle (us)
+ */
+typedef struct {
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t hist[EMU_LOOP_HIST_BUCKETS];
+} emu_loop_metric_t;
+
+/**
+ * @brief Loop statistics since init / reset
+ */
+typedef struct {
+    uint32_t cycles;
+    uint32_t skipped;           /*cycles skipped by wtd (tick came while previous cycle was running)*/
+    emu_loop_metric_t wake;
+    emu_loop_metric_t exec;
+    emu_loop_metric_t tail;
+} emu_loop_stats_t;
 
 
 /**
@@ -38,6 +79,7 @@ emu_result_t emu_loop_start(void);
 
 /**
 * @brief stop loop if running, else return error
+* @note Returns after cycle in progress ended, code can be verified / freed then
 */
 emu_result_t emu_loop_stop(void);
 
@@ -72,6 +114,11 @@ uint64_t emu_loop_get_iteration(void);
 */
 bool emu_loop_is_running(void);
 
+/**
+* @brief Check if loop is initialized and in state that emu_loop_start() accepts (created, stopped, halted)
+*/
+bool emu_loop_can_start(void);
+
 /**
 * @brief Check if loop is halted due to watchdog trigger
 */
@@ -117,3 +164,59 @@ bool emu_loop_wait_for_cycle_start(BaseType_t ticks_to_wait);
  * @brief Notify loop that cycle has ended (give WTD semaphore)
  */
 bool emu_loop_notify_cycle_end();
+
+/**
+ * @brief Wait for cycle start of task class (class tasks other than main)
+ */
+bool emu_loop_class_wait(uint8_t cls, BaseType_t ticks_to_wait);
+
+/**
+ * @brief Notify end of task class cycle (give its WTD semaphore)
+ */
+bool emu_loop_class_cycle_end(uint8_t cls);
+
+/**
+ * @brief Block range of task class, false when classes are not applied (main class runs whole code)
+ */
+bool emu_loop_class_range(uint8_t cls, uint16_t *first_block, uint16_t *blocks_cnt);
+
+/**
+ * @brief Are task classes configured (applied at next loop start)
+ */
+bool emu_loop_classes_active(void);
+
+/**
+ * @brief Parse PACKET_H_LOOP_CFG: [classes_cnt:u8] + classes_cnt * [period_us:u32][first_block:u16][blocks_cnt:u16][wtd_max_skipped:u8]
+ * @note classes_cnt 0 returns to single class running whole code
+ */
+emu_result_t emu_loop_parse_cfg(const uint8_t *data, const uint16_t data_len, void *emu_code_handle);
+
+/**
+ * @brief Mark end of code execution in current cycle (splits exec and tail time)
+ */
+void emu_loop_mark_exec_end(void);
+
+/**
+ * @brief Copy consistent snapshot of loop statistics, safe from any task
+ */
+void emu_loop_stats_get(emu_loop_stats_t *out);
+
+/**
+ * @brief Clear loop statistics
+ */
+void emu_loop_stats_reset(void);
+
+/**
+ * @brief Send PACKET_H_LOOP_STATS every N cycles, 0 disables periodic report
+ */
+void emu_loop_stats_set_send_every(uint16_t send_every);
+
+/**
+ * @brief Percentile from histogram (upper bound of bucket, clamped to max)
+ */
+uint32_t emu_loop_metric_percentile(const emu_loop_metric_t *metric, uint8_t percent);
+
+/**
+ * @brief Send PACKET_H_LOOP_STATS with current statistics
+ */
+emu_result_t emu_loop_stats_send(void);
@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "mem_types.h"
+#include "block_types.h"
+#include "emu_variables_acces.h"
+#include "emu_body.h"
+
+/*************************************************************************************************************************************************************************
+Pre-resolved block operands
+
+At emu_parse_verify_code every input and output access of block is flattened into block->ops (inputs first, then outputs, cfg.in_cnt + cfg.q_cnt entries).
+Access with index resolved at parse (scalars, static array indices) gets direct address of its element, reading it is one load from ops instead of
+inputs[i] -> mem_access_t -> instance -> data. When C type of block value differs from instance type, value is converted by kernel from
+emu_conv_kernels[source type][destination type] (same rules as MEM_CAST).
+
+Operands with dynamic index, packed bool elements (emu_packed.h) (and readers of instances that block moves at runtime, IN_SELECTOR output) keep ptr NULL and go through mem_get / mem_set.
+Updated flag of every operand is resolved too (emu_variables.h), so checking / setting / clearing it is one bitmap word operation.
+Table is in program arena (allocated with block cfg), only content is rebuilt at verify.
+************************************************************************************************************************************************************************/
+
+/**
+ * @brief Convert one value, dst and src point at values of types selected by table index
+ */
+typedef void (*emu_conv_kernel_t)(void *dst, const void *src);
+
+/**
+ * @brief Conversion kernels [source mem_types_t][destination mem_types_t], same type is plain copy
+ */
+extern const emu_conv_kernel_t emu_conv_kernels[MEM_TYPES_COUNT][MEM_TYPES_COUNT];
+
+typedef struct emu_operand_s {
+    void *ptr;               /*element address, NULL when index is dynamic or instance can move (use access)*/
+    mem_instance_t *inst;    /*instance of access, NULL when input is not connected*/
+    mem_flag_ref_t updated;  /*updated flag of instance in context bitmap*/
+    uint32_t clear_mask;     /*updated.mask when flag can be cleared, else 0*/
+    uint8_t type;            /*mem_types_t of instance*/
+} emu_operand_t;
+
+/**
+ * @brief mem_types_t of C value
+ */
+#define MEM_TYPE_OF(c_value) _Generic((c_value), \
+    uint8_t:  MEM_U8,  \
+    uint16_t: MEM_U16, \
+    uint32_t: MEM_U32, \
+    int16_t:  MEM_I16, \
+    int32_t:  MEM_I32, \
+    bool:     MEM_B,   \
+    float:    MEM_F    \
+)
+
+/**
+ * @brief Fill operand tables of all blocks from their accesses (called by emu_parse_verify_code)
+ */
+emu_result_t emu_operands_build(emu_code_handle_t code);
+
+/**
+ * @brief Get block input into chosen C-type (like MEM_GET but from operand table)
+ * @param dst_ptr pointer at wanted type
+ * @param block block handle (verified)
+ * @param num input index, input has to be connected
+ * @return emu_result_t, error only possible on dynamic index path
+ */
+#define BLOCK_IN_GET(dst_ptr, block, num) ({ \
+    const emu_operand_t *_op = &(block)->ops[(num)]; \
+    emu_result_t _res = {.code = EMU_OK}; \
+    if (likely(_op->ptr)) { \
+        if (likely(_op->type == MEM_TYPE_OF(*(dst_ptr)))) { \
+            *(dst_ptr) = *(const __typeof__(*(dst_ptr))*)_op->ptr; \
+        } else { \
+            emu_conv_kernels[_op->type][MEM_TYPE_OF(*(dst_ptr))]((dst_ptr), _op->ptr); \
+        } \
+    } else { \
+        _res = MEM_GET((dst_ptr), (block)->inputs[(num)]); \
+    } \
+    _res; \
+})
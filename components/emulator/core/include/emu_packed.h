@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "mem_types.h"
+#include "error_types.h"
+
+/*************************************************************************************************************************************************************************
+Packed bool arrays
+
+MEM_B array created with packed flag (instance packet) stores 1 bit per element in uint32_t words, element i is bit (i % 32) of word (i / 32).
+Fault flag / GPIO mirror arrays take 8x less heap and whole array kernel below processes 32 elements per word. Bits after last element stay 0.
+LOGIC block with RESULT connected to whole packed array runs IN_a AND / OR IN_b of whole packed arrays with mem_packed_op().
+Words are taken from MEM_B heap of context (4 byte aligned start), host counts 4 * MEM_PACKED_WORDS(elements) bytes (+ alignment) for them.
+
+Element has no address: mem_get by reference refuses it, mem_set / MEM_GET / fill packets handle it and operand table keeps ptr NULL.
+Fill packets still carry 1 byte per element, packing is done here.
+************************************************************************************************************************************************************************/
+
+#define MEM_PACKED_WORDS(el_cnt) (((uint32_t)(el_cnt) + 31) >> 5)
+
+typedef enum {
+    MEM_PACKED_AND = 0,
+    MEM_PACKED_OR,
+} mem_packed_op_t;
+
+static __always_inline bool mem_packed_get(const mem_instance_t *inst, uint32_t idx) {
+    return (inst->data.u32[idx >> 5] >> (idx & 31)) & 1;
+}
+
+/*elements of one word can be written by blocks of other core or task class, bit is changed atomically*/
+static __always_inline void mem_packed_put(mem_instance_t *inst, uint32_t idx, bool value) {
+    uint32_t mask = 1u << (idx & 31);
+    if (value) {__atomic_fetch_or(&inst->data.u32[idx >> 5], mask, __ATOMIC_RELAXED);}
+    else       {__atomic_fetch_and(&inst->data.u32[idx >> 5], ~mask, __ATOMIC_RELAXED);}
+}
+
+/**
+ * @brief Elements count of instance (product of dims, 1 for scalar)
+ */
+uint32_t mem_instance_el_cnt(const mem_instance_t *inst);
+
+/**
+ * @brief Bytes of instance data in heap (packed bool arrays are words)
+ */
+uint32_t mem_instance_data_size(const mem_instance_t *inst);
+
+/**
+ * @brief Copy 1 byte per element values (fill packet) into packed array
+ */
+void mem_packed_from_bytes(mem_instance_t *inst, uint32_t start, const uint8_t *src, uint32_t items);
+
+/**
+ * @brief dst = a op b for whole packed arrays, 32 elements per step
+ * @note All three have to be packed with same elements count, dst can be one of sources
+ */
+emu_result_t mem_packed_op(mem_instance_t *dst, const mem_instance_t *a, const mem_instance_t *b, mem_packed_op_t op);
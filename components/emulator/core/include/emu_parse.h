@@ -25,9 +25,14 @@ typedef enum{
     PACKET_H_SUBSCRIPTION_ADD     = 0xC1,
 
     PACKET_H_PUBLISH              = 0xD0,
+    PACKET_H_PROFILE              = 0xD1,
+    PACKET_H_LOOP_STATS           = 0xD2,
     
     PACKET_H_STATUS_LOG           = 0xE0,
     PACKET_H_ERROR_LOG            = 0xE1,
+
+    PACKET_H_SEQ                  = 0xFD, /*transport wrapper, not parsed: [FD][seq:u16][write] (emu_rx.h)*/
+    PACKET_H_FRAMES               = 0xFE, /*transport wrapper, not parsed: [FE] + n * ([len:u16][packet])*/
 }packet_header_t;
 
 /** Returns true if byte b is a recognised packet_header_t value (parse-path packet). */
@@ -46,6 +51,8 @@ static inline bool emu_is_parse_header(uint8_t b) {
         case PACKET_H_SUBSCRIPTION_INIT:
         case PACKET_H_SUBSCRIPTION_ADD:
         case PACKET_H_PUBLISH:
+        case PACKET_H_PROFILE:
+        case PACKET_H_LOOP_STATS:
         case PACKET_H_STATUS_LOG:
         case PACKET_H_ERROR_LOG:
             return true;
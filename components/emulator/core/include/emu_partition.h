@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "emu_body.h"
+
+/*************************************************************************************************************************************************************************
+Dual core block execution
+
+At emu_parse_verify_code plan is split into independent subgraphs: blocks are in same subgraph when they share instance that any block
+in code writes (outputs, SET target, instances used as dynamic index are reads). FOR chain stays with its FOR.
+Blocks of different subgraphs never touch same written memory, so they can run at the same time and result is same as full pass in block order.
+
+Subgraphs are balanced on EMU_PARALLEL_CORES by block count (largest first). Core 0 share runs on loop task, core 1 share on worker task
+pinned to other core, both released by same timer tick (emu_execute_code), worker is joined before emu_execute_code returns
+(before emu_subscribe_send). Split is used only when smaller share has at least EMU_PARALLEL_MIN_BLOCKS blocks, else barrier costs more than it saves.
+
+Dirty execution mode (emu_sched.h) and task classes (emu_loop.h) run on single core.
+Requires CONFIG_FREERTOS_UNICORE=n on target, on linux target (FreeRTOS POSIX port) worker runs as another pthread, so split can be tested on host.
+esp32c6 (default target) is single core, EMU_PARALLEL_ENABLED is 0 there and code always runs on loop task. Split and barrier run in bench
+(linux target), it compares state after same cycles with single core pass.
+************************************************************************************************************************************************************************/
+
+#define EMU_PARALLEL_CORES      2
+#define EMU_PARALLEL_MIN_BLOCKS 16
+
+#if (configNUMBER_OF_CORES > 1) || CONFIG_IDF_TARGET_LINUX
+#define EMU_PARALLEL_ENABLED 1
+#else
+#define EMU_PARALLEL_ENABLED 0
+#endif
+
+#define EMU_LOOP_CORE   0
+#if configNUMBER_OF_CORES > 1
+#define EMU_WORKER_CORE 1
+#else
+#define EMU_WORKER_CORE tskNO_AFFINITY
+#endif
+
+/**
+ * @brief Plan split between cores, built at verify
+ */
+typedef struct emu_partition_s {
+    uint16_t groups;                                /*independent subgraphs found*/
+    uint16_t cnt[EMU_PARALLEL_CORES];               /*plan entries per core*/
+    emu_plan_entry_t *plan[EMU_PARALLEL_CORES];     /*entries of blocks in core share, block order kept, chains as single entry*/
+} emu_partition_t;
+
+/**
+ * @brief Create worker task pinned to second core (called by emu_loop_init, once)
+ */
+emu_result_t emu_partition_worker_init(void);
+
+/**
+ * @brief Split code plan between cores or free split when it is not worth it (called at end of verify)
+ * @note Does nothing while loop is running
+ */
+emu_result_t emu_partition_update(emu_code_handle_t code);
+
+/**
+ * @brief Free split of code
+ */
+void emu_partition_free(emu_code_handle_t code);
+
+/**
+ * @brief Is split of code used for next cycle
+ */
+static __always_inline bool emu_partition_active(emu_code_handle_t code) {
+    return EMU_PARALLEL_ENABLED && code->parts;
+}
+
+/**
+ * @brief Run core shares: release worker, run core 0 share on caller, join worker
+ */
+emu_result_t emu_partition_execute(emu_code_handle_t code);
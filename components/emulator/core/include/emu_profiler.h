@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "emu_logging.h"
+#include "emu_body.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_cpu.h"
+#endif
+
+/*************************************************************************************************************************************************************************
+Per block profiler (opt-in)
+
+When ENABLE_BLOCK_PROFILER is defined (emu_logs_config.h) emu_execute_code can record for every block:
+call count, active count (block did not return RET_OK_INACTIVE), min/avg/max execution time in CPU cycles.
+Stats live in array parallel to code->blocks_list, allocated when profiler is started (ORD_EMU_PROFILER_START)
+and freed together with code.
+
+Report is sent as PACKET_H_PROFILE packets on ORD_EMU_PROFILER_SEND or every N cycles if N given with start order.
+FOR block time contains time of all blocks in its chain (they are executed by FOR, not by main loop).
+
+Packet: [0xD1][uint16_t total_blocks][uint16_t first_idx][uint8_t cnt][uint16_t cycles_per_us] + cnt * emu_profile_entry_t
+************************************************************************************************************************************************************************/
+
+/**
+ * @brief Stats of one block, index same as in code->blocks_list
+ */
+typedef struct{
+    uint32_t calls;
+    uint32_t active;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+}emu_block_profile_t;
+
+/**
+ * @brief One block in PACKET_H_PROFILE packet
+ */
+typedef struct __packed{
+    uint16_t block_idx;
+    uint8_t  block_type;
+    uint32_t calls;
+    uint32_t active;
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+}emu_profile_entry_t;
+
+/**
+ * @brief Stats table while recording, NULL when profiler is stopped
+ * @note Loop reads it once per block (emu_profiler_table) and records into that table, table is freed only while loop is stopped
+ */
+extern emu_block_profile_t *emu_profile_active;
+
+/**
+ * @brief Single read of active table (profiler can be stopped by interface task meanwhile)
+ */
+static __always_inline emu_block_profile_t *emu_profiler_table(void){
+    return __atomic_load_n(&emu_profile_active, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Cycle counter used for measurement (ns on linux target)
+ */
+static __always_inline uint32_t emu_profiler_now(void){
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
+}
+
+/**
+ * @brief Add one block execution to stats
+ */
+static __always_inline void emu_profiler_record(emu_block_profile_t *table, uint16_t block_idx, emu_result_t res, uint32_t cycles){
+    emu_block_profile_t *p = &table[block_idx];
+    p->calls++;
+    if (res.code != EMU_ERR_BLOCK_INACTIVE) {p->active++;}
+    if (cycles < p->min_cycles) {p->min_cycles = cycles;}
+    if (cycles > p->max_cycles) {p->max_cycles = cycles;}
+    p->total_cycles += cycles;
+}
+
+/**
+ * @brief Allocate (or clear) stats for code and start recording
+ * @param send_every send report every N cycles, 0 = only on ORD_EMU_PROFILER_SEND
+ * @return EMU_ERR_INVALID_STATE when table of other code has to be replaced while loop runs
+ */
+emu_result_t emu_profiler_start(emu_code_handle_t code, uint16_t send_every);
+
+/**
+ * @brief Stop recording, stats are kept until reset
+ */
+void emu_profiler_stop(void);
+
+/**
+ * @brief Free stats table (called when code is freed, loop is stopped)
+ */
+void emu_profiler_free(void);
+
+/**
+ * @brief Send stats of all blocks as PACKET_H_PROFILE packets
+ */
+emu_result_t emu_profiler_send(emu_code_handle_t code);
+
+/**
+ * @brief Called by loop task after each cycle, sends report when send_every cycles passed
+ */
+void emu_profiler_cycle_end(emu_code_handle_t code);
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "error_types.h"
+#include "mem_types.h"
+
+/*************************************************************************************************************************************************************************
+Retentive variables
+
+Instance with retain bit (instance packet head) keeps its value over power loss, like PLC retentive memory (counters, odometers...).
+At loop start (after verify) retained instances of program are collected and restored from NVS in one pass, before first cycle.
+Background task (lowest priority) compares retained data with copy of last saved values every EMU_RETAIN_PERIOD_MS and writes only
+changed instances, all of them in one NVS commit. Flash traffic follows how often values change, not cycle rate, and is at most one
+write per instance per period. Nothing is written while values stay the same.
+
+Blocks that keep state outside of outputs (COUNTER count) take it back from restored outputs, emu_block_restore_table is called for all
+blocks right after restore.
+
+NVS keeps layout signature (context, type, index, size of every retained instance). Program with other layout does not get old values,
+namespace is cleared and saving starts from initial values of new program.
+@note Value written by loop during copy may be saved half old / half new for arrays, next period saves consistent one
+************************************************************************************************************************************************************************/
+
+#define EMU_RETAIN_NVS_NAMESPACE  "emu_retain"
+#define EMU_RETAIN_PERIOD_MS      1000
+#define EMU_RETAIN_MAX_BYTES      (8 * 1024)  /*all retained data, bigger programs retain nothing*/
+#define EMU_RETAIN_TASK_STACK     3072
+
+/**
+ * @brief Create lock and background task, once at startup
+ */
+emu_result_t emu_retain_init(void);
+
+/**
+ * @brief Collect retained instances of current program and restore their values from NVS, repeated call for same program does nothing
+ * @note Call after code is verified and before loop starts
+ */
+emu_result_t emu_retain_start(void);
+
+/**
+ * @brief Save changed retained instances now (background task calls it every EMU_RETAIN_PERIOD_MS)
+ */
+emu_result_t emu_retain_flush(void);
+
+/**
+ * @brief Was value of instance restored from NVS by emu_retain_start (blocks take back state they keep outside of outputs)
+ */
+bool emu_retain_restored(const mem_instance_t *inst);
+
+/**
+ * @brief Forget retained instances, call before contexts are reset (values already in NVS stay)
+ */
+void emu_retain_reset(void);
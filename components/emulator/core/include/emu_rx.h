@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "emu_buffs.h"
+
+/*************************************************************************************************************************************************************************
+Receive window of BLE writes
+
+Write is plain (any packet or PACKET_H_FRAMES write) or sequenced: [PACKET_H_SEQ][seq:u16][plain write].
+Plain write is stop-and-wait, peer sends next one after ready byte EMU_RX_READY, it is accepted only when nothing else waits for processing
+(otherwise it is dropped and answered with EMU_RX_BUSY, peer sends it again after replies of writes in flight).
+Sequenced writes let peer keep up to EMU_IN_MSG_SLOTS writes in flight. Write seq lands in ring slot seq % EMU_IN_MSG_SLOTS as it arrives,
+interface task processes slots strictly in seq order, so BLE round trip overlaps with parsing of previous writes. Replies on emu_in:
+    [EMU_RX_ACK][next:u16]   all writes before next are processed and their slots free (cumulative, sent after every write)
+    [EMU_RX_NACK][seq:u16]   write seq is missing while later ones arrived, peer resends only it (later ones stay buffered),
+                             also when slot of seq is still held by write of restarted stream (seq is not buffered)
+    [EMU_RX_BUSY][next:u16]  plain write dropped, writes are still waiting for processing
+Write already processed or past window is dropped and answered with ACK of current position (lost ACK / resend after timeout).
+Stream starts at seq 0 after connect and after every plain write (peer sends first write of upload plain, usually ORD_RESET_ALL),
+so resend of processed write is never taken for new stream. Seq wraps 0xFFFF -> 0.
+************************************************************************************************************************************************************************/
+
+#define EMU_RX_READY     0x00
+#define EMU_RX_ACK       0x01
+#define EMU_RX_NACK      0x02
+#define EMU_RX_BUSY      0x03
+#define EMU_RX_SEQ_HEAD  3  /*header byte + seq*/
+
+/**
+ * @brief Sends reply to peer (ready byte, ACK, NACK), called from BLE and interface task
+ */
+typedef void (*emu_rx_notify_cb)(const uint8_t *data, size_t len);
+
+/**
+ * @brief Create lock, once before first write
+ */
+void emu_rx_init(emu_rx_notify_cb notify);
+
+/**
+ * @brief Forget stream and drop unprocessed writes (disconnect, MTU change), next stream starts at 0, write being processed finishes
+ */
+void emu_rx_reset(void);
+
+/**
+ * @brief Take slot for incoming write of len bytes, head holds its first EMU_RX_SEQ_HEAD bytes (less when write is shorter)
+ * @return Slot to copy whole write into and pass to emu_rx_commit(), NULL when write is dropped (reply already sent when needed)
+ */
+msg_packet_t *emu_rx_claim(const uint8_t *head, size_t len);
+
+/**
+ * @brief Write is copied into claimed slot, it can be processed (caller notifies interface task)
+ */
+void emu_rx_commit(msg_packet_t *slot);
+
+/**
+ * @brief Next write in order for interface task (without seq header), NULL when it did not arrive yet
+ */
+msg_packet_t *emu_rx_next(void);
+
+/**
+ * @brief Write from emu_rx_next() is processed, frees slot and replies to peer
+ */
+void emu_rx_done(void);
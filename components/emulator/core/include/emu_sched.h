@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "mem_types.h"
+#include "emu_body.h"
+#include "emu_variables.h"
+
+/*************************************************************************************************************************************************************************
+Dirty (dependency driven) execution mode
+
+In full mode emu_execute_code visits every block every cycle, most of them return RET_OK_INACTIVE because inputs were not updated.
+In dirty mode only blocks that can do something are visited, result is the same as in full mode:
+
+Graph is built at emu_parse_verify_code (loop start) from instances blocks read and write:
+- tracked instance: can_clear and is output of some block (it is cleared each cycle, so "updated" means written in this/previous cycle)
+- other instances (user variables, not clearable...) are sticky, once updated they can stay updated forever
+- block trigger from emu_block_sched_table: ALWAYS (timer, clock, counter), EN (needs input 0 updated), ALL_INPUTS (math, logic)
+- block is visited every cycle if its type is ALWAYS or its trigger inputs are sticky, else only when trigger input was written
+
+After block executes, every tracked instance it can write (outputs, SET target) that is updated schedules interested blocks
+(readers and owner that will clear it): blocks after it in this cycle, blocks before (or itself) in next cycle, same as full pass sees them.
+Visiting more blocks than needed is always safe, block behaves exactly like in full mode.
+Blocks in FOR chain run only inside FOR (plan skip), they are scheduled as their FOR and their writes are propagated after it.
+
+Instances written from outside of code (by host while loop runs) into tracked instances are not seen.
+Not used with task classes (emu_loop.h), code runs in full mode then.
+************************************************************************************************************************************************************************/
+
+typedef enum {
+    EMU_EXEC_FULL  = 0, /*visit all blocks every cycle*/
+    EMU_EXEC_DIRTY = 1, /*visit only blocks with written inputs and time driven blocks*/
+} emu_exec_mode_t;
+
+/**
+ * @brief Tracked instance block can write with range of interested blocks in inst_blocks
+ */
+typedef struct {
+    mem_flag_ref_t updated;     /*updated flag of instance*/
+    uint32_t first;
+    uint32_t end;
+} emu_sched_write_t;
+
+/**
+ * @brief Dirty mode scheduler, built from code at verify
+ */
+typedef struct emu_sched_s {
+    uint16_t blocks_cnt;        /*code->total_blocks at build*/
+    uint16_t words;             /*bitmap words (32 blocks each)*/
+    uint32_t *pending;          /*blocks to visit in current cycle*/
+    uint32_t *pending_next;     /*blocks to visit in next cycle*/
+    uint32_t *always;           /*blocks visited every cycle*/
+
+    uint16_t *inst_blocks;      /*blocks interested in tracked instances (readers and owners), grouped by instance*/
+    uint32_t *write_start;      /*start in writes for each block (total_blocks + 1)*/
+    emu_sched_write_t *writes;  /*tracked instances blocks can write*/
+} emu_sched_t;
+
+/**
+ * @brief Set execution mode of code, dirty mode graph is built at next verify (loop start)
+ */
+emu_result_t emu_sched_set_mode(emu_code_handle_t code, emu_exec_mode_t mode);
+
+/**
+ * @brief Build or free scheduler for code according to exec_mode (called at end of verify)
+ * @note Does nothing while loop is running, graph is in use by loop task
+ */
+emu_result_t emu_sched_update(emu_code_handle_t code);
+
+/**
+ * @brief Free scheduler of code
+ */
+void emu_sched_free(emu_code_handle_t code);
+
+static __always_inline void emu_sched_set(uint32_t *bitmap, uint16_t idx) {
+    bitmap[idx >> 5] |= (1u << (idx & 31));
+}
+
+/**
+ * @brief Visit all blocks in next cycle (first cycle, after aborted cycle)
+ */
+static __always_inline void emu_sched_visit_all(emu_sched_t *sched) {
+    memset(sched->pending_next, 0xFF, sched->words * sizeof(uint32_t));
+    if (sched->blocks_cnt & 31) {sched->pending_next[sched->words - 1] = (1u << (sched->blocks_cnt & 31)) - 1;}
+}
+
+/**
+ * @brief Move next cycle blocks and always blocks into pending
+ */
+static __always_inline void emu_sched_cycle_begin(emu_sched_t *sched) {
+    for (uint16_t w = 0; w < sched->words; w++) {
+        sched->pending[w] = sched->pending_next[w] | sched->always[w];
+        sched->pending_next[w] = 0;
+    }
+}
+
+/**
+ * @brief Remove blocks [from, to] from current cycle (executed by FOR)
+ */
+static __always_inline void emu_sched_drop(emu_sched_t *sched, uint16_t from, uint16_t to) {
+    for (uint16_t i = from; i <= to; i++) {
+        sched->pending[i >> 5] &= ~(1u << (i & 31));
+    }
+}
+
+/**
+ * @brief Schedule blocks interested in updated instances written by block
+ * @param last_done last block index executed in this cycle (after FOR chain)
+ */
+static __always_inline void emu_sched_propagate(emu_sched_t *sched, uint16_t block_idx, uint16_t last_done) {
+    for (uint32_t w = sched->write_start[block_idx]; w < sched->write_start[block_idx + 1]; w++) {
+        const emu_sched_write_t *write = &sched->writes[w];
+        if (!mem_flag_get(write->updated)) {continue;}
+        for (uint32_t i = write->first; i < write->end; i++) {
+            uint16_t target = sched->inst_blocks[i];
+            emu_sched_set((target > last_done) ? sched->pending : sched->pending_next, target);
+        }
+    }
+}
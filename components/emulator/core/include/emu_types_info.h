@@ -11,7 +11,7 @@
 /**
  * @brief total different mem_types_t
  */
-#define DATA_TYPES_CNT 7
+#define DATA_TYPES_CNT 8
 
 extern const char* EMU_ERR_TO_STR(emu_err_t err_code);
 extern const char* EMU_ORDER_TO_STR(emu_order_t order);
@@ -23,6 +23,18 @@ extern mem_context_t mem_contexts[MAX_CONTEXTS];
 emu_result_t emu_mem_parse_create_context(const uint8_t *data,const uint16_t packet_length, void *nothing);
 
 
+/**
+ * @brief Forget context, it can be created again after that
+ * @param ctx_id context to delete
+ * @note Space of context is taken back by emu_arena_reset only, use mem_contexts_reset_all to start over
+ */
+void mem_context_delete(uint8_t ctx_id);
+
+/**
+ * @brief Delete all contexts and release whole program arena (ORD_RESET_ALL), code has to be reset before
+ */
+void mem_contexts_reset_all(void);
+
 /**
  * @brief Parse and create instances 
  * @param data packet buff (skip header)
@@ -70,6 +82,45 @@ emu_err_t emu_mem_fill_instance_scalar_fast(const uint8_t* data);
  */
 emu_err_t emu_mem_fill_instance_array_fast(const uint8_t* data);
 
+/*************************************************************************************************************************************************************************
+Updated flags
+
+"updated" and "can_clear" of every instance are bits in bitmaps of its type manager (updated_bits, clear_bits, bit = instance index), not in instance.
+Runtime code does not look for bit of instance, location (mem_flag_ref_t) is resolved at verify (block operands, dirty scheduler) and kept.
+Bitmap words are shared by blocks of both cores (emu_partition.h) and by task classes that preempt each other (emu_loop.h), bits are always
+changed with atomic or / and (single amoor / amoand on RISC-V), plain read-modify-write of word would lose bit set by other writer.
+************************************************************************************************************************************************************************/
+
+#define MEM_FLAG_WORDS(cnt) (((uint32_t)(cnt) + 31) >> 5)
+
+static __always_inline mem_flag_ref_t mem_type_flag_ref(const type_manager_t *mgr, uint16_t inst_idx) {
+    return (mem_flag_ref_t){.word = &mgr->updated_bits[inst_idx >> 5], .mask = 1u << (inst_idx & 31)};
+}
 
+static __always_inline bool mem_flag_get(mem_flag_ref_t ref) {
+    return __atomic_load_n(ref.word, __ATOMIC_RELAXED) & ref.mask;
+}
 
+static __always_inline void mem_flag_set(mem_flag_ref_t ref) {
+    __atomic_fetch_or(ref.word, ref.mask, __ATOMIC_RELAXED);
+}
 
+static __always_inline void mem_flag_clear(mem_flag_ref_t ref) {
+    __atomic_fetch_and(ref.word, ~ref.mask, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Find updated flag of instance (instance is looked up by address, IN_SELECTOR output holds context / type of other instance)
+ * @return ref with NULL word when instance is not in any context
+ */
+mem_flag_ref_t mem_instance_flag_ref(const mem_instance_t *inst);
+
+/**
+ * @brief Can updated flag of instance be cleared
+ */
+bool mem_instance_can_clear(const mem_instance_t *inst);
+
+/**
+ * @brief Clear updated flags of all clearable instances in context (few word operations per type)
+ */
+void mem_context_clear_updated(uint8_t ctx_id);
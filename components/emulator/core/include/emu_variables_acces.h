@@ -28,27 +28,84 @@ emu_result_t mem_set(const mem_var_t source, const mem_access_t *target);
 
 
 /**
- * @brief Parse and create space for access structs
+ * @brief Parse and check space for access structs
  * @param data packet buff (skip header)
  * @param packet_length packet buff len (-header len)
  * @param nothing pass NULL
  * @return emu_result_t.code = EMU_OK when success, else look emu_result_t struct def
  * @note Packet [uint16_t ref_cnt][uint16_t total_indices]
- * @details Access space is common for all contexts,
+ * @details Access nodes are taken from program arena (common for all contexts) and released with code,
  * Total_indices value is computed as sum of provided static/dynamic indices_values in each struct
  */
 emu_result_t emu_mem_parse_access_create(const uint8_t*data, const uint16_t packet_length, void* nothing);
 
 /**
-* @brief Free space for mem_access storage
-*/
-void mem_access_free_space(void);
+ * @brief Index cache of access with dynamic indices, stored in the same arena node right after indices_values
+ * @details Strides and dims are taken at parse time, offset is computed again only when some index value differs
+ * from last call (or IN_SELECTOR replaced instance with one of other shape, geometry key).
+ * Access node belongs to one block input / output so it is used by one core only.
+ */
+typedef struct {
+    uint16_t dims[MAX_DIMS];     /*dims of instance, for bounds check*/
+    uint16_t strides[MAX_DIMS];  /*elements per step of each index*/
+    uint16_t last_idx[MAX_DIMS]; /*index values offset was computed for (static ones set at parse)*/
+    uint16_t offset;             /*element offset for last_idx*/
+    uint8_t  valid;              /*offset is valid for last_idx*/
+    uint32_t geometry;           /*instance dims_idx / type / context strides belong to*/
+} mem_index_cache_t;
+
+/**
+ * @brief Index cache of access (only for access with dynamic indices)
+ */
+static __always_inline mem_index_cache_t* mem_access_index_cache(const mem_access_t *access) {
+    return (mem_index_cache_t*)&access->indices_values[access->indices_cnt];
+}
+
+/**
+ * @brief Slice of span access, stored after indices_values (and index cache when access is dynamic)
+ */
+typedef struct {
+    uint16_t count;  /*elements, 0 = up to end of dim (dynamic start)*/
+    uint16_t stride; /*elements between neighbours, resolved access only (dynamic take it from index cache)*/
+    uint8_t  dim;    /*sliced dim, its index value is first element*/
+} mem_slice_t;
+
+/**
+ * @brief Slice of access (only for whole_array access)
+ */
+static __always_inline mem_slice_t* mem_access_slice(const mem_access_t *access) {
+    uint8_t *end = (uint8_t*)&access->indices_values[access->indices_cnt];
+    return (mem_slice_t*)(end + (access->is_index_resolved ? 0 : sizeof(mem_index_cache_t)));
+}
+
+/**
+ * @brief Elements of instance described by span access
+ */
+typedef struct {
+    mem_types_ptr_u data; /*first element*/
+    uint16_t count;       /*elements count*/
+    uint16_t stride;      /*elements between neighbours, 1 when contiguous*/
+    uint8_t  type;        /*mem_types_t of elements*/
+} mem_span_t;
+
+/**
+ * @brief Get elements described by access (slice / row / whole 1D array), element access gives span of 1
+ * @param span filled with address of first element, count and stride
+ * @param access access node, index values are read like in mem_get
+ * @return emu_result_t, EMU_ERR_MEM_OUT_OF_BOUNDS when slice leaves dim, EMU_ERR_MEM_INVALID_DATATYPE for packed bool array
+ * @note Updated flag is not touched, writer sets it once for whole span
+ */
+emu_result_t mem_get_span(mem_span_t *span, const mem_access_t *access);
 
 /**
  * @brief Parse one access message (recursive if in need)
+ * @note When whole_array bit is set indices are followed by [slice_dim:u8][count:u16], index of slice_dim is first element, count 0 = to end of dim
  */
 emu_err_t emu_mem_parse_access(const uint8_t *data, const uint16_t packet_length, uint16_t* idx, mem_access_t **out_ptr);
 
+/**
+ * @brief Check that program arena has space for references_count nodes with total_indices indices
+ */
 emu_result_t mem_access_allocate_space(uint16_t references_count, uint16_t total_indices);
 
 /**
@@ -59,16 +116,39 @@ emu_result_t mem_access_allocate_space(uint16_t references_count, uint16_t total
 
 #define CLAMP_CAST(VAL, MIN, MAX, TYPE) ({ \
     __typeof__(VAL) _v = (VAL); \
-    /* Compile-time dispatch: Only round if input is float */ \
-    _v = __builtin_types_compatible_p(__typeof__(_v), float) ? roundf((float)_v) : _v; \
     /* Disable type-limit warnings for generic limits (e.g., u8 < 0) */ \
     _Pragma("GCC diagnostic push") \
     _Pragma("GCC diagnostic ignored \"-Wtype-limits\"") \
-    TYPE _res = (_v < (MIN)) ? (TYPE)(MIN) : ((_v > (MAX)) ? (TYPE)(MAX) : (TYPE)_v); \
+    /* Compile-time dispatch: float is rounded (MAX as float can round up, so >=), integers compare as int64_t (u32 against signed limits would compare unsigned) */ \
+    TYPE _res = __builtin_choose_expr(__builtin_types_compatible_p(__typeof__(_v), float), \
+        ({ float _f = roundf((float)_v); (_f <= (float)(MIN)) ? (TYPE)(MIN) : ((_f >= (float)(MAX)) ? (TYPE)(MAX) : (TYPE)_f); }), \
+        (((int64_t)_v < (int64_t)(MIN)) ? (TYPE)(MIN) : (((int64_t)_v > (int64_t)(MAX)) ? (TYPE)(MAX) : (TYPE)_v))); \
     _Pragma("GCC diagnostic pop") \
     _res; \
 })
 
+/* -------------------------------------------------------------------------- */
+/* Q16.16 HELPERS                                  */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Q16.16 raw value to whole number, rounded half away from zero like roundf
+ */
+static __always_inline int32_t emu_q_to_int(int32_t q) {
+    int64_t r = ((q < 0) ? -(int64_t)q : (int64_t)q) + (MEM_Q_ONE >> 1);
+    r >>= MEM_Q_FRAC_BITS;
+    return (int32_t)((q < 0) ? -r : r);
+}
+
+/**
+ * @brief Whole number to Q16.16 raw value, saturated to Q range
+ */
+static __always_inline int32_t emu_q_from_int(int64_t v) {
+    if (v >= (INT32_MAX >> MEM_Q_FRAC_BITS) + 1) {return INT32_MAX;}
+    if (v < (INT32_MIN >> MEM_Q_FRAC_BITS)) {return INT32_MIN;}
+    return (int32_t)(v * MEM_Q_ONE);
+}
+
 /* -------------------------------------------------------------------------- */
 /* CONVERTER GENERATORS                            */
 /* -------------------------------------------------------------------------- */
@@ -83,6 +163,7 @@ static __always_inline T_TYPE emu_var_to_##T_NAME(mem_var_t v) { \
         case MEM_I32:  return CLAMP_CAST(GET_VAL(v, i32), T_MIN, T_MAX, T_TYPE); \
         case MEM_F:    return CLAMP_CAST(GET_VAL(v, f),   T_MIN, T_MAX, T_TYPE); \
         case MEM_B:    return GET_VAL(v, b) ? (T_TYPE)1 : (T_TYPE)0; \
+        case MEM_Q:    return CLAMP_CAST(emu_q_to_int(GET_VAL(v, q)), T_MIN, T_MAX, T_TYPE); \
         default: return 0; \
     } \
 }
@@ -107,6 +188,7 @@ static __always_inline float emu_var_to_f(mem_var_t v) {
         case MEM_I16:  return (float)GET_VAL(v, i16);
         case MEM_I32:  return (float)GET_VAL(v, i32);
         case MEM_B:    return GET_VAL(v, b) ? 1.0f : 0.0f;
+        case MEM_Q:    return (float)GET_VAL(v, q) * (1.0f / MEM_Q_ONE);
         default: return 0.0f;
     }
 }
@@ -121,10 +203,28 @@ static __always_inline float emu_var_to_f(mem_var_t v) {
         case MEM_U32: return (GET_VAL(v, u32) != 0);
         case MEM_I16:  return (GET_VAL(v, i16) != 0);
         case MEM_I32:  return (GET_VAL(v, i32) != 0);
+        case MEM_Q:    return (GET_VAL(v, q) != 0);
         default: return false;
     }
 }
 
+/**
+ * @brief Value as Q16.16 raw int32_t (not in MEM_CAST, int32_t C type is MEM_I32), integers are scaled without float
+ */
+static __always_inline int32_t emu_var_to_q(mem_var_t v) {
+    switch (v.type) {
+        case MEM_Q:   return GET_VAL(v, q);
+        case MEM_U8:  return emu_q_from_int(GET_VAL(v, u8));
+        case MEM_U16: return emu_q_from_int(GET_VAL(v, u16));
+        case MEM_U32: return emu_q_from_int(GET_VAL(v, u32));
+        case MEM_I16: return emu_q_from_int(GET_VAL(v, i16));
+        case MEM_I32: return emu_q_from_int(GET_VAL(v, i32));
+        case MEM_B:   return GET_VAL(v, b) ? MEM_Q_ONE : 0;
+        case MEM_F:   return CLAMP_CAST(GET_VAL(v, f) * (float)MEM_Q_ONE, INT32_MIN, INT32_MAX, int32_t);
+        default: return 0;
+    }
+}
+
 
 #define MEM_CAST(var, type_placeholder) _Generic((type_placeholder),\
     uint8_t:  emu_var_to_u8,  \
@@ -162,7 +262,7 @@ static __always_inline float emu_var_to_f(mem_var_t v) {
             int16_t:  (_inst->type == MEM_I16), \
             int32_t:  (_inst->type == MEM_I32), \
             float:    (_inst->type == MEM_F), \
-            bool:     (_inst->type == MEM_B), \
+            bool:     (_inst->type == MEM_B && !_inst->packed), /*packed bool element is a bit (mem_get)*/ \
             default:  0 \
         )) { \
             /* Direct memory access - no function call overhead */ \
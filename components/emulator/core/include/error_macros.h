@@ -2,22 +2,21 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <freertos/task.h>
-#include <freertos/ringbuf.h>
 #include <esp_log.h>
 #include "error_types.h"
 #include "emu_loop.h"
 #include "emu_logs_config.h"
-
-// --- Global Queue Handles ---
-extern RingbufHandle_t error_logs_buff_t;
-extern RingbufHandle_t status_logs_buff_t;
+#include "emu_log_ring.h"
 
 
 // Wrapper macros for logging with function name, can be disabled when not needed 
 // Używamy ({ }) aby "dotknąć" zmiennych w bloku bez generowania kodu assemblera
 
+/*set while program image is replayed (emu_image.c), parsers log every instance / block and image has hundreds of records*/
+extern bool emu_log_info_muted;
+
 #ifdef ENABLE_LOG_I
-    #define LOG_I(tag, fmt, ...) ESP_LOGI(tag, "[%s] " fmt, __func__, ##__VA_ARGS__)
+    #define LOG_I(tag, fmt, ...) ({ if (likely(!emu_log_info_muted)) {ESP_LOGI(tag, "[%s] " fmt, __func__, ##__VA_ARGS__);} })
 #else 
     #define LOG_I(tag, fmt, ...) ({ (void)(tag); (void)(fmt); })
 #endif
@@ -47,48 +46,17 @@ extern RingbufHandle_t status_logs_buff_t;
         } \
     })
 
-static __always_inline void _push_to_buf_overwrite(RingbufHandle_t rb, void *struct_ptr, size_t struct_size) {
-    if (rb == NULL) return;
-
-    if (unlikely(xPortInIsrContext())) {
-        BaseType_t hpw = pdFALSE;
-        // Try to send
-        if (xRingbufferSendFromISR(rb, struct_ptr, struct_size, &hpw) != pdTRUE) {
-            // If full, remove old item
-            size_t isize = 0;
-            void *old = xRingbufferReceiveFromISR(rb, &isize);
-            if (old) {
-                vRingbufferReturnItemFromISR(rb, old, &hpw);
-                // Retry send
-                (void)xRingbufferSendFromISR(rb, struct_ptr, struct_size, &hpw);
-            }
-        }
-        if (hpw == pdTRUE) {
-            portYIELD_FROM_ISR();
-        }
-    } else {
-        // Task Context
-        if (xRingbufferSend(rb, struct_ptr, struct_size, 0) != pdTRUE) {
-            size_t isize = 0;
-            void *old = xRingbufferReceive(rb, &isize, 0);
-            if (old) {
-                vRingbufferReturnItem(rb, old);
-                (void)xRingbufferSend(rb, struct_ptr, struct_size, 0);
-            }
-        }
-    }
-}
-
-#define _PUSH_TO_BUF(_rb, _struct_ptr) _push_to_buf_overwrite((_rb), (_struct_ptr), sizeof(*(_struct_ptr)))   
+// Only appends to log ring (never waits, full ring drops item), logger task sends it later
+#define _PUSH_TO_BUF(_ring, _struct_ptr) ((void)emu_log_ring_push(&(_ring), (_struct_ptr), sizeof(*(_struct_ptr))))
 
 #ifdef ENABLE_ERROR_BUFF
-    #define _TRY_ADD_ERROR(_err_ptr)  _PUSH_TO_BUF(error_logs_buff_t, (_err_ptr))
+    #define _TRY_ADD_ERROR(_err_ptr)  _PUSH_TO_BUF(error_logs_ring, (_err_ptr))
 #else
     #define _TRY_ADD_ERROR(_err_ptr)  ({ (void)(_err_ptr); })
 #endif
 
 #ifdef ENABLE_STATUS_BUFF
-    #define _TRY_ADD_STATUS(_rep_ptr)  _PUSH_TO_BUF(status_logs_buff_t, (_rep_ptr))
+    #define _TRY_ADD_STATUS(_rep_ptr)  _PUSH_TO_BUF(status_logs_ring, (_rep_ptr))
 #else 
     #define _TRY_ADD_STATUS(_rep_ptr)  ({ (void)(_rep_ptr); })
 #endif
@@ -213,7 +181,7 @@ static __always_inline void _push_to_buf_overwrite(RingbufHandle_t rb, void *str
                 .owner_idx = owner_custom_idx, \
             }; \
             _TRY_ADD_STATUS(&_rep); \
-            return (emu_result_t){ .code = EMU_OK }; \
+            return (emu_result_t){ .code = EMU_ERR_BLOCK_INACTIVE, .notice = 1 }; \
         })
 
     #define EMU_REPORT(log_msg_enum, owner_name_enum, owner_custom_idx, tag, fmt, ...) \
@@ -242,7 +210,7 @@ static __always_inline void _push_to_buf_overwrite(RingbufHandle_t rb, void *str
             (void)(log_msg_enum); \
             (void)(owner_name_enum); \
             (void)(owner_custom_idx); \
-            return (emu_result_t){ .code = EMU_OK }; \
+            return (emu_result_t){ .code = EMU_ERR_BLOCK_INACTIVE, .notice = 1 }; \
         })
 
     #define EMU_REPORT(log_msg_enum, owner_name_enum, owner_custom_idx, tag, fmt, ...) \
@@ -283,7 +251,7 @@ static __always_inline void _push_to_buf_overwrite(RingbufHandle_t rb, void *str
 /*Use when want to give block index and error depth*/
 #define RET_OKD(block_idx, msg, ...) EMU_RETURN_OK(EMU_LOG_finished, OWNER, block_idx, TAG, msg, ##__VA_ARGS__)
 
-/*Return when block inactive, no logging*/
+/*Return when block inactive, no logging, code EMU_ERR_BLOCK_INACTIVE as notice (no abort)*/
 #define RET_OK_INACTIVE(block_idx) EMU_RETURN_OK_SILENT(EMU_LOG_block_inactive, OWNER, block_idx)
 
 /*Add error to queue, no return*/
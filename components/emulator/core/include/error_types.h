@@ -156,6 +156,30 @@ typedef enum {
     EMU_OWNER_emu_subscribe_process,
     EMU_OWNER_emu_subscribe_reset,
     EMU_OWNER_emu_subscribe_send,
+    EMU_OWNER_emu_profiler_start,
+    EMU_OWNER_emu_profiler_send,
+    EMU_OWNER_emu_loop_stats_send,
+    EMU_OWNER_emu_sched_set_mode,
+    EMU_OWNER_emu_sched_build,
+    EMU_OWNER_emu_code_compile,
+    EMU_OWNER_emu_partition_worker_init,
+    EMU_OWNER_emu_partition_build,
+    EMU_OWNER_emu_loop_parse_cfg,
+    EMU_OWNER_emu_loop_classes_apply,
+    EMU_OWNER_emu_logger,
+    EMU_OWNER_emu_arena_init,
+    EMU_OWNER_emu_operands_build,
+    EMU_OWNER_mem_packed_op,
+    EMU_OWNER_mem_get_span,
+    EMU_OWNER_emu_image_save,
+    EMU_OWNER_emu_image_erase,
+    EMU_OWNER_emu_image_boot,
+    EMU_OWNER_emu_image_upload,
+    EMU_OWNER_emu_image_upload_run,
+    EMU_OWNER_emu_retain_init,
+    EMU_OWNER_emu_retain_start,
+    EMU_OWNER_emu_retain_flush,
+    EMU_OWNER_emu_interface_frames,
     
 
 }emu_owner_t;
@@ -236,7 +260,9 @@ typedef enum {
     EMU_LOG_created_ctx,
     EMU_LOG_clock_out_active,
     EMU_LOG_clock_out_inactive,
-    EMU_LOG_to_large_to_sub
+    EMU_LOG_to_large_to_sub,
+    EMU_LOG_error_logs_dropped,
+    EMU_LOG_status_logs_dropped
 } emu_log_t;
 
 
@@ -3,7 +3,7 @@
 #include <stdbool.h> 
 
 
-#define MEM_TYPES_COUNT 7
+#define MEM_TYPES_COUNT 8
 
 /**
  * @brief Data types used within contexts
@@ -16,9 +16,21 @@ typedef enum{
     MEM_I16  = 3,
     MEM_I32  = 4,
     MEM_B    = 5,
-    MEM_F    = 6
+    MEM_F    = 6,
+    MEM_Q    = 7  /*Q16.16 fixed point, int32_t raw value / 65536*/
 }mem_types_t;
 
+/**
+*@brief Q16.16 fixed point: range -32768 .. 32767.99998, resolution 1/65536, arithmetic on integer unit (no FPU needed)
+*/
+#define MEM_Q_FRAC_BITS 16
+#define MEM_Q_ONE       (1 << MEM_Q_FRAC_BITS)
+
+/**
+*@brief Type holds whole numbers (bool as 0 / 1), every value fits in int64_t
+*/
+#define MEM_TYPE_IS_INT(t) ((t) <= MEM_I32 || (t) == MEM_B)
+
 static const uint8_t MEM_TYPE_SIZES[MEM_TYPES_COUNT] = {
     1, // U8
     2, // U16
@@ -26,7 +38,8 @@ static const uint8_t MEM_TYPE_SIZES[MEM_TYPES_COUNT] = {
     2, // I16
     4, // I32
     1, // B
-    4  // F
+    4, // F
+    4  // Q
 };
 
 /** 
@@ -40,6 +53,7 @@ typedef union{
     int32_t  *i32;
     float    *f;
     bool     *b;
+    int32_t  *q;
     void     *raw;
  }mem_types_ptr_u;
 
@@ -54,6 +68,7 @@ typedef union{
     int32_t  i32;
     float    f;
     bool     b;
+    int32_t  q;
  }mem_types_val_u;
 
 /**
@@ -64,9 +79,9 @@ typedef struct __packed {
     uint16_t context   : 3;  /*Context that isnstance shall belong to*/
     uint16_t type      : 4;  /*mem_types_t type*/
     uint16_t dims_cnt  : 4;  /*dimensions count in case of arrays > 0*/
-    uint16_t updated   : 1;  /*Updated flag can be used for block output variables*/
-    uint16_t can_clear : 1;  /*Can updated flag be cleared*/
-    uint16_t reserved  : 3;  /*padding*/
+    uint16_t packed    : 1;  /*MEM_B array stored 1 bit per element (emu_packed.h)*/
+    uint16_t retain    : 1;  /*value survives power loss (emu_retain.h)*/
+    uint16_t reserved  : 3;  /*padding, updated / can_clear flags are in type_manager_t bitmaps*/
     uint16_t dims_idx;       /*Index in table of dimensions this table is stored in context for selected type*/ 
 }mem_instance_t; 
 
@@ -103,7 +118,7 @@ typedef struct mem_access_t {
     uint8_t  indices_cnt       : 4; /*Provided indices cnt*/
     uint8_t  is_index_resolved : 1; /*Is array index resolved*/
     uint8_t  can_resolve_index : 1; /*Can array index be resolved*/
-    uint8_t  whole_array       : 1; /*padding*/
+    uint8_t  whole_array       : 1; /*Access is a span (slice along one dim), mem_get_span*/
     uint8_t  reserved          : 1; /*padding*/
     uint8_t  is_idx_static_mask; /*mask for provided array indices type example: 0x01 means that idx 0 is number and rest is mem_access_t*/
     idx_val_t indices_values[]; /*Indices values as number or mem_access_t*/
@@ -136,8 +151,19 @@ typedef struct{
     mem_types_ptr_u  data_heap; /*base address of data heap */
     uint32_t data_heap_cursor;   /*next data index that can be used*/
     uint32_t data_heap_cap; /*in mem_types_t items*/
+
+    uint32_t* updated_bits; /*bit per instance (by index), set when instance is written*/
+    uint32_t* clear_bits;   /*bit per instance, updated flag can be cleared (block outputs)*/
 }type_manager_t;
 
+/**
+*@brief Location of instance updated flag, resolved once (verify) and used at runtime
+*/
+typedef struct{
+    uint32_t* word; /*word of updated_bits*/
+    uint32_t  mask; /*instance bit in word*/
+}mem_flag_ref_t;
+
 /**
  * @brief Context structure
  */
@@ -45,4 +45,21 @@ typedef enum {
     ORD_EMU_RUN_WITH_DEBUG = 0x6000, //Run with debug (Dump after each cycle)
     ORD_EMU_RUN_ONE_STEP   = 0x7000, //Run one block / one step (With debug)
 
+    /********PROFILER *******************/
+    ORD_EMU_PROFILER_START = 0x8000, //Clear and start per block profiler, optional [uint16_t send_every] cycles after order
+    ORD_EMU_PROFILER_STOP  = 0x8001, //Stop recording, stats are kept
+    ORD_EMU_PROFILER_SEND  = 0x8002, //Send PACKET_H_PROFILE report now
+
+    /********LOOP STATS *****************/
+    ORD_EMU_LOOP_STATS_GET   = 0x8010, //Send PACKET_H_LOOP_STATS now, optional [uint16_t send_every] cycles for periodic report (0 = off)
+    ORD_EMU_LOOP_STATS_RESET = 0x8011, //Clear loop statistics
+
+    /********EXECUTION MODE **************/
+    ORD_EMU_SET_EXEC_MODE    = 0x8020, //[uint8_t mode] 0 - full pass, 1 - dirty (only blocks with written inputs), applied at loop start
+
+    /********PROGRAM IMAGE ***************/
+    ORD_EMU_IMAGE_SAVE       = 0x9000, //Save verified program (upload since ORD_RESET_ALL) to flash, replayed at boot (emu_image.h)
+    ORD_EMU_IMAGE_ERASE      = 0x9001, //Erase saved program, next boot waits for upload
+    ORD_EMU_IMAGE_UPLOAD     = 0x9002, //[uint32_t offset][image bytes] chunk of program image built by host, complete image replaces program
+
 }emu_order_t;
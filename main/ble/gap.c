@@ -2,6 +2,7 @@
 #include "common.h"
 #include "gatt_svc.h"
 #include "emu_interface.h"
+#include "emu_rx.h"
 
 static int ble_gap_advertising_start(void);  
 static int ble_gap_configure_advertising(void);                          // Starts BLE advertising
@@ -83,6 +84,7 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
         else { return ble_gap_advertising_start();} //start adv if fail
 
     case BLE_GAP_EVENT_DISCONNECT:
+        emu_rx_reset(); //next peer starts its own stream
         return ble_gap_advertising_start(); //if device disconnect start advertising again
     case BLE_GAP_EVENT_CONN_UPDATE:
         return ble_gap_conn_find(event->conn_update.conn_handle, &desc);
@@ -96,6 +98,7 @@ static int gap_event_handler(struct ble_gap_event *event, void *arg) {
     case BLE_GAP_EVENT_MTU:
          ESP_LOGI(TAG, "Negotiated MTU: conn_handle=%d mtu=%d",
                  event->mtu.conn_handle, event->mtu.value);
+            emu_rx_reset(); //buffered writes go away with old slots
             emu_msg_buffs_init(event->mtu.value);
             return 0;
     }
@@ -3,6 +3,7 @@
 #include "gatt_uuids.h"
 #include "order_types.h"
 #include "emu_interface.h"
+#include "emu_rx.h"
 
 
 static chr_msg_buffer_t *emu_in_buffer = NULL;  // internal, not global outside this file
@@ -116,15 +117,18 @@ static int chr_access_cb(uint16_t conn_handle, uint16_t attr_handle,
         //write only
         if (ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR) {
             size_t len = OS_MBUF_PKTLEN(ctxt->om);
-            msg_packet_t *in_packet = emu_get_in_msg_packet();
+            uint8_t head[EMU_RX_SEQ_HEAD] = {0};
+            os_mbuf_copydata(ctxt->om, 0, (len < sizeof(head)) ? len : sizeof(head), head);
 
-            if (!in_packet || !in_packet->data || len > mtu_size) {
-                ESP_LOGW(TAG, "in_packet not ready or len %d exceeds mtu %d", len, mtu_size);
+            //slot of receive ring, NULL when write is dropped (busy, duplicate, outside window)
+            msg_packet_t *in_packet = emu_rx_claim(head, len);
+            if (!in_packet || !in_packet->data) {
+                ESP_LOGD(TAG, "write of %d bytes dropped (mtu %d)", len, mtu_size);
                 return BLE_ATT_ERR_INSUFFICIENT_RES;
             }
 
-            in_packet->len = len;
             os_mbuf_copydata(ctxt->om, 0, len, in_packet->data);
+            emu_rx_commit(in_packet);
             emu_interface_process_packet();
             return 0;
         } // end if op WRITE
@@ -203,12 +207,11 @@ void send_indication(void){
 }
 
 /* Send a 1-byte 0x00 notification on emu_in to signal the peer it may send the next packet */
-void gatt_notify_ready(void) {
+void gatt_notify_in(const uint8_t *data, size_t len) {
     if (!notify_status_emu_in.notify_status || !notify_status_emu_in.chr_conn_handle_status) return;
-    static const uint8_t ready_byte = 0x00;
 
     xSemaphoreTake(notify_mutex, portMAX_DELAY);
-    struct os_mbuf *om = ble_hs_mbuf_from_flat(&ready_byte, sizeof(ready_byte));
+    struct os_mbuf *om = ble_hs_mbuf_from_flat(data, len);
     if (!om) { xSemaphoreGive(notify_mutex); return; }
     int rc = ble_gatts_notify_custom(chr_conn_handle_emu_in, chr_val_handle_emu_in, om);
     if (rc != 0) os_mbuf_free_chain(om);
@@ -9,6 +9,7 @@
 #include "esc_manager.h"
 #include "emu_loop.h"
 #include "emu_interface.h"
+#include "emu_rx.h"
 
 TaskHandle_t main_task;
 
@@ -86,8 +87,8 @@ void app_main(void) {
     // Configure NimBLE host callbacks
     nimble_host_config_init();  
     xTaskCreate(nimble_host_task, "NimBLE Host", 4*1024, NULL, 3, NULL);
+    emu_rx_init(gatt_notify_in);
     xTaskCreate(emu_interface_task, "emu_interface_task", 4*1024, NULL, 2, NULL);
-    emu_interface_set_packet_done_cb(gatt_notify_ready);
     main_task = xTaskGetCurrentTaskHandle();
 
     //emu_debug_output_add(&emu_out_buffer);